@@ -0,0 +1,179 @@
+/*
+	File: atomic.h
+	Author: Philip Haynes
+	Minimal set of atomic operations for sharing state between the audio thread and everyone else.
+	We don't use stdatomic.h because MSVC still hides it behind an experimental flag.
+	Loads are acquire, stores are release, and read-modify-write operations are sequentially consistent.
+*/
+
+#ifndef AZAUDIO_ATOMIC_H
+#define AZAUDIO_ATOMIC_H
+
+#include "aza_c_std.h"
+
+#if AZAUDIO_BUILT_WITH_MSVC
+	#include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+#if AZAUDIO_BUILT_WITH_GCC || AZAUDIO_BUILT_WITH_CLANG
+
+static inline int32_t azaAtomicLoad32(volatile int32_t *ptr) {
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void azaAtomicStore32(volatile int32_t *ptr, int32_t value) {
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+// returns the value before the addition
+static inline int32_t azaAtomicFetchAdd32(volatile int32_t *ptr, int32_t value) {
+	return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+// returns the value before the exchange
+static inline int32_t azaAtomicExchange32(volatile int32_t *ptr, int32_t value) {
+	return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+// returns true if *ptr was expected and is now desired
+static inline bool azaAtomicCompareExchange32(volatile int32_t *ptr, int32_t expected, int32_t desired) {
+	return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline int64_t azaAtomicLoad64(volatile int64_t *ptr) {
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void azaAtomicStore64(volatile int64_t *ptr, int64_t value) {
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+// returns the value before the addition
+static inline int64_t azaAtomicFetchAdd64(volatile int64_t *ptr, int64_t value) {
+	return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+// returns true if *ptr was expected and is now desired
+static inline bool azaAtomicCompareExchange64(volatile int64_t *ptr, int64_t expected, int64_t desired) {
+	return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline void* azaAtomicLoadPtr(void *volatile *ptr) {
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void azaAtomicStorePtr(void *volatile *ptr, void *value) {
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+// returns the value before the exchange
+static inline void* azaAtomicExchangePtr(void *volatile *ptr, void *value) {
+	return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+// returns true if *ptr was expected and is now desired
+static inline bool azaAtomicCompareExchangePtr(void *volatile *ptr, void *expected, void *desired) {
+	return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+// Full sequentially-consistent memory fence
+static inline void azaAtomicFence() {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#elif AZAUDIO_BUILT_WITH_MSVC
+
+// NOTE: On x86 and x64, aligned loads and stores already have acquire and release semantics respectively, so we only need to stop the compiler from reordering around them.
+
+static inline int32_t azaAtomicLoad32(volatile int32_t *ptr) {
+	int32_t result = *ptr;
+	_ReadWriteBarrier();
+	return result;
+}
+
+static inline void azaAtomicStore32(volatile int32_t *ptr, int32_t value) {
+	_ReadWriteBarrier();
+	*ptr = value;
+}
+
+// returns the value before the addition
+static inline int32_t azaAtomicFetchAdd32(volatile int32_t *ptr, int32_t value) {
+	return (int32_t)_InterlockedExchangeAdd((volatile long*)ptr, (long)value);
+}
+
+// returns the value before the exchange
+static inline int32_t azaAtomicExchange32(volatile int32_t *ptr, int32_t value) {
+	return (int32_t)_InterlockedExchange((volatile long*)ptr, (long)value);
+}
+
+// returns true if *ptr was expected and is now desired
+static inline bool azaAtomicCompareExchange32(volatile int32_t *ptr, int32_t expected, int32_t desired) {
+	return (int32_t)_InterlockedCompareExchange((volatile long*)ptr, (long)desired, (long)expected) == expected;
+}
+
+static inline int64_t azaAtomicLoad64(volatile int64_t *ptr) {
+	int64_t result = *ptr;
+	_ReadWriteBarrier();
+	return result;
+}
+
+static inline void azaAtomicStore64(volatile int64_t *ptr, int64_t value) {
+	_ReadWriteBarrier();
+	*ptr = value;
+}
+
+// returns the value before the addition
+static inline int64_t azaAtomicFetchAdd64(volatile int64_t *ptr, int64_t value) {
+	return _InterlockedExchangeAdd64((volatile __int64*)ptr, value);
+}
+
+// returns true if *ptr was expected and is now desired
+static inline bool azaAtomicCompareExchange64(volatile int64_t *ptr, int64_t expected, int64_t desired) {
+	return _InterlockedCompareExchange64((volatile __int64*)ptr, desired, expected) == expected;
+}
+
+static inline void* azaAtomicLoadPtr(void *volatile *ptr) {
+	void *result = *ptr;
+	_ReadWriteBarrier();
+	return result;
+}
+
+static inline void azaAtomicStorePtr(void *volatile *ptr, void *value) {
+	_ReadWriteBarrier();
+	*ptr = value;
+}
+
+// returns the value before the exchange
+static inline void* azaAtomicExchangePtr(void *volatile *ptr, void *value) {
+	return _InterlockedExchangePointer(ptr, value);
+}
+
+// returns true if *ptr was expected and is now desired
+static inline bool azaAtomicCompareExchangePtr(void *volatile *ptr, void *expected, void *desired) {
+	return _InterlockedCompareExchangePointer(ptr, desired, expected) == expected;
+}
+
+// Full sequentially-consistent memory fence
+static inline void azaAtomicFence() {
+	_mm_mfence();
+}
+
+#else
+
+#error "platform not supported"
+
+#endif
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AZAUDIO_ATOMIC_H
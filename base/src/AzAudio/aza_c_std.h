@@ -118,6 +118,13 @@ static inline void aza_free(void *block) {
 	#define AZAUDIO_BUILT_WITH_MSVC 0
 #endif
 
+// restrict isn't a keyword in C++, but all the compilers we care about have __restrict
+#ifdef __cplusplus
+	#define AZA_RESTRICT __restrict
+#else
+	#define AZA_RESTRICT restrict
+#endif
+
 #if AZAUDIO_BUILT_WITH_CLANG
 	#define AZA_FORCE_INLINE(...) inline __VA_ARGS__
 #elif AZAUDIO_BUILT_WITH_GCC
@@ -256,8 +263,8 @@ if ((name).capacity < (num)) {\
 }
 
 #define AZA_DA_ERASE(name, index, num) {\
-	assert((uint32_t)(index) <= (name).count);\
-	memmove((name).data + (index), (name).data + ((index) + 1), sizeof((name).data[0]) * ((name).count - (index)));\
+	assert((uint32_t)(index) + (uint32_t)(num) <= (name).count);\
+	memmove((name).data + (index), (name).data + ((index) + (num)), sizeof((name).data[0]) * ((name).count - (index) - (num)));\
 	(name).count -= (num);\
 }
 
@@ -6,6 +6,7 @@
 #include "../threads.h"
 
 #include <pthread.h>
+#include <semaphore.h>
 
 #include <assert.h>
 #include <stdint.h>
@@ -88,3 +89,31 @@ void azaMutexUnlock(azaMutex *mutex) {
 	azaMutex_Linux *mutex_linux = (azaMutex_Linux*)mutex;
 	pthread_mutex_unlock(&mutex_linux->mutex);
 }
+
+typedef struct azaSemaphore_Linux {
+	sem_t semaphore;
+} azaSemaphore_Linux;
+static_assert(alignof(azaSemaphore_Linux) <= alignof(azaSemaphore), "Incorrect alignment for azaSemaphore on Linux");
+static_assert(sizeof(azaSemaphore_Linux) == sizeof(azaSemaphore), "Incorrect size for azaSemaphore on Linux");
+
+void azaSemaphoreInit(azaSemaphore *semaphore, uint32_t initialCount) {
+	azaSemaphore_Linux *semaphore_linux = (azaSemaphore_Linux*)semaphore;
+	sem_init(&semaphore_linux->semaphore, 0, initialCount);
+}
+
+void azaSemaphoreDeinit(azaSemaphore *semaphore) {
+	azaSemaphore_Linux *semaphore_linux = (azaSemaphore_Linux*)semaphore;
+	sem_destroy(&semaphore_linux->semaphore);
+}
+
+void azaSemaphoreWait(azaSemaphore *semaphore) {
+	azaSemaphore_Linux *semaphore_linux = (azaSemaphore_Linux*)semaphore;
+	while (sem_wait(&semaphore_linux->semaphore) == -1 && errno == EINTR) {}
+}
+
+void azaSemaphorePost(azaSemaphore *semaphore, uint32_t count) {
+	azaSemaphore_Linux *semaphore_linux = (azaSemaphore_Linux*)semaphore;
+	for (uint32_t i = 0; i < count; i++) {
+		sem_post(&semaphore_linux->semaphore);
+	}
+}
@@ -100,3 +100,32 @@ void azaMutexUnlock(azaMutex *mutex) {
 	azaMutex_Win32 *mutex_win32 = (azaMutex_Win32*)mutex;
 	LeaveCriticalSection(&mutex_win32->criticalSection);
 }
+
+typedef struct azaSemaphore_Win32 {
+	HANDLE hSemaphore;
+} azaSemaphore_Win32;
+static_assert(alignof(azaSemaphore_Win32) == alignof(azaSemaphore), "Incorrect alignment for azaSemaphore on Win32");
+static_assert(sizeof(azaSemaphore_Win32) == sizeof(azaSemaphore), "Incorrect size for azaSemaphore on Win32");
+
+void azaSemaphoreInit(azaSemaphore *semaphore, uint32_t initialCount) {
+	azaSemaphore_Win32 *semaphore_win32 = (azaSemaphore_Win32*)semaphore;
+	semaphore_win32->hSemaphore = CreateSemaphoreA(NULL, (LONG)initialCount, 0x7fffffff, NULL);
+}
+
+void azaSemaphoreDeinit(azaSemaphore *semaphore) {
+	azaSemaphore_Win32 *semaphore_win32 = (azaSemaphore_Win32*)semaphore;
+	CloseHandle(semaphore_win32->hSemaphore);
+	semaphore_win32->hSemaphore = NULL;
+}
+
+void azaSemaphoreWait(azaSemaphore *semaphore) {
+	azaSemaphore_Win32 *semaphore_win32 = (azaSemaphore_Win32*)semaphore;
+	WaitForSingleObject(semaphore_win32->hSemaphore, INFINITE);
+}
+
+void azaSemaphorePost(azaSemaphore *semaphore, uint32_t count) {
+	azaSemaphore_Win32 *semaphore_win32 = (azaSemaphore_Win32*)semaphore;
+	if (count) {
+		ReleaseSemaphore(semaphore_win32->hSemaphore, (LONG)count, NULL);
+	}
+}
@@ -45,6 +45,18 @@ typedef struct azaMutex {
 	alignas(AZA_MUTEX_ALIGNMENT) uint8_t data[AZA_MUTEX_SIZE];
 } azaMutex;
 
+#define AZA_SEMAPHORE_ALIGNMENT 8
+// This should be the total size in bytes of the actual platform-specific semaphore struct including any padding
+#ifdef __unix
+	#define AZA_SEMAPHORE_SIZE 32
+#elif defined(WIN32)
+	#define AZA_SEMAPHORE_SIZE 8
+#endif
+
+typedef struct azaSemaphore {
+	alignas(AZA_SEMAPHORE_ALIGNMENT) uint8_t data[AZA_SEMAPHORE_SIZE];
+} azaSemaphore;
+
 // returns 0 on success, errno on failure
 int azaThreadLaunch(azaThread *thread, AZA_THREAD_PROC_TYPE(proc), void *userdata);
 
@@ -66,6 +78,16 @@ void azaMutexLock(azaMutex *mutex);
 
 void azaMutexUnlock(azaMutex *mutex);
 
+void azaSemaphoreInit(azaSemaphore *semaphore, uint32_t initialCount);
+
+void azaSemaphoreDeinit(azaSemaphore *semaphore);
+
+// Blocks until the count is above zero, then decrements it.
+void azaSemaphoreWait(azaSemaphore *semaphore);
+
+// Increments the count by count, waking up to that many waiting threads.
+void azaSemaphorePost(azaSemaphore *semaphore, uint32_t count);
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,6 +33,10 @@ static azaCPUIDLeaf azaGetCPUIDLeaf(uint32_t leaf, uint32_t subleaf) {
 	return result;
 }
 
+static uint64_t azaGetXCR0() {
+	return _xgetbv(0);
+}
+
 #elif defined(__GNUC__) || defined(__clang__)
 
 #include <cpuid.h>
@@ -43,6 +47,13 @@ static azaCPUIDLeaf azaGetCPUIDLeaf(uint32_t leaf, uint32_t subleaf) {
 	return result;
 }
 
+// _xgetbv needs the xsave target, which we'd rather not require just for this
+static uint64_t azaGetXCR0() {
+	uint32_t eax, edx;
+	__asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+}
+
 #else
 
 #warning "platform not supported"
@@ -64,6 +75,7 @@ void azaCPUIDInit() {
 	azaCPUID.sse4_2              = azaIsBitSet(leaf.ecx, 20);
 	azaCPUID.avx                 = azaIsBitSet(leaf.ecx, 28);
 	azaCPUID.fma                 = azaIsBitSet(leaf.ecx, 12);
+	bool osxsave                 = azaIsBitSet(leaf.ecx, 27);
 
 	// Leaf 7
 	leaf = azaGetCPUIDLeaf(7, 0);
@@ -90,5 +102,29 @@ void azaCPUIDInit() {
 	azaCPUID.amx_tile            = azaIsBitSet(leaf.edx, 24);
 	azaCPUID.amx_int8            = azaIsBitSet(leaf.edx, 25);
 
+	// The CPU supporting AVX-512 doesn't mean the OS saves the upper halves of the zmm registers or the mask registers between context switches, so check that it does before we let anybody use them.
+	uint64_t xcr0 = osxsave ? azaGetXCR0() : 0;
+	// opmask, ZMM_Hi256, and Hi16_ZMM state, plus the SSE and AVX state they build on
+	const uint64_t xcr0AVX512 = 0xe6;
+	if ((xcr0 & xcr0AVX512) != xcr0AVX512) {
+		azaCPUID.avx512f             = false;
+		azaCPUID.avx512dq            = false;
+		azaCPUID.avx512_ifma         = false;
+		azaCPUID.avx512pf            = false;
+		azaCPUID.avx512er            = false;
+		azaCPUID.avx512cd            = false;
+		azaCPUID.avx512bw            = false;
+		azaCPUID.avx512vl            = false;
+		azaCPUID.avx512_vbmi         = false;
+		azaCPUID.avx512_vbmi2        = false;
+		azaCPUID.avx512_vnni         = false;
+		azaCPUID.avx512_bitalg       = false;
+		azaCPUID.avx512_vpopcntdq    = false;
+		azaCPUID.avx512_4vnniw       = false;
+		azaCPUID.avx512_4fmaps       = false;
+		azaCPUID.avx512_vp2intersect = false;
+		azaCPUID.avx512_fp16         = false;
+	}
+
 	azaCPUID.initted = true;
 }
\ No newline at end of file
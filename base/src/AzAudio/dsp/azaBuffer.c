@@ -8,6 +8,7 @@
 #include "../error.h"
 #include "../AzAudio.h"
 #include "../math.h"
+#include "../atomic.h"
 #include <threads.h> // thread_local
 
 
@@ -76,6 +77,7 @@ int azaBufferInit(azaBuffer *buffer, uint32_t frames, uint32_t leadingFrames, ui
 	buffer->leadingFrames = leadingFrames;
 	buffer->trailingFrames = trailingFrames;
 	buffer->stride = channelLayout.count;
+	buffer->silent = false;
 	buffer->channelLayout = channelLayout;
 	return AZA_SUCCESS;
 }
@@ -148,6 +150,8 @@ int azaBufferResize(azaBuffer *buffer, uint32_t frames, uint32_t leadingFrames,
 	buffer->leadingFrames = leadingFrames;
 	buffer->trailingFrames = trailingFrames;
 	buffer->stride = channelLayout.count;
+	// Growing the body can shift trailing frames into it
+	buffer->silent = false;
 	buffer->channelLayout = channelLayout;
 	if (channelLayout.count != buffer->channelLayout.count) {
 		azaBufferZero(buffer);
@@ -174,136 +178,7 @@ void azaBufferZero(azaBuffer *buffer) {
 
 // azaBufferReinterlace implementation is in specialized/azaBufferReinterlace.c
 
-void azaBufferMix(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc) {
-	assert(dst->frames == src->frames);
-	assert(dst->channelLayout.count == src->channelLayout.count);
-	const uint32_t channels = dst->channelLayout.count;
-	if AZA_UNLIKELY(volumeDst == 1.0f && volumeSrc == 0.0f) {
-		return;
-	} else if AZA_UNLIKELY(volumeDst == 0.0f && volumeSrc == 0.0f) {
-		azaBufferZero(dst);
-	} else if (volumeDst == 1.0f && volumeSrc == 1.0f) {
-		for (uint32_t i = 0; i < dst->frames; i++) {
-			for (uint32_t c = 0; c < channels; c++) {
-				dst->pSamples[i * dst->stride + c] = dst->pSamples[i * dst->stride + c] + src->pSamples[i * src->stride + c];
-			}
-		}
-	} else if AZA_LIKELY(volumeDst == 1.0f) {
-		for (uint32_t i = 0; i < dst->frames; i++) {
-			for (uint32_t c = 0; c < channels; c++) {
-				dst->pSamples[i * dst->stride + c] = dst->pSamples[i * dst->stride + c] + src->pSamples[i * src->stride + c] * volumeSrc;
-			}
-		}
-	} else if (volumeSrc == 1.0f) {
-		for (uint32_t i = 0; i < dst->frames; i++) {
-			for (uint32_t c = 0; c < channels; c++) {
-				dst->pSamples[i * dst->stride + c] = dst->pSamples[i * dst->stride + c] * volumeDst + src->pSamples[i * src->stride + c];
-			}
-		}
-	} else {
-		for (uint32_t i = 0; i < dst->frames; i++) {
-			for (uint32_t c = 0; c < channels; c++) {
-				dst->pSamples[i * dst->stride + c] = dst->pSamples[i * dst->stride + c] * volumeDst + src->pSamples[i * src->stride + c] * volumeSrc;
-			}
-		}
-	}
-}
-
-void azaBufferMixFadeEase(azaBuffer *dst, float volumeDstStart, float volumeDstEnd, fp_azaEase_t easeDst, azaBuffer *src, float volumeSrcStart, float volumeSrcEnd, fp_azaEase_t easeSrc) {
-	if (volumeDstStart == volumeDstEnd && volumeSrcStart == volumeSrcEnd) {
-		azaBufferMix(dst, volumeDstStart, src, volumeSrcStart);
-		return;
-	}
-	if ((easeDst == azaEaseLinear || volumeDstStart == volumeDstEnd) && (easeSrc == azaEaseLinear || volumeSrcStart == volumeSrcEnd)) {
-		azaBufferMixFadeLinear(dst, volumeDstStart, volumeDstEnd, src, volumeSrcStart, volumeSrcEnd);
-		return;
-	}
-	assert(dst->frames == src->frames);
-	assert(dst->channelLayout.count == src->channelLayout.count);
-	assert(easeDst);
-	assert(easeSrc);
-	const uint32_t channels = dst->channelLayout.count;
-	const float volumeDstDelta = volumeDstEnd - volumeDstStart;
-	const float volumeSrcDelta = volumeSrcEnd - volumeSrcStart;
-	const float framesF = (float)dst->frames;
-	if (volumeDstDelta == 0.0f) {
-		// No fading necessary for dst
-		if (volumeDstStart == 1.0f) {
-			// No attenuation necessary for dst
-			for (uint32_t i = 0; i < dst->frames; i++) {
-				float t = (float)i / framesF;
-				float volumeSrc = volumeSrcStart + volumeSrcDelta * easeSrc(t);
-				for (uint32_t c = 0; c < channels; c++) {
-					dst->pSamples[i * dst->stride + c] = dst->pSamples[i * dst->stride + c] + src->pSamples[i * src->stride + c] * volumeSrc;
-				}
-			}
-		} else {
-			// We must still attenuate dst, just without a fade
-			for (uint32_t i = 0; i < dst->frames; i++) {
-				float t = (float)i / framesF;
-				float volumeSrc = volumeSrcStart + volumeSrcDelta * easeSrc(t);
-				for (uint32_t c = 0; c < channels; c++) {
-					dst->pSamples[i * dst->stride + c] = dst->pSamples[i * dst->stride + c] + src->pSamples[i * src->stride + c] * volumeSrc;
-				}
-			}
-		}
-	} else {
-		// Fading is necessary for dst
-		for (uint32_t i = 0; i < dst->frames; i++) {
-			float t = (float)i / framesF;
-			float volumeDst = volumeDstStart + volumeDstDelta * easeDst(t);
-			float volumeSrc = volumeSrcStart + volumeSrcDelta * easeSrc(t);
-			for (uint32_t c = 0; c < channels; c++) {
-				dst->pSamples[i * dst->stride + c] = dst->pSamples[i * dst->stride + c] * volumeDst + src->pSamples[i * src->stride + c] * volumeSrc;
-			}
-		}
-	}
-}
-
-void azaBufferMixFadeLinear(azaBuffer *dst, float volumeDstStart, float volumeDstEnd, azaBuffer *src, float volumeSrcStart, float volumeSrcEnd) {
-	if (volumeDstStart == volumeDstEnd && volumeSrcStart == volumeSrcEnd) {
-		azaBufferMix(dst, volumeDstStart, src, volumeSrcStart);
-		return;
-	}
-	assert(dst->frames == src->frames);
-	assert(dst->channelLayout.count == src->channelLayout.count);
-	const uint32_t channels = dst->channelLayout.count;
-	const float volumeDstDelta = volumeDstEnd - volumeDstStart;
-	const float volumeSrcDelta = volumeSrcEnd - volumeSrcStart;
-	const float framesF = (float)dst->frames;
-	if (volumeDstDelta == 0.0f) {
-		// No fading necessary for dst
-		if (volumeDstStart == 1.0f) {
-			// No attenuation necessary for dst
-			for (uint32_t i = 0; i < dst->frames; i++) {
-				float t = (float)i / framesF;
-				float volumeSrc = volumeSrcStart + volumeSrcDelta * t;
-				for (uint32_t c = 0; c < channels; c++) {
-					dst->pSamples[i * dst->stride + c] = dst->pSamples[i * dst->stride + c] + src->pSamples[i * src->stride + c] * volumeSrc;
-				}
-			}
-		} else {
-			// We must still attenuate dst, just without a fade
-			for (uint32_t i = 0; i < dst->frames; i++) {
-				float t = (float)i / framesF;
-				float volumeSrc = volumeSrcStart + volumeSrcDelta * t;
-				for (uint32_t c = 0; c < channels; c++) {
-					dst->pSamples[i * dst->stride + c] = dst->pSamples[i * dst->stride + c] + src->pSamples[i * src->stride + c] * volumeSrc;
-				}
-			}
-		}
-	} else {
-		// Fading is necessary for dst
-		for (uint32_t i = 0; i < dst->frames; i++) {
-			float t = (float)i / framesF;
-			float volumeDst = volumeDstStart + volumeDstDelta * t;
-			float volumeSrc = volumeSrcStart + volumeSrcDelta * t;
-			for (uint32_t c = 0; c < channels; c++) {
-				dst->pSamples[i * dst->stride + c] = dst->pSamples[i * dst->stride + c] * volumeDst + src->pSamples[i * src->stride + c] * volumeSrc;
-			}
-		}
-	}
-}
+// azaBufferMix, azaBufferMixFadeEase, and azaBufferMixFadeLinear implementations are in specialized/azaBufferMix.c
 
 // azaBufferMixMatrix implementation is in specialized/azaBufferMixMatrix.c
 
@@ -313,9 +188,10 @@ void azaBufferCopy(azaBuffer *dst, azaBuffer *src) {
 	uint32_t leadingFrames = AZA_MIN(dst->leadingFrames, src->leadingFrames);
 	uint32_t trailingFrames = AZA_MIN(dst->trailingFrames, src->trailingFrames);
 	uint32_t totalFrames = src->frames + leadingFrames + trailingFrames;
+	dst->silent = src->silent;
 	if (dst->channelLayout.count == dst->stride && src->channelLayout.count == src->stride) {
 		uint32_t leadingSamples = leadingFrames * src->channelLayout.count;
-		memcpy(dst->pSamples - leadingSamples, src->pSamples - leadingSamples, sizeof(float) * totalFrames * src->channelLayout.count);
+		memmove(dst->pSamples - leadingSamples, src->pSamples - leadingSamples, sizeof(float) * totalFrames * src->channelLayout.count);
 	} else {
 		for (int64_t i = -(int64_t)leadingFrames; i < (int64_t)(src->frames + trailingFrames); i++) {
 			for (uint8_t c = 0; c < src->channelLayout.count; c++) {
@@ -332,6 +208,8 @@ void azaBufferCopyChannel(azaBuffer *dst, uint8_t channelDst, azaBuffer *src, ui
 	uint32_t leadingFrames = AZA_MIN(dst->leadingFrames, src->leadingFrames);
 	uint32_t trailingFrames = AZA_MIN(dst->trailingFrames, src->trailingFrames);
 	uint32_t totalFrames = src->frames + leadingFrames + trailingFrames;
+	// The other channels of dst are left alone
+	dst->silent = dst->silent && src->silent;
 	if (dst->stride == 1 && src->stride == 1) {
 		uint32_t leadingSamples = leadingFrames;
 		memcpy(dst->pSamples - leadingSamples, src->pSamples - leadingSamples, sizeof(float) * totalFrames);
@@ -356,6 +234,7 @@ void azaBufferBroadcastChannel(azaBuffer *dst, azaBuffer *src, uint8_t channelSr
 	uint32_t leadingFrames = AZA_MIN(dst->leadingFrames, src->leadingFrames);
 	uint32_t trailingFrames = AZA_MIN(dst->trailingFrames, src->trailingFrames);
 	uint32_t totalFrames = src->frames + leadingFrames + trailingFrames;
+	dst->silent = src->silent;
 	if (dst->stride == 1 && src->stride == 1) {
 		uint32_t leadingSamples = leadingFrames;
 		memcpy(dst->pSamples - leadingSamples, src->pSamples - leadingSamples, sizeof(float) * totalFrames);
@@ -440,20 +319,98 @@ azaBuffer azaBufferOneSample(float *sample, uint32_t samplerate) {
 
 
 
-// TODO: Maybe make this dynamic, and also deal with the thread_local memory leak snafu (possibly by making it not a stack, and therefore no longer thread_local)
-#define AZA_MAX_SIDE_BUFFERS 64
-static thread_local azaBuffer sideBufferPool[AZA_MAX_SIDE_BUFFERS] = {{0}};
-static thread_local size_t sideBuffersInUse = 0;
+// Each thread's own arena, used unless another one is bound
+static thread_local azaSideBufferArena sideBufferArenaOwned = {0};
+static thread_local azaSideBufferArena *sideBufferArena = NULL;
 static thread_local bool sideBufferCleanupInitted = false;
 
+// Returns zeroed memory aligned to AZA_SIDE_BUFFER_ALIGNMENT, putting what needs to be freed into *block
+static aza_byte* azaSideBufferAllocAligned(size_t size, void **block) {
+	*block = aza_calloc(1, size + AZA_SIDE_BUFFER_ALIGNMENT - 1);
+	if (!*block) return NULL;
+	return (aza_byte*)aza_align((size_t)*block, AZA_SIDE_BUFFER_ALIGNMENT);
+}
+
+static int azaSideBufferArenaGrow(azaSideBufferArena *arena, size_t capacity) {
+	assert(arena->stack.count == 0);
+	if (capacity <= arena->capacity) return AZA_SUCCESS;
+	void *block;
+	aza_byte *data = azaSideBufferAllocAligned(capacity, &block);
+	if (!data) return AZA_ERROR_OUT_OF_MEMORY;
+	if (arena->block) aza_free(arena->block);
+	arena->block = block;
+	arena->data = data;
+	arena->capacity = capacity;
+	return AZA_SUCCESS;
+}
+
+static void azaSideBufferBlockFree(azaSideBufferBlock *block) {
+	if (!block) return;
+	if (block->block) aza_free(block->block);
+	aza_free(block);
+}
+
+void azaSideBufferArenaDeinit(azaSideBufferArena *arena) {
+	for (uint32_t i = 0; i < arena->stack.count; i++) {
+		if (arena->stack.data[i].overflow) aza_free(arena->stack.data[i].overflow);
+	}
+	AZA_DA_DEINIT(arena->stack);
+	if (arena->block) aza_free(arena->block);
+	azaSideBufferBlockFree((azaSideBufferBlock*)azaAtomicExchangePtr((void*volatile*)&arena->blockOffered, NULL));
+	azaSideBufferBlockFree((azaSideBufferBlock*)azaAtomicExchangePtr((void*volatile*)&arena->blockRetired, NULL));
+	arena->block = NULL;
+	arena->data = NULL;
+	arena->capacity = 0;
+	arena->used = 0;
+	arena->usedOverflow = 0;
+	arena->failedDepth = 0;
+}
+
+int azaSideBufferArenaReserve(azaSideBufferArena *arena, uint32_t frames, uint32_t channels, uint32_t depth) {
+	assert(arena->stack.count == 0 && "Can't reserve side buffers while they're in use");
+	AZA_DA_RESERVE_COUNT(arena->stack, depth, return AZA_ERROR_OUT_OF_MEMORY);
+	size_t bufferSize = aza_align((size_t)frames * (size_t)channels * sizeof(float), AZA_SIDE_BUFFER_ALIGNMENT);
+	return azaSideBufferArenaGrow(arena, bufferSize * depth);
+}
+
+bool azaSideBufferArenaOfferGrowth(azaSideBufferArena *arena) {
+	azaSideBufferBlockFree((azaSideBufferBlock*)azaAtomicExchangePtr((void*volatile*)&arena->blockRetired, NULL));
+	// These are written by the thread using the arena, but the worst a stale read can do is make us offer a little late.
+	size_t highWaterMark = arena->highWaterMark;
+	if (highWaterMark <= arena->capacity) return false;
+	if (azaAtomicLoadPtr((void*volatile*)&arena->blockOffered)) return true;
+	azaSideBufferBlock *offer = (azaSideBufferBlock*)aza_calloc(1, sizeof(azaSideBufferBlock));
+	if (!offer) return true;
+	offer->data = azaSideBufferAllocAligned(highWaterMark, &offer->block);
+	if (!offer->data) {
+		aza_free(offer);
+		return true;
+	}
+	offer->capacity = highWaterMark;
+	azaAtomicStorePtr((void*volatile*)&arena->blockOffered, offer);
+	return true;
+}
+
+// Switches to memory offered by azaSideBufferArenaOfferGrowth if there is any. The stack must be empty.
+static void azaSideBufferArenaTakeOffer(azaSideBufferArena *arena) {
+	if (!arena->blockOffered) return;
+	// The offering thread won't offer again until it sees the last one was taken, and it frees blockRetired before it does.
+	azaSideBufferBlock *offer = (azaSideBufferBlock*)azaAtomicExchangePtr((void*volatile*)&arena->blockOffered, NULL);
+	if (!offer) return;
+	azaSideBufferBlock old = { arena->block, arena->data, arena->capacity };
+	arena->block = offer->block;
+	arena->data = offer->data;
+	arena->capacity = offer->capacity;
+	*offer = old;
+	azaAtomicStorePtr((void*volatile*)&arena->blockRetired, offer);
+}
+
 void azaCleanupSideBuffers(void *ignored) {
 	(void)ignored;
-	if (sideBuffersInUse > 0) {
-		AZA_LOG_ERR("There are %zu side buffers in use at thread exit. This is either caused by thread termination or a bug.\n", sideBuffersInUse);
-	}
-	for (uint32_t i = 0; i < AZA_MAX_SIDE_BUFFERS; i++) {
-		azaBufferDeinit(&sideBufferPool[i], false);
+	if (sideBufferArenaOwned.stack.count > 0) {
+		AZA_LOG_ERR("There are %u side buffers in use at thread exit. This is either caused by thread termination or a bug.\n", sideBufferArenaOwned.stack.count);
 	}
+	azaSideBufferArenaDeinit(&sideBufferArenaOwned);
 }
 
 static void azaRegisterSideBufferCleanupFunction() {
@@ -463,28 +420,99 @@ static void azaRegisterSideBufferCleanupFunction() {
 	tss_set(key, (void*)1337);
 }
 
-azaBuffer azaPushSideBuffer(uint32_t frames, uint32_t leadingFrames, uint32_t trailingFrames, uint32_t channels, uint32_t samplerate) {
+static azaSideBufferArena* azaGetSideBufferArena() {
+	if (sideBufferArena) return sideBufferArena;
 	if (!sideBufferCleanupInitted) {
 		azaRegisterSideBufferCleanupFunction();
 		sideBufferCleanupInitted = true;
 	}
-	assert(sideBuffersInUse < AZA_MAX_SIDE_BUFFERS);
-	azaBuffer *buffer = &sideBufferPool[sideBuffersInUse];
-	azaBufferResize(buffer, frames, leadingFrames, trailingFrames, (azaChannelLayout) { .count = channels });
-	buffer->samplerate = samplerate;
-	sideBuffersInUse++;
-	return *buffer;
+	return &sideBufferArenaOwned;
+}
+
+azaSideBufferArena* azaSideBuffersBindArena(azaSideBufferArena *arena) {
+	azaSideBufferArena *previous = sideBufferArena;
+	sideBufferArena = arena;
+	return previous;
+}
+
+int azaSideBuffersPrewarm(uint32_t frames, uint32_t channels, uint32_t depth) {
+	return azaSideBufferArenaReserve(azaGetSideBufferArena(), frames, channels, depth);
+}
+
+size_t azaSideBuffersGetHighWaterMark() {
+	return azaGetSideBufferArena()->highWaterMark;
+}
+
+azaBuffer azaPushSideBuffer(uint32_t frames, uint32_t leadingFrames, uint32_t trailingFrames, uint32_t channels, uint32_t samplerate) {
+	azaSideBufferArena *arena = azaGetSideBufferArena();
+	uint32_t totalFrames = frames + leadingFrames + trailingFrames;
+	size_t size = aza_align((size_t)totalFrames * (size_t)channels * sizeof(float), AZA_SIDE_BUFFER_ALIGNMENT);
+	// Once a push fails to get a mark, every push on top of it has to fail the same way so the pops line up.
+	if (arena->failedDepth) goto noMark;
+	if (arena->stack.count == 0) {
+		azaSideBufferArenaTakeOffer(arena);
+	}
+	if (arena->fixed) {
+		if (arena->stack.count >= arena->stack.capacity) {
+			AZA_LOG_ERR_ONCE("azaPushSideBuffer error: Side buffers went deeper than the %u reserved in a fixed arena\n", arena->stack.capacity);
+			goto noMark;
+		}
+	} else {
+		AZA_DA_RESERVE_ONE_AT_END(arena->stack, goto noMark);
+	}
+	azaSideBufferArenaMark mark = {
+		.used = arena->used,
+		.overflow = NULL,
+		.overflowSize = 0,
+	};
+	// This includes what we couldn't get, so azaSideBufferArenaOfferGrowth knows how much we wanted.
+	arena->highWaterMark = AZA_MAX(arena->highWaterMark, arena->used + arena->usedOverflow + size);
+	float *data = NULL;
+	if (arena->used + size <= arena->capacity) {
+		data = (float*)(arena->data + arena->used);
+		arena->used += size;
+	} else if (!arena->fixed) {
+		// Didn't reserve enough, so get through this block with a separate allocation
+		data = (float*)azaSideBufferAllocAligned(size, &mark.overflow);
+		if (data) {
+			mark.overflowSize = size;
+			arena->usedOverflow += size;
+		}
+	}
+	arena->stack.data[arena->stack.count++] = mark;
+	if AZA_UNLIKELY(!data) {
+		return (azaBuffer) { .pSamples = NULL };
+	}
+	return (azaBuffer) {
+		.pSamples       = data + leadingFrames * channels,
+		.samplerate     = samplerate,
+		.frames         = frames,
+		.leadingFrames  = leadingFrames,
+		.trailingFrames = trailingFrames,
+		.stride         = (uint16_t)channels,
+		.silent         = false,
+		.bufferCapacity = totalFrames * channels,
+		.buffer         = data,
+		.channelLayout  = (azaChannelLayout) { .count = (uint8_t)channels },
+	};
+noMark:
+	arena->failedDepth++;
+	return (azaBuffer) { .pSamples = NULL };
 }
 
 azaBuffer azaPushSideBufferZero(uint32_t frames, uint32_t leadingFrames, uint32_t trailingFrames, uint32_t channels, uint32_t samplerate) {
 	azaBuffer buffer = azaPushSideBuffer(frames, leadingFrames, trailingFrames, channels, samplerate);
-	azaBufferZero(&buffer);
+	if (buffer.pSamples) {
+		azaBufferZero(&buffer);
+	}
 	return buffer;
 }
 
 azaBuffer azaPushSideBufferCopy(azaBuffer *src) {
 	azaBuffer result = azaPushSideBuffer(src->frames, src->leadingFrames, src->trailingFrames, src->channelLayout.count, src->samplerate);
-	azaBufferCopy(&result, src);
+	if (result.pSamples) {
+		azaBufferCopy(&result, src);
+	}
 	return result;
 }
 
@@ -494,11 +522,26 @@ azaBuffer azaPushSideBufferCopyZero(azaBuffer *src) {
 }
 
 void azaPopSideBuffer() {
-	assert(sideBuffersInUse >= 1);
-	sideBuffersInUse--;
+	azaSideBufferArena *arena = azaGetSideBufferArena();
+	if (arena->failedDepth) {
+		arena->failedDepth--;
+		return;
+	}
+	assert(arena->stack.count >= 1);
+	azaSideBufferArenaMark mark = arena->stack.data[--arena->stack.count];
+	arena->used = mark.used;
+	if (mark.overflow) {
+		aza_free(mark.overflow);
+		arena->usedOverflow -= mark.overflowSize;
+	}
+	if (arena->stack.count == 0 && !arena->fixed && arena->highWaterMark > arena->capacity) {
+		// We overflowed at some point, so make room for everything at once. If this fails we'll just keep overflowing.
+		azaSideBufferArenaGrow(arena, arena->highWaterMark);
+	}
 }
 
 void azaPopSideBuffers(uint8_t count) {
-	assert(sideBuffersInUse >= count);
-	sideBuffersInUse -= count;
-}
\ No newline at end of file
+	for (uint8_t i = 0; i < count; i++) {
+		azaPopSideBuffer();
+	}
+}
@@ -16,8 +16,6 @@
 extern "C" {
 #endif
 
-// TODO: azaBuffer might want to know when it's silence for optimization purposes
-
 // Buffer used by DSP functions for their input/output
 typedef struct azaBuffer {
 	float *pSamples; // Actual read/write-able data. Pointer is leadingFrames*stride indices into buffer.
@@ -26,7 +24,8 @@ typedef struct azaBuffer {
 	uint32_t leadingFrames; // We can have leading frames, used for sampling with kernels.
 	uint32_t trailingFrames; // We can have trailing frames, used for sampling with kernels.
 	uint16_t stride; // Distance between samples from one channel in number of floats.
-	uint8_t _reserved[2]; // Explicit padding bytes, reserved for later use.
+	bool silent; // If true, all samples in the body are known to be zero, which lets mixing and processing be skipped. false only means we don't know. The azaBuffer functions that write to dst keep this up to date, but if you write samples yourself you must set this to false. Views and slices get a copy of this flag, so writing through one doesn't clear it on the original.
+	uint8_t _reserved[1]; // Explicit padding bytes, reserved for later use.
 	uint32_t bufferCapacity; // Size of buffer in number of floats.
 	float *buffer; // Base pointer of our owned buffer. NULL if we're unowned.
 	azaChannelLayout channelLayout; // channelLayout.count is always required. Some functions expect the layout to be fully-specified, others don't care.
@@ -71,12 +70,18 @@ static inline float azaBufferGetLen_ms(azaBuffer *buffer) {
 	return 1000.0f * (float)buffer->frames / (float)buffer->samplerate;
 }
 
+// Updates dst->silent for the result of dst = dst*volumeDst + src*volumeSrc, where dstAudible and srcAudible tell whether the respective volumes are nonzero.
+static inline void azaBufferMixSilence(azaBuffer *dst, bool dstAudible, azaBuffer *src, bool srcAudible) {
+	dst->silent = (dst->silent || !dstAudible) && (src->silent || !srcAudible);
+}
+
+// Whether any samples of the two buffers share memory, including leading and trailing frames.
 static inline bool azaBuffersOverlap(azaBuffer *buffer1, azaBuffer *buffer2) {
-	uintptr_t buffer1Start = (uintptr_t)buffer1->pSamples;
-	uintptr_t buffer1End = (uintptr_t)(buffer1->pSamples + buffer1->frames);
-	uintptr_t buffer2Start = (uintptr_t)buffer2->pSamples;
-	uintptr_t buffer2End = (uintptr_t)(buffer2->pSamples + buffer2->frames);
-	return (buffer1Start <= buffer2End && buffer1End >= buffer2Start) || (buffer2Start <= buffer1End && buffer2End >= buffer1Start);
+	uintptr_t buffer1Start = (uintptr_t)(buffer1->pSamples - (size_t)buffer1->leadingFrames * buffer1->stride);
+	uintptr_t buffer1End = (uintptr_t)(buffer1->pSamples + (size_t)(buffer1->frames + buffer1->trailingFrames) * buffer1->stride);
+	uintptr_t buffer2Start = (uintptr_t)(buffer2->pSamples - (size_t)buffer2->leadingFrames * buffer2->stride);
+	uintptr_t buffer2End = (uintptr_t)(buffer2->pSamples + (size_t)(buffer2->frames + buffer2->trailingFrames) * buffer2->stride);
+	return buffer1Start < buffer2End && buffer2Start < buffer1End;
 }
 
 // If samples are externally-managed, you don't have to call azaBufferInit or azaBufferDeinit
@@ -100,6 +105,7 @@ void azaBufferDeinit(azaBuffer *buffer, bool warnOnUnowned);
 int azaBufferResize(azaBuffer *buffer, uint32_t frames, uint32_t leadingFrames, uint32_t trailingFrames, azaChannelLayout channelLayout);
 
 // Zeroes out an entire buffer, including leading and trailing frames.
+// NOTE: This doesn't set buffer->silent, since it's common to zero a buffer and then write into it directly. Set it yourself if nobody is going to do that.
 void azaBufferZero(azaBuffer *buffer);
 
 // buffers are defined to be interlaced (where channels come one after the other in memory for a single frame)
@@ -112,6 +118,7 @@ void azaBufferReinterlace(azaBuffer *dst, azaBuffer *src);
 
 // Mixes src into the existing contents of dst
 // Does NOT mix extraneous samples.
+// Does nothing if src->silent and volumeDst is 1.
 // NOTE: This will not respect channel positions. The buffers will be mixed as though the channel layouts are the same.
 // NOTE: asserts that dst and src have the same frame count and channel count.
 // For arbitrary channel mixing, use azaBufferMixMatrix.
@@ -134,6 +141,7 @@ void azaBufferMixFadeLinear(azaBuffer *dst, float volumeDstStart, float volumeDs
 
 // Copies the contents of one buffer into the other.
 // Copies extraneous samples (minimum of both buffers).
+// dst and src may overlap if they're both tightly packed (stride equals channel count).
 // NOTE: asserts that dst and src have the same frame count and channel count.
 void azaBufferCopy(azaBuffer *dst, azaBuffer *src);
 
@@ -173,15 +181,86 @@ void azaBufferMixMatrix(azaBuffer *dst, float volumeDst, azaBuffer *src, float v
 
 
 // Side Buffers, because sometimes you need extra buffers for processing.
-// We maintain a small stack of side buffers.
-// TODO: Make them allocate from a single arena rather than having individual buffers.
-//	      Or maybe don't because that makes debugging memory errors harder.
+// We maintain a stack of side buffers per thread, which are bump-allocated out of one contiguous arena. Every side buffer starts on an AZA_SIDE_BUFFER_ALIGNMENT-byte boundary.
+// If a push doesn't fit in the arena, that buffer gets its own allocation, and the arena grows to fit the high-water mark once the stack is empty again. To make sure the audio thread never allocates, reserve enough space ahead of time with azaSideBufferArenaReserve, mark the arena fixed, and bind it with azaSideBuffersBindArena. A fixed arena fails pushes that don't fit instead, and another thread can grow it with azaSideBufferArenaOfferGrowth. azaMixer does all this for you.
+// A push that fails gives you a buffer with pSamples == NULL, which you still have to pop. Processing functions should return AZA_ERROR_OUT_OF_MEMORY when that happens.
+// Side buffers don't own their memory, so never resize or deinit them.
+
+#define AZA_SIDE_BUFFER_ALIGNMENT 64
+// How many side buffers deep azaMixer reserves for if azaMixerConfig.sideBufferDepth is 0
+#define AZA_SIDE_BUFFER_DEFAULT_DEPTH 16
+
+typedef struct azaSideBufferArenaMark {
+	// How much of the arena was used before this push
+	size_t used;
+	// If this side buffer didn't fit in the arena, this is its own allocation, otherwise NULL.
+	void *overflow;
+	size_t overflowSize;
+} azaSideBufferArenaMark;
+
+// A replacement for an arena's memory, handed between threads by azaSideBufferArenaOfferGrowth
+typedef struct azaSideBufferBlock {
+	void *block;
+	aza_byte *data;
+	size_t capacity;
+} azaSideBufferBlock;
+
+typedef struct azaSideBufferArena {
+	// What we actually allocated, which data is aligned within
+	void *block;
+	aza_byte *data;
+	// Sizes are all in bytes
+	size_t capacity;
+	// If true, we never allocate after azaSideBufferArenaReserve, so pushes that don't fit fail instead. Set this yourself after reserving.
+	bool fixed;
+	// How many failed pushes are on top of the stack without a mark, because a fixed stack ran out of room for them
+	uint32_t failedDepth;
+	// Bigger memory from azaSideBufferArenaOfferGrowth, which we switch to once the stack is empty. Our old memory goes into blockRetired for the offering thread to free.
+	azaSideBufferBlock *volatile blockOffered;
+	azaSideBufferBlock *volatile blockRetired;
+	size_t used;
+	// Bytes in use by side buffers that didn't fit
+	size_t usedOverflow;
+	// The most bytes that were ever in use at once, including overflow
+	size_t highWaterMark;
+	// One for each side buffer in use
+	struct {
+		azaSideBufferArenaMark *data;
+		uint32_t count;
+		uint32_t capacity;
+	} stack;
+} azaSideBufferArena;
+
+// Frees everything the arena allocated. It must not have any side buffers in use.
+void azaSideBufferArenaDeinit(azaSideBufferArena *arena);
+
+// Makes room for depth side buffers of frames * channels samples each, so pushing them won't allocate. It must not have any side buffers in use.
+// May return AZA_ERROR_OUT_OF_MEMORY
+int azaSideBufferArenaReserve(azaSideBufferArena *arena, uint32_t frames, uint32_t channels, uint32_t depth);
+
+// For fixed arenas bound to another thread. If the arena ever needed more than it has, this allocates enough for its high-water mark and offers it to the thread using the arena, which switches over the next time its stack is empty. Also frees whatever that thread switched away from since last time.
+// Only one thread may call this for a given arena, and the arena must still be bound to at most one other thread.
+// returns true if the arena still wants more memory than it has after this call (either it's waiting on the offer or the allocation failed)
+bool azaSideBufferArenaOfferGrowth(azaSideBufferArena *arena);
+
+// Makes side buffer pushes and pops on the calling thread use arena until bound otherwise. Passing NULL goes back to the thread's own arena.
+// The arena must outlive the binding, and must not be bound to more than one thread at a time.
+// Returns the previously-bound arena (NULL if it was the thread's own) so you can put it back afterwards. Don't switch arenas while side buffers are in use unless you switch back before popping them.
+azaSideBufferArena* azaSideBuffersBindArena(azaSideBufferArena *arena);
+
+// Calls azaSideBufferArenaReserve on the calling thread's bound arena
+// May return AZA_ERROR_OUT_OF_MEMORY
+int azaSideBuffersPrewarm(uint32_t frames, uint32_t channels, uint32_t depth);
 
+// Returns the most bytes that were ever in use at once in the calling thread's bound arena. If this is more than you reserved, the arena had to allocate while processing.
+size_t azaSideBuffersGetHighWaterMark();
 
-// This cleans up side buffers on the current thread. Will be called automatically at the end of thread execution.
+// This cleans up the side buffer arena owned by the current thread. Will be called automatically at the end of thread execution.
 // The parameter is ignored, included only to work with tss_create
 void azaCleanupSideBuffers(void *ignored);
 
+// The contents are uninitialized, including leading and trailing frames
+// If the push fails, the result has pSamples == NULL (see above)
 azaBuffer azaPushSideBuffer(uint32_t frames, uint32_t leadingFrames, uint32_t trailingFrames, uint32_t channels, uint32_t samplerate);
 
 azaBuffer azaPushSideBufferZero(uint32_t frames, uint32_t leadingFrames, uint32_t trailingFrames, uint32_t channels, uint32_t samplerate);
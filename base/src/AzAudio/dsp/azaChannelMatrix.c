@@ -21,14 +21,20 @@
 int azaChannelMatrixInit(azaChannelMatrix *data, uint8_t inputs, uint8_t outputs) {
 	data->inputs = inputs;
 	data->outputs = outputs;
+	data->entryCount = 0;
+	data->kind = AZA_CHANNEL_MATRIX_DENSE;
 	uint16_t total = (uint16_t)inputs * (uint16_t)outputs;
 	if (total > 0) {
-		data->matrix = (float*)aza_calloc(total, sizeof(float));
+		// entries come right after matrix, and there can't be more entries than values
+		data->matrix = (float*)aza_calloc(total, sizeof(float) + sizeof(azaChannelMatrixEntry));
 		if (!data->matrix) {
+			data->entries = NULL;
 			return AZA_ERROR_OUT_OF_MEMORY;
 		}
+		data->entries = (azaChannelMatrixEntry*)(data->matrix + total);
 	} else {
 		data->matrix = NULL;
+		data->entries = NULL;
 	}
 	return AZA_SUCCESS;
 }
@@ -39,6 +45,56 @@ void azaChannelMatrixDeinit(azaChannelMatrix *data) {
 	}
 }
 
+void azaChannelMatrixClassify(azaChannelMatrix *data) {
+	data->entryCount = 0;
+	if (!data->matrix) {
+		data->kind = AZA_CHANNEL_MATRIX_DENSE;
+		return;
+	}
+	bool identity = data->inputs == data->outputs;
+	bool diagonal = identity;
+	bool permutation = true;
+	for (uint8_t output = 0; output < data->outputs; output++) {
+		uint8_t inputsUsed = 0;
+		for (uint8_t input = 0; input < data->inputs; input++) {
+			float gain = data->matrix[input * data->outputs + output];
+			if (gain == 0.0f) continue;
+			data->entries[data->entryCount++] = (azaChannelMatrixEntry) {
+				.input = input,
+				.output = output,
+				.gain = gain,
+			};
+			inputsUsed++;
+			if (input != output) {
+				identity = false;
+				diagonal = false;
+			}
+			if (gain != 1.0f) {
+				identity = false;
+			}
+		}
+		if (inputsUsed == 0) {
+			identity = false;
+		} else if (inputsUsed > 1) {
+			identity = false;
+			diagonal = false;
+			permutation = false;
+		}
+	}
+	uint16_t total = (uint16_t)data->inputs * (uint16_t)data->outputs;
+	if (identity) {
+		data->kind = AZA_CHANNEL_MATRIX_IDENTITY;
+	} else if (diagonal) {
+		data->kind = AZA_CHANNEL_MATRIX_DIAGONAL;
+	} else if (permutation) {
+		data->kind = AZA_CHANNEL_MATRIX_PERMUTATION;
+	} else if (data->entryCount * 2 <= total) {
+		data->kind = AZA_CHANNEL_MATRIX_SPARSE;
+	} else {
+		data->kind = AZA_CHANNEL_MATRIX_DENSE;
+	}
+}
+
 struct DistChannelPair {
 	int16_t dist, dstC;
 };
@@ -59,6 +115,7 @@ void azaChannelMatrixGenerateRoutingFromLayouts(azaChannelMatrix *data, azaChann
 		for (int16_t srcC = 0; srcC < srcLayout.count; srcC++) {
 			data->matrix[data->outputs * srcC] = 1.0f;
 		}
+		azaChannelMatrixClassify(data);
 		return;
 	}
 	bool srcChannelUsed[256];
@@ -92,4 +149,5 @@ void azaChannelMatrixGenerateRoutingFromLayouts(azaChannelMatrix *data, azaChann
 			data->matrix[data->outputs * srcC + list[1].dstC] = 1.0f - ((float)list[1].dist / totalDist);
 		}
 	}
+	azaChannelMatrixClassify(data);
 }
@@ -14,9 +14,36 @@ extern "C" {
 
 
 
+// What shape the nonzero values in an azaChannelMatrix take, so mixing can use a cheaper kernel than a dense matrix multiply
+typedef enum azaChannelMatrixKind {
+	// Every output is a weighted sum of every input. This is always correct, so it's what we assume until azaChannelMatrixClassify says otherwise.
+	AZA_CHANNEL_MATRIX_DENSE=0,
+	// At most half of the values are nonzero, so we only visit those.
+	AZA_CHANNEL_MATRIX_SPARSE,
+	// Every output takes at most one input, scaled by some gain.
+	AZA_CHANNEL_MATRIX_PERMUTATION,
+	// Same number of inputs and outputs, and every output takes only the input with the same index, scaled by some gain.
+	AZA_CHANNEL_MATRIX_DIAGONAL,
+	// Every output takes only the input with the same index, unscaled, so mixing is the same as azaBufferMix.
+	AZA_CHANNEL_MATRIX_IDENTITY,
+} azaChannelMatrixKind;
+
+// One nonzero value in an azaChannelMatrix
+typedef struct azaChannelMatrixEntry {
+	uint8_t input, output;
+	aza_byte _reserved[2];
+	float gain;
+} azaChannelMatrixEntry;
+
 typedef struct azaChannelMatrix {
 	uint8_t inputs, outputs;
+	// Number of entries, which is only valid if kind is not AZA_CHANNEL_MATRIX_DENSE
+	uint16_t entryCount;
+	azaChannelMatrixKind kind;
+	// Column-major, where matrix[input * outputs + output] is how much of input goes into output
 	float *matrix;
+	// Every nonzero value in matrix, ordered by output and then input. Shares an allocation with matrix.
+	azaChannelMatrixEntry *entries;
 } azaChannelMatrix;
 
 // allocates the matrix initialized to all zeroes
@@ -24,8 +51,13 @@ typedef struct azaChannelMatrix {
 int azaChannelMatrixInit(azaChannelMatrix *data, uint8_t inputs, uint8_t outputs);
 void azaChannelMatrixDeinit(azaChannelMatrix *data);
 
+// Determines kind and fills entries from the values in matrix.
+// Call this whenever you change the values in matrix yourself, or else they'll be mixed as AZA_CHANNEL_MATRIX_DENSE (which is correct, just slower), or with the old kind if it was classified before (which is wrong).
+void azaChannelMatrixClassify(azaChannelMatrix *data);
+
 // Expects data to have been initted with srcLayout.count cols and dstLayout.count rows
 // Also assumes the existing values in the matrix are all zero (won't set to zero if they're not)
+// Calls azaChannelMatrixClassify for you.
 void azaChannelMatrixGenerateRoutingFromLayouts(azaChannelMatrix *data, azaChannelLayout srcLayout, azaChannelLayout dstLayout);
 
 
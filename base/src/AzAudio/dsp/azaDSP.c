@@ -7,6 +7,7 @@
 
 #include "../AzAudio.h"
 #include "../error.h"
+#include "../mixer.h"
 
 #include "plugins/azaCubicLimiter.h"
 #include "plugins/azaLookaheadLimiter.h"
@@ -16,6 +17,7 @@
 #include "plugins/azaGate.h"
 #include "plugins/azaDelay.h"
 #include "plugins/azaReverb.h"
+#include "plugins/azaConvolutionReverb.h"
 #include "plugins/azaSampler.h"
 #include "plugins/azaRMS.h"
 #include "plugins/azaSpatialize.h"
@@ -27,16 +29,24 @@ void azaDSPSpecsCombineSerial(azaDSPSpecs *dst, azaDSPSpecs *src) {
 	dst->latencyFrames += src->latencyFrames + src->trailingFrames;
 	dst->leadingFrames = AZA_MAX(dst->leadingFrames, src->leadingFrames);
 	dst->trailingFrames = AZA_MAX(dst->trailingFrames, src->trailingFrames);
+	dst->tailFrames += src->tailFrames + src->leadingFrames;
+	dst->skipOnSilence = dst->skipOnSilence && src->skipOnSilence;
 }
 
 void azaDSPSpecsCombineParallel(azaDSPSpecs *dst, azaDSPSpecs *src) {
 	dst->latencyFrames = AZA_MAX(dst->latencyFrames, src->latencyFrames);
 	dst->leadingFrames = AZA_MAX(dst->leadingFrames, src->leadingFrames);
 	dst->trailingFrames = AZA_MAX(dst->trailingFrames, src->trailingFrames);
+	dst->tailFrames = AZA_MAX(dst->tailFrames, src->tailFrames);
+	dst->skipOnSilence = dst->skipOnSilence && src->skipOnSilence;
 }
 
 azaDSPSpecs azaDSPGetSpecs(azaDSP *dsp, uint32_t samplerate) {
-	if (!dsp->header.bypass && dsp->pFuncs->fp_getSpecs) {
+	if (dsp->header.bypass) {
+		// We pass src straight through
+		return (azaDSPSpecs) { .skipOnSilence = true };
+	}
+	if (dsp->pFuncs->fp_getSpecs) {
 		return dsp->pFuncs->fp_getSpecs(dsp, samplerate);
 	}
 	return (azaDSPSpecs) {0};
@@ -258,7 +268,8 @@ void azaDSPChainRemoveIndex(azaDSPChain *data, uint32_t index) {
 
 
 azaDSPSpecs azaDSPChainGetSpecs(azaDSPChain *dsp, uint32_t samplerate) {
-	azaDSPSpecs result = {0};
+	// An empty chain passes silence through
+	azaDSPSpecs result = { .skipOnSilence = true };
 	for (uint32_t i = 0; i < dsp->steps.count; i++) {
 		azaDSPSpecs specs = azaDSPGetSpecs(dsp->steps.data[i].dsp, samplerate);
 		azaDSPSpecsCombineSerial(&result, &specs);
@@ -266,6 +277,34 @@ azaDSPSpecs azaDSPChainGetSpecs(azaDSPChain *dsp, uint32_t samplerate) {
 	return result;
 }
 
+azaDSPSpecs azaDSPChainGetSpecsCached(azaDSPChain *data) {
+	azaDSPSpecs result = { .skipOnSilence = true };
+	for (uint32_t i = 0; i < data->steps.count; i++) {
+		azaDSPSpecsCombineSerial(&result, &data->steps.data[i].specs);
+	}
+	return result;
+}
+
+
+
+uint32_t azaDSPChainGetHistoryFrames(azaDSPChain *data, uint32_t samplerate) {
+	uint32_t result = 0;
+	for (uint32_t i = 0; i < data->steps.count; i++) {
+		azaDSPSpecs specs = azaDSPGetSpecs(data->steps.data[i].dsp, samplerate);
+		result = AZA_MAX(result, specs.leadingFrames + specs.trailingFrames);
+	}
+	return result;
+}
+
+uint32_t azaDSPChainGetHistoryFramesCached(azaDSPChain *data) {
+	uint32_t result = 0;
+	for (uint32_t i = 0; i < data->steps.count; i++) {
+		azaDSPSpecs *specs = &data->steps.data[i].specs;
+		result = AZA_MAX(result, specs->leadingFrames + specs->trailingFrames);
+	}
+	return result;
+}
+
 
 
 int azaDSPChainUpdate(azaDSPChain *data, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
@@ -291,7 +330,7 @@ int azaDSPChainUpdate(azaDSPChain *data, azaBuffer *dst, azaBuffer *src, uint32_
 	pSrc = src;
 	for (uint32_t i = 0; i < data->steps.count; i++) {
 		azaDSPChainStep *step = &data->steps.data[i];
-		uint32_t numSamples = (step->specs.leadingFrames + step->specs.trailingFrames) * pSrc->channelLayout.count;
+		uint32_t numSamples = (specs[i].leadingFrames + specs[i].trailingFrames) * pSrc->channelLayout.count;
 		if (step->bufferOffset != data->buffer.count || step->specs.leadingFrames != specs[i].leadingFrames || step->specs.trailingFrames != specs[i].trailingFrames) {
 			// TODO: We almost definitely want to keep as much data as possible instead of just zeroing it out. I believe this is causing live changes in latency to become silent. Maybe we should disallow such continuous latency changes, but at the very least we can do better.
 			// Should also capture when bufferOffset is AZA_DSP_CHAIN_BUFFER_OFFSET_UNINITIALIZED
@@ -306,45 +345,82 @@ int azaDSPChainUpdate(azaDSPChain *data, azaBuffer *dst, azaBuffer *src, uint32_
 	return AZA_SUCCESS;
 }
 
+// Whether src has been silent for long enough that step can only output silence
+static bool azaDSPChainStepCanSkip(azaDSPChainStep *step, azaBuffer *src) {
+	if (!src->silent || !step->specs.skipOnSilence) return false;
+	// Keep meters moving for the GUI
+	if (azaMixerGUIDSPIsSelected(step->dsp)) return false;
+	// framesSilent includes this block, and the silence has to have started far enough back that nothing we output this block could be affected by the sound before it.
+	uint64_t framesNeeded = (uint64_t)step->specs.latencyFrames + step->specs.tailFrames + step->specs.leadingFrames + step->specs.trailingFrames + src->frames;
+	return step->framesSilent >= framesNeeded;
+}
+
 // |llll|mmmmmmmm|tttt|
 // |bbbb|bbbbmmmm|mmmm|
 
-int azaDSPChainProcessWithHandler(azaDSPChain *data, azaBuffer *dst, azaBuffer *src, uint32_t flags, fp_azaDSPChainProcess_OnPluginError fp_OnPluginError, void *userdata) {
+// Runs every step on one block. Expects azaDSPChainUpdate to have been called already.
+static void azaDSPChainProcessBlock(azaDSPChain *data, azaBuffer *dst, azaBuffer *src, uint32_t flags, fp_azaDSPChainProcess_OnPluginError fp_OnPluginError, void *userdata) {
 	int err;
-	err = azaDSPChainUpdate(data, dst, src, flags);
-	if AZA_UNLIKELY(err) return err;
 	for (uint32_t i = 0; i < data->steps.count; i++) {
 		azaDSPChainStep *step = &data->steps.data[i];
 		if (step->dsp->processMetadata.error || step->dsp->header.bypass) {
 			continue; // Don't change src to dst
 		}
-		if (src->leadingFrames < step->specs.leadingFrames) {
-			AZA_LOG_ERR("Error(%s): For step %u (%s) src.leadingFrames (%u) < specs.leadingFrames(%u)\n", AZA_FUNCTION_NAME, i, step->dsp->guiMetadata.name, src->leadingFrames, step->specs.leadingFrames);
-			step->dsp->processMetadata.error = AZA_ERROR_INVALID_FRAME_COUNT;
-			goto next;
-		}
-		if (src->trailingFrames < step->specs.trailingFrames) {
-			AZA_LOG_ERR("Error(%s): For step %u (%s) src.trailingFrames (%u) < specs.trailingFrames(%u)\n", AZA_FUNCTION_NAME, i, step->dsp->guiMetadata.name, src->trailingFrames, step->specs.trailingFrames);
-			step->dsp->processMetadata.error = AZA_ERROR_INVALID_FRAME_COUNT;
-			goto next;
+		if (src->silent) {
+			step->framesSilent = (uint32_t)AZA_MIN((uint64_t)step->framesSilent + src->frames, UINT32_MAX);
+		} else {
+			step->framesSilent = 0;
 		}
-		if (step->specs.trailingFrames) {
+		uint32_t historyFrames = step->specs.leadingFrames + step->specs.trailingFrames;
+		azaBuffer limitedSrc;
+		if (src->leadingFrames >= historyFrames) {
+			limitedSrc = azaBufferSliceEx(src, 0, src->frames, 0, 0);
+			if (historyFrames) {
+				// Put our history right before the block, and give the plugin a view that starts trailingFrames early, such that the end of the block becomes its trailing frames. Nothing in the block has to move.
+				size_t historySamples = src->channelLayout.count * historyFrames;
+				size_t srcSamples = src->channelLayout.count * src->frames;
+				float *history = data->buffer.data + step->bufferOffset;
+				memcpy(src->pSamples - historySamples, history, sizeof(*src->pSamples) * historySamples);
+				memcpy(history, src->pSamples + srcSamples - historySamples, sizeof(*src->pSamples) * historySamples);
+				limitedSrc.pSamples -= src->channelLayout.count * step->specs.trailingFrames;
+				limitedSrc.leadingFrames = step->specs.leadingFrames;
+				limitedSrc.trailingFrames = step->specs.trailingFrames;
+			}
+		} else {
+			// Not enough room before the block for the whole history, so move the block forward to make room for the trailing frames after it instead.
+			if (src->leadingFrames < step->specs.leadingFrames) {
+				AZA_LOG_ERR("Error(%s): For step %u (%s) src.leadingFrames (%u) < specs.leadingFrames(%u)\n", AZA_FUNCTION_NAME, i, step->dsp->guiMetadata.name, src->leadingFrames, step->specs.leadingFrames);
+				step->dsp->processMetadata.error = AZA_ERROR_INVALID_FRAME_COUNT;
+				goto next;
+			}
+			if (src->trailingFrames < step->specs.trailingFrames) {
+				AZA_LOG_ERR("Error(%s): For step %u (%s) src.trailingFrames (%u) < specs.trailingFrames(%u)\n", AZA_FUNCTION_NAME, i, step->dsp->guiMetadata.name, src->trailingFrames, step->specs.trailingFrames);
+				step->dsp->processMetadata.error = AZA_ERROR_INVALID_FRAME_COUNT;
+				goto next;
+			}
 			// Move existing buffer forward by trailing frames
 			size_t trailingSamples = src->channelLayout.count * step->specs.trailingFrames;
 			size_t samples = src->channelLayout.count * src->frames;
 			memmove(src->pSamples + trailingSamples, src->pSamples, sizeof(*src->pSamples) * samples);
-		}
-		size_t bufferFrames = step->specs.trailingFrames + step->specs.leadingFrames;
-		if (bufferFrames) {
 			// Copy last iteration's buffer to beginning of src, and get next iteration's buffer out of src
 			size_t leadingSamples = src->channelLayout.count * step->specs.leadingFrames;
-			size_t bufferSamples = src->channelLayout.count * bufferFrames;
+			size_t bufferSamples = src->channelLayout.count * historyFrames;
 			size_t srcSamples = src->channelLayout.count * src->frames;
 			float *buffer = data->buffer.data + step->bufferOffset;
 			memcpy(src->pSamples - leadingSamples, buffer, sizeof(*src->pSamples) * bufferSamples);
 			memcpy(buffer, src->pSamples + srcSamples - leadingSamples, sizeof(*src->pSamples) * bufferSamples);
+			limitedSrc = azaBufferSliceEx(src, 0, src->frames, step->specs.leadingFrames, step->specs.trailingFrames);
 		}
-		azaBuffer limitedSrc = azaBufferSliceEx(src, 0, src->frames, step->specs.leadingFrames, step->specs.trailingFrames);
+		if (azaDSPChainStepCanSkip(step, src)) {
+			if (dst->pSamples != src->pSamples) {
+				azaBuffer dstBody = azaBufferSliceEx(dst, 0, dst->frames, 0, 0);
+				azaBufferZero(&dstBody);
+			}
+			dst->silent = true;
+			goto next;
+		}
+		// limitedSrc keeps the flag even if dst and src are the same buffer
+		dst->silent = false;
 		err = azaDSPProcess(step->dsp, dst, &limitedSrc, flags);
 		if AZA_UNLIKELY(err) {
 			step->dsp->processMetadata.error = err;
@@ -355,6 +431,71 @@ int azaDSPChainProcessWithHandler(azaDSPChain *data, azaBuffer *dst, azaBuffer *
 	next:
 		src = dst; // Only the first one can be transitive, because the first one puts the result in dst, so process only dst from here on out.
 	}
+}
+
+// Runs the whole chain on at most data->maxBlockFrames at a time.
+// Sub-blocks can't be processed in place in dst and src, because every step writes its history into the leading frames before the block, which would be the previous sub-block. Instead, each sub-block gets copied into a side buffer with room for those, and the result gets copied back out.
+static int azaDSPChainProcessSubBlocks(azaDSPChain *data, azaBuffer *dst, azaBuffer *src, uint32_t flags, fp_azaDSPChainProcess_OnPluginError fp_OnPluginError, void *userdata) {
+	assert(dst->frames == src->frames);
+	// Enough room for every step's history to go before the block, so we never need trailing frames
+	uint32_t leadingFrames = 0;
+	uint32_t trailingFrames = 0;
+	for (uint32_t i = 0; i < data->steps.count; i++) {
+		leadingFrames = AZA_MAX(leadingFrames, data->steps.data[i].specs.leadingFrames + data->steps.data[i].specs.trailingFrames);
+	}
+	uint32_t blockFrames = data->maxBlockFrames;
+	// The common case (and the only one azaMixer uses) is processing a buffer in place, which only needs the one side buffer.
+	bool inPlace = dst->pSamples == src->pSamples && dst->stride == src->stride && dst->channelLayout.count == src->channelLayout.count;
+	azaBuffer dstBlock = azaPushSideBuffer(blockFrames, leadingFrames, trailingFrames, dst->channelLayout.count, dst->samplerate);
+	dstBlock.channelLayout = dst->channelLayout;
+	azaBuffer srcBlock = dstBlock;
+	if (!inPlace) {
+		srcBlock = azaPushSideBuffer(blockFrames, leadingFrames, trailingFrames, src->channelLayout.count, src->samplerate);
+		srcBlock.channelLayout = src->channelLayout;
+	}
+	if AZA_UNLIKELY(!dstBlock.pSamples || !srcBlock.pSamples) {
+		azaPopSideBuffers(inPlace ? 1 : 2);
+		return AZA_ERROR_OUT_OF_MEMORY;
+	}
+	bool silent = true;
+	for (uint32_t frame = 0; frame < dst->frames; frame += blockFrames) {
+		uint32_t frames = AZA_MIN(blockFrames, dst->frames - frame);
+		azaBuffer dstBody = azaBufferSliceEx(dst, frame, frames, 0, 0);
+		azaBuffer srcBody = azaBufferSliceEx(src, frame, frames, 0, 0);
+		azaBuffer dstSub = azaBufferSliceEx(&dstBlock, 0, frames, leadingFrames, trailingFrames);
+		azaBuffer dstSubBody = azaBufferSliceEx(&dstBlock, 0, frames, 0, 0);
+		if (inPlace) {
+			azaBufferCopy(&dstSubBody, &srcBody);
+			dstSub.silent = src->silent;
+			azaDSPChainProcessBlock(data, &dstSub, &dstSub, frame == 0 ? flags : (flags & ~AZA_DSP_PROCESS_FLAG_CUT), fp_OnPluginError, userdata);
+		} else {
+			azaBuffer srcSub = azaBufferSliceEx(&srcBlock, 0, frames, leadingFrames, trailingFrames);
+			azaBuffer srcSubBody = azaBufferSliceEx(&srcBlock, 0, frames, 0, 0);
+			azaBufferCopy(&srcSubBody, &srcBody);
+			srcSub.silent = src->silent;
+			// If every step is bypassed, dst is left as it was
+			azaBufferCopy(&dstSubBody, &dstBody);
+			dstSub.silent = dst->silent;
+			azaDSPChainProcessBlock(data, &dstSub, &srcSub, frame == 0 ? flags : (flags & ~AZA_DSP_PROCESS_FLAG_CUT), fp_OnPluginError, userdata);
+		}
+		azaBufferCopy(&dstBody, &dstSubBody);
+		silent = silent && dstSub.silent;
+	}
+	dst->silent = silent;
+	azaPopSideBuffers(inPlace ? 1 : 2);
+	return AZA_SUCCESS;
+}
+
+int azaDSPChainProcessWithHandler(azaDSPChain *data, azaBuffer *dst, azaBuffer *src, uint32_t flags, fp_azaDSPChainProcess_OnPluginError fp_OnPluginError, void *userdata) {
+	int err;
+	err = azaDSPChainUpdate(data, dst, src, flags);
+	if AZA_UNLIKELY(err) return err;
+	if (data->maxBlockFrames && dst->frames > data->maxBlockFrames) {
+		err = azaDSPChainProcessSubBlocks(data, dst, src, flags, fp_OnPluginError, userdata);
+		if AZA_UNLIKELY(err) return err;
+	} else {
+		azaDSPChainProcessBlock(data, dst, src, flags, fp_OnPluginError, userdata);
+	}
 	return AZA_SUCCESS;
 }
 
@@ -373,6 +514,7 @@ int azaDSPRegistryInit() {
 	azaDSPAddRegEntry(azaDelayHeader);
 	azaDSPAddRegEntry(azaDelayDynamicHeader);
 	azaDSPAddRegEntry(azaReverbHeader);
+	azaDSPAddRegEntry(azaConvolutionReverbHeader);
 	azaDSPAddRegEntry(azaSamplerHeader);
 	azaDSPAddRegEntry(azaRMSHeader);
 	azaDSPAddRegEntry(azaSpatializeHeader);
@@ -32,6 +32,12 @@ typedef struct azaDSPSpecs {
 	uint32_t leadingFrames;
 	// How many src trailing frames are desired for processing. Used for kernel sampling.
 	uint32_t trailingFrames;
+	// How many frames of output may still follow once src goes silent, not counting latencyFrames. Used for things like delay lines and reverb tails. Only meaningful if skipOnSilence is true.
+	uint32_t tailFrames;
+	// If true, our output is guaranteed to be silent once src has been silent for latencyFrames + tailFrames (plus leading and trailing frames), so azaDSPChain can skip processing us entirely until src makes sound again.
+	// Leave this false if we make sound on our own (synths, samplers), or if we must see every block for any other reason.
+	bool skipOnSilence;
+	aza_byte _reserved[3];
 } azaDSPSpecs;
 
 // Combines specs for plugins that run in series (where one's output gets fed into the next one's input)
@@ -48,7 +54,7 @@ enum {
 // dsp is a pointer to the azaDSP derivative that contains all the metadata and configuration
 // dst is the buffer to be written to during processing
 // src is a buffer that acts as an input for processing
-// The data in dst and src are allowed to overlap (they may even be the exact same buffer), so reading from src must happen before writing to dst (may want to copy src to a sideBuffer).
+// The data in dst and src are allowed to overlap (they may even be the exact same buffer), so reading from src must happen before writing to dst (may want to copy src to a sideBuffer). Within azaDSPChain, if we have trailingFrames, src starts that many frames before dst in the same memory, so writing dst[i] overwrites src[i + trailingFrames].
 // flags enable the ability for process to handle a handful of events relevant to config and plugin chain changes
 // may return error codes depending on the kind of plugin
 typedef int (*fp_azaDSPProcess_t)(void *data, azaBuffer *dst, azaBuffer *src, uint32_t flags);
@@ -126,6 +132,8 @@ typedef struct azaDSPChainStep {
 	azaDSP *dsp;
 	uint32_t bufferOffset;
 	azaDSPSpecs specs;
+	// How many frames in a row our src has been silent, saturating at UINT32_MAX.
+	uint32_t framesSilent;
 } azaDSPChainStep;
 
 static const uint32_t AZA_DSP_CHAIN_BUFFER_OFFSET_UNINITIALIZED = 0xFFFFFFFF;
@@ -141,8 +149,14 @@ typedef struct azaDSPChain {
 		uint32_t count;
 		uint32_t capacity;
 	} buffer;
+	// If nonzero, blocks longer than this get processed through the whole chain this many frames at a time, such that the working set stays in cache from one plugin to the next. 0 processes whole blocks at once.
+	// Each sub-block goes through a side buffer with room for the chain's leading and trailing frames, so this costs one extra copy in and out per sub-block.
+	uint32_t maxBlockFrames;
 } azaDSPChain;
 
+// A reasonable value for azaDSPChain.maxBlockFrames. Small enough that a stereo block and the plugins' side buffers sit comfortably in L1.
+#define AZA_DSP_CHAIN_DEFAULT_MAX_BLOCK_FRAMES 128
+
 // Initialize with a given number of steps to allocate.
 // NOTE: Zeroes out the whole struct at the start.
 // May return AZA_ERROR_OUT_OF_MEMORY, but only if stepsToReserve > 0
@@ -175,6 +189,17 @@ void azaDSPChainRemoveIndex(azaDSPChain *data, uint32_t index);
 // returns the combined azaDSPSpecs of the entire plugin chain.
 azaDSPSpecs azaDSPChainGetSpecs(azaDSPChain *data, uint32_t samplerate);
 
+// returns the combined azaDSPSpecs of the entire plugin chain as they were at the last azaDSPChainUpdate (which azaDSPChainProcess calls for you), without asking any of the plugins.
+// Plugins that haven't been through an update yet count as zeroed-out specs.
+azaDSPSpecs azaDSPChainGetSpecsCached(azaDSPChain *data);
+
+// returns how many leading frames src needs for every step to get its leadingFrames and trailingFrames without moving the block, which is the largest leadingFrames + trailingFrames of any step.
+// Buffers with fewer leading frames than this still work, so long as they have the leadingFrames and trailingFrames from azaDSPChainGetSpecs, but each step that needs trailing frames has to move the whole block forward to make room for them.
+uint32_t azaDSPChainGetHistoryFrames(azaDSPChain *data, uint32_t samplerate);
+
+// Same as azaDSPChainGetHistoryFrames, but using the specs cached by the last azaDSPChainUpdate (see azaDSPChainGetSpecsCached)
+uint32_t azaDSPChainGetHistoryFramesCached(azaDSPChain *data);
+
 // Handles changes in azaDSPSpecs, moving buffer space around as needed.
 // This gets called by azaDSPChainProcess automatically, but doing it manually on setup can reduce the workload during processing.
 // May return AZA_ERROR_OUT_OF_MEMORY
@@ -184,6 +209,9 @@ typedef void (*fp_azaDSPChainProcess_OnPluginError)(azaDSP *dsp, void *userdata)
 
 // Process the DSP chain with the given buffers.
 // Calls azaDSPChainUpdate internally, so if config changes you don't need to do anything.
+// Give src at least azaDSPChainGetHistoryFrames leading frames, and no step has to move the block around to see its leading and trailing frames.
+// If data->maxBlockFrames is nonzero, the whole chain runs on sub-blocks of at most that many frames, one after the other. Plugins see the same thing as if you had called this once per sub-block.
+// Plugins that report skipOnSilence in their specs aren't processed once src has been silent long enough (see azaBuffer.silent), unless they're selected in the mixer GUI so their meters keep moving. dst->silent is cleared before each plugin is processed, and plugins that know their output is silent may set it again.
 // If a plugin has an error, we don't error out of the whole chain. Instead, we set the error field in the plugin header, and call fp_OnPluginError, which gets the dsp that had an error and your passed in userdata pointer. This function shouldn't change anything about the plugin chain, as it's in the middle of processing and will continue afterwards.
 // fp_OnPluginError can be NULL
 // May return AZA_ERROR_OUT_OF_MEMORY
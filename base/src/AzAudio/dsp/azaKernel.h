@@ -83,6 +83,16 @@ static inline void azaBufferSampleWithKernel(float *dst, int dstChannels, azaKer
 	azaSampleWithKernel(dst, dstChannels, kernel, src->pSamples, (int)src->stride, minFrame, maxFrame, wrap, frame, fraction, rate);
 }
 
+// Uses the kernel to sample up to frames consecutive frames from src into dst, which is much cheaper than calling azaSampleWithKernel for every frame.
+// dst has dstStride floats between frames, and dstChannels channels are written for each frame.
+// frame and fraction point at the sampling location of the first frame, and are updated to the location of the next frame to be sampled. fraction may be negative (down to -1) when moving backwards.
+// speeds has one entry per frame, which is how far the sampling location moves after sampling that frame. Negative speeds move backwards.
+// Sampling stops early after the first frame that moves the location to a frame <= boundStart or >= boundEnd, such that the caller can handle loop points and the ends of src. Pass INT32_MIN and INT32_MAX to never stop early.
+// Where the location sits exactly on a frame of src and the speed is exactly 1 or -1, that frame is copied as-is, since there's nothing to interpolate or alias.
+// The rest of the arguments are the same as for azaSampleWithKernel.
+// Returns how many frames were written to dst.
+uint32_t azaSampleWithKernelBlock(float *dst, int dstStride, int dstChannels, uint32_t frames, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t *frame, float *fraction, const float *speeds, int32_t boundStart, int32_t boundEnd, float rate);
+
 // How many total kernel samples have been taken as scalars (to measure SIMD efficacy)
 extern uint64_t azaKernelScalarSamples;
 // How many total kernel samples have been taken as vectors (to measure SIMD efficacy)
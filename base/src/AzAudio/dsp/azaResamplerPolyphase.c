@@ -0,0 +1,182 @@
+/*
+	File: azaResamplerPolyphase.c
+	Author: Philip Haynes
+*/
+
+#include "azaResamplerPolyphase.h"
+
+#include "../AzAudio.h"
+#include "../error.h"
+#include "../math.h"
+
+
+
+static uint32_t azaGCD(uint32_t a, uint32_t b) {
+	while (b) {
+		uint32_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+static void azaResamplerPolyphaseMakePhases(azaResamplerPolyphase *data) {
+	uint32_t L = data->upFactor;
+	uint32_t taps = data->taps;
+	// Relative to the src Nyquist frequency, scaled down when decimating so we don't alias
+	float cutoff = AZA_MIN(1.0f, (float)data->upFactor / (float)data->downFactor);
+	// Leave room for the transition band of the window below Nyquist
+	cutoff *= 1.0f - 4.0f / (float)data->config.radius;
+	float center = (float)taps / 2.0f;
+	for (uint32_t p = 0; p < L; p++) {
+		float *phase = data->phases + p * taps;
+		float sum = 0.0f;
+		for (uint32_t j = 0; j < taps; j++) {
+			// Coefficient j multiplies the src frame that's (taps-1-j) frames older than inputIndex, and the dst frame sits p/L frames after inputIndex
+			float t = (float)(taps-1-j) + (float)p / (float)L;
+			float value = cutoff * azaSincf(cutoff * (t - center)) * azaWindowBlackmanHarrisf(t / (float)taps);
+			phase[j] = value;
+			sum += value;
+		}
+		// Normalize every phase for unity gain at DC, otherwise the small differences in gain between phases become audible as a whine at the rate we cycle through them
+		for (uint32_t j = 0; j < taps; j++) {
+			phase[j] /= sum;
+		}
+	}
+}
+
+int azaResamplerPolyphaseInit(azaResamplerPolyphase *data, azaResamplerPolyphaseConfig config) {
+	*data = (azaResamplerPolyphase) {0};
+	if (config.srcSamplerate == 0 || config.dstSamplerate == 0) return AZA_ERROR_INVALID_CONFIGURATION;
+	if (config.channels == 0) return AZA_ERROR_INVALID_CHANNEL_COUNT;
+	if (config.radius == 0) config.radius = AZA_RESAMPLER_POLYPHASE_RADIUS_DEFAULT;
+	config.radius = AZA_CLAMP(config.radius, AZA_RESAMPLER_POLYPHASE_RADIUS_MIN, AZA_RESAMPLER_POLYPHASE_RADIUS_MAX);
+	data->config = config;
+	uint32_t gcd = azaGCD(config.srcSamplerate, config.dstSamplerate);
+	data->upFactor = config.dstSamplerate / gcd;
+	data->downFactor = config.srcSamplerate / gcd;
+	if (data->upFactor > AZA_RESAMPLER_POLYPHASE_MAX_PHASES) return AZA_ERROR_INVALID_CONFIGURATION;
+	// When decimating, the filter has to be longer in src frames by the same factor its cutoff is lowered
+	uint32_t taps = 2 * config.radius;
+	if (data->downFactor > data->upFactor) {
+		taps = (uint32_t)(((uint64_t)taps * data->downFactor + data->upFactor-1) / data->upFactor);
+	}
+	data->taps = (uint32_t)aza_align(taps, 8);
+	data->historyStride = (uint32_t)aza_align(data->taps - 1 + AZA_RESAMPLER_POLYPHASE_CHUNK_FRAMES, 16);
+	size_t phasesSize = (size_t)data->upFactor * data->taps * sizeof(float);
+	size_t historySize = (size_t)data->historyStride * config.channels * sizeof(float);
+	data->phases = aza_calloc(phasesSize + historySize, 1);
+	if (!data->phases) return AZA_ERROR_OUT_OF_MEMORY;
+	data->history = (float*)((char*)data->phases + phasesSize);
+	azaResamplerPolyphaseMakePhases(data);
+	azaResamplerPolyphaseReset(data);
+	return AZA_SUCCESS;
+}
+
+void azaResamplerPolyphaseDeinit(azaResamplerPolyphase *data) {
+	aza_free(data->phases);
+	data->phases = NULL;
+	data->history = NULL;
+}
+
+void azaResamplerPolyphaseReset(azaResamplerPolyphase *data) {
+	// Start with a full filter length of silence, such that the first dst frame lines up with the first src frame after the latency
+	memset(data->history, 0, (size_t)data->historyStride * data->config.channels * sizeof(float));
+	data->historyFrames = data->taps - 1;
+	data->inputIndex = data->taps - 1;
+	data->phase = 0;
+}
+
+uint32_t azaResamplerPolyphaseGetDstFrames(azaResamplerPolyphase *data, uint32_t srcFrames) {
+	// dst frame n reads history frame inputIndex + (phase + n*M) / L, which has to be before historyFrames + srcFrames
+	uint64_t available = (uint64_t)data->historyFrames + srcFrames;
+	if (available <= data->inputIndex) return 0;
+	uint64_t limit = (available - data->inputIndex) * data->upFactor - data->phase;
+	return (uint32_t)((limit + data->downFactor-1) / data->downFactor);
+}
+
+uint32_t azaResamplerPolyphaseGetSrcFrames(azaResamplerPolyphase *data, uint32_t dstFrames) {
+	if (dstFrames == 0) return 0;
+	uint64_t lastIndex = data->inputIndex + ((uint64_t)(dstFrames-1) * data->downFactor + data->phase) / data->upFactor;
+	assert(lastIndex + 1 >= data->historyFrames);
+	return (uint32_t)(lastIndex + 1 - data->historyFrames);
+}
+
+uint32_t azaResamplerPolyphaseGetLatencyFrames(azaResamplerPolyphase *data) {
+	uint64_t latency = (uint64_t)data->taps / 2 * data->upFactor;
+	return (uint32_t)((latency + data->downFactor/2) / data->downFactor);
+}
+
+int azaResamplerPolyphaseProcess(azaResamplerPolyphase *data, azaBuffer *dst, azaBuffer *src, uint32_t *dstFramesWritten) {
+	assert(data->phases);
+	uint8_t channels = data->config.channels;
+	if (src->channelLayout.count != channels || dst->channelLayout.count != channels) {
+		AZA_LOG_ERR("azaResamplerPolyphaseProcess error: Expected %u channels, but src has %u and dst has %u\n", (uint32_t)channels, (uint32_t)src->channelLayout.count, (uint32_t)dst->channelLayout.count);
+		return AZA_ERROR_MISMATCHED_CHANNEL_COUNT;
+	}
+	uint32_t dstFramesTotal = azaResamplerPolyphaseGetDstFrames(data, src->frames);
+	if (dst->frames < dstFramesTotal) {
+		AZA_LOG_ERR("azaResamplerPolyphaseProcess error: dst has %u frames, but we need %u\n", dst->frames, dstFramesTotal);
+		return AZA_ERROR_INVALID_FRAME_COUNT;
+	}
+	uint32_t quotient = data->downFactor / data->upFactor;
+	uint32_t remainder = data->downFactor % data->upFactor;
+	uint32_t dstFrame = 0;
+	uint32_t srcFrame = 0;
+	while (srcFrame < src->frames) {
+		uint32_t frames = AZA_MIN(src->frames - srcFrame, data->historyStride - data->historyFrames);
+		assert(frames > 0);
+		for (uint8_t c = 0; c < channels; c++) {
+			float *history = data->history + c * data->historyStride + data->historyFrames;
+			if (src->silent) {
+				memset(history, 0, frames * sizeof(float));
+			} else {
+				const float *srcSamples = src->pSamples + srcFrame * src->stride + c;
+				for (uint32_t i = 0; i < frames; i++) {
+					history[i] = srcSamples[i * src->stride];
+				}
+			}
+		}
+		srcFrame += frames;
+		data->historyFrames += frames;
+		// Count how many dst frames this chunk makes and where that leaves us
+		uint32_t count = 0;
+		uint32_t inputIndex = data->inputIndex;
+		uint32_t phase = data->phase;
+		while (inputIndex < data->historyFrames) {
+			count++;
+			inputIndex += quotient;
+			phase += remainder;
+			if (phase >= data->upFactor) {
+				phase -= data->upFactor;
+				inputIndex++;
+			}
+		}
+		if (count) {
+			for (uint8_t c = 0; c < channels; c++) {
+				azaResamplerPolyphaseConvolve(data, dst->pSamples + dstFrame * dst->stride + c, dst->stride, count, data->history + c * data->historyStride);
+			}
+			dstFrame += count;
+			data->inputIndex = inputIndex;
+			data->phase = phase;
+		}
+		// Drop the history we won't be looking at again
+		uint32_t keepFrom = AZA_MIN(data->inputIndex - (data->taps-1), data->historyFrames);
+		if (keepFrom) {
+			for (uint8_t c = 0; c < channels; c++) {
+				float *history = data->history + c * data->historyStride;
+				memmove(history, history + keepFrom, (data->historyFrames - keepFrom) * sizeof(float));
+			}
+			data->historyFrames -= keepFrom;
+			data->inputIndex -= keepFrom;
+		}
+	}
+	assert(dstFrame == dstFramesTotal);
+	if (dstFrame) {
+		dst->silent = false;
+	}
+	if (dstFramesWritten) {
+		*dstFramesWritten = dstFrame;
+	}
+	return AZA_SUCCESS;
+}
@@ -0,0 +1,94 @@
+/*
+	File: azaResamplerPolyphase.h
+	Author: Philip Haynes
+	Polyphase resampler for streams with a fixed rational ratio between samplerates.
+	Unlike azaBufferResample, which evaluates a kernel for every tap of every output frame, this precomputes every phase of the filter up front so each output frame is one dot product over contiguous history.
+	This is deliberately not a plugin because it changes the frame count.
+*/
+
+#ifndef AZAUDIO_AZARESAMPLERPOLYPHASE_H
+#define AZAUDIO_AZARESAMPLERPOLYPHASE_H
+
+#include "azaBuffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+// Largest number of phases (dstSamplerate / gcd(srcSamplerate, dstSamplerate)) we're willing to make a table for.
+// 44100 <-> 48000 needs 160 or 147, 11025 -> 48000 needs 640.
+#define AZA_RESAMPLER_POLYPHASE_MAX_PHASES 2048
+// How many src frames we take in at once. Bounds the size of the history buffers.
+#define AZA_RESAMPLER_POLYPHASE_CHUNK_FRAMES 512
+
+#define AZA_RESAMPLER_POLYPHASE_RADIUS_MIN 8
+#define AZA_RESAMPLER_POLYPHASE_RADIUS_MAX 256
+#define AZA_RESAMPLER_POLYPHASE_RADIUS_DEFAULT 32
+
+typedef struct azaResamplerPolyphaseConfig {
+	uint32_t srcSamplerate;
+	uint32_t dstSamplerate;
+	// This is the quality/latency knob.
+	// Number of zero crossings of the windowed sinc on each side of the center, measured at the lower of the two samplerates.
+	// Latency is radius frames at the lower samplerate, and cost per output frame scales linearly with it.
+	// The passband extends to about (1 - 4/radius) of the lower Nyquist frequency, with about 90dB of stopband attenuation.
+	// Clamped between AZA_RESAMPLER_POLYPHASE_RADIUS_MIN and AZA_RESAMPLER_POLYPHASE_RADIUS_MAX. 0 means AZA_RESAMPLER_POLYPHASE_RADIUS_DEFAULT.
+	uint32_t radius;
+	uint8_t channels;
+} azaResamplerPolyphaseConfig;
+
+typedef struct azaResamplerPolyphase {
+	azaResamplerPolyphaseConfig config;
+	// L, the interpolation factor, which is also the number of phases
+	uint32_t upFactor;
+	// M, the decimation factor
+	uint32_t downFactor;
+	// Filter length per phase in src frames, always a multiple of 8 so the dot products fill whole vectors.
+	uint32_t taps;
+	// upFactor phases of taps coefficients each. Coefficients are stored in reverse order so they line up with the history going forward in time.
+	float *phases;
+	// Deinterlaced history of src, with historyStride floats per channel.
+	float *history;
+	uint32_t historyStride;
+	// How many frames of history are valid for each channel.
+	uint32_t historyFrames;
+	// The newest frame in history that the next dst frame depends on.
+	uint32_t inputIndex;
+	// Which phase the next dst frame uses.
+	uint32_t phase;
+} azaResamplerPolyphase;
+
+// initializes azaResamplerPolyphase in existing memory
+// May return AZA_ERROR_OUT_OF_MEMORY, AZA_ERROR_INVALID_CHANNEL_COUNT, or AZA_ERROR_INVALID_CONFIGURATION if either samplerate is 0 or the ratio between them needs more than AZA_RESAMPLER_POLYPHASE_MAX_PHASES phases
+int azaResamplerPolyphaseInit(azaResamplerPolyphase *data, azaResamplerPolyphaseConfig config);
+// frees any additional memory that the azaResamplerPolyphase may have allocated
+void azaResamplerPolyphaseDeinit(azaResamplerPolyphase *data);
+// Clears the history so the next call to azaResamplerPolyphaseProcess starts a new stream
+void azaResamplerPolyphaseReset(azaResamplerPolyphase *data);
+
+// Returns exactly how many frames the next call to azaResamplerPolyphaseProcess will write given srcFrames of input.
+// This depends on the streaming state, so it can vary by one frame between calls with the same srcFrames.
+uint32_t azaResamplerPolyphaseGetDstFrames(azaResamplerPolyphase *data, uint32_t srcFrames);
+// Returns the minimum number of src frames the next call to azaResamplerPolyphaseProcess needs to write at least dstFrames frames. Useful for pulling from a stream.
+uint32_t azaResamplerPolyphaseGetSrcFrames(azaResamplerPolyphase *data, uint32_t dstFrames);
+// Returns the group delay in dst frames, rounded to the nearest frame
+uint32_t azaResamplerPolyphaseGetLatencyFrames(azaResamplerPolyphase *data);
+
+// Resamples all of src and writes the result to the beginning of dst. The number of frames written is put into dstFramesWritten, which may be NULL.
+// dst must have at least azaResamplerPolyphaseGetDstFrames(data, src->frames) frames.
+// May return AZA_ERROR_MISMATCHED_CHANNEL_COUNT or AZA_ERROR_INVALID_FRAME_COUNT
+int azaResamplerPolyphaseProcess(azaResamplerPolyphase *data, azaBuffer *dst, azaBuffer *src, uint32_t *dstFramesWritten);
+
+// Implemented in specialized/azaResamplerPolyphase.c
+// Writes dstFrames frames of one channel into dst starting from the current inputIndex and phase, without updating them. history points at the channel's history.
+void azaResamplerPolyphaseConvolve(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AZAUDIO_AZARESAMPLERPOLYPHASE_H
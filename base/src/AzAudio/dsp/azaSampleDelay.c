@@ -20,6 +20,26 @@ void azaSampleDelayDeinit(azaSampleDelay *data) {
 }
 
 static int azaSampleDelayHandleBufferResizes(azaSampleDelay *data, azaChannelLayout layout) {
+	if (data->buffer.frames == data->config.delayFrames && data->buffer.channelLayout.count == layout.count) {
+		return AZA_SUCCESS;
+	}
+	if (data->index && data->buffer.frames) {
+		// Rotate the ring so the oldest frame is first, such that azaBufferResize keeps the delayed signal in order
+		azaBuffer copy = azaPushSideBufferCopy(&data->buffer);
+		if AZA_UNLIKELY(!copy.pSamples) {
+			azaPopSideBuffer();
+			return AZA_ERROR_OUT_OF_MEMORY;
+		}
+		uint32_t framesAfterIndex = data->buffer.frames - data->index;
+		azaBuffer dstStart = azaBufferSliceEx(&data->buffer, 0, framesAfterIndex, 0, 0);
+		azaBuffer srcStart = azaBufferSliceEx(&copy, data->index, framesAfterIndex, 0, 0);
+		azaBufferCopy(&dstStart, &srcStart);
+		azaBuffer dstEnd = azaBufferSliceEx(&data->buffer, framesAfterIndex, data->index, 0, 0);
+		azaBuffer srcEnd = azaBufferSliceEx(&copy, 0, data->index, 0, 0);
+		azaBufferCopy(&dstEnd, &srcEnd);
+		azaPopSideBuffer();
+	}
+	data->index = 0;
 	return azaBufferResize(&data->buffer, data->config.delayFrames, 0, 0, layout);
 }
 
@@ -38,35 +58,92 @@ int azaSampleDelayProcess(azaSampleDelay *data, azaBuffer *dst, azaBuffer *src,
 	err = azaSampleDelayHandleBufferResizes(data, dst->channelLayout);
 	if AZA_UNLIKELY(err) return err;
 
-	uint8_t numSideBuffers = 0;
-	azaBuffer sideBuffer;
-	if (dst->pSamples == src->pSamples) {
-		sideBuffer = azaPushSideBufferCopy(src);
-		numSideBuffers++;
-		src = &sideBuffer;
+	const uint8_t channels = dst->channelLayout.count;
+	// Reading each input sample before writing the output means this works in-place
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		float *ringFrame = data->buffer.pSamples + data->index * data->buffer.stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		for (uint8_t c = 0; c < channels; c++) {
+			float sample = srcFrame[c];
+			dstFrame[c] = ringFrame[c];
+			ringFrame[c] = sample;
+		}
+		if (++data->index == data->buffer.frames) data->index = 0;
 	}
+	// Sound may have come out of the delay line
+	dst->silent = false;
+	return err;
+}
 
-	uint32_t carryFrames = AZA_MIN(data->buffer.frames, dst->frames);
-	uint32_t preserveFrames = data->buffer.frames - carryFrames;
-	uint32_t bodyFrames = dst->frames - carryFrames;
-
-	azaBuffer srcCarry = azaBufferSliceEx(&data->buffer, 0, carryFrames, 0, 0);
-	azaBuffer dstCarry = azaBufferSliceEx(dst, 0, carryFrames, 0, 0);
-	azaBufferCopy(&dstCarry, &srcCarry);
-	if (preserveFrames) {
-		memmove(data->buffer.pSamples, data->buffer.pSamples + carryFrames * data->buffer.stride, sizeof(*data->buffer.pSamples) * preserveFrames * data->buffer.stride);
+int azaSampleDelayMixMatrix(azaSampleDelay *data, azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc, azaChannelMatrix *matrix) {
+	assert(matrix);
+	assert(matrix->inputs == src->channelLayout.count);
+	assert(matrix->outputs == dst->channelLayout.count);
+	assert(dst->frames == src->frames);
+	const uint32_t delayFrames = data->config.delayFrames;
+	if (delayFrames) {
+		int err = azaSampleDelayHandleBufferResizes(data, dst->channelLayout);
+		if AZA_UNLIKELY(err) return err;
 	}
-	srcCarry = azaBufferSliceEx(src, bodyFrames, carryFrames, 0, 0);
-	dstCarry = azaBufferSliceEx(&data->buffer, preserveFrames, carryFrames, 0, 0);
-	azaBufferCopy(&dstCarry, &srcCarry);
-	if (bodyFrames) {
-		azaBuffer srcBody = azaBufferSliceEx(src, 0, bodyFrames, 0, 0);
-		azaBuffer dstBody = azaBufferSliceEx(dst, carryFrames, bodyFrames, 0, 0);
-		azaBufferCopy(&dstBody, &srcBody);
+	const bool srcAudible = !src->silent && volumeSrc != 0.0f;
+	if (volumeDst == 1.0f && !srcAudible && delayFrames == 0) {
+		return AZA_SUCCESS;
 	}
-
-	azaPopSideBuffers(numSideBuffers);
-	return err;
+	azaBufferMixSilence(dst, volumeDst != 0.0f, src, srcAudible || delayFrames != 0);
+	const uint8_t inputs = matrix->inputs;
+	const uint8_t outputs = matrix->outputs;
+	const bool overwrite = volumeDst == 0.0f;
+	// Classified matrices only need their nonzero entries
+	const bool dense = matrix->kind == AZA_CHANNEL_MATRIX_DENSE;
+	// src channel count columns, dst channel count rows, with volumeSrc baked in
+	// If we're not dense, this is instead the gain of each entry.
+	float matPremult[AZA_MAX_CHANNEL_POSITIONS * AZA_MAX_CHANNEL_POSITIONS];
+	if (dense) {
+		for (uint8_t c = 0; c < inputs; c++) {
+			for (uint8_t r = 0; r < outputs; r++) {
+				matPremult[r * inputs + c] = volumeSrc * matrix->matrix[c * outputs + r];
+			}
+		}
+	} else {
+		for (uint16_t e = 0; e < matrix->entryCount; e++) {
+			matPremult[e] = volumeSrc * matrix->entries[e].gain;
+		}
+	}
+	float mixed[AZA_MAX_CHANNEL_POSITIONS] = {0};
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		if (srcAudible && !dense) {
+			float *srcFrame = src->pSamples + i * src->stride;
+			for (uint8_t r = 0; r < outputs; r++) {
+				mixed[r] = 0.0f;
+			}
+			for (uint16_t e = 0; e < matrix->entryCount; e++) {
+				mixed[matrix->entries[e].output] += srcFrame[matrix->entries[e].input] * matPremult[e];
+			}
+		} else if (srcAudible) {
+			float *srcFrame = src->pSamples + i * src->stride;
+			for (uint8_t r = 0; r < outputs; r++) {
+				float *row = matPremult + r * inputs;
+				float accum = 0.0f;
+				for (uint8_t c = 0; c < inputs; c++) {
+					accum += srcFrame[c] * row[c];
+				}
+				mixed[r] = accum;
+			}
+		}
+		if (delayFrames) {
+			float *ringFrame = data->buffer.pSamples + data->index * data->buffer.stride;
+			for (uint8_t r = 0; r < outputs; r++) {
+				dstFrame[r] = (overwrite ? 0.0f : dstFrame[r] * volumeDst) + ringFrame[r];
+				ringFrame[r] = mixed[r];
+			}
+			if (++data->index == delayFrames) data->index = 0;
+		} else {
+			for (uint8_t r = 0; r < outputs; r++) {
+				dstFrame[r] = (overwrite ? 0.0f : dstFrame[r] * volumeDst) + mixed[r];
+			}
+		}
+	}
+	return AZA_SUCCESS;
 }
-
-
@@ -10,6 +10,7 @@
 
 // #include "../aza_c_std.h"
 #include "azaBuffer.h"
+#include "azaChannelMatrix.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,7 +24,10 @@ typedef struct azaSampleDelayConfig {
 
 typedef struct azaSampleDelay {
 	azaSampleDelayConfig config;
+	// Ring buffer of delayFrames frames
 	azaBuffer buffer;
+	// Frame in buffer that's next to come out, and the next frame to be overwritten by input
+	uint32_t index;
 } azaSampleDelay;
 // initializes azaSampleDelay in existing memory
 void azaSampleDelayInit(azaSampleDelay *data, azaSampleDelayConfig config);
@@ -31,6 +35,14 @@ void azaSampleDelayInit(azaSampleDelay *data, azaSampleDelayConfig config);
 void azaSampleDelayDeinit(azaSampleDelay *data);
 int azaSampleDelayProcess(azaSampleDelay *data, azaBuffer *dst, azaBuffer *src, uint32_t flags);
 
+// Does dst = dst*volumeDst + delayed(src*volumeSrc*matrix) in one pass, without any intermediate buffers. This is how azaMixer mixes its routes.
+// If volumeDst is 0, dst is overwritten without being read, so it doesn't need to be zeroed beforehand.
+// If src->silent, src isn't read and silence goes into the delay line.
+// NOTE: asserts that dst and src have the same frame count
+// NOTE: asserts that the matrix has the right number of inputs and outputs for the buffers
+// May return AZA_ERROR_OUT_OF_MEMORY
+int azaSampleDelayMixMatrix(azaSampleDelay *data, azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc, azaChannelMatrix *matrix);
+
 
 
 #ifdef __cplusplus
@@ -13,6 +13,7 @@
 #include "azaMeters.h"
 #include "azaDSP.h"
 #include "azaKernel.h"
+#include "azaResamplerPolyphase.h"
 
 // plugins
 
@@ -27,6 +28,7 @@
 #include "plugins/azaDelayDynamic.h"
 #include "plugins/azaDSPMultiplexer.h"
 #include "plugins/azaReverb.h"
+#include "plugins/azaConvolutionReverb.h"
 #include "plugins/azaSampler.h"
 #include "plugins/azaSpatialize.h"
 #include "plugins/azaMonitorSpectrum.h"
@@ -18,7 +18,7 @@ static const azaDSPFuncs azaCompressorFuncs = {
 	.fp_makeDefault = azaCompressorMakeDefault,
 	.fp_makeDuplicate = azaCompressorMakeDuplicate,
 	.fp_copyConfig = azaCompressorCopyConfig,
-	.fp_getSpecs = NULL,
+	.fp_getSpecs = azaCompressorGetSpecs,
 	.fp_process = azaCompressorProcess,
 	.fp_free = azaCompressorFree,
 	.fp_draw = azaCompressorDraw,
@@ -106,6 +106,15 @@ int azaCompressorCopyConfig(azaDSP *dst, azaDSP *src) {
 	return AZA_SUCCESS;
 }
 
+azaDSPSpecs azaCompressorGetSpecs(azaDSP *dsp, uint32_t samplerate) {
+	azaCompressor *data = (azaCompressor*)dsp;
+	// The rms window has to empty out and the attenuation has to settle (5 time constants gets us within 1dB of the floor)
+	return (azaDSPSpecs) {
+		.tailFrames = data->rms.config.windowSamples + (uint32_t)aza_ms_to_samples(5.0f * data->config.decay_ms, (float)samplerate),
+		.skipOnSilence = true,
+	};
+}
+
 int azaCompressorProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	// Bypass handled by azaDSPProcess
 	int err = AZA_SUCCESS;
@@ -130,8 +139,15 @@ int azaCompressorProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t fla
 	}
 
 	azaBuffer rmsBuffer = azaPushSideBuffer(dst->frames, 0, 0, 1, dst->samplerate);
+	if AZA_UNLIKELY(!rmsBuffer.pSamples) {
+		azaPopSideBuffer();
+		return AZA_ERROR_OUT_OF_MEMORY;
+	}
 	err = azaRMSProcess(&data->rms, &rmsBuffer, src, flags);
-	if AZA_UNLIKELY(err) return err;
+	if AZA_UNLIKELY(err) {
+		azaPopSideBuffer();
+		return err;
+	}
 
 	float t = (float)dst->samplerate / 1000.0f;
 	float attackFactor = expf(-1.0f / (data->config.attack_ms * t));
@@ -146,8 +162,11 @@ int azaCompressorProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t fla
 	}
 	data->minGainShort = 0.0f;
 	float totalGain = data->config.gainOutput + data->config.gainInput;
+	// The envelope has to go one frame at a time, but the conversions on either side of it don't, so we do those on the whole block at once in place.
+	float *levels = rmsBuffer.pSamples;
+	aza_amp_to_dbf_array(levels, levels, dst->frames);
 	for (size_t i = 0; i < dst->frames; i++) {
-		float rms = aza_amp_to_dbf(rmsBuffer.pSamples[i]) + data->config.gainInput;
+		float rms = levels[i] + data->config.gainInput;
 		if (rms < -120.0f) rms = -120.0f;
 		if (rms > data->attenuation) {
 			data->attenuation = rms + attackFactor * (data->attenuation - rms);
@@ -161,7 +180,11 @@ int azaCompressorProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t fla
 			gain = 0.0f;
 		}
 		data->minGainShort = azaMinf(data->minGainShort, gain);
-		float amp = aza_db_to_ampf(gain + totalGain);
+		levels[i] = gain + totalGain;
+	}
+	aza_db_to_ampf_array(levels, levels, dst->frames);
+	for (size_t i = 0; i < dst->frames; i++) {
+		float amp = levels[i];
 		for (size_t c = 0; c < dst->channelLayout.count; c++) {
 			size_t s = i * dst->stride + c;
 			dst->pSamples[s] *= amp;
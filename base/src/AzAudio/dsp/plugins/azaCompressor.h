@@ -68,6 +68,7 @@ void azaCompressorFree(azaDSP *dsp);
 azaDSP* azaCompressorMakeDefault();
 azaDSP* azaCompressorMakeDuplicate(azaDSP *src);
 int azaCompressorCopyConfig(azaDSP *dst, azaDSP *src);
+azaDSPSpecs azaCompressorGetSpecs(azaDSP *dsp, uint32_t samplerate);
 
 int azaCompressorProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags);
 
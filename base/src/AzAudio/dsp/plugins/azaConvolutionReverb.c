@@ -0,0 +1,468 @@
+/*
+	File: azaConvolutionReverb.c
+	Author: Philip Haynes
+*/
+
+#include "azaConvolutionReverb.h"
+
+#include "../../AzAudio.h"
+#include "../../math.h"
+#include "../../error.h"
+#include "../../atomic.h"
+
+#include "../../gui/gui.h"
+#include "../../mixer.h"
+
+
+
+static const azaDSPFuncs azaConvolutionReverbFuncs = {
+	.fp_makeDefault = azaConvolutionReverbMakeDefault,
+	.fp_makeDuplicate = azaConvolutionReverbMakeDuplicate,
+	.fp_copyConfig = azaConvolutionReverbCopyConfig,
+	.fp_getSpecs = azaConvolutionReverbGetSpecs,
+	.fp_process = azaConvolutionReverbProcess,
+	.fp_free = azaConvolutionReverbFree,
+	.fp_draw = azaConvolutionReverbDraw,
+};
+
+const azaDSP azaConvolutionReverbHeader = {
+	.header =  {
+		.size    = sizeof(azaConvolutionReverb),
+		.version = 1,
+		.owned   = false,
+		.bypass  = false,
+	},
+	.processMetadata = { 0 }, // ZII
+	.guiMetadata = {
+		.name             = "ConvolutionReverb",
+		.selected         = 0,
+		.drawTargetWidth  = 0.0f,
+		.drawCurrentWidth = 0.0f,
+	},
+	.pFuncs = &azaConvolutionReverbFuncs,
+};
+
+static uint32_t azaConvolutionReverbGetPartitionFrames(azaConvolutionReverbConfig *config) {
+	uint32_t result = AZAUDIO_CONVOLUTION_REVERB_MIN_PARTITION_FRAMES;
+	while (result < config->partitionFrames && result < AZAUDIO_CONVOLUTION_REVERB_MAX_PARTITION_FRAMES) {
+		result <<= 1;
+	}
+	return result;
+}
+
+// Per-channel state layout, see azaConvolutionReverbPartitions.state
+
+static size_t azaConvolutionReverbGetChannelStateSize(azaConvolutionReverbPartitions *partitions) {
+	return 3 * partitions->partitionFrames + partitions->partitionCount * 2 * partitions->binCount;
+}
+
+// The last 2*partitionFrames of input
+static float* azaConvolutionReverbGetInput(azaConvolutionReverbPartitions *partitions, uint8_t channel) {
+	return partitions->state + channel * azaConvolutionReverbGetChannelStateSize(partitions);
+}
+
+// partitionFrames of output, computed from the last full block of input
+static float* azaConvolutionReverbGetOutput(azaConvolutionReverbPartitions *partitions, uint8_t channel) {
+	return azaConvolutionReverbGetInput(partitions, channel) + 2 * partitions->partitionFrames;
+}
+
+// Spectrum of an input block, with binCount real parts followed by binCount imaginary parts
+static float* azaConvolutionReverbGetHistory(azaConvolutionReverbPartitions *partitions, uint8_t channel, uint32_t index) {
+	return azaConvolutionReverbGetOutput(partitions, channel) + partitions->partitionFrames + index * 2 * partitions->binCount;
+}
+
+// Spectrum of a partition of the impulse response, same layout as the history
+static float* azaConvolutionReverbGetPartition(azaConvolutionReverbPartitions *partitions, uint8_t irChannel, uint32_t index) {
+	return partitions->spectra + (irChannel * partitions->partitionCount + index) * 2 * partitions->binCount;
+}
+
+static void azaConvolutionReverbPartitionsFree(azaConvolutionReverbPartitions *partitions) {
+	if (!partitions) return;
+	azaFFTPlanDeinit(&partitions->fftPlan);
+	if (partitions->spectra) {
+		aza_free(partitions->spectra);
+	}
+	if (partitions->state) {
+		aza_free(partitions->state);
+	}
+	aza_free(partitions);
+}
+
+static void azaConvolutionReverbFreeRetired(azaConvolutionReverb *data) {
+	azaConvolutionReverbPartitions *retired = (azaConvolutionReverbPartitions*)azaAtomicExchangePtr((void*volatile*)&data->partitionsRetired, NULL);
+	while (retired) {
+		azaConvolutionReverbPartitions *next = retired->retiredNext;
+		azaConvolutionReverbPartitionsFree(retired);
+		retired = next;
+	}
+}
+
+// Replaces state with zeroed state for channelCount channels
+static int azaConvolutionReverbPartitionsReserveState(azaConvolutionReverbPartitions *partitions, uint8_t channelCount) {
+	// Scratch space needs 2*partitionFrames for the real part since azaFFTPlanInverseReal writes the whole block back into it
+	size_t size = channelCount * azaConvolutionReverbGetChannelStateSize(partitions) + 2 * partitions->partitionFrames + partitions->binCount;
+	float *state = aza_calloc(size, sizeof(float));
+	if (!state) return AZA_ERROR_OUT_OF_MEMORY;
+	if (partitions->state) {
+		aza_free(partitions->state);
+	}
+	partitions->state = state;
+	partitions->stateChannels = channelCount;
+	return AZA_SUCCESS;
+}
+
+// Cuts ir (which may be NULL) into partitions and transforms them, along with zeroed processing state for stateChannels channels
+// May return NULL indicating an out-of-memory error
+static azaConvolutionReverbPartitions* azaConvolutionReverbPartitionsMake(azaBuffer *ir, uint32_t partitionFrames, uint8_t stateChannels) {
+	azaConvolutionReverbPartitions *result = aza_calloc(1, sizeof(azaConvolutionReverbPartitions));
+	if (!result) return NULL;
+	uint32_t irFrames = ir && ir->pSamples ? ir->frames : 0;
+	uint32_t partitionCount = (irFrames + partitionFrames - 1) / partitionFrames;
+	uint32_t binCount = partitionFrames + 1;
+	result->partitionFrames = partitionFrames;
+	result->partitionCount = partitionCount;
+	result->binCount = binCount;
+	result->irChannels = partitionCount ? ir->channelLayout.count : 0;
+	if (azaFFTPlanInit(&result->fftPlan, 2 * partitionFrames)) goto error;
+	if (azaConvolutionReverbPartitionsReserveState(result, stateChannels)) goto error;
+	if (partitionCount) {
+		result->spectra = aza_malloc(sizeof(float) * result->irChannels * partitionCount * 2 * binCount);
+		if (!result->spectra) goto error;
+		// The second half of the scratch space isn't used until we process, so the blocks can go there
+		float *block = result->state + stateChannels * azaConvolutionReverbGetChannelStateSize(result);
+		for (uint8_t c = 0; c < result->irChannels; c++) {
+			for (uint32_t p = 0; p < partitionCount; p++) {
+				uint32_t start = p * partitionFrames;
+				uint32_t frames = AZA_MIN(partitionFrames, irFrames - start);
+				for (uint32_t i = 0; i < frames; i++) {
+					block[i] = ir->pSamples[(start + i) * ir->stride + c];
+				}
+				memset(block + frames, 0, sizeof(float) * (2 * partitionFrames - frames));
+				float *spectrum = azaConvolutionReverbGetPartition(result, c, p);
+				azaFFTPlanForwardReal(&result->fftPlan, block, spectrum, spectrum + binCount);
+			}
+		}
+	}
+	return result;
+error:
+	azaConvolutionReverbPartitionsFree(result);
+	return NULL;
+}
+
+// Publishes the shape of partitions for azaConvolutionReverbGetSpecs
+static void azaConvolutionReverbPublishPartitions(azaConvolutionReverb *data, azaConvolutionReverbPartitions *partitions) {
+	azaAtomicStore64(&data->partitionsActive, (int64_t)((uint64_t)partitions->partitionCount << 32 | partitions->partitionFrames));
+}
+
+// Builds partitions of impulseResponse for config.partitionFrames and offers them to the audio thread
+static int azaConvolutionReverbOfferPartitions(azaConvolutionReverb *data) {
+	azaConvolutionReverbFreeRetired(data);
+	uint32_t partitionFrames = azaConvolutionReverbGetPartitionFrames(&data->config);
+	// Make room for however many channels the audio thread is processing now so it doesn't have to
+	uint8_t stateChannels = AZA_MAX(data->channelCount, AZA_CHANNELS_DEFAULT);
+	azaConvolutionReverbPartitions *partitions = azaConvolutionReverbPartitionsMake(&data->impulseResponse, partitionFrames, stateChannels);
+	if (!partitions) return AZA_ERROR_OUT_OF_MEMORY;
+	data->partitionFramesBuilt = partitionFrames;
+	// If the audio thread never picked up the last ones we offered, they're still ours to free
+	azaConvolutionReverbPartitionsFree((azaConvolutionReverbPartitions*)azaAtomicExchangePtr((void*volatile*)&data->partitionsOffered, partitions));
+	return AZA_SUCCESS;
+}
+
+int azaConvolutionReverbUpdatePartitions(azaConvolutionReverb *data) {
+	azaConvolutionReverbFreeRetired(data);
+	if (data->partitionFramesBuilt == azaConvolutionReverbGetPartitionFrames(&data->config)) return AZA_SUCCESS;
+	return azaConvolutionReverbOfferPartitions(data);
+}
+
+void azaConvolutionReverbInit(azaConvolutionReverb *data, azaConvolutionReverbConfig config) {
+	data->dsp = azaConvolutionReverbHeader;
+	data->config = config;
+	memset(&data->impulseResponse, 0, sizeof(data->impulseResponse));
+	data->partitionFramesBuilt = 0;
+	data->partitions = NULL;
+	data->partitionsOffered = NULL;
+	data->partitionsRetired = NULL;
+	data->channelCount = 0;
+	data->blockFill = 0;
+	data->historyIndex = 0;
+	// If this fails, the audio thread builds them as a last resort
+	if (azaConvolutionReverbOfferPartitions(data) == AZA_SUCCESS) {
+		// The audio thread picks these up before it processes anything, so they're what we report until then
+		azaConvolutionReverbPublishPartitions(data, data->partitionsOffered);
+	} else {
+		// The ones the audio thread builds have no impulse response
+		azaAtomicStore64(&data->partitionsActive, (int64_t)azaConvolutionReverbGetPartitionFrames(&data->config));
+	}
+}
+
+void azaConvolutionReverbDeinit(azaConvolutionReverb *data) {
+	azaBufferDeinit(&data->impulseResponse, false);
+	azaConvolutionReverbPartitionsFree(data->partitions);
+	azaConvolutionReverbPartitionsFree(data->partitionsOffered);
+	azaConvolutionReverbFreeRetired(data);
+	data->partitions = NULL;
+	data->partitionsOffered = NULL;
+	data->partitionsRetired = NULL;
+}
+
+void azaConvolutionReverbReset(azaConvolutionReverb *data) {
+	azaMetersReset(&data->metersInput);
+	azaMetersReset(&data->metersOutput);
+	data->blockFill = 0;
+	data->historyIndex = 0;
+	if (data->partitions) {
+		memset(data->partitions->state, 0, sizeof(float) * data->channelCount * azaConvolutionReverbGetChannelStateSize(data->partitions));
+	}
+}
+
+void azaConvolutionReverbResetChannels(azaConvolutionReverb *data, uint32_t firstChannel, uint32_t channelCount) {
+	azaMetersResetChannels(&data->metersInput, firstChannel, channelCount);
+	azaMetersResetChannels(&data->metersOutput, firstChannel, channelCount);
+	if (data->partitions && firstChannel < data->channelCount) {
+		channelCount = AZA_MIN(channelCount, data->channelCount - firstChannel);
+		memset(azaConvolutionReverbGetInput(data->partitions, firstChannel), 0, sizeof(float) * channelCount * azaConvolutionReverbGetChannelStateSize(data->partitions));
+	}
+}
+
+int azaConvolutionReverbSetImpulseResponse(azaConvolutionReverb *data, azaBuffer *impulseResponse) {
+	int err;
+	azaBufferDeinit(&data->impulseResponse, false);
+	memset(&data->impulseResponse, 0, sizeof(data->impulseResponse));
+	if (impulseResponse && impulseResponse->frames) {
+		err = azaBufferInit(&data->impulseResponse, impulseResponse->frames, 0, 0, impulseResponse->channelLayout);
+		if (err) {
+			// Still drop the partitions of the old impulse response
+			azaConvolutionReverbOfferPartitions(data);
+			return err;
+		}
+		data->impulseResponse.samplerate = impulseResponse->samplerate;
+		azaBufferCopy(&data->impulseResponse, impulseResponse);
+	}
+	return azaConvolutionReverbOfferPartitions(data);
+}
+
+azaConvolutionReverb* azaConvolutionReverbMake(azaConvolutionReverbConfig config) {
+	azaConvolutionReverb *result = aza_calloc(1, sizeof(azaConvolutionReverb));
+	if (result) {
+		azaConvolutionReverbInit(result, config);
+	}
+	return result;
+}
+
+void azaConvolutionReverbFree(azaDSP *dsp) {
+	azaConvolutionReverbDeinit((azaConvolutionReverb*)dsp);
+	aza_free(dsp);
+}
+
+azaDSP* azaConvolutionReverbMakeDefault() {
+	return (azaDSP*)azaConvolutionReverbMake((azaConvolutionReverbConfig) {
+		.gainWet = -9.0f,
+		.gainDry = 0.0f,
+		.muteWet = false,
+		.muteDry = false,
+		.partitionFrames = 512,
+	});
+}
+
+azaDSP* azaConvolutionReverbMakeDuplicate(azaDSP *src) {
+	azaConvolutionReverb *data = (azaConvolutionReverb*)src;
+	azaConvolutionReverb *result = azaConvolutionReverbMake(data->config);
+	if (result && data->impulseResponse.pSamples) {
+		if (azaConvolutionReverbSetImpulseResponse(result, &data->impulseResponse)) {
+			azaConvolutionReverbFree((azaDSP*)result);
+			return NULL;
+		}
+	}
+	return (azaDSP*)result;
+}
+
+int azaConvolutionReverbCopyConfig(azaDSP *dst, azaDSP *src) {
+	azaConvolutionReverb *dataDst = (azaConvolutionReverb*)dst;
+	azaConvolutionReverb *dataSrc = (azaConvolutionReverb*)src;
+	dataDst->config = dataSrc->config;
+	return azaConvolutionReverbUpdatePartitions(dataDst);
+}
+
+static int azaConvolutionReverbHandleBufferResizes(azaConvolutionReverb *data, uint8_t channelCount) {
+	int err;
+	azaConvolutionReverbPartitions *offered = (azaConvolutionReverbPartitions*)azaAtomicExchangePtr((void*volatile*)&data->partitionsOffered, NULL);
+	if (offered) {
+		// Hand our old partitions back to be freed outside of the audio thread
+		azaConvolutionReverbPartitions *retired = data->partitions;
+		if (retired) {
+			do {
+				retired->retiredNext = (azaConvolutionReverbPartitions*)azaAtomicLoadPtr((void*volatile*)&data->partitionsRetired);
+			} while (!azaAtomicCompareExchangePtr((void*volatile*)&data->partitionsRetired, retired->retiredNext, retired));
+		}
+		data->partitions = offered;
+		azaConvolutionReverbPublishPartitions(data, offered);
+		// None of our old state lines up with the new partitions
+		data->channelCount = 0;
+	}
+	if AZA_UNLIKELY(!data->partitions) {
+		// Init couldn't build any, so all we can do is build some here, without the impulse response since that belongs to other threads.
+		data->partitions = azaConvolutionReverbPartitionsMake(NULL, azaConvolutionReverbGetPartitionFrames(&data->config), channelCount);
+		if (!data->partitions) return AZA_ERROR_OUT_OF_MEMORY;
+		azaConvolutionReverbPublishPartitions(data, data->partitions);
+		data->channelCount = 0;
+	}
+	if (data->channelCount != channelCount) {
+		// Don't bother carrying data over
+		if AZA_UNLIKELY(channelCount > data->partitions->stateChannels) {
+			// Nobody made room for this many channels, so all we can do is allocate here
+			err = azaConvolutionReverbPartitionsReserveState(data->partitions, channelCount);
+			if (err) {
+				data->channelCount = 0;
+				return err;
+			}
+		} else {
+			memset(data->partitions->state, 0, sizeof(float) * channelCount * azaConvolutionReverbGetChannelStateSize(data->partitions));
+		}
+		data->channelCount = channelCount;
+		data->blockFill = 0;
+		data->historyIndex = 0;
+	}
+	return AZA_SUCCESS;
+}
+
+// Called once we've taken in a full block of input, producing the next block of output
+static void azaConvolutionReverbProcessBlock(azaConvolutionReverb *data) {
+	azaConvolutionReverbPartitions *partitions = data->partitions;
+	uint32_t partitionFrames = partitions->partitionFrames;
+	uint32_t partitionCount = partitions->partitionCount;
+	uint32_t binCount = partitions->binCount;
+	float *scratchReal = partitions->state + data->channelCount * azaConvolutionReverbGetChannelStateSize(partitions);
+	float *scratchImag = scratchReal + 2 * partitionFrames;
+	if (partitionCount) {
+		data->historyIndex = (data->historyIndex + 1) % partitionCount;
+	}
+	for (uint8_t c = 0; c < data->channelCount; c++) {
+		float *input = azaConvolutionReverbGetInput(partitions, c);
+		float *output = azaConvolutionReverbGetOutput(partitions, c);
+		if (partitionCount) {
+			float *newest = azaConvolutionReverbGetHistory(partitions, c, data->historyIndex);
+			azaFFTPlanForwardReal(&partitions->fftPlan, input, newest, newest + binCount);
+			memset(scratchReal, 0, sizeof(float) * binCount);
+			memset(scratchImag, 0, sizeof(float) * binCount);
+			// The newest block gets the first partition, the one before it gets the second, and so on
+			uint8_t irChannel = c % partitions->irChannels;
+			uint32_t index = data->historyIndex;
+			for (uint32_t p = 0; p < partitionCount; p++) {
+				float *history = azaConvolutionReverbGetHistory(partitions, c, index);
+				float *partition = azaConvolutionReverbGetPartition(partitions, irChannel, p);
+				azaFFTSpectrumMultiplyAccumulate(scratchReal, scratchImag, history, history + binCount, partition, partition + binCount, binCount);
+				index = index ? index - 1 : partitionCount - 1;
+			}
+			azaFFTPlanInverseReal(&partitions->fftPlan, scratchReal, scratchReal, scratchImag);
+			// Overlap-save: The first half wrapped around from the circular convolution, so only the second half is valid
+			memcpy(output, scratchReal + partitionFrames, sizeof(float) * partitionFrames);
+		} else {
+			memset(output, 0, sizeof(float) * partitionFrames);
+		}
+		memcpy(input, input + partitionFrames, sizeof(float) * partitionFrames);
+	}
+}
+
+int azaConvolutionReverbProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
+	// Bypass handled by azaDSPProcess
+	int err = AZA_SUCCESS;
+	assert(dsp != NULL);
+	azaConvolutionReverb *data = (azaConvolutionReverb*)dsp;
+
+	if AZA_UNLIKELY(flags & AZA_DSP_PROCESS_FLAG_CUT) {
+		azaConvolutionReverbReset(data);
+	}
+
+	err = azaCheckBuffersForDSPProcess(dst, src, /* sameFrameCount: */ true, /* sameChannelCount: */ true);
+	if AZA_UNLIKELY(err) return err;
+
+	err = azaConvolutionReverbHandleBufferResizes(data, dst->channelLayout.count);
+	if AZA_UNLIKELY(err) return err;
+
+	if (dst->channelLayout.count > data->dsp.processMetadata.prevChannelCountDst) {
+		azaConvolutionReverbResetChannels(data, data->dsp.processMetadata.prevChannelCountDst, dst->channelLayout.count - data->dsp.processMetadata.prevChannelCountDst);
+	}
+	data->dsp.processMetadata.prevChannelCountDst = dst->channelLayout.count;
+
+	if (azaMixerGUIDSPIsSelected(dsp)) {
+		azaMetersUpdate(&data->metersInput, src, 1.0f);
+	}
+
+	float amountWet = data->config.muteWet ? 0.0f : aza_db_to_ampf(data->config.gainWet);
+	float amountDry = data->config.muteDry ? 0.0f : aza_db_to_ampf(data->config.gainDry);
+	azaConvolutionReverbPartitions *partitions = data->partitions;
+	uint32_t partitionFrames = partitions->partitionFrames;
+	// The dry signal comes out of our input history so it stays lined up with the wet signal, which makes our whole output exactly partitionFrames late.
+	for (uint32_t offset = 0; offset < src->frames;) {
+		uint32_t frames = AZA_MIN(partitionFrames - data->blockFill, src->frames - offset);
+		for (uint8_t c = 0; c < data->channelCount; c++) {
+			float *input = azaConvolutionReverbGetInput(partitions, c) + partitionFrames + data->blockFill;
+			float *dry = azaConvolutionReverbGetInput(partitions, c) + data->blockFill;
+			float *wet = azaConvolutionReverbGetOutput(partitions, c) + data->blockFill;
+			for (uint32_t i = 0; i < frames; i++) {
+				input[i] = src->pSamples[(offset + i) * src->stride + c];
+				dst->pSamples[(offset + i) * dst->stride + c] = dry[i] * amountDry + wet[i] * amountWet;
+			}
+		}
+		offset += frames;
+		data->blockFill += frames;
+		if (data->blockFill == partitionFrames) {
+			azaConvolutionReverbProcessBlock(data);
+			data->blockFill = 0;
+		}
+	}
+
+	if (azaMixerGUIDSPIsSelected(dsp)) {
+		azaMetersUpdate(&data->metersOutput, dst, 1.0f);
+	}
+	return AZA_SUCCESS;
+}
+
+azaDSPSpecs azaConvolutionReverbGetSpecs(azaDSP *dsp, uint32_t samplerate) {
+	azaConvolutionReverb *data = (azaConvolutionReverb*)dsp;
+	// Not config.partitionFrames nor impulseResponse, since the audio thread may not have picked those up yet
+	uint64_t partitionsActive = (uint64_t)azaAtomicLoad64(&data->partitionsActive);
+	uint32_t partitionFrames = (uint32_t)partitionsActive;
+	uint32_t partitionCount = (uint32_t)(partitionsActive >> 32);
+	// Once the latency has passed, every block in our history (plus the one they overlap with, plus the one being filled) has to be silent before our state is all zeroes again, which is what lets us be skipped and then pick up again without any stale output.
+	azaDSPSpecs result = {
+		.latencyFrames = partitionFrames,
+		.tailFrames = (partitionCount + 1) * partitionFrames,
+		.skipOnSilence = true,
+	};
+	return result;
+}
+
+
+
+// GUI
+
+
+
+static const float meterDBRange = 48.0f;
+static const float meterDBHeadroom = 12.0f;
+
+void azaConvolutionReverbDraw(azaDSP *dsp, azagRect bounds) {
+	azaConvolutionReverb *data = (azaConvolutionReverb*)dsp;
+	float boundsStartX = bounds.x;
+	float usedWidth;
+	usedWidth = azagDrawMeters(&data->metersInput, bounds, meterDBRange, meterDBHeadroom);
+	azagRectShrinkLeftMargin(&bounds, usedWidth);
+
+	usedWidth = azagDrawFader(bounds, &data->config.gainWet, &data->config.muteWet, true, "Wet Gain", 36, 6);
+	azagRectShrinkLeftMargin(&bounds, usedWidth);
+	usedWidth = azagDrawFader(bounds, &data->config.gainDry, &data->config.muteDry, true, "Dry Gain", 36, 6);
+	azagRectShrinkLeftMargin(&bounds, usedWidth);
+
+	float partitionFrames = (float)data->config.partitionFrames;
+	usedWidth = azagDrawSliderFloatLog(bounds, &partitionFrames, (float)AZAUDIO_CONVOLUTION_REVERB_MIN_PARTITION_FRAMES, (float)AZAUDIO_CONVOLUTION_REVERB_MAX_PARTITION_FRAMES, 1.0f, 512.0f, "Partition Size (Latency)", "%.0f");
+	data->config.partitionFrames = (uint32_t)roundf(partitionFrames);
+	// This also cleans up after the audio thread. If it fails we'll try again next time we draw.
+	azaConvolutionReverbUpdatePartitions(data);
+	azagRectShrinkLeftMargin(&bounds, usedWidth);
+
+	usedWidth = azagDrawMeters(&data->metersOutput, bounds, meterDBRange, meterDBHeadroom);
+	azagRectShrinkLeftMargin(&bounds, usedWidth);
+	float totalWidth = bounds.x - boundsStartX + azagThemeCurrent.margin.x;
+	data->dsp.guiMetadata.drawTargetWidth = totalWidth;
+}
@@ -0,0 +1,141 @@
+/*
+	File: azaConvolutionReverb.h
+	Author: Philip Haynes
+	Convolves the signal with an impulse response, using uniformly-partitioned overlap-save in the frequency domain.
+	The impulse response is cut into partitions of partitionFrames, each of which is transformed once up front. Every partitionFrames of input, we transform one block of input and multiply-accumulate it against all the partitions, so the cost per sample grows with the length of the impulse response divided by partitionFrames, and the latency is partitionFrames.
+*/
+
+#ifndef AZAUDIO_AZACONVOLUTIONREVERB_H
+#define AZAUDIO_AZACONVOLUTIONREVERB_H
+
+#include "../azaDSP.h"
+#include "../azaMeters.h"
+#include "../../fft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+
+extern const azaDSP azaConvolutionReverbHeader;
+
+#define AZAUDIO_CONVOLUTION_REVERB_MIN_PARTITION_FRAMES 32
+#define AZAUDIO_CONVOLUTION_REVERB_MAX_PARTITION_FRAMES 16384
+
+typedef struct azaConvolutionReverbConfig {
+	// effect gain in dB
+	float gainWet;
+	// dry gain in dB
+	float gainDry;
+	bool muteWet, muteDry;
+	aza_byte _reserved[2];
+	// How many frames go into each partition of the impulse response, which is also our latency.
+	// Smaller partitions have less latency but cost more CPU for long impulse responses.
+	// Gets rounded up to a power of 2 and clamped between AZAUDIO_CONVOLUTION_REVERB_MIN_PARTITION_FRAMES and AZAUDIO_CONVOLUTION_REVERB_MAX_PARTITION_FRAMES.
+	uint32_t partitionFrames;
+} azaConvolutionReverbConfig;
+
+// Everything that depends on the impulse response and partitionFrames. These get built outside of the audio thread and handed to it whole, so changing either never allocates or transforms anything on the audio thread.
+typedef struct azaConvolutionReverbPartitions {
+	// Actual partitionFrames after rounding and clamping
+	uint32_t partitionFrames;
+	uint32_t partitionCount;
+	// partitionFrames+1, the number of complex values in the spectrum of one block
+	uint32_t binCount;
+	// Channel count of the impulse response, or 0 if there isn't one
+	uint8_t irChannels;
+	// How many channels state has room for
+	uint8_t stateChannels;
+	// Transforms of 2*partitionFrames
+	azaFFTPlan fftPlan;
+	// Spectra of every partition for every channel of the impulse response, with all the real parts of one partition followed by all the imaginary parts.
+	float *spectra;
+	// For every channel, 2*partitionFrames of input, partitionFrames of output, and partitionCount spectra of past input blocks.
+	// After that, scratch space for one block that's shared between channels.
+	float *state;
+	// Next in azaConvolutionReverb.partitionsRetired
+	struct azaConvolutionReverbPartitions *retiredNext;
+} azaConvolutionReverbPartitions;
+
+typedef struct azaConvolutionReverb {
+	azaDSP dsp;
+	azaConvolutionReverbConfig config;
+
+	azaMeters metersInput;
+	azaMeters metersOutput;
+
+	// Our own copy of the impulse response, kept around so we can partition it again if config.partitionFrames changes. The audio thread never touches this.
+	azaBuffer impulseResponse;
+	// partitionFrames of the last partitions we built, so we know when config.partitionFrames needs them built again. The audio thread never touches this.
+	uint32_t partitionFramesBuilt;
+
+	// The partitions we're processing with. Only the audio thread touches these.
+	azaConvolutionReverbPartitions *partitions;
+	// Newly-built partitions, which the audio thread picks up at the start of its next block
+	azaConvolutionReverbPartitions *volatile partitionsOffered;
+	// A list of the partitions the audio thread replaced, for whoever offers the next ones to free
+	azaConvolutionReverbPartitions *volatile partitionsRetired;
+	// partitionFrames in the low 32 bits and partitionCount in the high 32 bits of the partitions we're processing with, published by the audio thread whenever it picks up new ones so azaConvolutionReverbGetSpecs can be called from any thread.
+	// Until the audio thread processes anything, this describes the partitions made by azaConvolutionReverbInit.
+	volatile int64_t partitionsActive;
+
+	// Channel count of our processing state, or 0 if it needs to be reset
+	uint8_t channelCount;
+	// How many frames of the current block we've taken in so far
+	uint32_t blockFill;
+	// Which block of spectra in our history is the most recent
+	uint32_t historyIndex;
+} azaConvolutionReverb;
+
+// initializes azaConvolutionReverb in existing memory
+// Until you call azaConvolutionReverbSetImpulseResponse the wet signal is silent.
+void azaConvolutionReverbInit(azaConvolutionReverb *data, azaConvolutionReverbConfig config);
+// frees any additional memory that the azaConvolutionReverb may have allocated
+void azaConvolutionReverbDeinit(azaConvolutionReverb *data);
+// Resets state. May be called automatically.
+void azaConvolutionReverbReset(azaConvolutionReverb *data);
+// Resets state for the specified channel range
+void azaConvolutionReverbResetChannels(azaConvolutionReverb *data, uint32_t firstChannel, uint32_t channelCount);
+
+// Copies impulseResponse and partitions it according to config.partitionFrames. Pass NULL to remove the impulse response.
+// impulseResponse may have 1 channel, which gets used for every channel we process, or one channel for each channel we process. If we process more channels than it has, they wrap around.
+// impulseResponse->samplerate should match the samplerate we process at, as we don't resample it.
+// This is safe to call while the plugin is being processed on another thread, which switches over at the start of its next block. Don't call it from more than one thread at a time, nor alongside azaConvolutionReverbUpdatePartitions or azaConvolutionReverbCopyConfig.
+// May return AZA_ERROR_OUT_OF_MEMORY
+int azaConvolutionReverbSetImpulseResponse(azaConvolutionReverb *data, azaBuffer *impulseResponse);
+
+// Partitions the impulse response again if config.partitionFrames changed, and frees any partitions the audio thread is done with. Call this after changing config.partitionFrames yourself, as the audio thread won't do it for you. azaConvolutionReverbCopyConfig and the GUI call it for you.
+// Has the same thread-safety as azaConvolutionReverbSetImpulseResponse.
+// May return AZA_ERROR_OUT_OF_MEMORY
+int azaConvolutionReverbUpdatePartitions(azaConvolutionReverb *data);
+
+// Convenience function that allocates and inits an azaConvolutionReverb for you
+// May return NULL indicating an out-of-memory error
+azaConvolutionReverb* azaConvolutionReverbMake(azaConvolutionReverbConfig config);
+// Frees an azaConvolutionReverb that was created with azaConvolutionReverbMake
+void azaConvolutionReverbFree(azaDSP *dsp);
+
+azaDSP* azaConvolutionReverbMakeDefault();
+// Also copies the impulse response
+azaDSP* azaConvolutionReverbMakeDuplicate(azaDSP *src);
+// May return AZA_ERROR_OUT_OF_MEMORY if partitionFrames changed
+int azaConvolutionReverbCopyConfig(azaDSP *dst, azaDSP *src);
+
+int azaConvolutionReverbProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags);
+
+// Reports partitionFrames of latency, and a tail long enough for our whole history of input blocks to be flushed with silence.
+// These come from the partitions the audio thread is processing with, so after changing the impulse response or config.partitionFrames they only change once it has picked up the new ones at the start of its next block.
+azaDSPSpecs azaConvolutionReverbGetSpecs(azaDSP *dsp, uint32_t samplerate);
+
+
+
+void azaConvolutionReverbDraw(azaDSP *dsp, azagRect bounds);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AZAUDIO_AZACONVOLUTIONREVERB_H
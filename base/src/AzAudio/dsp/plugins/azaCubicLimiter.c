@@ -16,7 +16,7 @@ static const azaDSPFuncs azaCubicLimiterFuncs = {
 	.fp_makeDefault = azaCubicLimiterMakeDefault,
 	.fp_makeDuplicate = azaCubicLimiterMakeDuplicate,
 	.fp_copyConfig = azaCubicLimiterCopyConfig,
-	.fp_getSpecs = NULL,
+	.fp_getSpecs = azaCubicLimiterGetSpecs,
 	.fp_process = azaCubicLimiterProcess,
 	.fp_free = azaCubicLimiterFree,
 	.fp_draw = NULL,
@@ -97,6 +97,13 @@ int azaCubicLimiterCopyConfig(azaDSP *dst, azaDSP *src) {
 	return AZA_SUCCESS;
 }
 
+azaDSPSpecs azaCubicLimiterGetSpecs(azaDSP *dsp, uint32_t samplerate) {
+	// Zero in, zero out
+	return (azaDSPSpecs) {
+		.skipOnSilence = true,
+	};
+}
+
 int azaCubicLimiterProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	// Bypass handled by azaDSPProcess
 	int err = AZA_SUCCESS;
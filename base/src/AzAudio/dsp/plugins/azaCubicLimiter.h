@@ -53,6 +53,7 @@ void azaCubicLimiterFree(azaDSP *dsp);
 azaDSP* azaCubicLimiterMakeDefault();
 azaDSP* azaCubicLimiterMakeDuplicate(azaDSP *src);
 int azaCubicLimiterCopyConfig(azaDSP *dst, azaDSP *src);
+azaDSPSpecs azaCubicLimiterGetSpecs(azaDSP *dsp, uint32_t samplerate);
 
 int azaCubicLimiterProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags);
 
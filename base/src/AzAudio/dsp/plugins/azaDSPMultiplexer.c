@@ -101,6 +101,10 @@ int azaDSPMultiplexerProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t
 		numSideBuffers++;
 		src = &sideBufferSrc;
 	}
+	if AZA_UNLIKELY(!processingBuffer.pSamples || !src->pSamples) {
+		result = AZA_ERROR_OUT_OF_MEMORY;
+		goto errorUnlocked;
+	}
 	azaBufferZero(dst);
 
 	azaMutexLock(&data->mutex);
@@ -128,6 +132,7 @@ int azaDSPMultiplexerProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t
 	}
 error:
 	azaMutexUnlock(&data->mutex);
+errorUnlocked:
 	azaPopSideBuffers(numSideBuffers);
 	return result;
 }
@@ -18,7 +18,7 @@ static const azaDSPFuncs azaDelayFuncs = {
 	.fp_makeDefault = azaDelayMakeDefault,
 	.fp_makeDuplicate = azaDelayMakeDuplicate,
 	.fp_copyConfig = azaDelayCopyConfig,
-	.fp_getSpecs = NULL,
+	.fp_getSpecs = azaDelayGetSpecs,
 	.fp_process = azaDelayProcess,
 	.fp_free = azaDelayFree,
 	.fp_draw = azaDelayDraw,
@@ -150,6 +150,32 @@ static int azaDelayHandleBufferResizes(azaDelay *data, uint32_t samplerate, uint
 	return AZA_SUCCESS;
 }
 
+azaDSPSpecs azaDelayGetSpecs(azaDSP *dsp, uint32_t samplerate) {
+	azaDelay *data = (azaDelay*)dsp;
+	azaDSPSpecs specs = {0};
+	// Echoes forever
+	if (data->config.feedback >= 1.0f) return specs;
+	azaDSPSpecs specsEffects = {0};
+	if (data->inputEffects.steps.count) {
+		specsEffects = azaDSPChainGetSpecs(&data->inputEffects, samplerate);
+		if (!specsEffects.skipOnSilence) return specs;
+	}
+	float delay_ms = 0.0f;
+	for (uint32_t c = 0; c < AZA_MAX_CHANNEL_POSITIONS; c++) {
+		delay_ms = azaMaxf(delay_ms, data->config.delay_ms + data->channelData[c].config.delay_ms);
+	}
+	// How many times we have to go around before the echoes are below -120dB
+	float echoes = 1.0f;
+	if (data->config.feedback > 0.0f) {
+		echoes += ceilf(logf(1.0e-6f) / logf(data->config.feedback));
+	}
+	float tailFrames = echoes * (aza_ms_to_samples(delay_ms, (float)samplerate) + (float)(specsEffects.latencyFrames + specsEffects.tailFrames));
+	// Keep it sane for feedback values very close to 1
+	specs.tailFrames = (uint32_t)azaMinf(tailFrames, 1.0e9f);
+	specs.skipOnSilence = true;
+	return specs;
+}
+
 int azaDelayProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	// Bypass handled by azaDSPProcess
 	int err = AZA_SUCCESS;
@@ -176,6 +202,10 @@ int azaDelayProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	}
 
 	azaBuffer sideBuffer = azaPushSideBufferZero(src->frames, 0, 0, src->channelLayout.count, src->samplerate);
+	if AZA_UNLIKELY(!sideBuffer.pSamples) {
+		err = AZA_ERROR_OUT_OF_MEMORY;
+		goto error;
+	}
 	for (uint8_t c = 0; c < src->channelLayout.count; c++) {
 		azaDelayChannelData *channelData = &data->channelData[c];
 		uint32_t index = channelData->index;
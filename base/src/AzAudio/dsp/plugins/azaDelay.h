@@ -80,6 +80,7 @@ void azaDelayFree(azaDSP *dsp);
 azaDSP* azaDelayMakeDefault();
 azaDSP* azaDelayMakeDuplicate(azaDSP *src);
 int azaDelayCopyConfig(azaDSP *dst, azaDSP *src);
+azaDSPSpecs azaDelayGetSpecs(azaDSP *dsp, uint32_t samplerate);
 
 int azaDelayProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags);
 
@@ -213,6 +213,10 @@ int azaDelayDynamicProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t f
 
 	azaKernel *kernel = azaDelayDynamicGetKernel(data, 1.0f);
 	azaBuffer sideBuffer = azaPushSideBufferCopy(src);
+	if AZA_UNLIKELY(!sideBuffer.pSamples) {
+		err = AZA_ERROR_OUT_OF_MEMORY;
+		goto error;
+	}
 	int kernelSamplesLeft = kernel->sampleZero;
 	int kernelSamplesRight = kernel->length - kernel->sampleZero;
 	uint32_t delaySamplesMax = (uint32_t)ceilf(aza_ms_to_samples(data->config.delayMax_ms, (float)src->samplerate));
@@ -255,6 +259,8 @@ int azaDelayDynamicProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t f
 			}
 			channelData->delay_ms = followerBackup;
 		}
+		// Even if src was silent, we may have just put the feedback in there
+		sideBuffer.silent = false;
 	}
 	if (data->inputEffects.steps.count) {
 		err = azaDSPChainProcess(&data->inputEffects, &sideBuffer, &sideBuffer, flags);
@@ -287,7 +293,10 @@ int azaDelayDynamicProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t f
 		channelData->ratePrevious = endRate;
 		// TODO: Swapping kernels by radius gets us nice, predictable performance costs, but without any interpolation between them, the jump in kernel radius creates a very quiet pop in the sampled audio. Using interpolation like that doubles our kernel sampling costs, which is already the most expensive part of this whole process.
 		kernel = azaDelayDynamicGetKernel(data, startRate);
-		for (uint32_t i = 0; i < dst->frames; i++) {
+		// src may be dst shifted by some frames either way (see fp_azaDSPProcess_t), so like memmove, walk in the direction that reads each src frame before we write over it.
+		bool backwards = src->pSamples < dst->pSamples;
+		for (uint32_t n = 0; n < dst->frames; n++) {
+			uint32_t i = backwards ? dst->frames-1 - n : n;
 			float t = (float)i / (float)dst->frames;
 			float rate = azaLerpf(startRate, endRate, t);
 			float index = azaLerpf(startIndex, endIndex, t);
@@ -18,7 +18,7 @@ static const azaDSPFuncs azaFilterFuncs = {
 	.fp_makeDefault = azaFilterMakeDefault,
 	.fp_makeDuplicate = azaFilterMakeDuplicate,
 	.fp_copyConfig = azaFilterCopyConfig,
-	.fp_getSpecs = NULL,
+	.fp_getSpecs = azaFilterGetSpecs,
 	.fp_process = azaFilterProcess,
 	.fp_free = azaFilterFree,
 	.fp_draw = azaFilterDraw,
@@ -48,8 +48,19 @@ const char *azaFilterKindString[] = {
 };
 static_assert(sizeof(azaFilterKindString) / sizeof(const char*) == AZA_FILTER_KIND_COUNT, "Pls update azaFilterKindString");
 
+const char *azaFilterTopologyString[] = {
+	"1-Pole",
+	"SVF",
+};
+static_assert(sizeof(azaFilterTopologyString) / sizeof(const char*) == AZA_FILTER_TOPOLOGY_COUNT, "Pls update azaFilterTopologyString");
+
 
 
+static float azaFilterGetChannelFrequency(azaFilter *data, uint8_t channel) {
+	float channelFrequencyOverride = data->config.channelFrequencyOverride[channel];
+	return channelFrequencyOverride != 0.0f ? channelFrequencyOverride : data->config.frequency;
+}
+
 void azaFilterInit(azaFilter *data, azaFilterConfig config) {
 	data->dsp = azaFilterHeader;
 	data->config = config;
@@ -64,12 +75,23 @@ void azaFilterReset(azaFilter *data) {
 	azaMetersReset(&data->metersInput);
 	azaMetersReset(&data->metersOutput);
 	memset(data->channelData, 0, sizeof(data->channelData));
+	for (uint8_t c = 0; c < AZA_MAX_CHANNEL_POSITIONS; c++) {
+		azaFollowerLinearJump(&data->channelData[c].frequency, azaFilterGetChannelFrequency(data, c));
+	}
+	memset(data->state, 0, sizeof(data->state));
+	data->coefficients.samplerate = 0;
 }
 
 void azaFilterResetChannels(azaFilter *data, uint32_t firstChannel, uint32_t channelCount) {
 	azaMetersResetChannels(&data->metersInput, firstChannel, channelCount);
 	azaMetersResetChannels(&data->metersOutput, firstChannel, channelCount);
 	memset(data->channelData + firstChannel, 0, sizeof(data->channelData[0]) * channelCount);
+	for (uint32_t c = firstChannel; c < firstChannel + channelCount; c++) {
+		azaFollowerLinearJump(&data->channelData[c].frequency, azaFilterGetChannelFrequency(data, (uint8_t)c));
+	}
+	for (uint32_t i = 0; i < AZAUDIO_FILTER_MAX_STAGES; i++) {
+		memset(data->state[i] + firstChannel, 0, sizeof(data->state[i][0]) * channelCount);
+	}
 }
 
 azaFilter* azaFilterMake(azaFilterConfig config) {
@@ -107,6 +129,204 @@ int azaFilterCopyConfig(azaDSP *dst, azaDSP *src) {
 	return AZA_SUCCESS;
 }
 
+// Fills damping with k = 1/Q for every SVF section and returns how many sections there are.
+static uint32_t azaFilterGetSVFDampings(azaFilterKind kind, uint32_t poles, float damping[AZAUDIO_FILTER_MAX_POLES]) {
+	if (kind == AZA_FILTER_BAND_PASS) {
+		// A damping of 2 puts both poles on the cutoff, which is the same as a one-pole low pass into a one-pole high pass.
+		for (uint32_t i = 0; i < poles; i++) {
+			damping[i] = 2.0f;
+		}
+		return poles;
+	}
+	uint32_t sections = 0;
+	uint32_t odd = poles & 1;
+	if (odd) {
+		// The real pole of an odd-order Butterworth, done as a section with both poles in the same place and one of them cancelled out by the mix.
+		damping[sections++] = 2.0f;
+	}
+	// Butterworth poles are spaced evenly around the unit circle, and each conjugate pair at angle theta from the negative real axis has a damping of 2*cos(theta). These go from least to most resonant.
+	for (uint32_t i = 0; i < poles/2; i++) {
+		float theta = AZA_PI * (float)(2*i + 1 + odd) / (float)(2*poles);
+		damping[sections++] = 2.0f * cosf(theta);
+	}
+	return sections;
+}
+
+azaDSPSpecs azaFilterGetSpecs(azaDSP *dsp, uint32_t samplerate) {
+	azaFilter *data = (azaFilter*)dsp;
+	azaDSPSpecs specs = {0};
+	// The lowest cutoff rings the longest
+	float frequency = data->config.frequency;
+	for (uint32_t c = 0; c < AZA_MAX_CHANNEL_POSITIONS; c++) {
+		float channelFrequencyOverride = data->config.channelFrequencyOverride[c];
+		if (channelFrequencyOverride != 0.0f) {
+			frequency = azaMinf(frequency, channelFrequencyOverride);
+		}
+	}
+	// A decay of 1 holds its state forever
+	if (frequency <= 0.0f) return specs;
+	uint32_t poles = AZA_MIN(data->config.poles+1, AZAUDIO_FILTER_MAX_POLES);
+	float timeConstants;
+	if (data->config.topology == AZA_FILTER_TOPOLOGY_SVF) {
+		// A section's envelope decays with a time constant of 2Q = 2/k, but it rings no shorter than the 2 one-poles it replaces.
+		float damping[AZAUDIO_FILTER_MAX_POLES];
+		uint32_t sections = azaFilterGetSVFDampings(data->config.kind, poles, damping);
+		timeConstants = 0.0f;
+		for (uint32_t i = 0; i < sections; i++) {
+			timeConstants += 2.0f * azaMaxf(2.0f / damping[i], 1.0f);
+		}
+	} else {
+		if (data->config.kind == AZA_FILTER_BAND_PASS) poles *= 2;
+		timeConstants = (float)poles;
+	}
+	// Each pole takes ln(1e6) time constants to fall below -120dB
+	float tailFrames = timeConstants * 13.815511f * (float)samplerate / (AZA_TAU * frequency);
+	specs.tailFrames = (uint32_t)azaMinf(ceilf(tailFrames), 1.0e9f);
+	specs.skipOnSilence = true;
+	return specs;
+}
+
+// Computes a channel's coefficients for frequency into values, indexed by row
+static void azaFilterGetChannelCoefficients(const azaFilterCoefficients *coefficients, float frequency, float values[AZAUDIO_FILTER_MAX_COEFFICIENT_ROWS]) {
+	switch (coefficients->topology) {
+		case AZA_FILTER_TOPOLOGY_ONE_POLE: {
+			values[0] = azaClampf(expf(-AZA_TAU * (frequency / (float)coefficients->samplerate)), 0.0f, 1.0f);
+		} break;
+		case AZA_FILTER_TOPOLOGY_SVF: {
+			float damping[AZAUDIO_FILTER_MAX_POLES];
+			uint32_t sections = azaFilterGetSVFDampings(coefficients->kind, coefficients->poles, damping);
+			// Prewarped so the cutoff lands where it should. Past nyquist tan wraps around, so stay just under it.
+			float g = tanf(AZA_PI * azaClampf(frequency / (float)coefficients->samplerate, 0.0f, 0.499f));
+			for (uint32_t i = 0; i < sections; i++) {
+				uint32_t row = coefficients->stages[i].row;
+				float a1 = 1.0f / (1.0f + g * (g + damping[i]));
+				float a2 = g * a1;
+				values[row+0] = a1;
+				values[row+1] = a2;
+				values[row+2] = g * a2;
+			}
+		} break;
+		case AZA_FILTER_TOPOLOGY_COUNT: break;
+	}
+}
+
+// Sets a channel's coefficients to endFrequency, with steps that ramp them from startFrequency across frames.
+static void azaFilterUpdateChannelCoefficients(azaFilter *data, uint8_t channel, float startFrequency, float endFrequency, uint32_t frames) {
+	azaFilterCoefficients *coefficients = &data->coefficients;
+	float start[AZAUDIO_FILTER_MAX_COEFFICIENT_ROWS];
+	float end[AZAUDIO_FILTER_MAX_COEFFICIENT_ROWS];
+	bool ramping = startFrequency != endFrequency && frames > 0;
+	if (ramping) {
+		if (startFrequency == coefficients->frequency[channel]) {
+			// Picking up where the last block left off, which is the usual case
+			for (uint32_t row = 0; row < coefficients->rowCount; row++) {
+				start[row] = coefficients->channels[row][channel];
+			}
+		} else {
+			azaFilterGetChannelCoefficients(coefficients, startFrequency, start);
+		}
+	}
+	azaFilterGetChannelCoefficients(coefficients, endFrequency, end);
+	for (uint32_t row = 0; row < coefficients->rowCount; row++) {
+		coefficients->channels[row][channel] = end[row];
+		coefficients->steps[row][channel] = ramping ? (end[row] - start[row]) / (float)frames : 0.0f;
+	}
+	coefficients->frequency[channel] = endFrequency;
+	coefficients->ramping[channel] = ramping;
+}
+
+// Moves each channel's frequency follower along by frames, writing where it starts and ends in this block.
+static void azaFilterUpdateFrequencies(azaFilter *data, uint32_t frames, uint32_t samplerate, uint8_t channelCount, float startFrequency[], float endFrequency[]) {
+	bool jump = data->config.frequencyFollowTime_ms <= 0.0f;
+	float deltaT = jump ? 1.0f : (float)frames / aza_ms_to_samples(data->config.frequencyFollowTime_ms, (float)samplerate);
+	for (uint8_t c = 0; c < channelCount; c++) {
+		azaFollowerLinear *follower = &data->channelData[c].frequency;
+		float target = azaFilterGetChannelFrequency(data, c);
+		if (jump) {
+			azaFollowerLinearJump(follower, target);
+		} else {
+			azaFollowerLinearSetTarget(follower, target);
+		}
+		startFrequency[c] = azaFollowerLinearUpdate(follower, deltaT);
+		endFrequency[c] = azaFollowerLinearGetValue(follower);
+	}
+}
+
+// Brings data->coefficients up to date for a block of frames where each channel's frequency goes from startFrequency to endFrequency, only recomputing what changed.
+// Changing anything else jumps straight to the new coefficients, since the stages themselves change.
+static void azaFilterUpdateCoefficients(azaFilter *data, uint32_t samplerate, uint8_t channelCount, uint32_t frames, float startFrequency[], float endFrequency[]) {
+	azaFilterCoefficients *coefficients = &data->coefficients;
+	uint32_t poles = AZA_MIN(data->config.poles+1, AZAUDIO_FILTER_MAX_POLES);
+	azaFilterTopology topology = data->config.topology < AZA_FILTER_TOPOLOGY_COUNT ? data->config.topology : AZA_FILTER_TOPOLOGY_ONE_POLE;
+	if (
+		coefficients->samplerate == samplerate
+		&& coefficients->poles == poles
+		&& coefficients->kind == data->config.kind
+		&& coefficients->topology == topology
+	) {
+		for (uint8_t c = 0; c < channelCount; c++) {
+			if (startFrequency[c] != endFrequency[c] || endFrequency[c] != coefficients->frequency[c] || coefficients->ramping[c]) {
+				azaFilterUpdateChannelCoefficients(data, c, startFrequency[c], endFrequency[c], frames);
+			}
+		}
+		return;
+	}
+	// Different stages will use different rows of state, so it would only be garbage now.
+	if (coefficients->samplerate != 0 && (coefficients->topology != topology || coefficients->kind != data->config.kind)) {
+		memset(data->state, 0, sizeof(data->state));
+	}
+	coefficients->samplerate = samplerate;
+	coefficients->poles = poles;
+	coefficients->kind = data->config.kind;
+	coefficients->topology = topology;
+	switch (topology) {
+		case AZA_FILTER_TOPOLOGY_ONE_POLE: {
+			// Every one-pole is the same aside from which kind it is, so the kernels only need to know how many there are.
+			coefficients->stageCount = coefficients->kind == AZA_FILTER_BAND_PASS ? 2*poles : poles;
+			coefficients->rowCount = 1;
+		} break;
+		case AZA_FILTER_TOPOLOGY_SVF: {
+			// low = v2, band = v1, high = x - k*v1 - v2
+			float damping[AZAUDIO_FILTER_MAX_POLES];
+			uint32_t sections = azaFilterGetSVFDampings(coefficients->kind, poles, damping);
+			coefficients->stageCount = coefficients->kind < AZA_FILTER_KIND_COUNT ? sections : 0;
+			coefficients->rowCount = coefficients->kind == AZA_FILTER_BAND_PASS ? 3 : 3*coefficients->stageCount;
+			for (uint32_t i = 0; i < coefficients->stageCount; i++) {
+				azaFilterStage *stage = &coefficients->stages[i];
+				// Band pass sections are all the same, so they can share their coefficients.
+				stage->row = coefficients->kind == AZA_FILTER_BAND_PASS ? 0 : 3*i;
+				// The real pole of an odd order is a double pole with one of them cancelled by a zero, where low + band is 1/(s+1) and high + band is s/(s+1).
+				bool realPole = (poles & 1) && i == 0;
+				switch (coefficients->kind) {
+					case AZA_FILTER_HIGH_PASS:
+						stage->mix[0] = 1.0f;
+						stage->mix[1] = realPole ? -1.0f : -damping[i];
+						stage->mix[2] = -1.0f;
+						break;
+					case AZA_FILTER_LOW_PASS:
+						stage->mix[0] = 0.0f;
+						stage->mix[1] = realPole ? 1.0f : 0.0f;
+						stage->mix[2] = 1.0f;
+						break;
+					case AZA_FILTER_BAND_PASS:
+						// k*band has unity gain at the cutoff
+						stage->mix[0] = 0.0f;
+						stage->mix[1] = damping[i];
+						stage->mix[2] = 0.0f;
+						break;
+					default: break;
+				}
+			}
+		} break;
+		case AZA_FILTER_TOPOLOGY_COUNT: break;
+	}
+	// Do all of them, so channels that show up later already have valid coefficients.
+	for (uint8_t c = 0; c < AZA_MAX_CHANNEL_POSITIONS; c++) {
+		float frequency = c < channelCount ? endFrequency[c] : azaFilterGetChannelFrequency(data, c);
+		azaFilterUpdateChannelCoefficients(data, c, frequency, frequency, frames);
+	}
+}
+
 int azaFilterProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	// Bypass handled by azaDSPProcess
 	int err = AZA_SUCCESS;
@@ -132,56 +352,11 @@ int azaFilterProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags)
 		azaMetersUpdate(&data->metersInput, src, 1.0f);
 	}
 
-	uint32_t poles = AZA_MIN(data->config.poles+1, AZAUDIO_FILTER_MAX_POLES);
-	for (uint8_t c = 0; c < dst->channelLayout.count; c++) {
-		azaFilterChannelData *channelData = &data->channelData[c];
-		float channelFrequencyOverride = data->config.channelFrequencyOverride[c];
-		float frequency = channelFrequencyOverride != 0.0f ? channelFrequencyOverride : data->config.frequency;
-		float decay = azaClampf(expf(-AZA_TAU * (frequency / (float)dst->samplerate)), 0.0f, 1.0f);
-
-		switch (data->config.kind) {
-			case AZA_FILTER_HIGH_PASS: {
-				for (uint32_t i = 0; i < dst->frames; i++) {
-					// TODO: High pass seems to lose a lot of volume with lots of poles. Investigate if this is expected and how to handle it.
-					float sample = src->pSamples[i * src->stride + c];
-					channelData->outputs[0] = sample + decay * (channelData->outputs[0] - sample);
-					sample -= channelData->outputs[0];
-					for (uint32_t pole = 1; pole < poles; pole++) {
-						channelData->outputs[pole] = sample + decay * (channelData->outputs[pole] - sample);
-						sample -= channelData->outputs[pole];
-					}
-					dst->pSamples[i * dst->stride + c] = sample * amountWet + src->pSamples[i * src->stride + c] * amountDry;
-				}
-			} break;
-			case AZA_FILTER_LOW_PASS: {
-				for (uint32_t i = 0; i < dst->frames; i++) {
-					float sample = src->pSamples[i * src->stride + c];
-					channelData->outputs[0] = sample + decay * (channelData->outputs[0] - sample);
-					for (uint32_t pole = 1; pole < poles; pole++) {
-						channelData->outputs[pole] = channelData->outputs[pole-1] + decay * (channelData->outputs[pole] - channelData->outputs[pole-1]);
-					}
-					dst->pSamples[i * dst->stride + c] = channelData->outputs[poles-1] * amountWet + src->pSamples[i * src->stride + c] * amountDry;
-				}
-			} break;
-			case AZA_FILTER_BAND_PASS: {
-				for (uint32_t i = 0; i < dst->frames; i++) {
-					float sample = src->pSamples[i * src->stride + c];
-					for (uint32_t pole = 0; pole < poles; pole++) {
-						// Low pass
-						channelData->outputs[2*pole+0] = sample + decay * (channelData->outputs[2*pole+0] - sample);
-						sample = channelData->outputs[2*pole+0];
-						// High pass
-						channelData->outputs[2*pole+1] = sample + decay * (channelData->outputs[2*pole+1] - sample);
-						sample -= channelData->outputs[2*pole+1];
-						// Compensate for the innate -3dB at the cutoff, done twice is -6dB, which is ~1/2 amp
-						sample *= 2.0f;
-					}
-					dst->pSamples[i * dst->stride + c] = sample * amountWet + src->pSamples[i * src->stride + c] * amountDry;
-				}
-			} break;
-			case AZA_FILTER_KIND_COUNT: break;
-		}
-	}
+	float startFrequency[AZA_MAX_CHANNEL_POSITIONS];
+	float endFrequency[AZA_MAX_CHANNEL_POSITIONS];
+	azaFilterUpdateFrequencies(data, dst->frames, dst->samplerate, dst->channelLayout.count, startFrequency, endFrequency);
+	azaFilterUpdateCoefficients(data, dst->samplerate, dst->channelLayout.count, dst->frames, startFrequency, endFrequency);
+	azaFilterProcessCascade(data, dst, src, amountWet, amountDry);
 
 	if (azaMixerGUIDSPIsSelected(dsp)) {
 		azaMetersUpdate(&data->metersOutput, src, 1.0f);
@@ -236,6 +411,15 @@ void azaFilterDraw(azaDSP *dsp, azagRect bounds) {
 		}
 		azagDrawRect(kindRect, highlighted ? azagThemeCurrent.colorSwitchHighlight : azagThemeCurrent.colorSwitch);
 		azagDrawTextMargin(azaTextFormat("%udB/oct", poles*6), kindRect.xy, AZAG_TEXT_SCALE_TEXT, colorText);
+		kindRect.y += kindRect.h + azagThemeCurrent.margin.y;
+	}
+	{ // topology
+		bool highlighted = azagMouseInRect(kindRect);
+		if (highlighted && azagMousePressed(AZAG_MOUSE_BUTTON_LEFT)) {
+			data->config.topology = (azaFilterTopology)((data->config.topology + 1) % AZA_FILTER_TOPOLOGY_COUNT);
+		}
+		azagDrawRect(kindRect, highlighted ? azagThemeCurrent.colorSwitchHighlight : azagThemeCurrent.colorSwitch);
+		azagDrawTextMargin(azaFilterTopologyString[data->config.topology % AZA_FILTER_TOPOLOGY_COUNT], kindRect.xy, AZAG_TEXT_SCALE_TEXT, colorText);
 	}
 	azagRectShrinkLeftMargin(&bounds, kindRect.w);
 	float usedWidth = azagDrawSliderFloatLog(bounds, &data->config.frequency, 5.0f, 24000.0f, 0.1f, 500.0f, "Cutoff Frequency", "%.1fHz");
@@ -244,4 +428,18 @@ void azaFilterDraw(azaDSP *dsp, azagRect bounds) {
 	azagRectShrinkLeftMargin(&bounds, usedWidth);
 	float totalWidth = bounds.x - boundsStartX + azagThemeCurrent.margin.x;
 	data->dsp.guiMetadata.drawTargetWidth = totalWidth;
-}
\ No newline at end of file
+}
+
+
+
+// Utilities
+
+
+
+void azaFilterSetRamps(azaFilter *data, uint8_t numChannels, float startFrequency[], float endFrequency[], uint32_t frames, uint32_t samplerate) {
+	data->config.frequencyFollowTime_ms = aza_samples_to_ms((float)frames, (float)samplerate);
+	for (uint8_t c = 0; c < numChannels; c++) {
+		azaFollowerLinearJump(&data->channelData[c].frequency, startFrequency[c]);
+		data->config.channelFrequencyOverride[c] = endFrequency[c];
+	}
+}
@@ -49,6 +49,16 @@ typedef enum azaFilterKind {
 } azaFilterKind;
 extern const char *azaFilterKindString[];
 
+typedef enum azaFilterTopology {
+	// Cascaded one-pole filters, each of which adds 6dB/oct. The response at the cutoff sags by 3dB for every pole.
+	AZA_FILTER_TOPOLOGY_ONE_POLE=0,
+	// Cascaded state variable filters (using the topology-preserving transform), each of which covers 2 poles. Low and high pass are tuned as Butterworth filters, so the passband stays flat right up to the cutoff. Band pass has the same shape as AZA_FILTER_TOPOLOGY_ONE_POLE, but it lands on unity gain at the cutoff.
+	AZA_FILTER_TOPOLOGY_SVF,
+
+	AZA_FILTER_TOPOLOGY_COUNT
+} azaFilterTopology;
+extern const char *azaFilterTopologyString[];
+
 typedef struct azaFilterConfig {
 	azaFilterKind kind;
 	// pole count - 1 (defaults to AZA_FILTER_6_DB)
@@ -59,16 +69,55 @@ typedef struct azaFilterConfig {
 	float dryMix;
 	// Additional wet gain in dB
 	float gainWet;
-	// How long it takes to linear fade into the target frequency
+	// How long it takes to linear fade into the target frequency, where 0 jumps straight to it. While it fades, the coefficients are interpolated every frame.
 	float frequencyFollowTime_ms;
 	// As long as these are 0.0f, we use the frequency above, otherwise you can specify a different frequency on a per-channel basis.
 	float channelFrequencyOverride[AZA_MAX_CHANNEL_POSITIONS];
+	// How the poles are built (defaults to AZA_FILTER_TOPOLOGY_ONE_POLE)
+	azaFilterTopology topology;
 } azaFilterConfig;
 
+// Every per-channel array has room for this many channels, which rounds AZA_MAX_CHANNEL_POSITIONS up to a whole number of 8-wide vectors.
+#define AZAUDIO_FILTER_LANES ((AZA_MAX_CHANNEL_POSITIONS + 7) & ~7)
+// The most stages a filter can have, which is the band pass with 2 one-poles or 1 SVF section per pole.
+#define AZAUDIO_FILTER_MAX_STAGES (2*AZAUDIO_FILTER_MAX_POLES)
+// SVF low and high pass sections each need their own a1, a2, and a3
+#define AZAUDIO_FILTER_MAX_COEFFICIENT_ROWS (3*AZAUDIO_FILTER_MAX_POLES/2)
+
+// One section of an AZA_FILTER_TOPOLOGY_SVF cascade. One-poles don't need these, since they only differ by kind.
+typedef struct azaFilterStage {
+	// Index of this section's first row in azaFilterCoefficients.channels
+	uint32_t row;
+	// How the output is made from the section's input (x), band pass (v1), and low pass (v2).
+	// output = mix[0]*x + mix[1]*v1 + mix[2]*v2
+	float mix[3];
+} azaFilterStage;
+
+typedef struct azaFilterCoefficients {
+	// What the coefficients were computed for, where a samplerate of 0 means they need to be computed.
+	uint32_t samplerate;
+	uint32_t poles;
+	azaFilterKind kind;
+	azaFilterTopology topology;
+	float frequency[AZAUDIO_FILTER_LANES];
+	// How many one-poles or SVF sections there are
+	uint32_t stageCount;
+	azaFilterStage stages[AZAUDIO_FILTER_MAX_POLES];
+	// How many rows of channels and steps are used
+	uint32_t rowCount;
+	// Whether each channel's steps are non-zero
+	bool ramping[AZAUDIO_FILTER_LANES];
+	// Per-channel coefficients for the end of the current block.
+	// AZA_FILTER_TOPOLOGY_ONE_POLE: the decay in row 0, which every one-pole uses
+	// AZA_FILTER_TOPOLOGY_SVF: a1, a2, and a3 in 3 consecutive rows
+	float channels[AZAUDIO_FILTER_MAX_COEFFICIENT_ROWS][AZAUDIO_FILTER_LANES];
+	// How much each coefficient in channels moves per frame while the frequency ramps across a block. The block starts at channels - steps*frames.
+	float steps[AZAUDIO_FILTER_MAX_COEFFICIENT_ROWS][AZAUDIO_FILTER_LANES];
+} azaFilterCoefficients;
+
 typedef struct azaFilterChannelData {
-	// Only used if channelFrequencyOverrides are used
+	// Follows the channel's frequency, which is either config.frequency or its channelFrequencyOverride
 	azaFollowerLinear frequency;
-	float outputs[2*AZAUDIO_FILTER_MAX_POLES];
 } azaFilterChannelData;
 
 typedef struct azaFilter {
@@ -81,6 +130,11 @@ typedef struct azaFilter {
 	azaFollowerLinear frequency;
 
 	azaFilterChannelData channelData[AZA_MAX_CHANNEL_POSITIONS];
+
+	// Only recomputed when the frequency or anything else they depend on changes
+	azaFilterCoefficients coefficients;
+	// State for every stage, where each row holds all the channels side by side, so the kernels can run several channels at once in vector lanes. A one-pole uses 1 row and an SVF section uses 2.
+	float state[AZAUDIO_FILTER_MAX_STAGES][AZAUDIO_FILTER_LANES];
 } azaFilter;
 
 // initializes azaFilter in existing memory
@@ -101,15 +155,29 @@ void azaFilterFree(azaDSP *dsp);
 azaDSP* azaFilterMakeDefault();
 azaDSP* azaFilterMakeDuplicate(azaDSP *src);
 int azaFilterCopyConfig(azaDSP *dst, azaDSP *src);
+azaDSPSpecs azaFilterGetSpecs(azaDSP *dsp, uint32_t samplerate);
 
 int azaFilterProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags);
 
+// Runs every channel of src through the stages in data->coefficients and writes wet*output + dry*src into dst. The coefficients must be up to date, including their steps for dst->frames.
+// Implemented in specialized/azaFilterCascade.c
+void azaFilterProcessCascade(azaFilter *data, azaBuffer *dst, azaBuffer *src, float amountWet, float amountDry);
+
 
 
 void azaFilterDraw(azaDSP *dsp, azagRect bounds);
 
 
 
+// Utilities
+
+// Sets up targets and followers such that the cutoff will ramp from start to end perfectly in the span of frames at the given samplerate, interpolating the coefficients every frame.
+// Useful for inlining into another synchronous process.
+// Expects startFrequency and endFrequency to be in arrays of length numChannels. The end frequencies are set as the channelFrequencyOverrides, so they can't be 0.
+void azaFilterSetRamps(azaFilter *data, uint8_t numChannels, float startFrequency[], float endFrequency[], uint32_t frames, uint32_t samplerate);
+
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -18,7 +18,7 @@ static const azaDSPFuncs azaGateFuncs = {
 	.fp_makeDefault = azaGateMakeDefault,
 	.fp_makeDuplicate = azaGateMakeDuplicate,
 	.fp_copyConfig = azaGateCopyConfig,
-	.fp_getSpecs = NULL,
+	.fp_getSpecs = azaGateGetSpecs,
 	.fp_process = azaGateProcess,
 	.fp_free = azaGateFree,
 	.fp_draw = azaGateDraw,
@@ -104,6 +104,22 @@ int azaGateCopyConfig(azaDSP *dst, azaDSP *src) {
 	return AZA_SUCCESS;
 }
 
+azaDSPSpecs azaGateGetSpecs(azaDSP *dsp, uint32_t samplerate) {
+	azaGate *data = (azaGate*)dsp;
+	azaDSPSpecs specs = {0};
+	uint32_t activationTail = 0;
+	if (data->activationEffects.steps.count) {
+		azaDSPSpecs specsActivation = azaDSPChainGetSpecs(&data->activationEffects, samplerate);
+		// If the activation effects can make sound from nothing, so can our gain
+		if (!specsActivation.skipOnSilence) return specs;
+		activationTail = specsActivation.latencyFrames + specsActivation.tailFrames;
+	}
+	// The rms window has to empty out and the attenuation has to settle (5 time constants gets us within 1dB of the floor)
+	specs.tailFrames = activationTail + data->rms.config.windowSamples + (uint32_t)aza_ms_to_samples(5.0f * data->config.decay_ms, (float)samplerate);
+	specs.skipOnSilence = true;
+	return specs;
+}
+
 int azaGateProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	// Bypass handled by azaDSPProcess
 	int err = AZA_SUCCESS;
@@ -133,6 +149,10 @@ int azaGateProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	if (data->activationEffects.steps.count) {
 		activationBuffer = azaPushSideBufferCopy(src);
 		sideBuffersInUse++;
+		if AZA_UNLIKELY(!activationBuffer.pSamples) {
+			err = AZA_ERROR_OUT_OF_MEMORY;
+			goto error;
+		}
 		err = azaDSPChainProcess(&data->activationEffects, &activationBuffer, &activationBuffer, flags);
 		if AZA_UNLIKELY(err) {
 			goto error;
@@ -140,6 +160,10 @@ int azaGateProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	} else {
 		activationBuffer = *src;
 	}
+	if AZA_UNLIKELY(!rmsBuffer.pSamples) {
+		err = AZA_ERROR_OUT_OF_MEMORY;
+		goto error;
+	}
 
 	err = azaRMSProcess(&data->rms, &rmsBuffer, &activationBuffer, flags);
 	if AZA_UNLIKELY(err) {
@@ -150,8 +174,11 @@ int azaGateProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	float decayFactor = expf(-1.0f / (data->config.decay_ms * t));
 	float totalGain = data->config.gainOutput + data->config.gainInput;
 	float undergainFactor = AZA_MAX(0.0f, data->config.ratio - 1.0f);
+	// Same as azaCompressor, only the envelope needs to be serial, so the conversions to and from dB are done in place on the whole block.
+	float *levels = rmsBuffer.pSamples;
+	aza_amp_to_dbf_array(levels, levels, dst->frames);
 	for (size_t i = 0; i < dst->frames; i++) {
-		float rms = aza_amp_to_dbf(rmsBuffer.pSamples[i]) + data->config.gainInput;
+		float rms = levels[i] + data->config.gainInput;
 		if (rms < -120.0f) rms = -120.0f;
 		if (rms > data->config.threshold) {
 			data->attenuation = rms + attackFactor * (data->attenuation - rms);
@@ -165,7 +192,11 @@ int azaGateProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 			gain = undergainFactor * (data->attenuation - data->config.threshold);
 		}
 		data->gain = gain;
-		float amp = aza_db_to_ampf(gain + totalGain);
+		levels[i] = gain + totalGain;
+	}
+	aza_db_to_ampf_array(levels, levels, dst->frames);
+	for (size_t i = 0; i < dst->frames; i++) {
+		float amp = levels[i];
 		for (uint8_t c = 0; c < dst->channelLayout.count; c++) {
 			dst->pSamples[i * dst->stride + c] *= amp;
 		}
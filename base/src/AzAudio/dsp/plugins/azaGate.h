@@ -71,6 +71,7 @@ void azaGateFree(azaDSP *dsp);
 azaDSP* azaGateMakeDefault();
 azaDSP* azaGateMakeDuplicate(azaDSP *src);
 int azaGateCopyConfig(azaDSP *dst, azaDSP *src);
+azaDSPSpecs azaGateGetSpecs(azaDSP *dsp, uint32_t samplerate);
 
 int azaGateProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags);
 
@@ -43,11 +43,42 @@ const azaDSP azaLookaheadLimiterHeader = {
 void azaLookaheadLimiterInit(azaLookaheadLimiter *data, azaLookaheadLimiterConfig config) {
 	data->dsp = azaLookaheadLimiterHeader;
 	data->config = config;
+	data->lookaheadFrames = 0;
+	data->capacityFrames = 0;
+	data->bufferChannels = 0;
+	data->peaks = NULL;
+	data->buffer = NULL;
 	azaLookaheadLimiterReset(data);
+	// If this fails we'll try again when we process
+	azaLookaheadLimiterReserve(data, AZA_SAMPLERATE_DEFAULT, AZA_CHANNELS_DEFAULT);
 }
 
 void azaLookaheadLimiterDeinit(azaLookaheadLimiter *data) {
-	// Nah, we good
+	if (data->peaks) {
+		aza_free(data->peaks);
+		data->peaks = NULL;
+	}
+	if (data->buffer) {
+		aza_free(data->buffer);
+		data->buffer = NULL;
+	}
+}
+
+// Resets everything that lives in the rings
+static void azaLookaheadLimiterResetWindow(azaLookaheadLimiter *data) {
+	data->index = 0;
+	data->framesSinceSum = 0;
+	data->frame = 0;
+	data->peaksFirst = 0;
+	data->peaksCount = 0;
+	data->gainHeld = 1.0f;
+	data->gainSum = (float)data->lookaheadFrames;
+	if (data->buffer) {
+		for (uint32_t i = 0; i < data->capacityFrames; i++) {
+			data->buffer[i] = 1.0f;
+		}
+		memset(data->buffer + data->capacityFrames, 0, sizeof(float) * data->capacityFrames * data->bufferChannels);
+	}
 }
 
 void azaLookaheadLimiterReset(azaLookaheadLimiter *data) {
@@ -55,18 +86,16 @@ void azaLookaheadLimiterReset(azaLookaheadLimiter *data) {
 	azaMetersReset(&data->metersOutput);
 	data->minAmp = 1.0f;
 	data->minAmpShort = 1.0f;
-	memset(data->peakBuffer, 0, sizeof(data->peakBuffer));
-	data->index = 0;
-	data->cooldown = 0;
-	data->sum = 1.0f;
-	data->slope = 0.0f;
-	memset(data->channelData, 0, sizeof(data->channelData));
+	azaLookaheadLimiterResetWindow(data);
 }
 
 void azaLookaheadLimiterResetChannels(azaLookaheadLimiter *data, uint32_t firstChannel, uint32_t channelCount) {
 	azaMetersResetChannels(&data->metersInput, firstChannel, channelCount);
 	azaMetersResetChannels(&data->metersOutput, firstChannel, channelCount);
-	memset(data->channelData + firstChannel, 0, sizeof(data->channelData[0]) * channelCount);
+	if (data->buffer && firstChannel < data->bufferChannels) {
+		channelCount = AZA_MIN(channelCount, data->bufferChannels - firstChannel);
+		memset(data->buffer + data->capacityFrames * (1 + firstChannel), 0, sizeof(float) * data->capacityFrames * channelCount);
+	}
 }
 
 azaLookaheadLimiter* azaLookaheadLimiterMake(azaLookaheadLimiterConfig config) {
@@ -86,6 +115,7 @@ azaDSP* azaLookaheadLimiterMakeDefault() {
 	return (azaDSP*)azaLookaheadLimiterMake((azaLookaheadLimiterConfig) {
 		.gainInput = 0.0f,
 		.gainOutput = 0.0f,
+		.lookahead_ms = AZAUDIO_LOOKAHEAD_DEFAULT_MS,
 	});
 }
 
@@ -101,6 +131,84 @@ int azaLookaheadLimiterCopyConfig(azaDSP *dst, azaDSP *src) {
 	return AZA_SUCCESS;
 }
 
+static uint32_t azaLookaheadLimiterMsToFrames(float lookahead_ms, uint32_t samplerate) {
+	float frames = aza_ms_to_samples(lookahead_ms, (float)samplerate);
+	return frames >= 1.0f ? (uint32_t)frames : 1;
+}
+
+static uint32_t azaLookaheadLimiterGetLookaheadFrames(azaLookaheadLimiter *data, uint32_t samplerate) {
+	float lookahead_ms = data->config.lookahead_ms;
+	// Written this way so NaN also gets us the default
+	if (!(lookahead_ms > 0.0f)) {
+		lookahead_ms = AZAUDIO_LOOKAHEAD_DEFAULT_MS;
+	}
+	lookahead_ms = azaMinf(lookahead_ms, AZAUDIO_LOOKAHEAD_MAX_MS);
+	return azaLookaheadLimiterMsToFrames(lookahead_ms, samplerate);
+}
+
+int azaLookaheadLimiterReserve(azaLookaheadLimiter *data, uint32_t samplerate, uint8_t channelCount) {
+	uint32_t capacityFrames = AZA_MAX(azaLookaheadLimiterMsToFrames(AZAUDIO_LOOKAHEAD_MAX_MS, samplerate), data->capacityFrames);
+	// Keep room for any channels we've had before so going back and forth doesn't keep reallocating
+	uint32_t bufferChannels = AZA_MAX(channelCount, data->bufferChannels);
+	bool sameCapacity = capacityFrames == data->capacityFrames;
+	if (sameCapacity && bufferChannels == data->bufferChannels) return AZA_SUCCESS;
+	float *buffer = aza_calloc(capacityFrames * (1 + bufferChannels), sizeof(float));
+	if (!buffer) return AZA_ERROR_OUT_OF_MEMORY;
+	if (sameCapacity) {
+		// We only gained channels, so everything carries over as-is
+		memcpy(buffer, data->buffer, sizeof(float) * capacityFrames * (1 + data->bufferChannels));
+	} else {
+		azaLookaheadLimiterPeak *peaks = aza_calloc(capacityFrames + 1, sizeof(azaLookaheadLimiterPeak));
+		if (!peaks) {
+			aza_free(buffer);
+			return AZA_ERROR_OUT_OF_MEMORY;
+		}
+		if (data->peaks) {
+			aza_free(data->peaks);
+		}
+		data->peaks = peaks;
+	}
+	if (data->buffer) {
+		aza_free(data->buffer);
+	}
+	data->buffer = buffer;
+	data->bufferChannels = bufferChannels;
+	if (!sameCapacity) {
+		data->capacityFrames = capacityFrames;
+		// The rings wrap in different places now, so nothing in them lines up anymore
+		azaLookaheadLimiterResetWindow(data);
+	}
+	return AZA_SUCCESS;
+}
+
+// Sums up the last lookaheadFrames held gains from oldest to newest
+static float azaLookaheadLimiterSumWindow(azaLookaheadLimiter *data) {
+	uint32_t j = data->index + data->capacityFrames - data->lookaheadFrames;
+	if (j >= data->capacityFrames) j -= data->capacityFrames;
+	float sum = 0.0f;
+	for (uint32_t i = 0; i < data->lookaheadFrames; i++) {
+		sum += data->buffer[j];
+		if (++j >= data->capacityFrames) j = 0;
+	}
+	return sum;
+}
+
+static int azaLookaheadLimiterHandleBuffer(azaLookaheadLimiter *data, uint32_t samplerate, uint8_t channelCount) {
+	uint32_t lookaheadFrames = azaLookaheadLimiterGetLookaheadFrames(data, samplerate);
+	if AZA_UNLIKELY(lookaheadFrames > data->capacityFrames || channelCount > data->bufferChannels) {
+		// Nobody reserved room for this format, so all we can do is allocate here
+		int err = azaLookaheadLimiterReserve(data, samplerate, channelCount);
+		if AZA_UNLIKELY(err) return err;
+	}
+	if (lookaheadFrames != data->lookaheadFrames) {
+		// Everything stays where it is in the rings, we just read from a different distance behind
+		data->lookaheadFrames = lookaheadFrames;
+		data->framesSinceSum = 0;
+		data->gainSum = azaLookaheadLimiterSumWindow(data);
+	}
+	return AZA_SUCCESS;
+}
+
 int azaLookaheadLimiterProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	// Bypass handled by azaDSPProcess
 	int err = AZA_SUCCESS;
@@ -114,6 +222,9 @@ int azaLookaheadLimiterProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32
 	err = azaCheckBuffersForDSPProcess(dst, src, /* sameFrameCount: */ true, /* sameChannelCount: */ true);
 	if AZA_UNLIKELY(err) return err;
 
+	err = azaLookaheadLimiterHandleBuffer(data, dst->samplerate, dst->channelLayout.count);
+	if AZA_UNLIKELY(err) return err;
+
 	if (dst->channelLayout.count > data->dsp.processMetadata.prevChannelCountDst) {
 		azaLookaheadLimiterResetChannels(data, data->dsp.processMetadata.prevChannelCountDst, dst->channelLayout.count - data->dsp.processMetadata.prevChannelCountDst);
 	}
@@ -124,11 +235,27 @@ int azaLookaheadLimiterProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32
 	if (azaMixerGUIDSPIsSelected(dsp)) {
 		azaMetersUpdate(&data->metersInput, src, amountInput);
 	}
-	// TODO: There's some odd behavior where CPU usage jumps the instant there's any attenuation and never drops again. Pls investigate!
 	azaBuffer gainBuffer;
 	gainBuffer = azaPushSideBufferZero(dst->frames, dst->leadingFrames, dst->trailingFrames, 1, dst->samplerate);
+	if AZA_UNLIKELY(!gainBuffer.pSamples) {
+		azaPopSideBuffer();
+		return AZA_ERROR_OUT_OF_MEMORY;
+	}
 	// TODO: It may be desirable to prevent the subwoofer channel from affecting the rest, and it may want its own independent limiter.
-	int index = data->index;
+	const uint32_t lookaheadFrames = data->lookaheadFrames;
+	const uint32_t capacityFrames = data->capacityFrames;
+	const uint32_t peaksCap = capacityFrames + 1;
+	// The peak that's coming out this frame is still in the window, so the window is 1 longer than the lookahead
+	const uint32_t windowFrames = lookaheadFrames + 1;
+	// Comes back up with a time constant of 5 lookaheads
+	const float releaseFactor = 1.0f / (float)(lookaheadFrames * 5);
+	float *window = data->buffer;
+	azaLookaheadLimiterPeak *peaks = data->peaks;
+	uint32_t index = data->index;
+	// Where we read what went in lookaheadFrames ago
+	uint32_t indexOut = index + capacityFrames - lookaheadFrames;
+	if (indexOut >= capacityFrames) indexOut -= capacityFrames;
+	const uint32_t indexOutStart = indexOut;
 	// Do all the gain calculations and put them into gainBuffer
 	for (uint32_t i = 0; i < dst->frames; i++) {
 		for (uint8_t c = 0; c < src->channelLayout.count; c++) {
@@ -136,43 +263,58 @@ int azaLookaheadLimiterProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32
 			gainBuffer.pSamples[i] = azaMaxf(sample, gainBuffer.pSamples[i]);
 		}
 		float peak = azaMaxf(gainBuffer.pSamples[i] * amountInput, 1.0f);
-		data->peakBuffer[index] = peak;
-		index = (index+1)%AZAUDIO_LOOKAHEAD_SAMPLES;
-		float slope = (1.0f / peak - data->sum) / AZAUDIO_LOOKAHEAD_SAMPLES;
-		if (slope < data->slope) {
-			data->slope = slope;
-			data->cooldown = AZAUDIO_LOOKAHEAD_SAMPLES;
-		} else if (data->cooldown == 0 && data->sum < 1.0f) {
-			data->slope = (1.0f - data->sum) / (AZAUDIO_LOOKAHEAD_SAMPLES * 5.0f);
-			for (int index2 = 0; index2 < AZAUDIO_LOOKAHEAD_SAMPLES; index2++) {
-				float peak2 = data->peakBuffer[(index+index2)%AZAUDIO_LOOKAHEAD_SAMPLES];
-				float slope2 = (1.0f / peak2 - data->sum) / (float)(index2+1);
-				if (slope2 < data->slope) {
-					data->slope = slope2;
-					data->cooldown = index2+1;
-				}
-			}
-		} else if (data->cooldown > 0) {
-			data->cooldown -= 1;
+		// Let go of the peak that came out last frame (or more if the lookahead just got shorter)
+		while (data->peaksCount && data->frame - peaks[data->peaksFirst].frame >= windowFrames) {
+			if (++data->peaksFirst >= peaksCap) data->peaksFirst = 0;
+			data->peaksCount--;
 		}
-		data->sum += data->slope;
-		data->minAmpShort = azaMinf(data->minAmpShort, data->sum);
-		if (data->sum > 1.0f) {
-			data->slope = 0.0f;
-			data->sum = 1.0f;
+		// Anything no bigger than the new peak can't be the biggest in the window anymore, since it'll leave before the new one does
+		while (data->peaksCount) {
+			uint32_t last = data->peaksFirst + data->peaksCount - 1;
+			if (last >= peaksCap) last -= peaksCap;
+			if (peaks[last].peak > peak) break;
+			data->peaksCount--;
 		}
-		gainBuffer.pSamples[i] = data->sum;
+		uint32_t next = data->peaksFirst + data->peaksCount;
+		if (next >= peaksCap) next -= peaksCap;
+		peaks[next].peak = peak;
+		peaks[next].frame = data->frame;
+		data->peaksCount++;
+		data->frame++;
+		// The held gain drops to meet the biggest peak in the window as soon as it comes in, and stays at or below it until it comes out
+		float gainHeld = data->gainHeld + (1.0f - data->gainHeld) * releaseFactor;
+		gainHeld = azaMinf(gainHeld, 1.0f / peaks[data->peaksFirst].peak);
+		data->gainHeld = gainHeld;
+		data->gainSum += gainHeld - window[indexOut];
+		window[index] = gainHeld;
+		if (++index >= capacityFrames) index = 0;
+		if (++indexOut >= capacityFrames) indexOut = 0;
+		if (++data->framesSinceSum >= lookaheadFrames) {
+			data->framesSinceSum = 0;
+			// Keep rounding errors from building up in the running sum
+			data->gainSum = 0.0f;
+			for (uint32_t j = 0, k = indexOut; j < lookaheadFrames; j++) {
+				data->gainSum += window[k];
+				if (++k >= capacityFrames) k = 0;
+			}
+		}
+		float gain = data->gainSum / (float)lookaheadFrames;
+		data->minAmpShort = azaMinf(data->minAmpShort, gain);
+		gainBuffer.pSamples[i] = gain;
 	}
 	data->minAmp = azaMinf(data->minAmp, data->minAmpShort);
 	// Apply the gain from gainBuffer to all the channels
 	for (uint8_t c = 0; c < dst->channelLayout.count; c++) {
-		azaLookaheadLimiterChannelData *channelData = &data->channelData[c];
-		index = data->index;
+		float *delay = data->buffer + capacityFrames * (1 + c);
+		uint32_t channelIndex = data->index;
+		uint32_t channelIndexOut = indexOutStart;
 
 		for (uint32_t i = 0; i < dst->frames; i++) {
-			channelData->valBuffer[index] = src->pSamples[i * src->stride + c];
-			index = (index+1)%AZAUDIO_LOOKAHEAD_SAMPLES;
-			float out = azaClampf(channelData->valBuffer[index] * gainBuffer.pSamples[i] * amountInput, -1.0f, 1.0f);
+			float sample = delay[channelIndexOut];
+			delay[channelIndex] = src->pSamples[i * src->stride + c];
+			if (++channelIndex >= capacityFrames) channelIndex = 0;
+			if (++channelIndexOut >= capacityFrames) channelIndexOut = 0;
+			float out = azaClampf(sample * gainBuffer.pSamples[i] * amountInput, -1.0f, 1.0f);
 			dst->pSamples[i * dst->stride + c] = out * amountOutput;
 		}
 	}
@@ -185,8 +327,13 @@ int azaLookaheadLimiterProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32
 }
 
 azaDSPSpecs azaLookaheadLimiterGetSpecs(azaDSP *dsp, uint32_t samplerate) {
+	azaLookaheadLimiter *data = (azaLookaheadLimiter*)dsp;
+	uint32_t lookaheadFrames = azaLookaheadLimiterGetLookaheadFrames(data, samplerate);
 	return (azaDSPSpecs) {
-		.latencyFrames = AZAUDIO_LOOKAHEAD_SAMPLES,
+		.latencyFrames = lookaheadFrames,
+		// Give the gain time to recover so we don't come back in with a stale peak
+		.tailFrames = lookaheadFrames * 5,
+		.skipOnSilence = true,
 	};
 }
 
@@ -248,6 +395,9 @@ void azaLookaheadLimiterDraw(azaDSP *dsp, azagRect bounds) {
 	}
 	data->minAmpShort = 1.0f;
 
+	float sliderWidth = azagDrawSliderFloatLog(bounds, &data->config.lookahead_ms, 0.1f, AZAUDIO_LOOKAHEAD_MAX_MS, 0.1f, AZAUDIO_LOOKAHEAD_DEFAULT_MS, "Lookahead", "%.1fms");
+	azagRectShrinkLeftMargin(&bounds, sliderWidth);
+
 	azagDrawFader(bounds, &data->config.gainOutput, NULL, false, "Output Gain", faderDBRange, faderDBHeadroom);
 	azagRectShrinkLeftMargin(&bounds, faderWidth);
 	azagDrawMeters(&data->metersOutput, bounds, faderDBRange, faderDBHeadroom);
@@ -17,12 +17,11 @@ extern "C" {
 
 extern const azaDSP azaLookaheadLimiterHeader;
 
-// TODO: Work on making the lookahead limiter more transparent without necessarily increasing latency. Perhaps find a way to make our linear envelope more like an S-curve? Also probably make the lookahead time configurable.
-// 128 samples at 48.0kHz is 128.0/48.0=2.7ms
-// 128 samples at 44.1kHz is 128.0/44.1=2.9ms
-//  64 samples at 48.0kHz is  64.0/48.0=1.3ms
-//  64 samples at 44.1kHz is  64.0/44.1=1.5ms
-#define AZAUDIO_LOOKAHEAD_SAMPLES 128
+// TODO: Work on making the lookahead limiter more transparent without necessarily increasing latency. Perhaps find a way to make our linear envelope more like an S-curve?
+// About the 128 samples at 48kHz that the lookahead used to be fixed at
+#define AZAUDIO_LOOKAHEAD_DEFAULT_MS 2.7f
+// Longer lookaheads get clamped to this, which is what we make room for so the lookahead can change without reallocating
+#define AZAUDIO_LOOKAHEAD_MAX_MS 50.0f
 
 
 
@@ -31,13 +30,20 @@ typedef struct azaLookaheadLimiterConfig {
 	float gainInput;
 	// output gain in dB
 	float gainOutput;
+	// How far ahead we look for peaks in ms, which is also how long the gain takes to ramp down to meet one, and how much latency we add.
+	// 0 or less means AZAUDIO_LOOKAHEAD_DEFAULT_MS. Always at least 1 sample and at most AZAUDIO_LOOKAHEAD_MAX_MS.
+	// Changing this while we run jumps the delay, repeating or skipping what the difference covers, but the signal and the gain carry over.
+	float lookahead_ms;
 } azaLookaheadLimiterConfig;
 
-typedef struct azaLookaheadLimiterChannelData {
-	float valBuffer[AZAUDIO_LOOKAHEAD_SAMPLES];
-} azaLookaheadLimiterChannelData;
+// One entry in the queue of upcoming peaks
+typedef struct azaLookaheadLimiterPeak {
+	float peak;
+	// Value of azaLookaheadLimiter.frame when this peak came in
+	uint32_t frame;
+} azaLookaheadLimiterPeak;
 
-// NOTE: This limiter increases latency by AZAUDIO_LOOKAHEAD_SAMPLES samples
+// NOTE: This limiter increases latency by config.lookahead_ms
 typedef struct azaLookaheadLimiter {
 	azaDSP dsp;
 	azaLookaheadLimiterConfig config;
@@ -46,17 +52,36 @@ typedef struct azaLookaheadLimiter {
 	azaMeters metersOutput;
 	float minAmp, minAmpShort;
 
-	// Data shared by all channels
-	float peakBuffer[AZAUDIO_LOOKAHEAD_SAMPLES];
-	int index;
-	int cooldown;
-	float sum;
-	float slope;
-	azaLookaheadLimiterChannelData channelData[AZA_MAX_CHANNEL_POSITIONS];
+	// The lookahead we're running with in frames, which is where our latency actually comes from
+	uint32_t lookaheadFrames;
+	// How many frames the rings in buffer have room for, which is the most lookaheadFrames can be without reallocating
+	uint32_t capacityFrames;
+	// How many channels buffer has room for
+	uint32_t bufferChannels;
+	// Where we write next in the held gains and every channel's delay line. We read lookaheadFrames behind it.
+	uint32_t index;
+	// How many frames since we last summed up the window from scratch
+	uint32_t framesSinceSum;
+	// Counts up every frame, only used to tell when peaks leave the window
+	uint32_t frame;
+	// Ring buffer of capacityFrames+1 peaks. Every peak is bigger than all the ones after it, so the first one is always the biggest in the window (a monotonic queue).
+	azaLookaheadLimiterPeak *peaks;
+	uint32_t peaksFirst;
+	uint32_t peaksCount;
+	// The held gain from before, which can drop immediately but comes back up slowly
+	float gainHeld;
+	// Sum of the last lookaheadFrames held gains (the window). Averaging them turns every step down into a linear ramp that finishes right as the peak comes out.
+	float gainSum;
+	// A ring of capacityFrames held gains followed by a delay line of capacityFrames for each channel
+	float *buffer;
 } azaLookaheadLimiter;
 
-// initializes azaLookaheadLimiter in existing memory
+// initializes azaLookaheadLimiter in existing memory, reserving room for AZA_SAMPLERATE_DEFAULT and AZA_CHANNELS_DEFAULT
 void azaLookaheadLimiterInit(azaLookaheadLimiter *data, azaLookaheadLimiterConfig config);
+// Makes room for any lookahead up to AZAUDIO_LOOKAHEAD_MAX_MS at samplerate with channelCount channels, so processing with them won't have to allocate. Don't call this while the limiter is being processed.
+// Processing anything bigger than what's been reserved allocates on the spot and resets the window.
+// returns AZA_ERROR_OUT_OF_MEMORY if we couldn't allocate, which leaves the limiter as it was
+int azaLookaheadLimiterReserve(azaLookaheadLimiter *data, uint32_t samplerate, uint8_t channelCount);
 // frees any additional memory that the azaLookaheadLimiter may have allocated
 void azaLookaheadLimiterDeinit(azaLookaheadLimiter *data);
 // Resets our state. May be called automatically.
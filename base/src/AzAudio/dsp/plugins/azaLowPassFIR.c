@@ -131,11 +131,15 @@ int azaLowPassFIRProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t fla
 		return AZA_ERROR_INVALID_FRAME_COUNT;
 	}
 	azaBuffer sideBuffer;
-	if (dst->pSamples == src->pSamples) {
+	if (azaBuffersOverlap(dst, src)) {
 		// We progressively write into dst as we sample, and our kernel will sample the frames we put into dst if we don't do this.
 		sideBuffer = azaPushSideBufferCopy(src);
 		src = &sideBuffer;
 		numSideBuffers++;
+		if AZA_UNLIKELY(!sideBuffer.pSamples) {
+			azaPopSideBuffers(numSideBuffers);
+			return AZA_ERROR_OUT_OF_MEMORY;
+		}
 	}
 
 	if (azaMixerGUIDSPIsSelected(dsp)) {
@@ -195,6 +199,7 @@ azaDSPSpecs azaLowPassFIRGetSpecs(azaDSP *dsp, uint32_t samplerate) {
 		.latencyFrames = 0,
 		.leadingFrames = maxKernelRadius,
 		.trailingFrames = maxKernelRadius,
+		.skipOnSilence = true,
 	};
 	return result;
 }
@@ -66,6 +66,7 @@ void azaMonitorSpectrumDeinit(azaMonitorSpectrum *data) {
 		data->outputBuffer = NULL;
 		data->outputBufferCapacity = 0;
 	}
+	azaFFTPlanDeinit(&data->fftPlan);
 }
 
 void azaMonitorSpectrumReset(azaMonitorSpectrum *data) {
@@ -148,6 +149,11 @@ static int azaMonitorSpectrumHandleBufferResizes(azaMonitorSpectrum *data, azaBu
 		}
 		data->outputBufferCapacity = requiredOutputCapacity;
 	}
+	if (data->fftPlan.len != data->config.window) {
+		azaFFTPlanDeinit(&data->fftPlan);
+		int err = azaFFTPlanInit(&data->fftPlan, data->config.window);
+		if (err) return err;
+	}
 	return AZA_SUCCESS;
 }
 
@@ -232,6 +238,10 @@ int azaMonitorSpectrumProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_
 				}
 			};
 			azaBuffer full = azaPushSideBuffer(data->config.window*2, 0, 0, 1, src->samplerate);
+			if AZA_UNLIKELY(!full.pSamples) {
+				azaPopSideBuffer();
+				return AZA_ERROR_OUT_OF_MEMORY;
+			}
 			azaBuffer dst = (azaBuffer) {
 				.pSamples = data->outputBuffer,
 				.samplerate = data->samplerate,
@@ -253,9 +263,8 @@ int azaMonitorSpectrumProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_
 						channelChosen = 0;
 					}
 					azaBufferCopyChannel(&real, 0, &inputBuffer, channelChosen);
-					azaBufferZero(&imag);
 					azaMonitorSpectrumApplyWindow(real);
-					azaFFT(real.pSamples, imag.pSamples, real.frames);
+					azaFFTPlanForwardReal(&data->fftPlan, real.pSamples, real.pSamples, imag.pSamples);
 					uint32_t window = (data->config.window >> 1) + 1;
 					for (uint32_t i = 0; i < window; i++) {
 						float x = real.pSamples[i];
@@ -273,9 +282,8 @@ int azaMonitorSpectrumProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_
 					uint32_t window = (data->config.window >> 1) + 1;
 					for (uint8_t c = 0; c < data->inputBufferChannelCount; c++) {
 						azaBufferCopyChannel(&real, 0, &inputBuffer, c);
-						azaBufferZero(&imag);
 						azaMonitorSpectrumApplyWindow(real);
-						azaFFT(real.pSamples, imag.pSamples, real.frames);
+						azaFFTPlanForwardReal(&data->fftPlan, real.pSamples, real.pSamples, imag.pSamples);
 						for (uint32_t i = 0; i < window; i++) {
 							float x = real.pSamples[i];
 							float y = imag.pSamples[i];
@@ -7,6 +7,7 @@
 #define AZAUDIO_AZAMONITORSPECTRUM_H
 
 #include "../azaDSP.h"
+#include "../../fft.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -61,6 +62,9 @@ typedef struct azaMonitorSpectrum {
 	uint16_t numCounted;
 	uint32_t outputBufferCapacity;
 	float *outputBuffer;
+
+	// Rebuilt whenever config.window changes
+	azaFFTPlan fftPlan;
 } azaMonitorSpectrum;
 
 // initializes azaMonitorSpectrum in existing memory
@@ -43,6 +43,8 @@ void azaRMSInit(azaRMS *data, azaRMSConfig config) {
 	data->config = config;
 	data->index = 0;
 	data->bufferCap = 0;
+	data->bufferWindow = 0;
+	data->bufferStride = 0;
 	data->buffer = NULL;
 }
 
@@ -62,11 +64,11 @@ void azaRMSReset(azaRMS *data) {
 
 void azaRMSResetChannels(azaRMS *data, uint32_t firstChannel, uint32_t channelCount) {
 	memset(data->channelData + firstChannel, 0, sizeof(data->channelData[0]) * channelCount);
-	if (data->buffer) {
-		float *start = data->buffer + data->config.windowSamples * firstChannel;
-		float *end = start + AZA_MIN(data->config.windowSamples * channelCount, data->bufferCap);
-		size_t count = end - start;
-		memset(start, 0, sizeof(data->buffer[0]) * count);
+	if (data->buffer && firstChannel < data->bufferStride) {
+		uint32_t count = AZA_MIN(channelCount, data->bufferStride - firstChannel);
+		for (uint32_t i = 0; i < data->bufferWindow; i++) {
+			memset(data->buffer + i * data->bufferStride + firstChannel, 0, sizeof(data->buffer[0]) * count);
+		}
 	}
 }
 
@@ -104,13 +106,21 @@ int azaRMSCopyConfig(azaDSP *dst, azaDSP *src) {
 }
 
 static int azaHandleRMSBuffer(azaRMS *data, uint8_t channels) {
-	if (data->bufferCap < data->config.windowSamples * channels) {
-		uint32_t newBufferCap = (uint32_t)aza_grow(data->bufferCap, data->config.windowSamples * channels, 32);
-		data->buffer = aza_realloc(data->buffer, newBufferCap * sizeof(float));
-		if (!data->buffer) {
+	uint32_t window = AZA_MAX(data->config.windowSamples, 1);
+	uint32_t stride = channels == 1 ? 1 : (channels + 7) & ~7;
+	if (data->bufferCap < window * stride) {
+		uint32_t newBufferCap = (uint32_t)aza_grow(data->bufferCap, window * stride, 32);
+		float *newBuffer = aza_realloc(data->buffer, newBufferCap * sizeof(float));
+		if (!newBuffer) {
 			return AZA_ERROR_OUT_OF_MEMORY;
 		}
+		data->buffer = newBuffer;
 		data->bufferCap = newBufferCap;
+		data->bufferWindow = 0;
+	}
+	if (data->bufferWindow != window || data->bufferStride != stride) {
+		data->bufferWindow = window;
+		data->bufferStride = stride;
 		azaRMSReset(data);
 	}
 	return AZA_SUCCESS;
@@ -144,40 +154,7 @@ int azaRMSProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	}
 	data->dsp.processMetadata.prevChannelCountDst = dst->channelLayout.count;
 
-	if (dst->channelLayout.count == 1 && src->channelLayout.count != 1) {
-		// Combine channels
-		azaRMSChannelData *channelData = &data->channelData[0];
-		float *channelBuffer = &data->buffer[0];
-		fp_azaOp op = data->config.combineOp ? data->config.combineOp : azaOpMax;
-		for (size_t i = 0; i < src->frames; i++) {
-			channelData->squaredSum -= channelBuffer[data->index];
-			channelBuffer[data->index] = 0.0f;
-			for (size_t c = 0; c < src->channelLayout.count; c++) {
-				op(&channelBuffer[data->index], azaSqrf(src->pSamples[i * src->stride + c]));
-			}
-			channelData->squaredSum += channelBuffer[data->index];
-			// Deal with potential rounding errors making sqrtf emit NaNs
-			if (channelData->squaredSum < 0.0f) channelData->squaredSum = 0.0f;
-			dst->pSamples[i * dst->stride] = sqrtf(channelData->squaredSum/(data->config.windowSamples * src->channelLayout.count));
-			if (++data->index >= data->config.windowSamples)
-				data->index = 0;
-		}
-	} else {
-		// Individual channels
-		for (uint32_t c = 0; c < dst->channelLayout.count; c++) {
-			azaRMSChannelData *channelData = &data->channelData[c];
-			float *channelBuffer = &data->buffer[data->config.windowSamples * c];
-			for (size_t i = 0; i < src->frames; i++) {
-				channelData->squaredSum -= channelBuffer[data->index];
-				channelBuffer[data->index] = azaSqrf(src->pSamples[i * src->stride + c]);
-				channelData->squaredSum += channelBuffer[data->index];
-				// Deal with potential rounding errors making sqrtf emit NaNs
-				if (channelData->squaredSum < 0.0f) channelData->squaredSum = 0.0f;
-				dst->pSamples[i * dst->stride] = sqrtf(channelData->squaredSum/(data->config.windowSamples * src->channelLayout.count));
-				if (++data->index >= data->config.windowSamples)
-					data->index = 0;
-			}
-		}
-	}
+	azaRMSProcessWindow(data, dst, src);
+
 	return AZA_SUCCESS;
 }
\ No newline at end of file
@@ -20,9 +20,13 @@ typedef struct azaRMSConfig {
 	uint32_t windowSamples;
 	uint32_t _reserved; // Explicit padding bytes, reserved for later use.
 	// If dst is 1 channel, this is used to combine all the channel values into a single RMS value per frame. If left NULL, defaults to azaOpMax
+	// azaOpAdd and azaOpMax are done across channels in vector lanes, whereas anything else gets called for every sample.
 	fp_azaOp combineOp;
 } azaRMSConfig;
 
+// The most channels a frame in azaRMS.buffer has room for, which rounds AZA_MAX_CHANNEL_POSITIONS up to a whole number of 8-wide vectors.
+#define AZAUDIO_RMS_MAX_STRIDE ((AZA_MAX_CHANNEL_POSITIONS + 7) & ~7)
+
 typedef struct azaRMSChannelData {
 	float squaredSum;
 } azaRMSChannelData;
@@ -32,6 +36,10 @@ typedef struct azaRMS {
 	azaRMSConfig config;
 	uint32_t index;
 	uint32_t bufferCap;
+	// What buffer is currently laid out for. If either changes, the window starts over.
+	uint32_t bufferWindow;
+	// How many floats apart consecutive frames are in buffer. When combining channels, every frame is 1 float, otherwise the channels of each frame sit side by side, rounded up to a multiple of 8 so they can be done together in vector lanes.
+	uint32_t bufferStride;
 	float *buffer;
 	azaRMSChannelData channelData[AZA_MAX_CHANNEL_POSITIONS];
 } azaRMS;
@@ -57,6 +65,11 @@ int azaRMSCopyConfig(azaDSP *dst, azaDSP *src);
 
 int azaRMSProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags);
 
+// Moves the window along by src->frames and writes the RMS of each frame into dst, with the buffer already set up for dst.
+// Every running sum is re-summed from the buffer each time the window wraps around, so rounding errors don't build up.
+// Implemented in specialized/azaRMSWindow.c
+void azaRMSProcessWindow(azaRMS *data, azaBuffer *dst, azaBuffer *src);
+
 
 
 #ifdef __cplusplus
@@ -17,7 +17,7 @@ static const azaDSPFuncs azaReverbFuncs = {
 	.fp_makeDefault = azaReverbMakeDefault,
 	.fp_makeDuplicate = azaReverbMakeDuplicate,
 	.fp_copyConfig = azaReverbCopyConfig,
-	.fp_getSpecs = NULL,
+	.fp_getSpecs = azaReverbGetSpecs,
 	.fp_process = azaReverbProcess,
 	.fp_free = azaReverbFree,
 	.fp_draw = azaReverbDraw,
@@ -40,9 +40,101 @@ const azaDSP azaReverbHeader = {
 	.pFuncs = &azaReverbFuncs,
 };
 
+const char *azaReverbModeString[] = {
+	"Tapped Delays",
+	"FDN",
+};
+static_assert(sizeof(azaReverbModeString) / sizeof(const char*) == AZA_REVERB_MODE_COUNT, "Pls update azaReverbModeString");
+
+
+
+// Feedback delay network
+
+
+
+// Line lengths in frames at 48kHz. They're all prime so their echoes take as long as possible to line up.
+static const uint32_t azaReverbFDNDelays[AZAUDIO_REVERB_FDN_LINES] = {
+	1009, 1061, 1123, 1201, 1291, 1381, 1459, 1553,
+	1637, 1709, 1823, 1913, 2003, 2111, 2203, 2309,
+};
+
+// Time in seconds for the FDN to decay by 60dB
+static float azaReverbFDNGetDecayTime(azaReverbConfig *config) {
+	return 0.3f + 0.1f * azaMaxf(config->roomsize, 0.0f);
+}
+
+static void azaReverbFDNInit(azaReverbFDN *fdn) {
+	memset(fdn, 0, sizeof(*fdn));
+	// Sylvester's construction of a Hadamard matrix, where the sign of each element is the parity of the bits shared by its row and column
+	for (uint32_t row = 0; row < AZAUDIO_REVERB_FDN_LINES; row++) {
+		for (uint32_t col = 0; col < AZAUDIO_REVERB_FDN_LINES; col++) {
+			uint32_t bits = row & col;
+			uint32_t parity = 0;
+			while (bits) {
+				parity ^= bits & 1;
+				bits >>= 1;
+			}
+			fdn->signs[row][col] = parity ? -1.0f : 1.0f;
+		}
+	}
+}
+
+static void azaReverbFDNDeinit(azaReverbFDN *fdn) {
+	if (fdn->delayMemory) {
+		aza_free(fdn->delayMemory);
+		fdn->delayMemory = NULL;
+	}
+	fdn->delayMemoryFrames = 0;
+	fdn->samplerate = 0;
+}
+
+static void azaReverbFDNReset(azaReverbFDN *fdn) {
+	if (fdn->delayMemory) {
+		memset(fdn->delayMemory, 0, sizeof(float) * fdn->delayMemoryFrames * AZAUDIO_REVERB_FDN_LINES);
+	}
+	memset(fdn->damping, 0, sizeof(fdn->damping));
+	fdn->writeIndex = 0;
+}
+
+// Reallocates the delay memory if samplerate changed, and updates the coefficients from config
+// May return AZA_ERROR_OUT_OF_MEMORY
+static int azaReverbFDNUpdate(azaReverbFDN *fdn, azaReverbConfig *config, uint32_t samplerate) {
+	if (fdn->samplerate != samplerate) {
+		uint32_t maxDelay = 0;
+		for (uint32_t j = 0; j < AZAUDIO_REVERB_FDN_LINES; j++) {
+			fdn->delays[j] = AZA_MAX(1, (uint32_t)roundf((float)azaReverbFDNDelays[j] * (float)samplerate / 48000.0f));
+			maxDelay = AZA_MAX(maxDelay, fdn->delays[j]);
+		}
+		uint32_t frames = 1;
+		while (frames <= maxDelay) frames <<= 1;
+		if (frames != fdn->delayMemoryFrames) {
+			azaReverbFDNDeinit(fdn);
+			fdn->delayMemory = aza_calloc(frames * AZAUDIO_REVERB_FDN_LINES, sizeof(float));
+			if (!fdn->delayMemory) return AZA_ERROR_OUT_OF_MEMORY;
+			fdn->delayMemoryFrames = frames;
+		}
+		azaReverbFDNReset(fdn);
+		fdn->samplerate = samplerate;
+	}
+	float decayFrames = azaReverbFDNGetDecayTime(config) * (float)samplerate;
+	for (uint32_t j = 0; j < AZAUDIO_REVERB_FDN_LINES; j++) {
+		// -60dB over decayFrames
+		fdn->gains[j] = powf(10.0f, -3.0f * (float)fdn->delays[j] / decayFrames);
+	}
+	float dampingFrequency = azaMinf(config->color * 4000.0f, 0.45f * (float)samplerate);
+	fdn->dampingCoefficient = 1.0f - expf(-AZA_TAU * azaMaxf(dampingFrequency, 1.0f) / (float)samplerate);
+	return AZA_SUCCESS;
+}
+
+
+
+// azaReverb
+
+
 void azaReverbInit(azaReverb *data, azaReverbConfig config) {
 	data->dsp = azaReverbHeader;
 	data->config = config;
+	azaReverbFDNInit(&data->fdn);
 
 	azaDelayInit(&data->inputDelay, (azaDelayConfig){
 		.gainWet = 0.0f,
@@ -106,6 +198,7 @@ void azaReverbInit(azaReverb *data, azaReverbConfig config) {
 
 void azaReverbDeinit(azaReverb *data) {
 	azaDelayDeinit(&data->inputDelay);
+	azaReverbFDNDeinit(&data->fdn);
 	for (int tap = 0; tap < AZAUDIO_REVERB_DELAY_COUNT; tap++) {
 		azaDelayDeinit(&data->delays[tap]);
 		azaFilterDeinit(&data->filters[tap]);
@@ -116,6 +209,7 @@ void azaReverbReset(azaReverb *data) {
 	azaMetersReset(&data->metersInput);
 	azaMetersReset(&data->metersOutput);
 	azaDelayReset(&data->inputDelay);
+	azaReverbFDNReset(&data->fdn);
 	for (int tap = 0; tap < AZAUDIO_REVERB_DELAY_COUNT; tap++) {
 		azaDelayReset(&data->delays[tap]);
 		azaFilterReset(&data->filters[tap]);
@@ -126,6 +220,7 @@ void azaReverbResetChannels(azaReverb *data, uint32_t firstChannel, uint32_t cha
 	azaMetersResetChannels(&data->metersInput, firstChannel, channelCount);
 	azaMetersResetChannels(&data->metersOutput, firstChannel, channelCount);
 	azaDelayResetChannels(&data->inputDelay, firstChannel, channelCount);
+	// The FDN is shared between all channels, so there's nothing to reset there
 	for (int tap = 0; tap < AZAUDIO_REVERB_DELAY_COUNT; tap++) {
 		azaDelayResetChannels(&data->delays[tap], firstChannel, channelCount);
 		azaFilterResetChannels(&data->filters[tap], firstChannel, channelCount);
@@ -154,6 +249,7 @@ azaDSP* azaReverbMakeDefault() {
 		.roomsize = 5.0f,
 		.color = 1.0f,
 		.delay_ms = 50.0f,
+		.mode = AZA_REVERB_MODE_FDN,
 	});
 }
 
@@ -195,20 +291,46 @@ int azaReverbProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags)
 		azaMetersUpdate(&data->metersInput, src, 1.0f);
 	}
 	azaBuffer inputBuffer = azaPushSideBuffer(src->frames, 0, 0, src->channelLayout.count, src->samplerate);
+	if AZA_UNLIKELY(!inputBuffer.pSamples) {
+		azaPopSideBuffer();
+		return AZA_ERROR_OUT_OF_MEMORY;
+	}
 	if (data->config.delay_ms != 0.0f) {
 		data->inputDelay.config.delay_ms = data->config.delay_ms;
 		err = azaDelayProcess(&data->inputDelay, &inputBuffer, src, flags);
-		if AZA_UNLIKELY(err) return err;
+		if AZA_UNLIKELY(err) {
+			azaPopSideBuffer();
+			return err;
+		}
 	} else {
 		azaBufferCopy(&inputBuffer, src);
 	}
+	float amount = data->config.muteWet ? 0.0f :  aza_db_to_ampf(data->config.gainWet);
+	float amountDry = data->config.muteDry ? 0.0f : aza_db_to_ampf(data->config.gainDry);
+	if (data->config.mode == AZA_REVERB_MODE_FDN) {
+		err = azaReverbFDNUpdate(&data->fdn, &data->config, src->samplerate);
+		if AZA_UNLIKELY(err) {
+			azaPopSideBuffer();
+			return err;
+		}
+		azaReverbFDNProcess(&data->fdn, &inputBuffer);
+		inputBuffer.silent = false;
+		if (dst->pSamples != src->pSamples) {
+			azaBufferCopy(dst, src);
+		}
+		azaBufferMix(dst, amountDry, &inputBuffer, amount);
+		azaPopSideBuffer();
+		return AZA_SUCCESS;
+	}
 	azaBuffer sideBufferCombined = azaPushSideBufferZero(src->frames, 0, 0, src->channelLayout.count, src->samplerate);
 	azaBuffer sideBufferEarly = azaPushSideBuffer(src->frames, 0, 0, src->channelLayout.count, src->samplerate);
 	azaBuffer sideBufferDiffuse = azaPushSideBuffer(src->frames, 0, 0, src->channelLayout.count, src->samplerate);
+	if AZA_UNLIKELY(!sideBufferCombined.pSamples || !sideBufferEarly.pSamples || !sideBufferDiffuse.pSamples) {
+		err = AZA_ERROR_OUT_OF_MEMORY;
+		goto error;
+	}
 	float feedback = 0.985f - (0.2f / data->config.roomsize);
 	float color = data->config.color * 4000.0f;
-	float amount = data->config.muteWet ? 0.0f :  aza_db_to_ampf(data->config.gainWet);
-	float amountDry = data->config.muteDry ? 0.0f : aza_db_to_ampf(data->config.gainDry);
 	for (int tap = 0; tap < AZAUDIO_REVERB_DELAY_COUNT*2/3; tap++) {
 		// TODO: Make feedback depend on delay time such that they all decay in amplitude at the same rate over time
 		azaDelay *delay = &data->delays[tap];
@@ -217,9 +339,9 @@ int azaReverbProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags)
 		filter->config.frequency = color;
 		azaBufferCopy(&sideBufferEarly, &inputBuffer);
 		err = azaFilterProcess(filter, &sideBufferEarly, &sideBufferEarly, flags);
-		if AZA_UNLIKELY(err) return err;
+		if AZA_UNLIKELY(err) goto error;
 		err = azaDelayProcess(delay, &sideBufferEarly, &sideBufferEarly, flags);
-		if AZA_UNLIKELY(err) return err;
+		if AZA_UNLIKELY(err) goto error;
 		azaBufferMix(&sideBufferCombined, 1.0f, &sideBufferEarly, 1.0f / (float)AZAUDIO_REVERB_DELAY_COUNT);
 	}
 	for (int tap = AZAUDIO_REVERB_DELAY_COUNT*2/3; tap < AZAUDIO_REVERB_DELAY_COUNT; tap++) {
@@ -231,19 +353,33 @@ int azaReverbProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags)
 		// What the hell is this?
 		// azaBufferCopyChannel(&sideBufferDiffuse, 0, &sideBufferCombined, 0);
 		err = azaFilterProcess(filter, &sideBufferDiffuse, &sideBufferDiffuse, flags);
-		if AZA_UNLIKELY(err) return err;
+		if AZA_UNLIKELY(err) goto error;
 		err = azaDelayProcess(delay, &sideBufferDiffuse, &sideBufferDiffuse, flags);
-		if AZA_UNLIKELY(err) return err;
+		if AZA_UNLIKELY(err) goto error;
 		azaBufferMix(&sideBufferCombined, 1.0f, &sideBufferDiffuse, 1.0f / (float)AZAUDIO_REVERB_DELAY_COUNT);
 	}
 	azaBufferMix(dst, amountDry, &sideBufferCombined, amount);
+error:
 	azaPopSideBuffers(4);
-	return AZA_SUCCESS;
+	return err;
 }
 
 azaDSPSpecs azaReverbGetSpecs(azaDSP *dsp, uint32_t samplerate) {
 	azaReverb *data = (azaReverb*)dsp;
 	azaDSPSpecs specs = {0};
+	if (data->config.mode == AZA_REVERB_MODE_FDN) {
+		uint32_t maxDelay = 0;
+		for (uint32_t j = 0; j < AZAUDIO_REVERB_FDN_LINES; j++) {
+			maxDelay = AZA_MAX(maxDelay, azaReverbFDNDelays[j]);
+		}
+		// -120dB takes twice as long as -60dB
+		float tail = 2.0f * azaReverbFDNGetDecayTime(&data->config) * (float)samplerate;
+		tail += (float)maxDelay * (float)samplerate / 48000.0f;
+		tail += aza_ms_to_samples(data->config.delay_ms, (float)samplerate);
+		specs.tailFrames = (uint32_t)azaMinf(ceilf(tail), 1.0e9f);
+		specs.skipOnSilence = true;
+		return specs;
+	}
 	azaDSPSpecs specsIndividualDelays = {0};
 	for (uint32_t tap = 0; tap < AZAUDIO_REVERB_DELAY_COUNT; tap++) {
 		azaDSPSpecs specTap = azaDSPGetSpecs(&data->delays[tap].dsp, samplerate);
@@ -261,9 +397,29 @@ azaDSPSpecs azaReverbGetSpecs(azaDSP *dsp, uint32_t samplerate) {
 
 
 
+static const float reverbModeRectWidth = 100.0f;
+
 void azaReverbDraw(azaDSP *dsp, azagRect bounds) {
 	azaReverb *data = (azaReverb*)dsp;
 	float boundsStartX = bounds.x;
+	azagRect modeRect = bounds;
+	modeRect.w = reverbModeRectWidth;
+	modeRect.h = azagTextHeightMargin("A", AZAG_TEXT_SCALE_TEXT);
+	azagColor colorText = azagColorSatVal(azagThemeCurrent.colorSwitchHighlight, 0.5f, 0.9f);
+	for (int i = 0; i < AZA_REVERB_MODE_COUNT; i++) {
+		bool highlighted = azagMouseInRect(modeRect);
+		if (highlighted && azagMousePressed(AZAG_MOUSE_BUTTON_LEFT)) {
+			data->config.mode = (azaReverbMode)i;
+		}
+		bool selected = ((int)data->config.mode == i);
+		azagDrawRect(modeRect, highlighted ? azagThemeCurrent.colorSwitchHighlight : azagThemeCurrent.colorSwitch);
+		if (selected) {
+			azagDrawRectOutline(modeRect, colorText);
+		}
+		azagDrawTextMargin(azaReverbModeString[i], modeRect.xy, AZAG_TEXT_SCALE_TEXT, colorText);
+		modeRect.y += modeRect.h + azagThemeCurrent.margin.y;
+	}
+	azagRectShrinkLeftMargin(&bounds, modeRect.w);
 	float usedWidth = azagDrawFader(bounds, &data->config.gainWet, &data->config.muteWet, true, "Wet Gain", 36, 6);
 	azagRectShrinkLeftMargin(&bounds, usedWidth);
 	usedWidth = azagDrawFader(bounds, &data->config.gainDry, &data->config.muteDry, true, "Dry Gain", 36, 6);
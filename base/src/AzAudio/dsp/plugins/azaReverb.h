@@ -1,7 +1,9 @@
 /*
 	File: azaReverb.h
 	Author: Philip Haynes
-	TODO: This implementation is really bad and horrible and stupid. Please do something smarter, like at the very least a unified buffer for delays. Even better, probably use frequency space.
+	AZA_REVERB_MODE_FDN is a feedback delay network with all of its delay lines in one unified buffer, processed one frame at a time with the lines spread across SIMD lanes.
+	AZA_REVERB_MODE_TAPPED_DELAYS is the original implementation, which runs 30 azaDelays and 30 azaFilters. It's really bad and horrible and stupid, and is only kept around for anyone who likes how it sounds.
+	For reverb from a recorded or designed impulse response, see azaConvolutionReverb.
 */
 
 #ifndef AZAUDIO_AZAREVERB_H
@@ -20,6 +22,16 @@ extern "C" {
 
 extern const azaDSP azaReverbHeader;
 
+typedef enum azaReverbMode {
+	// 30 azaDelays and azaFilters
+	AZA_REVERB_MODE_TAPPED_DELAYS=0,
+	// Feedback delay network
+	AZA_REVERB_MODE_FDN,
+	AZA_REVERB_MODE_COUNT,
+} azaReverbMode;
+
+extern const char *azaReverbModeString[];
+
 typedef struct azaReverbConfig {
 	// effect gain in dB
 	float gainWet;
@@ -27,13 +39,44 @@ typedef struct azaReverbConfig {
 	float gainDry;
 	bool muteWet, muteDry;
 	// value affecting reverb feedback, roughly in the range of 1 to 100 for reasonable results
+	// In AZA_REVERB_MODE_FDN, the time to decay by 60dB is 0.3s + roomsize*0.1s
 	float roomsize;
 	// value affecting damping of high frequencies, roughly in the range of 1 to 5
+	// In AZA_REVERB_MODE_FDN, the lines are lowpassed at color*4kHz
 	float color;
 	// delay for first reflections in ms
 	float delay_ms;
+	// Which algorithm to use. This is last (and the old algorithm is 0) so existing initializers keep the sound they had.
+	azaReverbMode mode;
 } azaReverbConfig;
 
+#define AZAUDIO_REVERB_FDN_LINES 16
+
+// State for AZA_REVERB_MODE_FDN
+typedef struct azaReverbFDN {
+	// One ring buffer for every delay line, where each frame holds one sample for each line. Every frame we write all the lines with one contiguous store, and each line reads back from its own distance behind that.
+	float *delayMemory;
+	// Capacity of delayMemory in frames, which is a power of 2
+	uint32_t delayMemoryFrames;
+	uint32_t writeIndex;
+	// samplerate the delays and coefficients were computed for, or 0 if they need to be computed
+	uint32_t samplerate;
+	// Length of each line in frames
+	uint32_t delays[AZAUDIO_REVERB_FDN_LINES];
+	// Gain applied every trip through each line, which depends on its length so all the lines decay at the same rate
+	float gains[AZAUDIO_REVERB_FDN_LINES];
+	// State of the one-pole lowpass that damps each line
+	float damping[AZAUDIO_REVERB_FDN_LINES];
+	float dampingCoefficient;
+	// Rows of a Hadamard matrix, used as sign patterns for spreading input channels across the lines and taking output channels from them, so every channel gets its own decorrelated mix.
+	float signs[AZAUDIO_REVERB_FDN_LINES][AZAUDIO_REVERB_FDN_LINES];
+} azaReverbFDN;
+
+// Runs the FDN over buffer in-place, replacing each frame of input with the wet output.
+// Each frame does one lowpass per line, then mixes the lines with the Householder matrix I - 2/N * ones before feeding them back.
+// Implemented in specialized/azaReverbFDN.c
+void azaReverbFDNProcess(azaReverbFDN *fdn, azaBuffer *buffer);
+
 #define AZAUDIO_REVERB_DELAY_COUNT 30
 typedef struct azaReverb {
 	azaDSP dsp;
@@ -43,6 +86,7 @@ typedef struct azaReverb {
 	azaMeters metersOutput;
 
 	azaDelay inputDelay;
+	azaReverbFDN fdn;
 	azaDelay delays[AZAUDIO_REVERB_DELAY_COUNT];
 	azaFilter filters[AZAUDIO_REVERB_DELAY_COUNT];
 } azaReverb;
@@ -68,8 +112,9 @@ int azaReverbCopyConfig(azaDSP *dst, azaDSP *src);
 
 int azaReverbProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags);
 
-// Reverb was going to report the specs from delay and filters, which may still be desired, but we know they're zeroed, so probably just ignore it for now?
-// azaDSPSpecs azaReverbGetSpecs(azaDSP *dsp, uint32_t samplerate);
+// In AZA_REVERB_MODE_FDN, reports a tail long enough to decay by 120dB so we can be skipped on silence.
+// AZA_REVERB_MODE_TAPPED_DELAYS reports whatever its delays and filters report.
+azaDSPSpecs azaReverbGetSpecs(azaDSP *dsp, uint32_t samplerate);
 
 
 
@@ -44,15 +44,67 @@ const azaDSP azaSamplerHeader = {
 enum { AZA_SAMPLER_DESIRED_KERNEL_RADIUS = 13 };
 static const float azaSamplerStopBand = 20000.0f;
 
-void azaSamplerInit(azaSampler *data, azaSamplerConfig config) {
+static void azaSamplerApplyConfigDefaults(azaSamplerConfig *config) {
+	if (config->maxInstances == 0) config->maxInstances = AZAUDIO_SAMPLER_DEFAULT_MAX_INSTANCES;
+	if (config->stealFadeMs == 0.0f) config->stealFadeMs = AZAUDIO_SAMPLER_DEFAULT_STEAL_FADE_MS;
+	if (config->maxCommands == 0) config->maxCommands = AZAUDIO_SAMPLER_DEFAULT_MAX_COMMANDS;
+}
+
+static azaSamplerStateTable* azaSamplerStateTableMake(uint32_t count) {
+	azaSamplerStateTable *result = aza_calloc(1, sizeof(azaSamplerStateTable) + count * sizeof(azaSamplerInstanceState));
+	if (!result) return NULL;
+	result->states = (azaSamplerInstanceState*)(result + 1);
+	result->count = count;
+	return result;
+}
+
+static void azaSamplerStateTableFreeList(azaSamplerStateTable *table) {
+	while (table) {
+		azaSamplerStateTable *previous = table->previous;
+		aza_free(table);
+		table = previous;
+	}
+}
+
+// Detaches the tables stateTable replaced if nobody can be reading them anymore, returning them for the caller to free outside of the lock.
+// Must be called with the mutex held, and after stateTable was last swapped with a full barrier.
+static azaSamplerStateTable* azaSamplerCollectStateTables(azaSampler *data) {
+	azaSamplerStateTable *table = data->stateTable;
+	// Adding 0 is a read-modify-write, so it sees the latest count rather than whatever was last published to us
+	if (!table->previous || azaAtomicFetchAdd32(&data->stateTableReaders, 0) != 0) return NULL;
+	azaSamplerStateTable *result = table->previous;
+	table->previous = NULL;
+	return result;
+}
+
+int azaSamplerInit(azaSampler *data, azaSamplerConfig config) {
 	data->dsp = azaSamplerHeader;
+	azaSamplerApplyConfigDefaults(&config);
 	data->config = config;
+	data->capacity = 2 * config.maxInstances;
 	data->numInstances = 0;
+	data->numStolen = 0;
+	data->numPublished = 0;
+	data->stateTableReaders = 0;
+	data->time = 0;
 	azaMutexInit(&data->mutex);
+	data->instances = aza_calloc(data->capacity, sizeof(azaSamplerInstance));
+	data->stateTable = azaSamplerStateTableMake(data->capacity);
+	int err = azaQueueInit_unchecked(&data->commands, sizeof(azaSamplerCommand), (uint16_t)AZA_MIN(config.maxCommands, UINT16_MAX));
+	if (err || !data->instances || !data->stateTable) {
+		azaSamplerDeinit(data);
+		return AZA_ERROR_OUT_OF_MEMORY;
+	}
+	return AZA_SUCCESS;
 }
 
 void azaSamplerDeinit(azaSampler *data) {
 	azaMutexDeinit(&data->mutex);
+	aza_free(data->instances);
+	data->instances = NULL;
+	azaSamplerStateTableFreeList(data->stateTable);
+	data->stateTable = NULL;
+	azaQueueDeinit(&data->commands);
 }
 
 void azaSamplerReset(azaSampler *data) {
@@ -66,7 +118,10 @@ void azaSamplerResetChannels(azaSampler *data, uint32_t firstChannel, uint32_t c
 azaSampler* azaSamplerMake(azaSamplerConfig config) {
 	azaSampler *result = aza_calloc(1, sizeof(azaSampler));
 	if (result) {
-		azaSamplerInit(result, config);
+		if (azaSamplerInit(result, config)) {
+			aza_free(result);
+			return NULL;
+		}
 	}
 	return result;
 }
@@ -88,32 +143,122 @@ azaDSP* azaSamplerMakeDuplicate(azaDSP *src) {
 	return (azaDSP*)azaSamplerMake(data->config);
 }
 
+static void azaSamplerStealDownTo(azaSampler *data, uint32_t maxCount);
+static void azaSamplerApplyCommand(azaSampler *data, const azaSamplerCommand *command);
+
 int azaSamplerCopyConfig(azaDSP *dst, azaDSP *src) {
 	azaSampler *dataDst = (azaSampler*)dst;
 	azaSampler *dataSrc = (azaSampler*)src;
-	dataDst->config = dataSrc->config;
+	azaSamplerConfig config = dataSrc->config;
+	azaSamplerApplyConfigDefaults(&config);
+	// The command ring can't be resized while other threads might be pushing onto it
+	config.maxCommands = dataDst->config.maxCommands;
+	azaSamplerInstance *instancesOld = NULL;
+	azaSamplerStateTable *stateTablesOld = NULL;
+	if (config.maxInstances != dataDst->config.maxInstances) {
+		// Allocate outside of the lock so we never make the audio thread wait on it
+		uint32_t capacity = 2 * config.maxInstances;
+		azaSamplerInstance *instances = aza_calloc(capacity, sizeof(azaSamplerInstance));
+		azaSamplerStateTable *stateTable = azaSamplerStateTableMake(capacity);
+		if (!instances || !stateTable) {
+			aza_free(instances);
+			aza_free(stateTable);
+			return AZA_ERROR_OUT_OF_MEMORY;
+		}
+		azaMutexLock(&dataDst->mutex);
+		// If there are more playing than fit, the newest ones get cut off
+		dataDst->numInstances = AZA_MIN(dataDst->numInstances, capacity);
+		memcpy(instances, dataDst->instances, dataDst->numInstances * sizeof(azaSamplerInstance));
+		dataDst->numStolen = 0;
+		for (uint32_t i = 0; i < dataDst->numInstances; i++) {
+			dataDst->numStolen += instances[i].stolen;
+		}
+		instancesOld = dataDst->instances;
+		dataDst->instances = instances;
+		dataDst->capacity = capacity;
+		stateTable->previous = dataDst->stateTable;
+		// Has to be a full barrier so that checking stateTableReaders can't happen before readers could see the new table
+		azaAtomicExchangePtr((void*volatile*)&dataDst->stateTable, stateTable);
+		dataDst->numPublished = 0;
+		dataDst->config = config;
+		// Whatever's over the new limit fades out like it was stolen
+		azaSamplerStealDownTo(dataDst, config.maxInstances);
+		stateTablesOld = azaSamplerCollectStateTables(dataDst);
+		azaMutexUnlock(&dataDst->mutex);
+	} else {
+		azaMutexLock(&dataDst->mutex);
+		dataDst->config = config;
+		// Readers may have been busy the last time the tables were swapped
+		stateTablesOld = azaSamplerCollectStateTables(dataDst);
+		azaMutexUnlock(&dataDst->mutex);
+	}
+	aza_free(instancesOld);
+	azaSamplerStateTableFreeList(stateTablesOld);
 	return AZA_SUCCESS;
 }
 
-int azaSamplerProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
-	// Bypass handled by azaDSPProcess
-	int err = AZA_SUCCESS;
-	assert(dsp != NULL);
-	azaSampler *data = (azaSampler*)dsp;
-
-	if AZA_UNLIKELY(flags & AZA_DSP_PROCESS_FLAG_CUT) {
-		azaSamplerReset(data);
+// Called when azaSampleWithKernelBlock stopped because the instance reached a loop point or an end of its buffer.
+// startedBeforeLoopEnd and startedAfterLoopStart are whether the instance was inside the loop region before it got here.
+// Returns true if the instance ran off the end of its buffer and stopped.
+static bool azaSamplerInstanceHandleBound(azaSamplerInstance *instance, bool startedBeforeLoopEnd, bool startedAfterLoopStart, int32_t loopStart, int32_t loopEnd) {
+	// TODO: Loop crossfades, because nobody likes a pop
+	if (instance->loop) {
+		int32_t loopRegionLength = loopEnd - loopStart;
+		if (instance->pingpong) {
+			if (!instance->reverse && startedBeforeLoopEnd && instance->frame >= loopEnd) {
+				// AZA_LOG_INFO("We're forwards going backwards (frame = %i, fraction= %f)!\n", instance->frame, instance->fraction);
+				// - 1 because loopEnd is not considered a part of the range, and we definitely
+				instance->frame = loopEnd+loopEnd - instance->frame - 1;
+				instance->fraction = -instance->fraction;
+				instance->reverse = true;
+			} else if (instance->reverse && startedAfterLoopStart && instance->frame <= loopStart) {
+				// AZA_LOG_INFO("We're backwards going forwards (frame = %i, fraction= %f)!\n", instance->frame, instance->fraction);
+				// not - 1 because loopStart is considered a part of the range
+				instance->frame = loopStart+loopStart - instance->frame;
+				instance->fraction = -instance->fraction;
+				instance->reverse = false;
+			}
+		} else {
+			if (!instance->reverse && startedBeforeLoopEnd && instance->frame >= loopEnd) {
+				instance->frame -= loopRegionLength;
+			} else if (instance->reverse && startedAfterLoopStart && instance->frame <= loopStart) {
+				instance->frame += loopRegionLength - 1;
+			}
+		}
 	}
+	if ((!instance->reverse && instance->frame >= (int32_t)instance->buffer->frames) || (instance->reverse && instance->frame < 0)) {
+		instance->envelope.instance.stage = AZA_ADSR_STAGE_STOP;
+		return true;
+	}
+	return false;
+}
 
-	err = azaCheckBuffer(dst);
-	if AZA_UNLIKELY(err) return err;
-
-	(void)src; // We don't care about src here
-
-	azaMutexLock(&data->mutex);
+// Copies what other threads might want to know about our instances into stateTable.
+static void azaSamplerPublishStates(azaSampler *data) {
+	azaSamplerStateTable *table = data->stateTable;
+	uint32_t count = AZA_MAX(data->numInstances, data->numPublished);
+	if (count == 0) return;
+	// Make it odd so readers know to wait. This is a full barrier, so none of the writes below can happen before it.
+	azaAtomicFetchAdd32(&table->sequence, 1);
+	for (uint32_t i = 0; i < count; i++) {
+		azaSamplerInstanceState *state = &table->states[i];
+		if (i < data->numInstances) {
+			azaSamplerInstance *instance = &data->instances[i];
+			state->id = instance->id;
+			state->speedCurrent = azaFollowerLinearGetValue(&instance->speed);
+			state->speedTarget = instance->speed.end;
+			state->volumeCurrent = azaFollowerLinearGetValue(&instance->volume);
+			state->volumeTarget = instance->volume.end;
+		} else {
+			state->id = 0;
+		}
+	}
+	azaAtomicFetchAdd32(&table->sequence, 1);
+	data->numPublished = data->numInstances;
+}
 
-	// Keep our lowpass below the minimum nyquist frequency (leaving some extra space for the transition band to alias onto itself outside the range of human hearing)
-	float stopBandFactor = azaClampf(2.0f * azaSamplerStopBand / (float)dst->samplerate, 0.25f, 1.0f);
+// Renders every instance into dst, which may be part of a block. samples, speeds, and volumes have room for at least dst->frames.
+static void azaSamplerRender(azaSampler *data, azaBuffer *dst, azaBuffer *samples, azaBuffer *speeds, azaBuffer *volumes, float stopBandFactor) {
 	for (uint32_t inst = 0; inst < data->numInstances; inst++) {
 		azaSamplerInstance *instance = &data->instances[inst];
 		// Instead of requiring the correct number of channels we'll just put in as many as we have for now. It's hacky, but we'll deal with that later.
@@ -122,182 +267,372 @@ int azaSamplerProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags)
 		float deltaMs = 1000.0f / (float)instance->buffer->samplerate;
 		int32_t loopStart = instance->loopStart >= (int32_t)instance->buffer->frames ? 0 : instance->loopStart;
 		int32_t loopEnd = instance->loopEnd <= loopStart ? instance->buffer->frames : instance->loopEnd;
-		int32_t loopRegionLength = loopEnd - loopStart;
+		// The envelope and followers are cheap, so run them for the whole block up front
+		uint32_t frames = dst->frames;
+		float speedMax = 0.0f;
+		bool audible = false;
 		for (uint32_t i = 0; i < dst->frames; i++) {
 			float volumeEnvelope = azaADSRUpdate(&instance->envelope, deltaMs);
 			if (instance->envelope.instance.stage == AZA_ADSR_STAGE_STOP) {
-				data->numInstances--;
-				if ((int)inst < (int)data->numInstances) {
-					memmove(data->instances+inst, data->instances+inst+1, (data->numInstances-inst) * sizeof(*data->instances));
-				}
-				inst -= 1;
+				frames = i;
 				break;
 			}
 			float volumeGain = azaFollowerLinearUpdate(&instance->volume, deltaMs / data->config.volumeTransitionTimeMs);
 			float volume = volumeEnvelope * volumeGain;
-			float speed = azaFollowerLinearUpdate(&instance->speed, deltaMs / data->config.speedTransitionTimeMs);
-			if AZA_UNLIKELY(volume == 0.0f) continue;
-			speed *= samplerateFactor;
-			if (speed == 1.0f && instance->fraction == 0.0f) {
-				// No resampling necessary
-				for (uint8_t c = 0; c < channels; c++) {
-					float sample = instance->buffer->pSamples[instance->frame * instance->buffer->stride + c];
-					dst->pSamples[i * dst->stride + c] += sample * volume;
+			float speed = azaFollowerLinearUpdate(&instance->speed, deltaMs / data->config.speedTransitionTimeMs) * samplerateFactor;
+			// We don't move while we're silent
+			if AZA_UNLIKELY(volume == 0.0f) speed = 0.0f;
+			volumes->pSamples[i] = volume;
+			speeds->pSamples[i] = instance->reverse ? -speed : speed;
+			speedMax = azaMaxf(speedMax, speed);
+			audible = audible || volume != 0.0f;
+		}
+		if (audible) {
+			// Choosing the kernel once for the whole block keeps it hot in cache. Using the fastest speed in the block means we never alias while speed is changing.
+			float rate = azaMinf(stopBandFactor / speedMax, 1.0f);
+			// This value has to be <= AZA_KERNEL_DEFAULT_LANCZOS_COUNT
+			azaKernel *kernel = azaKernelGetDefaultLanczos(azaKernelGetRadiusForRate(rate, AZA_SAMPLER_DESIRED_KERNEL_RADIUS));
+			// TODO: Find some way to deal with the quiet pops you get from swapping out kernels
+			uint32_t i = 0;
+			// The envelope may have already stopped at frames, but everything before that still has to be rendered
+			while (i < frames) {
+				// Stop at whichever loop point or end of the buffer we're heading towards, so azaSamplerInstanceHandleBound can decide what happens there
+				bool startedBeforeLoopEnd = instance->frame <= loopEnd;
+				bool startedAfterLoopStart = instance->frame >= loopStart;
+				int32_t boundStart = INT32_MIN;
+				int32_t boundEnd = INT32_MAX;
+				if (instance->reverse) {
+					boundStart = instance->loop && startedAfterLoopStart ? AZA_MAX(loopStart, -1) : -1;
+				} else {
+					boundEnd = instance->loop && startedBeforeLoopEnd ? AZA_MIN(loopEnd, (int32_t)instance->buffer->frames) : (int32_t)instance->buffer->frames;
 				}
-			} else {
-				// Oof all resampling!
-#if 0 // Old way!
-				#define SAMPLER_KERNEL_RADIUS 15
-				#define SAMPLER_KERNEL_SAMPLE_COUNT (SAMPLER_KERNEL_RADIUS*2+1)
-				float kernelSamples[SAMPLER_KERNEL_SAMPLE_COUNT];
-				float kernelIntegral = 0.0f;
-				{ // Calculate interpolation kernel for our speed and offset
-					// TODO: Definitely switch to using azaKernel, once it's been altered to allow low-passes below source nyquist, as is generally needed (this is a necessary step to fix aliasing issues in azaSpatialize and backend resampling as well).
-					float rate = (speed > 1.0f ? 1.0f / speed : 1.0f) * stopBandFactor;
-					float x = rate*(-instance->fraction - (float)SAMPLER_KERNEL_RADIUS);
-					// Calculating it like this breaks down in the degenerate case where our kernel radius is too small to cover even the first lobe (because we're low-passing well below the source nyquist frequency). Doing this would create volume attenuation when rate is very low.
-					// kernelIntegral = 1.0f / rate;
-					for (int i = 0; i < SAMPLER_KERNEL_SAMPLE_COUNT; i++) {
-						float amount = azaLanczosf(x, azaMaxf(floorf((float)(0+SAMPLER_KERNEL_RADIUS)*rate), 1.0f));
-						kernelSamples[i] = amount;
-						kernelIntegral += amount;
-						x += rate;
+				bool wasReverse = instance->reverse;
+				uint32_t sampled = azaSampleWithKernelBlock(samples->pSamples + i * samples->stride, samples->stride, channels, frames - i, kernel, instance->buffer->pSamples, instance->buffer->stride, 0, instance->buffer->frames, instance->loop, &instance->frame, &instance->fraction, speeds->pSamples + i, boundStart, boundEnd, rate);
+				for (uint32_t j = i; j < i + sampled; j++) {
+					float volume = volumes->pSamples[j];
+					for (uint8_t c = 0; c < channels; c++) {
+						dst->pSamples[j * dst->stride + c] += samples->pSamples[j * samples->stride + c] * volume;
 					}
 				}
-				for (uint8_t c = 0; c < dst->channelLayout.count; c++) {
-					float sample = 0.0f;
-					for (int i = 0; i < SAMPLER_KERNEL_SAMPLE_COUNT; i++) {
-						int frame = azaWrapi(i + (int)instance->frame - SAMPLER_KERNEL_RADIUS, instance->buffer->frames);
-						float amount = kernelSamples[i];
-						sample += instance->buffer->pSamples[frame * instance->buffer->stride + c] * amount;
+				i += sampled;
+				if (instance->frame <= boundStart || instance->frame >= boundEnd) {
+					if (azaSamplerInstanceHandleBound(instance, startedBeforeLoopEnd, startedAfterLoopStart, loopStart, loopEnd)) break;
+					if (instance->reverse != wasReverse) {
+						for (uint32_t j = i; j < frames; j++) {
+							speeds->pSamples[j] = -speeds->pSamples[j];
+						}
 					}
-					sample /= kernelIntegral;
-
-					dst->pSamples[i * dst->stride + c] += sample * volume;
-				}
-#else // NEW WAY
-				float rate = azaMinf(stopBandFactor / speed, 1.0f);
-				// This value has to be <= AZA_KERNEL_DEFAULT_LANCZOS_COUNT
-				azaKernel *kernel = azaKernelGetDefaultLanczos(azaKernelGetRadiusForRate(rate, AZA_SAMPLER_DESIRED_KERNEL_RADIUS));
-				// TODO: Find some way to deal with the quiet pops you get from swapping out kernels
-				float frame[AZA_MAX_CHANNEL_POSITIONS];
-				azaSampleWithKernel(frame, channels, kernel, instance->buffer->pSamples, instance->buffer->stride, 0, instance->buffer->frames, instance->loop, instance->frame, instance->fraction, rate);
-				for (uint8_t c = 0; c < channels; c++) {
-					float sample = frame[c];
-					dst->pSamples[i * dst->stride + c] += sample * volume;
 				}
-#endif
 			}
-			// TODO: Loop crossfades, because nobody likes a pop
-			bool startedBeforeLoopEnd = instance->frame <= loopEnd;
-			bool startedAfterLoopStart = instance->frame >= loopStart;
-			if (instance->reverse) {
-				instance->fraction -= speed;
-			} else {
-				instance->fraction += speed;
-			}
-			int32_t framesToAdd = (int32_t)truncf(instance->fraction);
-			instance->frame += framesToAdd;
-			instance->fraction -= framesToAdd;
-			if (instance->loop) {
-				if (instance->pingpong) {
-					if (!instance->reverse && startedBeforeLoopEnd && instance->frame >= loopEnd) {
-						// AZA_LOG_INFO("We're forwards going backwards (frame = %i, fraction= %f)!\n", instance->frame, instance->fraction);
-						// - 1 because loopEnd is not considered a part of the range, and we definitely
-						instance->frame = loopEnd+loopEnd - instance->frame - 1;
-						instance->fraction = -instance->fraction;
-						instance->reverse = true;
-					} else if (instance->reverse && startedAfterLoopStart && instance->frame <= loopStart) {
-						// AZA_LOG_INFO("We're backwards going forwards (frame = %i, fraction= %f)!\n", instance->frame, instance->fraction);
-						// not - 1 because loopStart is considered a part of the range
-						instance->frame = loopStart+loopStart - instance->frame;
-						instance->fraction = -instance->fraction;
-						instance->reverse = false;
-					}
-				} else {
-					if (!instance->reverse && startedBeforeLoopEnd && instance->frame >= loopEnd) {
-						instance->frame -= loopRegionLength;
-					} else if (instance->reverse && startedAfterLoopStart && instance->frame <= loopStart) {
-						instance->frame += loopRegionLength - 1;
-					}
-				}
+		}
+		if (instance->envelope.instance.stage == AZA_ADSR_STAGE_STOP) {
+			// Swap-remove, and process whatever got swapped in next
+			if (instance->stolen) {
+				data->numStolen--;
 			}
-			if ((!instance->reverse && instance->frame >= (int32_t)instance->buffer->frames) || (instance->reverse && instance->frame < 0)) {
-				instance->envelope.instance.stage = AZA_ADSR_STAGE_STOP;
+			data->numInstances--;
+			if (inst < data->numInstances) {
+				data->instances[inst] = data->instances[data->numInstances];
 			}
+			inst -= 1;
+		}
+	}
+}
+
+int azaSamplerProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
+	// Bypass handled by azaDSPProcess
+	int err = AZA_SUCCESS;
+	assert(dsp != NULL);
+	azaSampler *data = (azaSampler*)dsp;
+
+	if AZA_UNLIKELY(flags & AZA_DSP_PROCESS_FLAG_CUT) {
+		azaSamplerReset(data);
+	}
+
+	err = azaCheckBuffer(dst);
+	if AZA_UNLIKELY(err) return err;
+
+	(void)src; // We don't care about src here
+
+	azaMutexLock(&data->mutex);
+
+	// If we don't add anything, whatever silence was in dst stays there
+	bool addedNothing = true;
+
+	// Each instance gets sampled a whole block at a time, so these hold the per-frame parameters and the sampled frames before they're mixed into dst
+	azaBuffer samples = azaPushSideBuffer(dst->frames, 0, 0, dst->channelLayout.count, dst->samplerate);
+	azaBuffer speeds = azaPushSideBuffer(dst->frames, 0, 0, 1, dst->samplerate);
+	azaBuffer volumes = azaPushSideBuffer(dst->frames, 0, 0, 1, dst->samplerate);
+	if AZA_UNLIKELY(!samples.pSamples || !speeds.pSamples || !volumes.pSamples) {
+		azaPopSideBuffers(3);
+		azaMutexUnlock(&data->mutex);
+		return AZA_ERROR_OUT_OF_MEMORY;
+	}
+
+	// Keep our lowpass below the minimum nyquist frequency (leaving some extra space for the transition band to alias onto itself outside the range of human hearing)
+	float stopBandFactor = azaClampf(2.0f * azaSamplerStopBand / (float)dst->samplerate, 0.25f, 1.0f);
+	azaTime timeStart = { data->time };
+	azaTime timePerFrame = azaTimePerSample(dst->samplerate);
+	uint32_t frame = 0;
+	while (frame < dst->frames) {
+		// Everything that's due by this frame happens before we render it, and the next command that's due in this block splits it there
+		azaQueueEntry *entry;
+		while ((entry = azaQueueDequeueDue(&data->commands, timeStart, timePerFrame, frame))) {
+			azaSamplerApplyCommand(data, (azaSamplerCommand*)entry);
+		}
+		uint32_t frameNext = azaQueueGetNextFrame(&data->commands, timeStart, timePerFrame, dst->frames);
+		if (data->numInstances) {
+			addedNothing = false;
+			azaBuffer segment = frame == 0 && frameNext == dst->frames ? *dst : azaBufferSlice(dst, frame, frameNext - frame);
+			azaSamplerRender(data, &segment, &samples, &speeds, &volumes, stopBandFactor);
 		}
+		frame = frameNext;
 	}
+	azaAtomicStore64(&data->time, timeStart.time + (int64_t)dst->frames * timePerFrame.time);
+	azaSamplerPublishStates(data);
+
+	azaPopSideBuffers(3);
 
 	if (azaMixerGUIDSPIsSelected(dsp)) {
 		azaMetersUpdate(&data->metersOutput, dst, 1.0f);
 	}
 
+	if (addedNothing && src && dst->pSamples == src->pSamples) {
+		dst->silent = src->silent;
+	}
+
 	azaMutexUnlock(&data->mutex);
 	return AZA_SUCCESS;
 }
 
-uint32_t azaSamplerPlayFull(azaSampler *data, azaBuffer *buffer, float speed, float gainDB, azaADSRConfig envelope, bool loop, bool pingpong, int32_t loopStart, int32_t loopEnd) {
-	static uint32_t nextId = 1;
-	azaMutexLock(&data->mutex);
-	if (data->numInstances >= AZAUDIO_SAMPLER_MAX_INSTANCES) {
-		azaMutexUnlock(&data->mutex);
-		return 0;
+// Fades out from wherever the envelope is right now over config.stealFadeMs by hijacking its release
+static void azaSamplerStealInstance(azaSampler *data, azaSamplerInstance *instance) {
+	assert(!instance->stolen);
+	instance->stolen = true;
+	data->numStolen++;
+	instance->envelope.instance.releaseStartAmp = azaADSRGetValue(&instance->envelope);
+	instance->envelope.instance.progress = 0.0f;
+	instance->envelope.instance.stage = AZA_ADSR_STAGE_RELEASE;
+	instance->envelope.config.release = data->config.stealFadeMs;
+}
+
+static float azaSamplerInstanceGetAmp(azaSamplerInstance *instance) {
+	return azaADSRGetValue(&instance->envelope) * azaFollowerLinearGetValue(&instance->volume);
+}
+
+// Returns whether a should be stolen before b
+static bool azaSamplerInstanceStealsBefore(azaSamplerSteal steal, azaSamplerInstance *a, azaSamplerInstance *b) {
+	switch (steal) {
+		case AZA_SAMPLER_STEAL_QUIETEST: {
+			float ampA = azaSamplerInstanceGetAmp(a);
+			float ampB = azaSamplerInstanceGetAmp(b);
+			if (ampA != ampB) return ampA < ampB;
+		} break;
+		case AZA_SAMPLER_STEAL_LOWEST_PRIORITY:
+			if (a->priority != b->priority) return a->priority < b->priority;
+			break;
+		default: break;
+	}
+	// Oldest wins ties. ids only go up until they wrap around, so compare their difference, which stays correct as long as what's playing spans fewer than 2^31 plays.
+	return (int32_t)(a->id - b->id) < 0;
+}
+
+// Steals instances according to config.steal until there are no more than maxCount left that aren't stolen
+static void azaSamplerStealDownTo(azaSampler *data, uint32_t maxCount) {
+	while (data->numInstances - data->numStolen > maxCount) {
+		azaSamplerInstance *victim = NULL;
+		for (uint32_t i = 0; i < data->numInstances; i++) {
+			azaSamplerInstance *instance = &data->instances[i];
+			if (instance->stolen) continue;
+			if (!victim || azaSamplerInstanceStealsBefore(data->config.steal, instance, victim)) {
+				victim = instance;
+			}
+		}
+		assert(victim);
+		azaSamplerStealInstance(data, victim);
+	}
+}
+
+// Makes sure there's room for one more instance that counts towards config.maxInstances
+static void azaSamplerMakeRoom(azaSampler *data) {
+	azaSamplerStealDownTo(data, data->config.maxInstances - 1);
+	if (data->numInstances >= data->capacity) {
+		// Everything past maxInstances is already fading out, so cut off the quietest of those right away
+		uint32_t victim = UINT32_MAX;
+		for (uint32_t i = 0; i < data->numInstances; i++) {
+			azaSamplerInstance *instance = &data->instances[i];
+			if (!instance->stolen) continue;
+			if (victim == UINT32_MAX || azaSamplerInstanceStealsBefore(AZA_SAMPLER_STEAL_QUIETEST, instance, &data->instances[victim])) {
+				victim = i;
+			}
+		}
+		assert(victim != UINT32_MAX);
+		data->numStolen--;
+		data->numInstances--;
+		data->instances[victim] = data->instances[data->numInstances];
 	}
-	uint32_t id = nextId++;
-	// TODO: Do we have to care about id looparound? Maybe just use 64-bit ints to guarantee no matter what that we don't or handle overlap.
+}
+
+static void azaSamplerStartInstance(azaSampler *data, uint32_t id, const azaSamplerCommandPlay *play) {
+	azaSamplerMakeRoom(data);
 	uint32_t index = data->numInstances++;
 	azaSamplerInstance *instance = &data->instances[index];
-	instance->buffer = buffer;
+	*instance = (azaSamplerInstance) {0};
+	instance->buffer = play->buffer;
 	instance->id = id;
 	instance->frame = 0;
 	instance->fraction = 0.0f;
+	float speed = play->speed;
 	if (speed < 0.0f) {
-		instance->frame = buffer->frames-1;
+		instance->frame = play->buffer->frames-1;
 		instance->reverse = true;
 		speed = -speed;
 	}
-	instance->loop = loop;
-	instance->pingpong = pingpong;
-	instance->loopStart = loopStart;
-	instance->loopEnd = loopEnd;
-	instance->envelope.config = envelope;
+	instance->loop = play->loop;
+	instance->pingpong = play->pingpong;
+	instance->loopStart = play->loopStart;
+	instance->loopEnd = play->loopEnd;
+	instance->envelope.config = play->envelope;
 	instance->envelope.instance = (azaADSRInstance) {0};
 	azaADSRStart(&instance->envelope);
 	azaFollowerLinearJump(&instance->speed, speed);
-	azaFollowerLinearJump(&instance->volume, aza_db_to_ampf(gainDB));
-	azaMutexUnlock(&data->mutex);
-	return id;
+	azaFollowerLinearJump(&instance->volume, aza_db_to_ampf(play->gainDB));
 }
 
 azaSamplerInstance* azaSamplerGetInstance(azaSampler *data, uint32_t id) {
-	azaSamplerInstance *result = NULL;
-	azaMutexLock(&data->mutex);
 	for (uint32_t i = 0; i < data->numInstances; i++) {
 		if (data->instances[i].id == id) {
-			result = &data->instances[i];
+			return &data->instances[i];
 		}
 	}
-	azaMutexUnlock(&data->mutex);
-	return result;
+	return NULL;
 }
 
 static void azaSamplerStopInstance(azaSamplerInstance *data) {
+	// Stolen instances are already on their way out faster than a release would take them
+	if (data->stolen) return;
 	azaADSRStop(&data->envelope);
 }
 
-void azaSamplerStop(azaSampler *data, uint32_t id) {
-	azaMutexLock(&data->mutex);
-	azaSamplerInstance *instance = azaSamplerGetInstance(data, id);
-	if (instance) {
-		azaSamplerStopInstance(instance);
+// If command's id is still waiting to be played, pushes command back to when it plays so it isn't lost. Entries with the same time come out in the order they went in, so it lands right after the play.
+static void azaSamplerDeferUntilPlayed(azaSampler *data, const azaSamplerCommand *command) {
+	azaQueueEntry *entry;
+	for (uint32_t i = 0; (entry = azaQueueGetSorted(&data->commands, i)); i++) {
+		const azaSamplerCommand *pending = (const azaSamplerCommand*)entry;
+		if (pending->kind != AZA_SAMPLER_COMMAND_PLAY || pending->id != command->id) continue;
+		azaSamplerCommand deferred = *command;
+		deferred.header.time = pending->header.time;
+		// If the queue is full this gets dropped, same as if it couldn't be pushed in the first place
+		azaQueueEnqueue(&data->commands, &deferred.header);
+		return;
 	}
-	azaMutexUnlock(&data->mutex);
 }
 
-void azaSamplerStopAll(azaSampler *data) {
-	azaMutexLock(&data->mutex);
-	for (uint32_t i = 0; i < data->numInstances; i++) {
-		azaSamplerStopInstance(&data->instances[i]);
+static void azaSamplerApplyCommand(azaSampler *data, const azaSamplerCommand *command) {
+	if (command->kind == AZA_SAMPLER_COMMAND_PLAY) {
+		azaSamplerStartInstance(data, command->id, &command->play);
+		return;
 	}
-	azaMutexUnlock(&data->mutex);
+	if (command->kind == AZA_SAMPLER_COMMAND_STOP_ALL) {
+		for (uint32_t i = 0; i < data->numInstances; i++) {
+			azaSamplerStopInstance(&data->instances[i]);
+		}
+		return;
+	}
+	azaSamplerInstance *instance = azaSamplerGetInstance(data, command->id);
+	if (!instance) {
+		// It may not have started yet, or it may have already stopped, which is fine
+		azaSamplerDeferUntilPlayed(data, command);
+		return;
+	}
+	switch (command->kind) {
+		case AZA_SAMPLER_COMMAND_STOP:
+			azaSamplerStopInstance(instance);
+			break;
+		case AZA_SAMPLER_COMMAND_SET_SPEED:
+			azaFollowerLinearSetTarget(&instance->speed, command->speed);
+			break;
+		case AZA_SAMPLER_COMMAND_SET_GAIN:
+			azaFollowerLinearSetTarget(&instance->volume, aza_db_to_ampf(command->gainDB));
+			break;
+		case AZA_SAMPLER_COMMAND_SET_PRIORITY:
+			instance->priority = command->priority;
+			break;
+		default: break;
+	}
+}
+
+
+
+bool azaSamplerPushCommand(azaSampler *data, const azaSamplerCommand *command) {
+	return azaQueueEnqueue(&data->commands, &command->header);
+}
+
+uint32_t azaSamplerPlayFullAt(azaSampler *data, azaTime time, azaBuffer *buffer, float speed, float gainDB, azaADSRConfig envelope, bool loop, bool pingpong, int32_t loopStart, int32_t loopEnd) {
+	static volatile int32_t nextId = 1;
+	// ids wrap around after 2^32 plays. 0 means failure, so skip it. Anything still playing from 2^32 plays ago is so unlikely that we don't bother checking for it.
+	uint32_t id;
+	do {
+		id = (uint32_t)azaAtomicFetchAdd32(&nextId, 1);
+	} while (id == 0);
+	azaSamplerCommand command = {
+		.header.time = time,
+		.kind = AZA_SAMPLER_COMMAND_PLAY,
+		.id = id,
+		.play = {
+			.buffer = buffer,
+			.speed = speed,
+			.gainDB = gainDB,
+			.envelope = envelope,
+			.loopStart = loopStart,
+			.loopEnd = loopEnd,
+			.loop = loop,
+			.pingpong = pingpong,
+		},
+	};
+	if (!azaSamplerPushCommand(data, &command)) return 0;
+	return id;
+}
+
+bool azaSamplerGetInstanceState(azaSampler *data, uint32_t id, azaSamplerInstanceState *dst) {
+	if (id == 0) return false;
+	// This is a full barrier, so either azaSamplerCopyConfig sees us here or we see the table it swapped in
+	azaAtomicFetchAdd32(&data->stateTableReaders, 1);
+	azaSamplerStateTable *table = (azaSamplerStateTable*)azaAtomicLoadPtr((void*volatile*)&data->stateTable);
+	bool found;
+	while (true) {
+		int32_t sequence = azaAtomicLoad32(&table->sequence);
+		if (sequence & 1) {
+			// The audio thread is in the middle of publishing, which doesn't take long
+			continue;
+		}
+		found = false;
+		for (uint32_t i = 0; i < table->count; i++) {
+			if (table->states[i].id == id) {
+				*dst = table->states[i];
+				found = true;
+				break;
+			}
+		}
+		azaAtomicFence();
+		if (azaAtomicLoad32(&table->sequence) == sequence) break;
+	}
+	azaAtomicFetchAdd32(&data->stateTableReaders, -1);
+	return found;
+}
+
+bool azaSamplerStopAt(azaSampler *data, azaTime time, uint32_t id) {
+	azaSamplerCommand command = {
+		.header.time = time,
+		.kind = AZA_SAMPLER_COMMAND_STOP,
+		.id = id,
+	};
+	return azaSamplerPushCommand(data, &command);
+}
+
+bool azaSamplerStopAll(azaSampler *data) {
+	azaSamplerCommand command = {
+		.kind = AZA_SAMPLER_COMMAND_STOP_ALL,
+	};
+	return azaSamplerPushCommand(data, &command);
 }
@@ -10,6 +10,7 @@
 #include "../azaMeters.h"
 #include "../utility.h"
 #include "../../backend/threads.h"
+#include "../../atomic.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -18,8 +19,24 @@ extern "C" {
 
 
 extern const azaDSP azaSamplerHeader;
-// TODO: Probably make this dynamic
-#define AZAUDIO_SAMPLER_MAX_INSTANCES 16
+// Default for azaSamplerConfig::maxInstances
+#define AZAUDIO_SAMPLER_DEFAULT_MAX_INSTANCES 16
+// Default for azaSamplerConfig::stealFadeMs
+#define AZAUDIO_SAMPLER_DEFAULT_STEAL_FADE_MS 5.0f
+// Default for azaSamplerConfig::maxCommands
+#define AZAUDIO_SAMPLER_DEFAULT_MAX_COMMANDS 256
+
+// How to choose which instance to steal when we're at azaSamplerConfig::maxInstances and another one gets played
+typedef enum azaSamplerSteal {
+	// Steal the instance that started playing the longest time ago
+	AZA_SAMPLER_STEAL_OLDEST=0,
+	// Steal the instance with the lowest volume right now
+	AZA_SAMPLER_STEAL_QUIETEST,
+	// Steal the instance with the lowest priority (see azaSamplerSetPriority), or the oldest of those if there's a tie
+	AZA_SAMPLER_STEAL_LOWEST_PRIORITY,
+
+	AZA_SAMPLER_STEAL_COUNT
+} azaSamplerSteal;
 
 typedef struct azaSamplerInstance {
 	azaBuffer *buffer;
@@ -31,7 +48,11 @@ typedef struct azaSamplerInstance {
 	bool loop;
 	// When we hit a loop point, this will make us reverse instead of wrapping around.
 	bool pingpong;
-	aza_byte _reserved[9]; // Explicit padding reserved for later.
+	// Whether this instance was stolen and is fading out, after which it goes away
+	bool stolen;
+	// Used by AZA_SAMPLER_STEAL_LOWEST_PRIORITY. Starts at 0.
+	uint8_t priority;
+	aza_byte _reserved[7]; // Explicit padding reserved for later.
 	// Start of the looping region in frames
 	// If this value is >= buffer->frames, we treat this value as 0
 	int32_t loopStart;
@@ -49,25 +70,108 @@ typedef struct azaSamplerConfig {
 	float speedTransitionTimeMs;
 	// If gain changes this is how long it takes to lerp to the new value in ms (lerp happens in amp space)
 	float volumeTransitionTimeMs;
-	aza_byte _reserved[8]; // Explicit padding reserved for later.
+	// How many instances can play at once before playing another one steals one. 0 means AZAUDIO_SAMPLER_DEFAULT_MAX_INSTANCES.
+	// The memory for them is allocated up front.
+	uint32_t maxInstances;
+	// How long a stolen instance takes to fade out in ms. 0 means AZAUDIO_SAMPLER_DEFAULT_STEAL_FADE_MS.
+	float stealFadeMs;
+	azaSamplerSteal steal;
+	// How many commands (plays, stops, and parameter changes) can be waiting for the audio thread at once. 0 means AZAUDIO_SAMPLER_DEFAULT_MAX_COMMANDS. Rounded up to a power of 2, up to 32768.
+	// This only takes effect in azaSamplerInit, changing it with azaSamplerCopyConfig does nothing.
+	uint32_t maxCommands;
 } azaSamplerConfig;
-static_assert(sizeof(azaSamplerConfig) == (16), "Please update the expected size of azaSamplerConfig and remember to reserve padding explicitly.");
+static_assert(sizeof(azaSamplerConfig) == (24), "Please update the expected size of azaSamplerConfig and remember to reserve padding explicitly.");
+
+typedef enum azaSamplerCommandKind {
+	AZA_SAMPLER_COMMAND_PLAY=0,
+	AZA_SAMPLER_COMMAND_STOP,
+	AZA_SAMPLER_COMMAND_STOP_ALL,
+	AZA_SAMPLER_COMMAND_SET_SPEED,
+	AZA_SAMPLER_COMMAND_SET_GAIN,
+	AZA_SAMPLER_COMMAND_SET_PRIORITY,
+} azaSamplerCommandKind;
+
+typedef struct azaSamplerCommandPlay {
+	azaBuffer *buffer;
+	float speed;
+	float gainDB;
+	azaADSRConfig envelope;
+	int32_t loopStart;
+	int32_t loopEnd;
+	bool loop;
+	bool pingpong;
+	aza_byte _reserved[6]; // Explicit padding reserved for later.
+} azaSamplerCommandPlay;
+
+// Everything that changes what a sampler is playing goes through one of these, such that only the audio thread ever touches the instances.
+typedef struct azaSamplerCommand {
+	// header.time is when this takes effect on the sampler's clock (see azaSamplerGetTime). Anything at or before the start of a block happens on its first frame, so 0 means as soon as possible.
+	azaQueueEntry header;
+	azaSamplerCommandKind kind;
+	// Which instance this applies to. Ignored by AZA_SAMPLER_COMMAND_STOP_ALL.
+	uint32_t id;
+	union {
+		azaSamplerCommandPlay play;
+		float speed;
+		float gainDB;
+		uint8_t priority;
+	};
+} azaSamplerCommand;
+
+// What the audio thread last saw of an instance, published at the end of every block.
+typedef struct azaSamplerInstanceState {
+	// 0 if this state is unused
+	volatile uint32_t id;
+	volatile float speedCurrent;
+	volatile float speedTarget;
+	volatile float volumeCurrent;
+	volatile float volumeTarget;
+} azaSamplerInstanceState;
+
+typedef struct azaSamplerStateTable {
+	// Tables this one replaced, which another thread might still be reading. They get freed once azaSampler::stateTableReaders is seen at 0 after the swap.
+	struct azaSamplerStateTable *previous;
+	// Points just past the end of this struct in the same allocation
+	azaSamplerInstanceState *states;
+	uint32_t count;
+	// Odd while the audio thread is writing to states. Readers try again if it changed while they were reading.
+	volatile int32_t sequence;
+} azaSamplerStateTable;
 
 typedef struct azaSampler {
 	azaDSP dsp;
 	azaSamplerConfig config;
+	// Only held by azaSamplerProcess and azaSamplerCopyConfig. Playing and controlling instances goes through the command ring.
 	azaMutex mutex;
 
 	azaMeters metersOutput;
 
-	azaSamplerInstance instances[AZAUDIO_SAMPLER_MAX_INSTANCES];
+	// The first numInstances are playing, in no particular order. Only the audio thread touches these.
+	// There's room for twice config.maxInstances, such that instances fading out after being stolen don't take up room for new ones.
+	azaSamplerInstance *instances;
+	uint32_t capacity;
 	uint32_t numInstances;
+	// How many of the playing instances were stolen and are fading out. These don't count towards config.maxInstances.
+	uint32_t numStolen;
+	// How many states in stateTable might have a nonzero id.
+	uint32_t numPublished;
+	// How many threads are in azaSamplerGetInstanceState. Anyone who comes in after stateTable is replaced sees the new one, so once this is 0 the old ones can be freed.
+	volatile int32_t stateTableReaders;
 	aza_byte _reserved[4]; // Explicit padding reserved for later.
+	// Published by the audio thread for azaSamplerGetSpeedCurrent and friends.
+	azaSamplerStateTable *stateTable;
+
+	// azaSamplerCommand entries. Any number of threads push onto it without waiting on each other or the audio thread, which splits blocks wherever they land.
+	azaQueue commands;
+
+	// Time at the start of the next block. Starts at 0 and advances by however many frames we process.
+	volatile int64_t time;
 } azaSampler;
-static_assert(sizeof(azaSampler) == (sizeof(azaDSP) + sizeof(azaSamplerConfig) + sizeof(azaMutex) + sizeof(azaMeters) + sizeof(azaSamplerInstance) * AZAUDIO_SAMPLER_MAX_INSTANCES + 8), "Please update the expected size of azaSampler and remember to reserve padding explicitly.");
+static_assert(sizeof(azaSampler) == (sizeof(azaDSP) + sizeof(azaSamplerConfig) + sizeof(azaMutex) + sizeof(azaMeters) + sizeof(azaSamplerInstance*) + sizeof(azaSamplerStateTable*) + sizeof(azaQueue) + 32), "Please update the expected size of azaSampler and remember to reserve padding explicitly.");
 
 // initializes azaSampler in existing memory
-void azaSamplerInit(azaSampler *data, azaSamplerConfig config);
+// May return AZA_ERROR_OUT_OF_MEMORY
+int azaSamplerInit(azaSampler *data, azaSamplerConfig config);
 // frees any additional memory that the azaSampler may have allocated
 void azaSamplerDeinit(azaSampler *data);
 // Resets state. May be called automatically.
@@ -83,6 +187,7 @@ void azaSamplerFree(azaDSP *dsp);
 
 azaDSP* azaSamplerMakeDefault();
 azaDSP* azaSamplerMakeDuplicate(azaDSP *src);
+// May return AZA_ERROR_OUT_OF_MEMORY if maxInstances changed
 int azaSamplerCopyConfig(azaDSP *dst, azaDSP *src);
 
 int azaSamplerProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags);
@@ -90,7 +195,22 @@ int azaSamplerProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags)
 
 
 
-// Adds an instance of the sound in buffer
+// Everything below is safe to call from any thread while the audio thread is processing, and none of it takes a lock.
+// Plays, stops, and parameter changes are queued as commands that the audio thread picks up at the start of its next block, so they take effect at most one block later.
+// Commands for an id that was played with azaSamplerPlayFullAt but hasn't started yet wait until it does.
+
+
+
+// Queues a command for the audio thread. Any number of threads may call this at once.
+// returns false if config.maxCommands are already waiting, in which case nothing happens
+bool azaSamplerPushCommand(azaSampler *data, const azaSamplerCommand *command);
+
+// Returns the time at the start of the next block the audio thread will process. Use this as a base for scheduling commands with sample accuracy.
+static inline azaTime azaSamplerGetTime(azaSampler *data) {
+	return AZA_CLITERAL(azaTime) { azaAtomicLoad64(&data->time) };
+}
+
+// Adds an instance of the sound in buffer at the given time on the sampler's clock (see azaSamplerGetTime)
 // speed affects the rate of playback for this instance (pitch control where 1.0f is base speed)
 // negative speed values will play the sound in reverse
 // gainDB affects the volume for this instance
@@ -99,8 +219,15 @@ int azaSamplerProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags)
 // if pingpong is true, then instead of a loop wrapping around to the opposite end of the loop range, it will reverse the sound at a loop range boundary.
 // loopStart is the start of the looping region in frames
 // If this value is >= buffer->frames, we treat this value as 0
-// returns the sound id, used for interacting with this instance later
-uint32_t azaSamplerPlayFull(azaSampler *data, azaBuffer *buffer, float speed, float gainDB, azaADSRConfig envelope, bool loop, bool pingpong, int32_t loopStart, int32_t loopEnd);
+// If config.maxInstances are already playing, one of them gets stolen according to config.steal, and fades out over config.stealFadeMs
+// returns the sound id, used for interacting with this instance later, or 0 if the command queue is full
+// ids are shared by every sampler and are never 0. They wrap around, so an id only gets reused after another 2^32-1 plays.
+uint32_t azaSamplerPlayFullAt(azaSampler *data, azaTime time, azaBuffer *buffer, float speed, float gainDB, azaADSRConfig envelope, bool loop, bool pingpong, int32_t loopStart, int32_t loopEnd);
+
+// Same as azaSamplerPlayFullAt, starting at the beginning of the next block.
+static inline uint32_t azaSamplerPlayFull(azaSampler *data, azaBuffer *buffer, float speed, float gainDB, azaADSRConfig envelope, bool loop, bool pingpong, int32_t loopStart, int32_t loopEnd) {
+	return azaSamplerPlayFullAt(data, AZA_CLITERAL(azaTime) { 0 }, buffer, speed, gainDB, envelope, loop, pingpong, loopStart, loopEnd);
+}
 
 static inline uint32_t azaSamplerPlay(azaSampler *data, azaBuffer *buffer, float speed, float gainDB, azaADSRConfig envelope) {
 	return azaSamplerPlayFull(data, buffer, speed, gainDB, envelope, false, false, 0, 0);
@@ -110,75 +237,78 @@ static inline uint32_t azaSamplerLoop(azaSampler *data, azaBuffer *buffer, float
 	return azaSamplerPlayFull(data, buffer, speed, gainDB, envelope, true, false, 0, 0);
 }
 
+// Only safe to use on the audio thread, such as between blocks in the same callback that calls azaSamplerProcess.
 // may return NULL, indicating the id wasn't found
 azaSamplerInstance* azaSamplerGetInstance(azaSampler *data, uint32_t id);
 
-static inline void azaSamplerSetSpeed(azaSampler *data, uint32_t id, float speed) {
-	azaMutexLock(&data->mutex);
-	azaSamplerInstance *instance = azaSamplerGetInstance(data, id);
-	if (instance) {
-		azaFollowerLinearSetTarget(&instance->speed, speed);
-	}
-	azaMutexUnlock(&data->mutex);
+// returns false if the command queue is full
+static inline bool azaSamplerSetSpeed(azaSampler *data, uint32_t id, float speed) {
+	azaSamplerCommand command = {0};
+	command.kind = AZA_SAMPLER_COMMAND_SET_SPEED;
+	command.id = id;
+	command.speed = speed;
+	return azaSamplerPushCommand(data, &command);
 }
 
-static inline void azaSamplerSetGain(azaSampler *data, uint32_t id, float gainDB) {
-	azaMutexLock(&data->mutex);
-	azaSamplerInstance *instance = azaSamplerGetInstance(data, id);
-	if (instance) {
-		azaFollowerLinearSetTarget(&instance->volume, aza_db_to_ampf(gainDB));
-	}
-	azaMutexUnlock(&data->mutex);
+// returns false if the command queue is full
+static inline bool azaSamplerSetGain(azaSampler *data, uint32_t id, float gainDB) {
+	azaSamplerCommand command = {0};
+	command.kind = AZA_SAMPLER_COMMAND_SET_GAIN;
+	command.id = id;
+	command.gainDB = gainDB;
+	return azaSamplerPushCommand(data, &command);
 }
 
+// Higher priority instances are less likely to be stolen with AZA_SAMPLER_STEAL_LOWEST_PRIORITY
+// returns false if the command queue is full
+static inline bool azaSamplerSetPriority(azaSampler *data, uint32_t id, uint8_t priority) {
+	azaSamplerCommand command = {0};
+	command.kind = AZA_SAMPLER_COMMAND_SET_PRIORITY;
+	command.id = id;
+	command.priority = priority;
+	return azaSamplerPushCommand(data, &command);
+}
+
+// Copies the state of the given instance as of the end of the last block into dst
+// returns false if the id wasn't playing then
+bool azaSamplerGetInstanceState(azaSampler *data, uint32_t id, azaSamplerInstanceState *dst);
+
 static inline float azaSamplerGetSpeedCurrent(azaSampler *data, uint32_t id) {
-	azaMutexLock(&data->mutex);
-	azaSamplerInstance *instance = azaSamplerGetInstance(data, id);
-	float result = 0.0f;
-	if (instance) {
-		result = azaFollowerLinearGetValue(&instance->speed);
-	}
-	azaMutexUnlock(&data->mutex);
-	return result;
+	azaSamplerInstanceState state;
+	if (!azaSamplerGetInstanceState(data, id, &state)) return 0.0f;
+	return state.speedCurrent;
 }
 
 static inline float azaSamplerGetGainCurrent(azaSampler *data, uint32_t id) {
-	azaMutexLock(&data->mutex);
-	azaSamplerInstance *instance = azaSamplerGetInstance(data, id);
-	float result = 0.0f;
-	if (instance) {
-		result = aza_amp_to_dbf(azaFollowerLinearGetValue(&instance->volume));
-	}
-	azaMutexUnlock(&data->mutex);
-	return result;
+	azaSamplerInstanceState state;
+	if (!azaSamplerGetInstanceState(data, id, &state)) return 0.0f;
+	return aza_amp_to_dbf(state.volumeCurrent);
 }
 
 static inline float azaSamplerGetSpeedTarget(azaSampler *data, uint32_t id) {
-	azaMutexLock(&data->mutex);
-	azaSamplerInstance *instance = azaSamplerGetInstance(data, id);
-	float result = 0.0f;
-	if (instance) {
-		result = instance->speed.end;
-	}
-	azaMutexUnlock(&data->mutex);
-	return result;
+	azaSamplerInstanceState state;
+	if (!azaSamplerGetInstanceState(data, id, &state)) return 0.0f;
+	return state.speedTarget;
 }
 
 static inline float azaSamplerGetGainTarget(azaSampler *data, uint32_t id) {
-	azaMutexLock(&data->mutex);
-	azaSamplerInstance *instance = azaSamplerGetInstance(data, id);
-	float result = 0.0f;
-	if (instance) {
-		result = aza_amp_to_dbf(instance->volume.end);
-	}
-	azaMutexUnlock(&data->mutex);
-	return result;
+	azaSamplerInstanceState state;
+	if (!azaSamplerGetInstanceState(data, id, &state)) return 0.0f;
+	return aza_amp_to_dbf(state.volumeTarget);
 }
 
-// Triggers the release of the given sound instance
-void azaSamplerStop(azaSampler *data, uint32_t id);
+// Triggers the release of the given sound instance at the given time on the sampler's clock (see azaSamplerGetTime)
+// returns false if the command queue is full
+bool azaSamplerStopAt(azaSampler *data, azaTime time, uint32_t id);
+
+// Triggers the release of the given sound instance at the start of the next block
+// returns false if the command queue is full
+static inline bool azaSamplerStop(azaSampler *data, uint32_t id) {
+	return azaSamplerStopAt(data, AZA_CLITERAL(azaTime) { 0 }, id);
+}
 
-void azaSamplerStopAll(azaSampler *data);
+// returns false if the command queue is full
+bool azaSamplerStopAll(azaSampler *data);
 
 
 
@@ -210,9 +210,12 @@ static void azaGetChannelMetadata(azaChannelLayout channelLayout, azaVec3 *dstVe
 
 #define FILTER_IN_CHANNEL_DATA 1
 
-void azaSpatializeInit(azaSpatialize *data, azaSpatializeConfig config) {
+int azaSpatializeInit(azaSpatialize *data, azaSpatializeConfig config) {
 	data->dsp = azaSpatializeHeader;
 	data->config = config;
+	data->time = 0;
+	int err = azaQueueInit(&data->eventQueue, sizeof(azaSpatializeEvent), AZAUDIO_SPATIALIZE_MAX_EVENTS);
+	if (err) return err;
 	azaDelayDynamicConfig delayConfig = {
 		.gainWet = 0.0f,
 		.gainDry = 0.0f,
@@ -242,6 +245,7 @@ void azaSpatializeInit(azaSpatialize *data, azaSpatializeConfig config) {
 	azaFilterInit(&data->filter, filterConfig);
 	azaDelayDynamicInit(&data->delay, delayConfig);
 #endif
+	return AZA_SUCCESS;
 }
 
 void azaSpatializeDeinit(azaSpatialize *data) {
@@ -254,6 +258,7 @@ void azaSpatializeDeinit(azaSpatialize *data) {
 	azaFilterDeinit(&data->filter);
 	azaDelayDynamicDeinit(&data->delay);
 #endif
+	azaQueueDeinit(&data->eventQueue);
 }
 
 void azaSpatializeReset(azaSpatialize *data) {
@@ -283,7 +288,10 @@ void azaSpatializeResetChannels(azaSpatialize *data, uint32_t firstChannel, uint
 azaSpatialize* azaSpatializeMake(azaSpatializeConfig config) {
 	azaSpatialize *result = aza_calloc(1, sizeof(azaSpatialize));
 	if (result) {
-		azaSpatializeInit(result, config);
+		if (azaSpatializeInit(result, config)) {
+			aza_free(result);
+			return NULL;
+		}
 	}
 	return result;
 }
@@ -325,39 +333,12 @@ static float azaSpatializeGetFilterCutoff(float delay, float dot) {
 }
 
 //int azaSpatializeProcess(azaSpatialize *data, azaBuffer dstBuffer, azaBuffer srcBuffer, azaVec3 srcPosStart, float srcAmpStart, azaVec3 srcPosEnd, float srcAmpEnd) {
-int azaSpatializeProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
-	// Bypass handled by azaDSPProcess
+// Does all the actual work for azaSpatializeProcess between events
+static int azaSpatializeProcessSegment(azaSpatialize *data, azaBuffer *dst, azaBuffer *src, uint32_t flags, const azaWorld *world) {
 	int err = AZA_SUCCESS;
-	assert(dsp != NULL);
-	azaSpatialize *data = (azaSpatialize*)dsp;
-
-	if AZA_UNLIKELY(flags & AZA_DSP_PROCESS_FLAG_CUT) {
-		azaSpatializeReset(data);
-	}
-
-	err = azaCheckBuffersForDSPProcess(dst, src, /* sameFrameCount: */ true, /* sameChannelCount: */ false);
-	if AZA_UNLIKELY(err) return err;
-
-	if (dst->channelLayout.count > data->dsp.processMetadata.prevChannelCountDst) {
-		azaSpatializeResetChannels(data, data->dsp.processMetadata.prevChannelCountDst, dst->channelLayout.count - data->dsp.processMetadata.prevChannelCountDst);
-	}
-	data->dsp.processMetadata.prevChannelCountDst = dst->channelLayout.count;
-
-	if (data->dsp.guiMetadata.selected) {
-		azaMetersUpdate(&data->metersInput, src, 1.0f);
-	}
 
 	uint8_t srcChannels = data->config.numSrcChannelsActive ? AZA_MIN(src->channelLayout.count, data->config.numSrcChannelsActive) : src->channelLayout.count;
 
-	const azaWorld *world = data->config.world;
-	if (world == NULL) {
-		world = &azaWorldDefault;
-	}
-	if (world->speedOfSound <= 0.0f) {
-		AZA_LOG_ERR("%s error: world->speedOfSound (%f) is out of bounds! This must be a positive nonzero value!\n", AZA_FUNCTION_NAME, world->speedOfSound);
-		return AZA_ERROR_INVALID_CONFIGURATION;
-	}
-
 	// Channel layout metadata
 	uint8_t nonSubChannels, hasAerials;
 	azaVec3 earNormal[AZA_MAX_CHANNEL_POSITIONS];
@@ -367,6 +348,11 @@ int azaSpatializeProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t fla
 
 	// Since src and dst can be the same buffer, copy src out, zero dst, and then go from there.
 	azaBuffer srcBuffer = azaPushSideBuffer(src->frames, 0, 0, srcChannels, src->samplerate);
+	azaBuffer sideBuffer = azaPushSideBufferCopyZero(dst);
+	if AZA_UNLIKELY(!srcBuffer.pSamples || !sideBuffer.pSamples) {
+		err = AZA_ERROR_OUT_OF_MEMORY;
+		goto error;
+	}
 	{
 		uint8_t oldChannels = src->channelLayout.count;
 		src->channelLayout.count = srcChannels;
@@ -374,7 +360,6 @@ int azaSpatializeProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t fla
 		src->channelLayout.count = oldChannels;
 	}
 	azaBufferZero(dst);
-	azaBuffer sideBuffer = azaPushSideBufferCopyZero(dst);
 
 	// We'll add this to per-channel delays to avoid negative delays.
 	// TODO: We may consider adding this to the reported plugin delay to factor in to delay compensation.
@@ -386,7 +371,6 @@ int azaSpatializeProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t fla
 
 	for (uint8_t srcC = 0; srcC < srcChannels; srcC++) {
 		// Transform srcPos to headspace
-		// TODO: Handle events
 		azaFollowerLinearSetTarget(&data->channelData[srcC].amplitude, data->config.channels[srcC].target.amplitude);
 		azaFollowerLinear3DSetTarget(&data->channelData[srcC].position, data->config.channels[srcC].target.position);
 		azaVec3 srcPosStart = azaWorldTransformPoint(world, azaFollowerLinear3DUpdate(&data->channelData[srcC].position, followerDeltaT));
@@ -413,8 +397,9 @@ int azaSpatializeProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t fla
 			azaBufferMixFadeLinear(&sideBuffer, 1.0f, 1.0f, &srcBuffer, srcAmpStart, srcAmpEnd);
 
 			if (data->config.doFilter) {
-				// TODO: Probably let the filter cutoff change smoothly
-				channelData->filter.config.frequency = azaSpatializeGetFilterCutoff(delayStart_ms, 1.0f);
+				float cutoffStart = azaSpatializeGetFilterCutoff(delayStart_ms, 1.0f);
+				float cutoffEnd = azaSpatializeGetFilterCutoff(delayEnd_ms, 1.0f);
+				azaFilterSetRamps(&channelData->filter, 1, &cutoffStart, &cutoffEnd, dst->frames, dst->samplerate);
 				err = azaFilterProcess(&data->channelData[srcC].filter, &sideBuffer, &sideBuffer, flags);
 				if AZA_UNLIKELY(err) goto error;
 			}
@@ -527,14 +512,19 @@ int azaSpatializeProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t fla
 		}
 
 		if (data->config.doFilter) {
-			// TODO: Probably let the filter cutoff change smoothly
-			if (data->config.usePerChannelFilter) {
-				for (uint8_t c = 0; c < sideBuffer.channelLayout.count; c++) {
-					channelData->filter.config.channelFrequencyOverride[c] = azaSpatializeGetFilterCutoff(delayStart_ms, channelsStart[c].dot);
+			float cutoffStart[AZA_MAX_CHANNEL_POSITIONS];
+			float cutoffEnd[AZA_MAX_CHANNEL_POSITIONS];
+			for (uint8_t c = 0; c < sideBuffer.channelLayout.count; c++) {
+				if (data->config.usePerChannelFilter) {
+					cutoffStart[c] = azaSpatializeGetFilterCutoff(delayStart_ms, channelsStart[c].dot);
+					cutoffEnd[c] = azaSpatializeGetFilterCutoff(delayEnd_ms, channelsEnd[c].dot);
+				} else {
+					cutoffStart[c] = azaSpatializeGetFilterCutoff(avgDelayStart_ms, 1.0f);
+					cutoffEnd[c] = azaSpatializeGetFilterCutoff(avgDelayEnd_ms, 1.0f);
 				}
-			} else {
-				channelData->filter.config.frequency = azaSpatializeGetFilterCutoff(avgDelayStart_ms, 1.0f);
 			}
+			// The cutoff moves with the source every frame, rather than stepping once per buffer.
+			azaFilterSetRamps(&channelData->filter, sideBuffer.channelLayout.count, cutoffStart, cutoffEnd, dst->frames, dst->samplerate);
 			err = azaFilterProcess(&data->channelData[srcC].filter, &sideBuffer, &sideBuffer, flags);
 			if AZA_UNLIKELY(err) goto error;
 		}
@@ -571,6 +561,63 @@ error:
 	return err;
 }
 
+int azaSpatializeProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
+	// Bypass handled by azaDSPProcess
+	int err = AZA_SUCCESS;
+	assert(dsp != NULL);
+	azaSpatialize *data = (azaSpatialize*)dsp;
+
+	if AZA_UNLIKELY(flags & AZA_DSP_PROCESS_FLAG_CUT) {
+		azaSpatializeReset(data);
+	}
+
+	err = azaCheckBuffersForDSPProcess(dst, src, /* sameFrameCount: */ true, /* sameChannelCount: */ false);
+	if AZA_UNLIKELY(err) return err;
+
+	if (dst->channelLayout.count > data->dsp.processMetadata.prevChannelCountDst) {
+		azaSpatializeResetChannels(data, data->dsp.processMetadata.prevChannelCountDst, dst->channelLayout.count - data->dsp.processMetadata.prevChannelCountDst);
+	}
+	data->dsp.processMetadata.prevChannelCountDst = dst->channelLayout.count;
+
+	if (data->dsp.guiMetadata.selected) {
+		azaMetersUpdate(&data->metersInput, src, 1.0f);
+	}
+
+	const azaWorld *world = data->config.world;
+	if (world == NULL) {
+		world = &azaWorldDefault;
+	}
+	if (world->speedOfSound <= 0.0f) {
+		AZA_LOG_ERR("%s error: world->speedOfSound (%f) is out of bounds! This must be a positive nonzero value!\n", AZA_FUNCTION_NAME, world->speedOfSound);
+		return AZA_ERROR_INVALID_CONFIGURATION;
+	}
+
+	// Split the block wherever an event lands, so new targets start on the exact frame they were scheduled for
+	azaTime timeStart = { data->time };
+	azaTime timePerFrame = azaTimePerSample(dst->samplerate);
+	uint32_t frame = 0;
+	while (frame < dst->frames) {
+		azaQueueEntry *entry;
+		while ((entry = azaQueueDequeueDue(&data->eventQueue, timeStart, timePerFrame, frame))) {
+			azaSpatializeEvent *event = (azaSpatializeEvent*)entry;
+			memcpy(data->config.channels, event->newConfig, sizeof(event->newConfig));
+		}
+		uint32_t frameNext = azaQueueGetNextFrame(&data->eventQueue, timeStart, timePerFrame, dst->frames);
+		if (frame == 0 && frameNext == dst->frames) {
+			err = azaSpatializeProcessSegment(data, dst, src, flags, world);
+		} else {
+			azaBuffer dstSegment = azaBufferSlice(dst, frame, frameNext - frame);
+			azaBuffer srcSegment = azaBufferSlice(src, frame, frameNext - frame);
+			// Only the first segment follows a discontinuity
+			err = azaSpatializeProcessSegment(data, &dstSegment, &srcSegment, frame == 0 ? flags : flags & ~AZA_DSP_PROCESS_FLAG_CUT, world);
+		}
+		if AZA_UNLIKELY(err) break;
+		frame = frameNext;
+	}
+	azaAtomicStore64(&data->time, timeStart.time + (int64_t)dst->frames * timePerFrame.time);
+	return err;
+}
+
 azaDSPSpecs azaSpatializeGetSpecs(azaDSP *dsp, uint32_t samplerate) {
 	azaSpatialize *data = (azaSpatialize*)dsp;
 	azaDSPSpecs specs = {0};
@@ -10,6 +10,7 @@
 #include "../azaDSP.h"
 #include "azaDelayDynamic.h"
 #include "azaFilter.h"
+#include "../../atomic.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -89,6 +90,10 @@ typedef struct azaSpatializeConfig {
 	azaSpatializeChannelConfig channels[AZA_MAX_CHANNEL_POSITIONS];
 } azaSpatializeConfig;
 
+// How many events can be waiting for the audio thread at once
+#define AZAUDIO_SPATIALIZE_MAX_EVENTS 64
+
+// Replaces config.channels at header.time on the azaSpatialize's clock (see azaSpatializeGetTime), splitting the block there such that the followers start moving towards the new targets on that exact frame.
 typedef struct azaSpatializeEvent {
 	azaQueueEntry header;
 	azaSpatializeChannelConfig newConfig[AZA_MAX_CHANNEL_POSITIONS];
@@ -97,7 +102,10 @@ typedef struct azaSpatializeEvent {
 typedef struct azaSpatialize {
 	azaDSP dsp;
 	azaSpatializeConfig config;
-	// TODO: azaQueue eventQueue;
+	// azaSpatializeEvent entries, which any thread may push with azaSpatializePushEvent
+	azaQueue eventQueue;
+	// Time at the start of the next block. Starts at 0 and advances by however many frames we process.
+	volatile int64_t time;
 
 	azaMeters metersInput;
 	azaMeters metersOutput;
@@ -106,7 +114,8 @@ typedef struct azaSpatialize {
 } azaSpatialize;
 
 // initializes azaSpatialize in existing memory
-void azaSpatializeInit(azaSpatialize *data, azaSpatializeConfig config);
+// May return AZA_ERROR_OUT_OF_MEMORY
+int azaSpatializeInit(azaSpatialize *data, azaSpatializeConfig config);
 // frees any additional memory that the azaSpatialize may have allocated
 void azaSpatializeDeinit(azaSpatialize *data);
 // Resets state. May be called automatically.
@@ -129,6 +138,17 @@ int azaSpatializeProcess(void *dsp, azaBuffer *dst, azaBuffer *src, uint32_t fla
 // azaDelayDynamic's sampling kernel causes there to be a minimum latency requirement, so we'll report that here
 azaDSPSpecs azaSpatializeGetSpecs(azaDSP *dsp, uint32_t samplerate);
 
+// Returns the time at the start of the next block. Use this as a base for scheduling events with sample accuracy.
+static inline azaTime azaSpatializeGetTime(azaSpatialize *data) {
+	return AZA_CLITERAL(azaTime) { azaAtomicLoad64(&data->time) };
+}
+
+// Queues an event for the audio thread. Safe to call from any thread, and never blocks.
+// returns false if AZAUDIO_SPATIALIZE_MAX_EVENTS are already waiting, in which case nothing happens
+static inline bool azaSpatializePushEvent(azaSpatialize *data, const azaSpatializeEvent *event) {
+	return azaQueueEnqueue(&data->eventQueue, &event->header);
+}
+
 
 
 // Utilities
@@ -6,6 +6,7 @@
 #include "utility.h"
 #include "../AzAudio.h"
 #include "../error.h"
+#include "../atomic.h"
 
 #include <stdlib.h>
 
@@ -14,80 +15,139 @@ azaWorld azaWorldDefault;
 
 
 int azaQueueInit_unchecked(azaQueue *data, uint16_t entrySizeBytes, uint16_t countLimit) {
+	assert((entrySizeBytes & 0x7) == 0);
+	uint32_t limit = 1;
+	while (limit < countLimit && limit < 0x8000) {
+		limit *= 2;
+	}
 	data->entrySizeBytes = entrySizeBytes;
-	data->countLimit = countLimit;
+	data->countLimit = (uint16_t)limit;
 	data->count = 0;
 	data->startIndex = 0;
-	// Double countLimit so we can just ignore wraparound. Wastes memory, but let's see if we actually care.
-	data->buffer = aza_calloc((size_t)countLimit * 2, (size_t)entrySizeBytes);
-	if (!data->buffer) {
+	data->head = 0;
+	data->tail = 0;
+	// One allocation for the sequences, the ring, and the sorted buffer
+	size_t sequencesSize = aza_align(limit * sizeof(int32_t), 8);
+	size_t entriesSize = (size_t)limit * (size_t)entrySizeBytes;
+	data->sequences = aza_calloc(sequencesSize + 2 * entriesSize, 1);
+	if (!data->sequences) {
 		return AZA_ERROR_OUT_OF_MEMORY;
 	}
+	data->ring = (aza_byte*)data->sequences + sequencesSize;
+	data->buffer = data->ring + entriesSize;
+	for (uint32_t i = 0; i < limit; i++) {
+		data->sequences[i] = (int32_t)i;
+	}
 	return AZA_SUCCESS;
 }
 
 void azaQueueDeinit(azaQueue *data) {
-	if (data->buffer) {
-		aza_free(data->buffer);
+	if (data->sequences) {
+		aza_free((void*)data->sequences);
+		data->sequences = NULL;
+		data->ring = NULL;
+		data->buffer = NULL;
 	}
 }
 
-void azaQueueClear(azaQueue *data) {
-	data->count = 0;
-	data->startIndex = 0;
+static inline azaQueueEntry* azaQueueGetEntry(aza_byte *entries, uint16_t entrySizeBytes, uint32_t index) {
+	return (azaQueueEntry*)(entries + (size_t)index * (size_t)entrySizeBytes);
 }
 
-bool azaQueueEnqueue(azaQueue *data, azaQueueEntry *src) {
-	if (data->count >= data->countLimit) {
-		return false;
+// Moves everything that's been enqueued out of the ring and into buffer, keeping buffer sorted by time.
+static void azaQueueTake(azaQueue *data) {
+	uint32_t mask = data->countLimit - 1;
+	// If buffer is full, the rest waits in the ring until there's room
+	while (data->count < data->countLimit) {
+		uint32_t slot = data->tail & mask;
+		if (azaAtomicLoad32(&data->sequences[slot]) != (int32_t)(data->tail + 1)) break;
+		if (data->startIndex + data->count >= data->countLimit) {
+			memmove(data->buffer, azaQueueGetEntry(data->buffer, data->entrySizeBytes, data->startIndex), (size_t)data->count * (size_t)data->entrySizeBytes);
+			data->startIndex = 0;
+		}
+		azaQueueEntry *src = azaQueueGetEntry(data->ring, data->entrySizeBytes, slot);
+		// Insertion sort, which keeps entries with the same time in the order they were enqueued. There usually aren't many, and they're usually already in order.
+		uint32_t i = data->count;
+		while (i > 0 && azaQueueGetEntry(data->buffer, data->entrySizeBytes, data->startIndex + i-1)->time.time > src->time.time) {
+			i--;
+		}
+		aza_byte *dst = (aza_byte*)azaQueueGetEntry(data->buffer, data->entrySizeBytes, data->startIndex + i);
+		memmove(dst + data->entrySizeBytes, dst, (size_t)(data->count - i) * (size_t)data->entrySizeBytes);
+		memcpy(dst, src, data->entrySizeBytes);
+		data->count++;
+		// Hand the slot back to the enqueuers for the next lap
+		azaAtomicStore32(&data->sequences[slot], (int32_t)(data->tail + data->countLimit));
+		data->tail++;
 	}
-	// Prefer to do this in Enqueue rather than Dequeue because Dequeue will be happening in the sound thread, while Enqueue may be happening in a less performance-critical place.
-	if (data->startIndex >= data->countLimit) {
-		memmove(data->buffer, data->buffer + (size_t)data->startIndex * (size_t)data->entrySizeBytes, (size_t)data->count * (size_t)data->entrySizeBytes);
+}
+
+void azaQueueClear(azaQueue *data) {
+	do {
+		data->count = 0;
 		data->startIndex = 0;
+		azaQueueTake(data);
+	} while (data->count);
+}
+
+bool azaQueueEnqueue(azaQueue *data, const azaQueueEntry *src) {
+	uint32_t mask = data->countLimit - 1;
+	uint32_t position = (uint32_t)azaAtomicLoad32(&data->head);
+	while (true) {
+		uint32_t slot = position & mask;
+		int32_t difference = (int32_t)((uint32_t)azaAtomicLoad32(&data->sequences[slot]) - position);
+		if (difference == 0) {
+			// The slot is free, so try to claim it
+			if (azaAtomicCompareExchange32(&data->head, (int32_t)position, (int32_t)(position + 1))) {
+				memcpy(azaQueueGetEntry(data->ring, data->entrySizeBytes, slot), src, data->entrySizeBytes);
+				azaAtomicStore32(&data->sequences[slot], (int32_t)(position + 1));
+				return true;
+			}
+		} else if (difference < 0) {
+			// The consumer hasn't taken the entry from a whole lap ago, so we're full
+			return false;
+		}
+		// Somebody else claimed it first
+		position = (uint32_t)azaAtomicLoad32(&data->head);
 	}
-	size_t dstIndex = (size_t)data->startIndex + (size_t)data->count;
-	azaQueueEntry *dst = (azaQueueEntry*)(data->buffer + dstIndex * (size_t)data->entrySizeBytes);
-	memcpy(dst, src, data->entrySizeBytes);
-	return true;
 }
 
 azaQueueEntry* azaQueueDequeue(azaQueue *data) {
-	azaQueueEntry *result;
-	if (data->count) {
-		result = (azaQueueEntry*)(data->buffer + (size_t)data->startIndex * (size_t)data->entrySizeBytes);
+	azaQueueEntry *result = azaQueuePeek(data);
+	if (result) {
 		data->startIndex++;
 		data->count--;
-	} else {
-		result = NULL;
 	}
 	return result;
 }
 
 azaQueueEntry* azaQueuePeek(azaQueue *data) {
-	azaQueueEntry *result;
-	if (data->count) {
-		result = (azaQueueEntry*)(data->buffer + (size_t)data->startIndex * (size_t)data->entrySizeBytes);
-	} else {
-		result = NULL;
-	}
-	return result;
+	azaQueueTake(data);
+	if (data->count == 0) return NULL;
+	return azaQueueGetEntry(data->buffer, data->entrySizeBytes, data->startIndex);
 }
 
-static int compareQueueEntryTime(const void *_lhs, const void *_rhs) {
-	const azaQueueEntry *lhs = _lhs;
-	const azaQueueEntry *rhs = _rhs;
-	// Sort descending
-	if (lhs->time.time < rhs->time.time) return 1;
-	if (lhs->time.time > rhs->time.time) return -1;
-	return 0;
+void azaQueueSort(azaQueue *data) {
+	azaQueueTake(data);
 }
 
-void azaQueueSort(azaQueue *data) {
-	if (data->count >= 2) {
-		void *bufferStart = data->buffer + (size_t)data->startIndex * (size_t)data->entrySizeBytes;
-		qsort(bufferStart, data->count, data->entrySizeBytes, compareQueueEntryTime);
-	}
+azaQueueEntry* azaQueueGetSorted(azaQueue *data, uint32_t index) {
+	if (index >= data->count) return NULL;
+	return azaQueueGetEntry(data->buffer, data->entrySizeBytes, data->startIndex + index);
+}
+
+azaQueueEntry* azaQueueDequeueDue(azaQueue *data, azaTime timeStart, azaTime timePerFrame, uint32_t frame) {
+	azaQueueEntry *result = azaQueuePeek(data);
+	// Passing frame+1 as the block length means anything after frame comes back as frame+1
+	if (!result || azaTimeGetFrameInBlock(result->time, timeStart, timePerFrame, frame+1) > frame) return NULL;
+	data->startIndex++;
+	data->count--;
+	return result;
+}
+
+uint32_t azaQueueGetNextFrame(azaQueue *data, azaTime timeStart, azaTime timePerFrame, uint32_t frames) {
+	azaQueueEntry *entry = azaQueuePeek(data);
+	if (!entry) return frames;
+	return azaTimeGetFrameInBlock(entry->time, timeStart, timePerFrame, frames);
 }
 
 
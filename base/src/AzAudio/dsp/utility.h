@@ -35,45 +35,94 @@ static inline azaTime azaTimePerSample(uint32_t samplerate) {
 
 
 
+// Returns which frame of a block starting at timeStart the given time lands on, rounding up so nothing happens early. Anything at or before timeStart lands on frame 0, and anything past the end of the block returns frames.
+static inline uint32_t azaTimeGetFrameInBlock(azaTime time, azaTime timeStart, azaTime timePerFrame, uint32_t frames) {
+	int64_t delta = time.time - timeStart.time;
+	if (delta <= 0) return 0;
+	int64_t frame = (delta + timePerFrame.time - 1) / timePerFrame.time;
+	return frame < (int64_t)frames ? (uint32_t)frame : frames;
+}
+
+
+
 // Base interface to azaQueue entries, must be at the beginning of any derived structs
 typedef struct azaQueueEntry {
 	azaTime time;
 } azaQueueEntry;
 
+// Time-ordered queue of events. Any number of threads may enqueue at once without locking or waiting on each other, while exactly one thread (usually the audio thread) takes them out in order of time.
+// Entries go into a bounded ring in the style of Dmitry Vyukov's MPMC queue. The consuming thread moves them out of the ring into a sorted list as it needs them.
 typedef struct azaQueue {
 	uint16_t entrySizeBytes;
+	// Always a power of 2
 	uint16_t countLimit;
+	// How many entries have been moved into buffer that haven't been dequeued yet. Only the consuming thread touches this.
 	uint16_t count;
+	// Where in buffer the earliest entry lives. Only the consuming thread touches this.
 	uint16_t startIndex;
+	// Next position in the ring to enqueue to, advanced by whichever thread claims it
+	volatile int32_t head;
+	// Next position in the ring to take from. Only the consuming thread touches this.
+	uint32_t tail;
+	// One per slot in ring. Equal to the position when the slot is free to write, and the position + 1 when it's ready to read.
+	volatile int32_t *sequences;
+	// countLimit entries, written by enqueuers
+	aza_byte *ring;
+	// countLimit entries taken out of ring, sorted by time. Only the consuming thread touches this.
 	aza_byte *buffer;
 } azaQueue;
 
 // Inits a queue for entries of the given size and an upper bound on how many entries can be queued.
+// countLimit gets rounded up to a power of 2, up to a maximum of 32768.
 // May return AZA_ERROR_OUT_OF_MEMORY
 int azaQueueInit_unchecked(azaQueue *data, uint16_t entrySizeBytes, uint16_t countLimit);
-// NOTE: static_asserts that both entrySizeBytes and countLimit are <= UINT16_MAX
+// NOTE: Fails to compile unless entrySizeBytes is a multiple of 8 and both entrySizeBytes and countLimit fit in a uint16_t
+// static_assert isn't allowed in an expression, so we make a negative array size instead
+#define AZA_QUEUE_CHECK(condition) (void)sizeof(char[(condition) ? 1 : -1])
 #define azaQueueInit(data, entrySizeBytes, countLimit) (\
-	static_assert((entrySizeBytes) <= UINT16_MAX, "In " AZA_FUNCTION_NAME " entrySizeBytes (" #entrySizeBytes ") would overflow our uint16_t!");\
-	static_assert(((entrySizeBytes) & 0x7) == 0, "In " AZA_FUNCTION_NAME " entrySizeBytes (" #entrySizeBytes ") is not aligned on an 8-byte boundary!");\
-	static_assert((countLimit) <= UINT16_MAX, "In " AZA_FUNCTION_NAME " countLimit (" #countLimit ") would overflow our uint16_t!");\
-	static_assert((countLimit) > 0, "In " AZA_FUNCTION_NAME " countLimit (" #countLimit ") must be specified!");\
-	azaQueueInit_unchecked((data), (entrySizeBytes), (countLimit))\
+	AZA_QUEUE_CHECK((entrySizeBytes) <= UINT16_MAX),\
+	AZA_QUEUE_CHECK(((entrySizeBytes) & 0x7) == 0),\
+	AZA_QUEUE_CHECK((countLimit) <= UINT16_MAX),\
+	AZA_QUEUE_CHECK((countLimit) > 0),\
+	azaQueueInit_unchecked((data), (uint16_t)(entrySizeBytes), (uint16_t)(countLimit))\
 )
-// Frees the buffer
+// Frees the buffers
 void azaQueueDeinit(azaQueue *data);
-// Empties the queue
+// Empties the queue. Only call this from the consuming thread.
 void azaQueueClear(azaQueue *data);
-// Push an entry onto the queue
+// Push an entry onto the queue. Safe to call from any thread.
 // returns false if the queue is full
-bool azaQueueEnqueue(azaQueue *data, azaQueueEntry *src);
-// Pop an entry off the queue and return it
+bool azaQueueEnqueue(azaQueue *data, const azaQueueEntry *src);
+// Pop the entry with the earliest time off the queue and return it. Entries with the same time come out in the order they were enqueued.
+// The returned entry stays valid until the next call to anything other than azaQueueEnqueue. Only call this from the consuming thread.
 // returns NULL if the queue is empty
 azaQueueEntry* azaQueueDequeue(azaQueue *data);
-// Peeks at the next entry on the queue
+// Peeks at the entry with the earliest time. Only call this from the consuming thread.
 // returns NULL if the queue is empty
 azaQueueEntry* azaQueuePeek(azaQueue *data);
-// Sorts the queue by time
+// Entries are always kept in order of time now, so this only takes anything newly enqueued out of the ring. Only call this from the consuming thread.
 void azaQueueSort(azaQueue *data);
+// Looks at the entry index places after the earliest among those already taken out of the ring, without taking anything new out. Only call this from the consuming thread.
+// returns NULL if there aren't that many
+azaQueueEntry* azaQueueGetSorted(azaQueue *data, uint32_t index);
+
+// Splitting a block at event boundaries:
+// 	uint32_t frame = 0;
+// 	while (frame < frames) {
+// 		azaQueueEntry *entry;
+// 		while ((entry = azaQueueDequeueDue(&queue, timeStart, timePerFrame, frame))) {
+// 			// Apply entry
+// 		}
+// 		uint32_t frameNext = azaQueueGetNextFrame(&queue, timeStart, timePerFrame, frames);
+// 		// Process frames [frame, frameNext)
+// 		frame = frameNext;
+// 	}
+
+// Pops the earliest entry if it lands on or before frame of the block starting at timeStart (see azaTimeGetFrameInBlock). Only call this from the consuming thread.
+// returns NULL if there's nothing due yet
+azaQueueEntry* azaQueueDequeueDue(azaQueue *data, azaTime timeStart, azaTime timePerFrame, uint32_t frame);
+// Returns which frame of the block starting at timeStart the earliest entry lands on, or frames if there's nothing in this block. Only call this from the consuming thread.
+uint32_t azaQueueGetNextFrame(azaQueue *data, azaTime timeStart, azaTime timePerFrame, uint32_t frames);
 
 
 
@@ -6,6 +6,8 @@
 #include "fft.h"
 
 #include "math.h"
+#include "error.h"
+#include "aza_c_std.h"
 
 #include <assert.h>
 
@@ -76,4 +78,150 @@ void azaFFT(float * restrict valReal, float * restrict valImag, uint32_t len) {
 			// rotImag_d = tempReal_d*cosImag_d + rotImag*cosReal_d;
 		}
 	}
-}
\ No newline at end of file
+}
+
+
+// FFT Plans
+
+
+
+int azaFFTPlanInit(azaFFTPlan *plan, uint32_t len) {
+	memset(plan, 0, sizeof(*plan));
+	if (len < 2 || (len & (len-1)) != 0) return AZA_ERROR_INVALID_FRAME_COUNT;
+	uint32_t halfLen = len >> 1;
+	uint32_t radix4TwiddleCount = len >= 4 ? 6 * (len/4 * 2 - 1) : 0;
+	// One allocation for all the tables
+	void *block = aza_malloc(sizeof(float) * (halfLen * 2 + radix4TwiddleCount) + sizeof(uint32_t) * len);
+	if (!block) return AZA_ERROR_OUT_OF_MEMORY;
+	plan->len = len;
+	plan->log2Len = 0;
+	while ((1u << plan->log2Len) < len) plan->log2Len++;
+	plan->twiddleReal = (float*)block;
+	plan->twiddleImag = plan->twiddleReal + halfLen;
+	plan->radix4Twiddles = plan->twiddleImag + halfLen;
+	plan->bitReverse = (uint32_t*)(plan->radix4Twiddles + radix4TwiddleCount);
+	for (uint32_t k = 0; k < halfLen; k++) {
+		// Calculate these in double precision since any error here shows up in every transform
+		double angle = AZA_TAU_D * (double)k / (double)len;
+		plan->twiddleReal[k] = (float) cos(angle);
+		plan->twiddleImag[k] = (float)-sin(angle);
+	}
+	for (uint32_t m = 1; m <= len/4; m <<= 1) {
+		float *twiddles = plan->radix4Twiddles + 6*(m-1);
+		for (uint32_t k = 0; k < m; k++) {
+			for (uint32_t power = 1; power <= 3; power++) {
+				double angle = AZA_TAU_D * (double)(power*k) / (double)(4*m);
+				twiddles[(power-1)*2*m + k]     = (float) cos(angle);
+				twiddles[(power-1)*2*m + m + k] = (float)-sin(angle);
+			}
+		}
+	}
+	for (uint32_t i = 0; i < len; i++) {
+		uint32_t reversed = 0;
+		for (uint32_t bit = 0; bit < plan->log2Len; bit++) {
+			reversed |= ((i >> bit) & 1) << (plan->log2Len - 1 - bit);
+		}
+		plan->bitReverse[i] = reversed;
+	}
+	return AZA_SUCCESS;
+}
+
+void azaFFTPlanDeinit(azaFFTPlan *plan) {
+	if (plan->twiddleReal) {
+		aza_free(plan->twiddleReal);
+	}
+	memset(plan, 0, sizeof(*plan));
+}
+
+void azaFFTPlanForward(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag) {
+	azaFFTPlanTransform(plan, valReal, valImag, plan->log2Len);
+}
+
+void azaFFTPlanInverse(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag) {
+	// Swapping real and imaginary parts on the way in and out turns a forward transform into an inverse one
+	azaFFTPlanTransform(plan, valImag, valReal, plan->log2Len);
+	float scale = 1.0f / (float)plan->len;
+	for (uint32_t i = 0; i < plan->len; i++) {
+		valReal[i] *= scale;
+		valImag[i] *= scale;
+	}
+}
+
+// For the real transforms, we treat the even samples as real parts and the odd samples as imaginary parts of a complex signal z of half the length.
+// With Z = FFT(z), M = len/2, and W = e^(-i*tau/len):
+// X[k] = E[k] + W^k * O[k], where E[k] = (Z[k] + conj(Z[M-k]))/2 and O[k] = (Z[k] - conj(Z[M-k]))/2i
+// Since E[M-k] = conj(E[k]) and O[M-k] = conj(O[k]), each k gives us X[M-k] too, which lets us do it in-place.
+
+void azaFFTPlanForwardReal(azaFFTPlan *plan, const float *samples, float *dstReal, float *dstImag) {
+	uint32_t halfLen = plan->len >> 1;
+	// Going forwards is safe if samples == dstReal since we only ever write behind where we read
+	for (uint32_t i = 0; i < halfLen; i++) {
+		float even = samples[2*i+0];
+		float odd  = samples[2*i+1];
+		dstReal[i] = even;
+		dstImag[i] = odd;
+	}
+	azaFFTPlanTransform(plan, dstReal, dstImag, plan->log2Len - 1);
+	// DC and nyquist are purely real
+	float z0Real = dstReal[0], z0Imag = dstImag[0];
+	dstReal[0] = z0Real + z0Imag;
+	dstImag[0] = 0.0f;
+	dstReal[halfLen] = z0Real - z0Imag;
+	dstImag[halfLen] = 0.0f;
+	for (uint32_t k = 1; k <= halfLen/2; k++) {
+		uint32_t j = halfLen - k;
+		float evenReal = 0.5f * (dstReal[k] + dstReal[j]);
+		float evenImag = 0.5f * (dstImag[k] - dstImag[j]);
+		float oddReal  = 0.5f * (dstImag[k] + dstImag[j]);
+		float oddImag  = 0.5f * (dstReal[j] - dstReal[k]);
+		float rotReal = plan->twiddleReal[k];
+		float rotImag = plan->twiddleImag[k];
+		float tempReal = oddReal*rotReal - oddImag*rotImag;
+		float tempImag = oddReal*rotImag + oddImag*rotReal;
+		dstReal[k] = evenReal + tempReal;
+		dstImag[k] = evenImag + tempImag;
+		// X[M-k] = conj(E[k] - W^k * O[k]), and this is the same as X[k] when j == k
+		dstReal[j] =   evenReal - tempReal;
+		dstImag[j] = -(evenImag - tempImag);
+	}
+}
+
+void azaFFTPlanInverseReal(azaFFTPlan *plan, float *dst, float *srcReal, float *srcImag) {
+	uint32_t halfLen = plan->len >> 1;
+	// Undo the unpacking above to get back to Z, where E[k] = (X[k] + conj(X[M-k]))/2 and O[k] = conj(W^k) * (X[k] - conj(X[M-k]))/2
+	{
+		float evenReal = 0.5f * (srcReal[0] + srcReal[halfLen]);
+		float oddReal  = 0.5f * (srcReal[0] - srcReal[halfLen]);
+		float evenImag = 0.5f * (srcImag[0] - srcImag[halfLen]);
+		float oddImag  = 0.5f * (srcImag[0] + srcImag[halfLen]);
+		// Z = E + i*O
+		srcReal[0] = evenReal - oddImag;
+		srcImag[0] = evenImag + oddReal;
+	}
+	for (uint32_t k = 1; k <= halfLen/2; k++) {
+		uint32_t j = halfLen - k;
+		float evenReal = 0.5f * (srcReal[k] + srcReal[j]);
+		float evenImag = 0.5f * (srcImag[k] - srcImag[j]);
+		float diffReal = 0.5f * (srcReal[k] - srcReal[j]);
+		float diffImag = 0.5f * (srcImag[k] + srcImag[j]);
+		float rotReal =  plan->twiddleReal[k];
+		float rotImag = -plan->twiddleImag[k];
+		float oddReal = diffReal*rotReal - diffImag*rotImag;
+		float oddImag = diffReal*rotImag + diffImag*rotReal;
+		srcReal[k] = evenReal - oddImag;
+		srcImag[k] = evenImag + oddReal;
+		// Z[M-k] = conj(E[k]) + i*conj(O[k]), and this is the same as Z[k] when j == k
+		srcReal[j] =  evenReal + oddImag;
+		srcImag[j] = -evenImag + oddReal;
+	}
+	// Inverse transform via the same real/imaginary swap as azaFFTPlanInverse
+	azaFFTPlanTransform(plan, srcImag, srcReal, plan->log2Len - 1);
+	float scale = 1.0f / (float)halfLen;
+	// Going backwards is safe if dst == srcReal since we only ever write ahead of where we read
+	for (uint32_t i = halfLen; i-- > 0;) {
+		float even = srcReal[i] * scale;
+		float odd  = srcImag[i] * scale;
+		dst[2*i+0] = even;
+		dst[2*i+1] = odd;
+	}
+}
@@ -7,6 +7,8 @@
 #ifndef AZAUDIO_FFT_H
 #define AZAUDIO_FFT_H
 
+#include "aza_c_std.h"
+
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -17,11 +19,67 @@ extern "C" {
 // For time-domain signals valReal should contain len samples and valImag should be len zeroes.
 // The result will put len/2+1 values into valReal and valImag
 // The output valReal[i] and valImag[i] correspond to i*samplerate/len Hz
-// TODO: Study and document more properties of this function, including how to reverse it and what the remaining len/2-1 values in the output mean.
-void azaFFT(float * restrict valReal, float * restrict valImag, uint32_t len);
+// This computes its twiddle factors every call, so if you're doing more than one transform of the same size, use an azaFFTPlan instead.
+void azaFFT(float * AZA_RESTRICT valReal, float * AZA_RESTRICT valImag, uint32_t len);
+
+
+
+// FFT Plans
+
+
+
+// Precomputed tables for transforms of a single length, so the transforms themselves don't have to call any trig functions.
+typedef struct azaFFTPlan {
+	// Number of points in the complex transforms, and number of samples in the real transforms
+	uint32_t len;
+	uint32_t log2Len;
+	// len/2 twiddle factors, where twiddleReal[k] + i*twiddleImag[k] = e^(-i*tau*k/len)
+	float *twiddleReal;
+	float *twiddleImag;
+	// Bit-reversed index for every index in [0, len)
+	uint32_t *bitReverse;
+	// Contiguous twiddles for every radix-4 pass that combines 4 transforms of size m into one of size 4m, for m from 1 to len/4.
+	// Each pass has 6*m floats starting at 6*(m-1). With w = e^(-i*tau/4m) these are the real parts of w^k for k in [0, m), then the imaginary parts, then the same for w^2k and w^3k.
+	float *radix4Twiddles;
+} azaFFTPlan;
+
+// len must be a power of 2 that's at least 2
+// May return AZA_ERROR_INVALID_FRAME_COUNT if len isn't a power of 2 or is less than 2
+// May return AZA_ERROR_OUT_OF_MEMORY
+int azaFFTPlanInit(azaFFTPlan *plan, uint32_t len);
+void azaFFTPlanDeinit(azaFFTPlan *plan);
+
+// Complex forward transform of (1 << log2n) values done in-place, where log2n <= plan->log2Len. This is the core that all the azaFFTPlan transforms use.
+// Implemented in specialized/azaFFT.c
+void azaFFTPlanTransform(azaFFTPlan *plan, float * AZA_RESTRICT valReal, float * AZA_RESTRICT valImag, uint32_t log2n);
+
+// Complex forward transform of plan->len values, done in-place.
+// Unlike azaFFT, all len outputs are valid, where the upper half are the negative frequencies.
+void azaFFTPlanForward(azaFFTPlan *plan, float * AZA_RESTRICT valReal, float * AZA_RESTRICT valImag);
+// Complex inverse transform of plan->len values, done in-place.
+// This includes the 1/len scale, so azaFFTPlanInverse(azaFFTPlanForward(x)) == x
+void azaFFTPlanInverse(azaFFTPlan *plan, float * AZA_RESTRICT valReal, float * AZA_RESTRICT valImag);
+
+// Forward transform of plan->len real samples, done as a complex transform of half the length, so it's about half the work of azaFFTPlanForward.
+// dstReal and dstImag get plan->len/2+1 values each, corresponding to i*samplerate/len Hz. The rest of the spectrum is the complex conjugate of these, mirrored.
+// samples may be the same pointer as dstReal, in which case samples gets overwritten.
+void azaFFTPlanForwardReal(azaFFTPlan *plan, const float *samples, float *dstReal, float *dstImag);
+// Inverse of azaFFTPlanForwardReal, reading plan->len/2+1 values each from srcReal and srcImag and writing plan->len real samples to dst.
+// This includes the 1/len scale. srcReal and srcImag are used as scratch space so their contents are destroyed. dst may be the same pointer as srcReal.
+void azaFFTPlanInverseReal(azaFFTPlan *plan, float *dst, float *srcReal, float *srcImag);
+
+
+
+// Spectral Operations
+
+
+
+// acc[i] += a[i] * b[i] for count complex values, which is convolution in the frequency domain.
+// Implemented in specialized/azaFFT.c
+void azaFFTSpectrumMultiplyAccumulate(float * AZA_RESTRICT accReal, float * AZA_RESTRICT accImag, const float *aReal, const float *aImag, const float *bReal, const float *bImag, uint32_t count);
 
 #ifdef __cplusplus
 }
 #endif
 
-#endif // AZAUDIO_FFT_H
\ No newline at end of file
+#endif // AZAUDIO_FFT_H
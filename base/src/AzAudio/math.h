@@ -187,6 +187,128 @@ float aza_db_to_ampf(float db);
 
 float aza_amp_to_dbf(float amp);
 
+// Fast approximations of the above for dynamics processors that convert every frame.
+// Both are accurate to within 0.001dB. They use the exponent bits of the float directly, along with a polynomial that's exact at every power of 2, so they're also continuous and monotonic.
+// Amps at or below FLT_MIN (including 0 and anything negative) come out as about -758dB rather than -inf, and dB at or below that come out as FLT_MIN rather than 0, which are both well below anything audible.
+// The scalar and vector versions do the same operations in the same order, so they give the same results.
+
+// 20*log10(2), for going from log2 to dB
+static const float AZA_DB_PER_LOG2 = 6.02059991f;
+// log2(10)/20, for going from dB to log2
+static const float AZA_LOG2_PER_DB = 0.166096405f;
+// Smallest normal float, since the approximations need the exponent bits to mean what they usually do
+static const float AZA_FLOAT_MIN_NORMAL = 1.17549435e-38f;
+// log2(1+t) on [0, 1), fitted so the error is at most 0.00012 (0.0007dB)
+static const float AZA_LOG2_FAST_C1 = 1.43872573f;
+static const float AZA_LOG2_FAST_C2 = -0.677783926f;
+static const float AZA_LOG2_FAST_C3 = 0.321188857f;
+static const float AZA_LOG2_FAST_C4 = -0.0821306608f;
+// 2^t on [0, 1), fitted so the relative error is at most 0.0001 (0.0009dB)
+static const float AZA_EXP2_FAST_C1 = 0.69542435f;
+static const float AZA_EXP2_FAST_C2 = 0.226307681f;
+static const float AZA_EXP2_FAST_C3 = 0.0782679691f;
+
+static inline float
+aza_amp_to_dbf_fast(float amp) {
+	amp = amp > AZA_FLOAT_MIN_NORMAL ? amp : AZA_FLOAT_MIN_NORMAL;
+	uint32_t bits;
+	memcpy(&bits, &amp, sizeof(bits));
+	float exponent = (float)((int32_t)(bits >> 23) - 127);
+	bits = (bits & 0x007fffffu) | 0x3f800000u;
+	float t;
+	memcpy(&t, &bits, sizeof(t));
+	t -= 1.0f;
+	float log2 = exponent + t * (AZA_LOG2_FAST_C1 + t * (AZA_LOG2_FAST_C2 + t * (AZA_LOG2_FAST_C3 + t * AZA_LOG2_FAST_C4)));
+	return log2 * AZA_DB_PER_LOG2;
+}
+
+static inline float
+aza_db_to_ampf_fast(float db) {
+	float log2 = db * AZA_LOG2_PER_DB;
+	log2 = log2 > -126.0f ? log2 : -126.0f;
+	log2 = log2 < 127.99f ? log2 : 127.99f;
+	int32_t exponent = (int32_t)log2;
+	// Truncation rounds negatives up, and we want floor
+	if ((float)exponent > log2) exponent -= 1;
+	float t = log2 - (float)exponent;
+	float result = 1.0f + t * (AZA_EXP2_FAST_C1 + t * (AZA_EXP2_FAST_C2 + t * AZA_EXP2_FAST_C3));
+	uint32_t bits;
+	memcpy(&bits, &result, sizeof(bits));
+	bits += (uint32_t)exponent << 23;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+AZA_SIMD_FEATURES("sse2")
+static inline __m128
+aza_amp_to_db_x4_sse(__m128 amp) {
+	amp = _mm_max_ps(amp, _mm_set1_ps(AZA_FLOAT_MIN_NORMAL));
+	__m128i bits = _mm_castps_si128(amp);
+	__m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+	__m128 t = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+	t = _mm_sub_ps(t, _mm_set1_ps(1.0f));
+	__m128 poly = _mm_add_ps(_mm_set1_ps(AZA_LOG2_FAST_C3), _mm_mul_ps(t, _mm_set1_ps(AZA_LOG2_FAST_C4)));
+	poly = _mm_add_ps(_mm_set1_ps(AZA_LOG2_FAST_C2), _mm_mul_ps(t, poly));
+	poly = _mm_add_ps(_mm_set1_ps(AZA_LOG2_FAST_C1), _mm_mul_ps(t, poly));
+	__m128 log2 = _mm_add_ps(exponent, _mm_mul_ps(t, poly));
+	return _mm_mul_ps(log2, _mm_set1_ps(AZA_DB_PER_LOG2));
+}
+
+AZA_SIMD_FEATURES("sse2")
+static inline __m128
+aza_db_to_amp_x4_sse(__m128 db) {
+	__m128 log2 = _mm_mul_ps(db, _mm_set1_ps(AZA_LOG2_PER_DB));
+	log2 = _mm_max_ps(log2, _mm_set1_ps(-126.0f));
+	log2 = _mm_min_ps(log2, _mm_set1_ps(127.99f));
+	__m128i exponent = _mm_cvttps_epi32(log2);
+	// Truncation rounds negatives up, and we want floor. The comparison gives us -1 where we need to subtract 1.
+	exponent = _mm_add_epi32(exponent, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(exponent), log2)));
+	__m128 t = _mm_sub_ps(log2, _mm_cvtepi32_ps(exponent));
+	__m128 poly = _mm_add_ps(_mm_set1_ps(AZA_EXP2_FAST_C2), _mm_mul_ps(t, _mm_set1_ps(AZA_EXP2_FAST_C3)));
+	poly = _mm_add_ps(_mm_set1_ps(AZA_EXP2_FAST_C1), _mm_mul_ps(t, poly));
+	__m128 result = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(t, poly));
+	return _mm_castsi128_ps(_mm_add_epi32(_mm_castps_si128(result), _mm_slli_epi32(exponent, 23)));
+}
+
+AZA_SIMD_FEATURES("avx2")
+static inline __m256
+aza_amp_to_db_x8_avx2(__m256 amp) {
+	amp = _mm256_max_ps(amp, _mm256_set1_ps(AZA_FLOAT_MIN_NORMAL));
+	__m256i bits = _mm256_castps_si256(amp);
+	__m256 exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+	__m256 t = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+	t = _mm256_sub_ps(t, _mm256_set1_ps(1.0f));
+	__m256 poly = _mm256_add_ps(_mm256_set1_ps(AZA_LOG2_FAST_C3), _mm256_mul_ps(t, _mm256_set1_ps(AZA_LOG2_FAST_C4)));
+	poly = _mm256_add_ps(_mm256_set1_ps(AZA_LOG2_FAST_C2), _mm256_mul_ps(t, poly));
+	poly = _mm256_add_ps(_mm256_set1_ps(AZA_LOG2_FAST_C1), _mm256_mul_ps(t, poly));
+	__m256 log2 = _mm256_add_ps(exponent, _mm256_mul_ps(t, poly));
+	return _mm256_mul_ps(log2, _mm256_set1_ps(AZA_DB_PER_LOG2));
+}
+
+AZA_SIMD_FEATURES("avx2")
+static inline __m256
+aza_db_to_amp_x8_avx2(__m256 db) {
+	__m256 log2 = _mm256_mul_ps(db, _mm256_set1_ps(AZA_LOG2_PER_DB));
+	log2 = _mm256_max_ps(log2, _mm256_set1_ps(-126.0f));
+	log2 = _mm256_min_ps(log2, _mm256_set1_ps(127.99f));
+	__m256i exponent = _mm256_cvttps_epi32(log2);
+	// Truncation rounds negatives up, and we want floor. The comparison gives us -1 where we need to subtract 1.
+	exponent = _mm256_add_epi32(exponent, _mm256_castps_si256(_mm256_cmp_ps(_mm256_cvtepi32_ps(exponent), log2, _CMP_GT_OQ)));
+	__m256 t = _mm256_sub_ps(log2, _mm256_cvtepi32_ps(exponent));
+	__m256 poly = _mm256_add_ps(_mm256_set1_ps(AZA_EXP2_FAST_C2), _mm256_mul_ps(t, _mm256_set1_ps(AZA_EXP2_FAST_C3)));
+	poly = _mm256_add_ps(_mm256_set1_ps(AZA_EXP2_FAST_C1), _mm256_mul_ps(t, poly));
+	__m256 result = _mm256_add_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(t, poly));
+	return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_castps_si256(result), _mm256_slli_epi32(exponent, 23)));
+}
+
+// Converts count values from src into dst with aza_amp_to_dbf_fast, 4 or 8 at a time where available. dst and src can be the same.
+// Implemented in specialized/azaDecibels.c
+void aza_amp_to_dbf_array(float *dst, const float *src, uint32_t count);
+
+// Converts count values from src into dst with aza_db_to_ampf_fast, 4 or 8 at a time where available. dst and src can be the same.
+// Implemented in specialized/azaDecibels.c
+void aza_db_to_ampf_array(float *dst, const float *src, uint32_t count);
+
 static inline float
 aza_ms_to_samples(float ms, float samplerate) {
 	return ms * samplerate * 0.001f;
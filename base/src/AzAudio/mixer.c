@@ -7,6 +7,7 @@
 #include "AzAudio.h"
 #include "math.h"
 #include "error.h"
+#include "atomic.h"
 
 #include "timer.h"
 
@@ -25,6 +26,10 @@ void azaTrackRouteDeinit(azaTrackRoute *data) {
 int azaTrackInit(azaTrack *data, uint32_t bufferFrames, azaChannelLayout bufferChannelLayout) {
 	int err = azaBufferInit(&data->buffer, bufferFrames, 0, 0, bufferChannelLayout);
 	if AZA_UNLIKELY(err) return err;
+	data->bufferFrames = bufferFrames;
+	data->bufferChannelLayout = bufferChannelLayout;
+	data->bufferLeadingFrames = 0;
+	data->historyFramesWanted = 0;
 	azaDSPChainInit(&data->plugins, 0);
 	return AZA_SUCCESS;
 }
@@ -40,9 +45,12 @@ void azaTrackDeinit(azaTrack *data) {
 			}
 		}
 	}
+	// We already freed what we own, so don't let azaDSPChainDeinit try again
+	data->plugins.steps.count = 0;
 	azaDSPChainDeinit(&data->plugins);
 	for (uint32_t i = 0; i < data->receives.count; i++) {
-		azaTrackRouteDeinit(&data->receives.data[i]);
+		azaTrackRouteDeinit(data->receives.data[i]);
+		aza_free(data->receives.data[i]);
 	}
 	AZA_DA_DEINIT(data->receives);
 }
@@ -73,36 +81,48 @@ void azaTrackSetName(azaTrack *data, const char *name) {
 
 int azaTrackConnect(azaTrack *from, azaTrack *to, float gain, azaTrackRoute **dstTrackRoute, uint32_t flags) {
 	for (uint32_t i = 0; i < to->receives.count; i++) {
-		if (to->receives.data[i].track == from) {
-			to->receives.data[i].gain = gain;
+		if (to->receives.data[i]->track == from) {
+			to->receives.data[i]->gain = gain;
 			if (dstTrackRoute) {
-				*dstTrackRoute = &to->receives.data[i];
+				*dstTrackRoute = to->receives.data[i];
 			}
 			return AZA_SUCCESS;
 		}
 	}
-	azaTrackRoute route = {
-		.track = from,
-		.gain = gain,
-	};
-	azaTrackRouteInit(&route);
-	int err = azaChannelMatrixInit(&route.channelMatrix, from->buffer.channelLayout.count, to->buffer.channelLayout.count);
-	if (err) return err;
+	azaTrackRoute *route = aza_calloc(1, sizeof(azaTrackRoute));
+	if (!route) return AZA_ERROR_OUT_OF_MEMORY;
+	route->track = from;
+	route->gain = gain;
+	azaTrackRouteInit(route);
+	int err = azaChannelMatrixInit(&route->channelMatrix, from->bufferChannelLayout.count, to->bufferChannelLayout.count);
+	if (err) goto fail;
 	if (!(flags & AZA_TRACK_CHANNEL_ROUTING_ZERO)) {
-		azaChannelMatrixGenerateRoutingFromLayouts(&route.channelMatrix, from->buffer.channelLayout, to->buffer.channelLayout);
+		azaChannelMatrixGenerateRoutingFromLayouts(&route->channelMatrix, from->bufferChannelLayout, to->bufferChannelLayout);
 	}
-	AZA_DA_APPEND(to->receives, route, return AZA_ERROR_OUT_OF_MEMORY);
+	AZA_DA_APPEND(to->receives, route, err = AZA_ERROR_OUT_OF_MEMORY; goto fail);
 	if (dstTrackRoute) {
-		*dstTrackRoute = &to->receives.data[to->receives.count-1];
+		*dstTrackRoute = route;
 	}
 	return AZA_SUCCESS;
+fail:
+	azaTrackRouteDeinit(route);
+	aza_free(route);
+	return err;
 }
 
+static void azaMixerRetire(azaMixer *data, uint32_t kind, void *ptr);
+
 void azaTrackDisconnect(azaTrack *from, azaTrack *to) {
 	for (uint32_t i = 0; i < to->receives.count; i++) {
-		if (to->receives.data[i].track == from) {
-			azaTrackRouteDeinit(&to->receives.data[i]);
+		azaTrackRoute *route = to->receives.data[i];
+		if (route->track == from) {
 			AZA_DA_ERASE(to->receives, i, 1);
+			if (to->mixer) {
+				azaMixerRetire(to->mixer, AZA_MIXER_RETIRED_ROUTE, route);
+			} else {
+				azaTrackRouteDeinit(route);
+				aza_free(route);
+			}
 			break;
 		}
 	}
@@ -110,79 +130,76 @@ void azaTrackDisconnect(azaTrack *from, azaTrack *to) {
 
 azaTrackRoute* azaTrackGetReceive(azaTrack *from, azaTrack *to) {
 	for (uint32_t i = 0; i < to->receives.count; i++) {
-		if (to->receives.data[i].track == from) return &to->receives.data[i];
+		if (to->receives.data[i]->track == from) return to->receives.data[i];
 	}
 	return NULL;
 }
 
 void azaTrackProcess_OnPluginError(azaDSP *dsp, void *userdata) {
-	if (azaMixerGUIIsOpen()) {
-		azaMixerGUIShowError(azaGetLastErrorMessage());
+	azaMixer *mixer = (azaMixer*)userdata;
+	// We may be on a worker thread, which can't touch the GUI, so just hold onto the first error for azaMixerProcess to report once everyone's done.
+	if (mixer && azaAtomicCompareExchange32(&mixer->pluginErrorPending, 0, 1)) {
+		aza_strcpy(mixer->pluginErrorMessage, azaGetLastErrorMessage(), sizeof(mixer->pluginErrorMessage));
 	}
 }
 
-static inline uint32_t azaTrackGetLatency(azaTrack *track, uint32_t samplerate) {
-	azaDSPSpecs specs = azaDSPChainGetSpecs(&track->plugins, samplerate);
-	uint32_t myLatency = specs.latencyFrames;
-	uint32_t maxIncomingLatency = 0;
-	for (uint32_t i = 0; i < track->receives.count; i++) {
-		azaTrackRoute *route = &track->receives.data[i];
-		if (route->mute || route->track->mute) continue;
-		uint32_t latency = azaTrackGetLatency(route->track, samplerate);
-		maxIncomingLatency = AZA_MAX(maxIncomingLatency, latency);
-	}
-	return myLatency + maxIncomingLatency;
+static bool azaTrackReceivesAreAudible(azaTrack *data) {
+	return !(data->gain == -INFINITY || data->mute);
 }
 
-int azaTrackProcess(uint32_t frames, uint32_t samplerate, azaTrack *data) {
-	if (data->processed) return AZA_SUCCESS;
+static bool azaTrackRouteIsAudible(azaTrackRoute *route) {
+	return !(route->mute || route->track->mute);
+}
 
-	// Latency measurement
-	azaDSPSpecs dspSpecs = azaDSPChainGetSpecs(&data->plugins, samplerate);
-	if (dspSpecs.leadingFrames > data->buffer.leadingFrames || dspSpecs.trailingFrames > data->buffer.trailingFrames) {
-		int err = azaBufferResize(&data->buffer, data->buffer.frames, dspSpecs.leadingFrames, dspSpecs.trailingFrames, data->buffer.channelLayout);
-		if (err) return err;
-	}
+// Processes a single track, assuming every track we receive from has already been processed this block.
+static int azaMixerGraphProcessTrack(uint32_t frames, uint32_t samplerate, azaMixerGraph *graph, uint32_t index) {
+	azaMixerGraphTrack *graphTrack = &graph->tracks.data[index];
+	azaTrack *data = graphTrack->track;
 
 	data->buffer.samplerate = samplerate;
 	azaBuffer buffer = azaBufferSlice(&data->buffer, 0, frames);
-	azaBufferZero(&buffer);
-	if (data->gain == -INFINITY || data->mute) {
+	buffer.silent = true;
+	if (graphTrack->mute) {
+		azaBufferZero(&buffer);
+		data->buffer.silent = true;
 		return AZA_SUCCESS;
 	}
+	data->buffer.silent = false;
 	int err = AZA_SUCCESS;
-	uint32_t maxLatency = 0;
-	for (uint32_t i = 0; i < data->receives.count; i++) {
-		azaTrackRoute *route = &data->receives.data[i];
-		if (route->mute || route->track->mute) continue;
-		uint32_t latency = azaTrackGetLatency(route->track, samplerate);
-		maxLatency = AZA_MAX(maxLatency, latency);
-	}
-	azaBuffer sideBuffer;
-	uint8_t numSideBuffers = 0;
-	if (data->receives.count) {
-		sideBuffer = azaPushSideBuffer(buffer.frames, 0, 0, buffer.channelLayout.count, samplerate);
-		numSideBuffers++;
-	}
-	for (uint32_t i = 0; i < data->receives.count; i++) {
-		azaTrackRoute *route = &data->receives.data[i];
-		if (route->mute || route->track->mute) continue;
-		err = azaTrackProcess(frames, samplerate, route->track);
-		if (err) goto error;
-		uint32_t latency = azaTrackGetLatency(route->track, samplerate);
-		uint32_t latencyCompensationFrames = maxLatency - latency;
-		azaBuffer srcBuffer = azaBufferSlice(&route->track->buffer, 0, frames);
-		azaBufferMixMatrix(&sideBuffer, 0.0f, &srcBuffer, aza_db_to_ampf(route->gain), &route->channelMatrix);
-		route->latencyCompensationDelay.config.delayFrames = latencyCompensationFrames;
-		err = azaSampleDelayProcess(&route->latencyCompensationDelay, &sideBuffer, &sideBuffer, 0);
+	// The first route we mix overwrites buffer, so we only have to zero it if there's nothing to mix.
+	bool mixedAnyRoutes = false;
+	for (uint32_t i = 0; i < graphTrack->routesCount; i++) {
+		azaMixerGraphRoute *graphRoute = &graph->routes.data[graphTrack->routesStart + i];
+		azaTrackRoute *route = graphRoute->route;
+		azaBuffer srcBuffer = azaBufferSlice(&graph->tracks.data[graphRoute->srcIndex].track->buffer, 0, frames);
+		// latencyCompensationDelay.config.delayFrames is kept up to date by azaMixerUpdateLatency
+		if (srcBuffer.silent) {
+			// Once the delay line has nothing but silence in it, there's nothing left to mix.
+			bool flushed = route->framesSilent >= route->latencyCompensationDelay.config.delayFrames;
+			route->framesSilent = (uint32_t)AZA_MIN((uint64_t)route->framesSilent + frames, UINT32_MAX);
+			if (flushed) continue;
+		} else {
+			route->framesSilent = 0;
+		}
+		// Channel mixing, gain, and latency compensation all in one pass straight into buffer
+		err = azaSampleDelayMixMatrix(&route->latencyCompensationDelay, &buffer, mixedAnyRoutes ? 1.0f : 0.0f, &srcBuffer, aza_db_to_ampf(graphRoute->gain), &route->channelMatrix);
 		if (err) goto error;
-		azaBufferMix(&buffer, 1.0f, &sideBuffer, 1.0f);
+		mixedAnyRoutes = true;
+	}
+	if (!mixedAnyRoutes) {
+		azaBufferZero(&buffer);
 	}
 	// TODO: Check when track configuration changed so we can pass the appropriate flag
-	err = azaDSPChainProcessWithHandler(&data->plugins, &buffer, &buffer, 0, azaTrackProcess_OnPluginError, NULL);
+	err = azaDSPChainProcessWithHandler(&graphTrack->plugins, &buffer, &buffer, 0, azaTrackProcess_OnPluginError, data->mixer);
 	if AZA_UNLIKELY(err) goto error;
-	if (data->gain != 0.0f) {
-		float amp = aza_db_to_ampf(data->gain);
+	// With room for the longest history before the buffer, the plugins never need any after it (see azaDSPChainGetHistoryFrames). Until azaMixerCommit makes that room, the chain moves the block to make room instead.
+	uint32_t historyFrames = azaDSPChainGetHistoryFramesCached(&graphTrack->plugins);
+	// Only our own buffer can be replaced with a bigger one. Anything else would never get the room, so it would want a commit forever.
+	if (historyFrames > data->buffer.leadingFrames && data->buffer.buffer) {
+		azaAtomicStore32(&data->historyFramesWanted, (int32_t)historyFrames);
+	}
+	if (graphTrack->gain != 0.0f && !buffer.silent) {
+		float amp = aza_db_to_ampf(graphTrack->gain);
 		for (uint32_t i = 0; i < buffer.frames; i++) {
 			for (uint32_t c = 0; c < buffer.channelLayout.count; c++) {
 				buffer.pSamples[i * buffer.stride + c] *= amp;
@@ -192,25 +209,643 @@ int azaTrackProcess(uint32_t frames, uint32_t samplerate, azaTrack *data) {
 	if (azaMixerGUIIsOpen()) {
 		azaMetersUpdate(&data->meters, &buffer, 1.0f);
 	}
-	data->processed = true;
+	// Tracks that receive from us look at this
+	data->buffer.silent = buffer.silent;
 error:
-	azaPopSideBuffers(numSideBuffers);
 	return err;
 }
 
+
+
+// Graph snapshots
+
+
+
+#define AZA_MIXER_GRAPH_INDEX_NONE UINT32_MAX
+
+static void azaMixerGraphFree(azaMixerGraph *graph) {
+	for (uint32_t i = 0; i < graph->tracks.count; i++) {
+		// The graph doesn't own the plugins themselves, so don't use azaDSPChainDeinit
+		AZA_DA_DEINIT(graph->tracks.data[i].plugins.steps);
+		AZA_DA_DEINIT(graph->tracks.data[i].plugins.buffer);
+		if (graph->tracks.data[i].buffer.buffer) {
+			azaBufferDeinit(&graph->tracks.data[i].buffer, false);
+		}
+	}
+	if (graph->tracks.data) aza_free(graph->tracks.data);
+	if (graph->routes.data) aza_free(graph->routes.data);
+	if (graph->dependents.data) aza_free(graph->dependents.data);
+	if (graph->queueStorage) aza_free(graph->queueStorage);
+	aza_free(graph);
+}
+
+// Modified depth-first search for directed graphs to determine whether a cycle exists.
+static int azaMixerCheckRoutingVisit(azaTrack *track) {
+	for (uint32_t i = 0; i < track->receives.count; i++) {
+		azaTrack *recv = track->receives.data[i]->track;
+		if (!recv) break;
+		if (recv->mark == 2) continue;
+		if (recv->mark == 1) return AZA_ERROR_MIXER_ROUTING_CYCLE;
+		recv->mark = 1;
+		if (azaMixerCheckRoutingVisit(recv)) return AZA_ERROR_MIXER_ROUTING_CYCLE;
+		recv->mark = 2;
+	}
+	return AZA_SUCCESS;
+}
+
+static int azaMixerCheckRouting(azaMixer *data) {
+	for (uint32_t i = 0; i < data->tracks.count; i++) {
+		data->tracks.data[i]->mark = 0;
+	}
+	azaTrack *track = &data->master;
+	track->mark = 0;
+	return azaMixerCheckRoutingVisit(track);
+}
+
+// Appends track to graph after everything it receives from. Expects the routing to be acyclic.
+static int azaMixerGraphVisit(azaMixerGraph *graph, azaTrack *track, uint32_t samplerate) {
+	if (track->graphIndex != AZA_MIXER_GRAPH_INDEX_NONE) return AZA_SUCCESS;
+	bool audible = azaTrackReceivesAreAudible(track);
+	if (audible) {
+		for (uint32_t i = 0; i < track->receives.count; i++) {
+			azaTrackRoute *route = track->receives.data[i];
+			if (!azaTrackRouteIsAudible(route)) continue;
+			int err = azaMixerGraphVisit(graph, route->track, samplerate);
+			if (err) return err;
+		}
+	}
+	uint32_t index = graph->tracks.count++;
+	azaMixerGraphTrack *graphTrack = &graph->tracks.data[index];
+	graphTrack->track = track;
+	graphTrack->gain = track->gain;
+	graphTrack->mute = !audible;
+	graphTrack->routesStart = graph->routes.count;
+	if (audible) {
+		for (uint32_t i = 0; i < track->receives.count; i++) {
+			azaTrackRoute *route = track->receives.data[i];
+			if (!azaTrackRouteIsAudible(route)) continue;
+			graph->routes.data[graph->routes.count++] = (azaMixerGraphRoute) {
+				.route = route,
+				.srcIndex = route->track->graphIndex,
+				.gain = route->gain,
+			};
+		}
+	}
+	graphTrack->routesCount = graph->routes.count - graphTrack->routesStart;
+	int err = azaDSPChainInit(&graphTrack->plugins, track->plugins.steps.count);
+	if (err) return err;
+	for (uint32_t i = 0; i < track->plugins.steps.count; i++) {
+		azaDSPChainAppend(&graphTrack->plugins, track->plugins.steps.data[i].dsp);
+	}
+	// Make room before the buffer for all of our plugins' history (see azaDSPChainGetHistoryFrames), since the audio thread can't.
+	// The audio thread may be swapping in a buffer from a previous graph right now, so we never look at track->buffer. If we see the old leadingFrames we just make a replacement that goes unused.
+	uint32_t historyFrames = AZA_MAX(azaDSPChainGetHistoryFrames(&track->plugins, samplerate), (uint32_t)azaAtomicLoad32(&track->historyFramesWanted));
+	if (historyFrames > (uint32_t)azaAtomicLoad32(&track->bufferLeadingFrames)) {
+		err = azaBufferInit(&graphTrack->buffer, track->bufferFrames, historyFrames, 0, track->bufferChannelLayout);
+		if (err) return err;
+	}
+	track->graphIndex = index;
+	return AZA_SUCCESS;
+}
+
+// Builds a new graph from the current state of the tracks. Expects the mutex to be held.
+static int azaMixerGraphBuild(azaMixer *data, azaMixerGraph **dst) {
+	uint32_t samplerate = (uint32_t)azaAtomicLoad32(&data->samplerateAudio);
+	if (!samplerate) samplerate = AZA_SAMPLERATE_DEFAULT;
+	int err = AZA_SUCCESS;
+	azaMixerGraph *graph = aza_calloc(1, sizeof(azaMixerGraph));
+	if (!graph) return AZA_ERROR_OUT_OF_MEMORY;
+	if (azaMixerCheckRouting(data)) {
+		graph->hasCircularRouting = true;
+		*dst = graph;
+		return AZA_SUCCESS;
+	}
+	uint32_t maxTracks = data->tracks.count + 1;
+	uint32_t maxRoutes = data->master.receives.count;
+	data->master.graphIndex = AZA_MIXER_GRAPH_INDEX_NONE;
+	for (uint32_t i = 0; i < data->tracks.count; i++) {
+		data->tracks.data[i]->graphIndex = AZA_MIXER_GRAPH_INDEX_NONE;
+		maxRoutes += data->tracks.data[i]->receives.count;
+	}
+	graph->tracks.data = aza_calloc(maxTracks, sizeof(azaMixerGraphTrack));
+	if (!graph->tracks.data) goto outOfMemory;
+	if (maxRoutes) {
+		graph->routes.data = aza_calloc(maxRoutes, sizeof(azaMixerGraphRoute));
+		if (!graph->routes.data) goto outOfMemory;
+		graph->dependents.data = aza_calloc(maxRoutes, sizeof(uint32_t));
+		if (!graph->dependents.data) goto outOfMemory;
+	}
+	err = azaMixerGraphVisit(graph, &data->master, samplerate);
+	if (err) goto fail;
+	// Every route is a dependency of its destination, so make the reverse mapping for the scheduler
+	for (uint32_t i = 0; i < graph->routes.count; i++) {
+		graph->tracks.data[graph->routes.data[i].srcIndex].dependentsCount++;
+	}
+	uint32_t dependentsStart = 0;
+	for (uint32_t i = 0; i < graph->tracks.count; i++) {
+		azaMixerGraphTrack *graphTrack = &graph->tracks.data[i];
+		graphTrack->dependentsStart = dependentsStart;
+		dependentsStart += graphTrack->dependentsCount;
+		graphTrack->plugins.maxBlockFrames = data->config.dspBlockFrames;
+		// Becomes a cursor for filling in dependents below, which ends up back where it started.
+		graphTrack->dependentsCount = 0;
+	}
+	for (uint32_t i = 0; i < graph->tracks.count; i++) {
+		azaMixerGraphTrack *graphTrack = &graph->tracks.data[i];
+		for (uint32_t r = 0; r < graphTrack->routesCount; r++) {
+			azaMixerGraphTrack *src = &graph->tracks.data[graph->routes.data[graphTrack->routesStart + r].srcIndex];
+			graph->dependents.data[src->dependentsStart + src->dependentsCount++] = i;
+		}
+	}
+	graph->dependents.count = dependentsStart;
+	if (data->scheduler.queues.count) {
+		// Power of 2 so indexing is just a mask
+		graph->queueCapacity = 16;
+		while (graph->queueCapacity < graph->tracks.count) graph->queueCapacity *= 2;
+		graph->queueStorage = aza_calloc((size_t)graph->queueCapacity * data->scheduler.queues.count, sizeof(uint32_t));
+		if (!graph->queueStorage) goto outOfMemory;
+	}
+	*dst = graph;
+	return AZA_SUCCESS;
+outOfMemory:
+	err = AZA_ERROR_OUT_OF_MEMORY;
+fail:
+	azaMixerGraphFree(graph);
+	return err;
+}
+
+// Returns whether publishing b in place of a would make no difference
+static bool azaMixerGraphsMatch(azaMixerGraph *a, azaMixerGraph *b) {
+	if (a->hasCircularRouting != b->hasCircularRouting) return false;
+	if (a->tracks.count != b->tracks.count) return false;
+	if (a->routes.count != b->routes.count) return false;
+	for (uint32_t i = 0; i < a->tracks.count; i++) {
+		azaMixerGraphTrack *trackA = &a->tracks.data[i];
+		azaMixerGraphTrack *trackB = &b->tracks.data[i];
+		if (trackA->track != trackB->track) return false;
+		if (trackA->gain != trackB->gain) return false;
+		if (trackA->mute != trackB->mute) return false;
+		if (trackA->routesCount != trackB->routesCount) return false;
+		if (trackB->buffer.buffer) return false;
+		if (trackA->plugins.steps.count != trackB->plugins.steps.count) return false;
+		for (uint32_t s = 0; s < trackA->plugins.steps.count; s++) {
+			if (trackA->plugins.steps.data[s].dsp != trackB->plugins.steps.data[s].dsp) return false;
+		}
+	}
+	for (uint32_t i = 0; i < a->routes.count; i++) {
+		azaMixerGraphRoute *routeA = &a->routes.data[i];
+		azaMixerGraphRoute *routeB = &b->routes.data[i];
+		if (routeA->route != routeB->route) return false;
+		if (routeA->srcIndex != routeB->srcIndex) return false;
+		if (routeA->gain != routeB->gain) return false;
+	}
+	return true;
+}
+
+static void azaMixerRetire(azaMixer *data, uint32_t kind, void *ptr) {
+	azaMutexLock(&data->mutex);
+	azaMixerRetired retired = {
+		.ptr = ptr,
+		.version = data->graphPublished ? data->graphPublished->version : 0,
+		.kind = kind,
+	};
+	// If we can't keep track of it, leaking is better than freeing it out from under the audio thread.
+	AZA_DA_APPEND(data->retired, retired, AZA_LOG_ERR("azaMixerRetire error: Out of memory, so we're leaking %p\n", ptr));
+	azaMutexUnlock(&data->mutex);
+}
+
+static void azaMixerFreeRetired(azaMixerRetired *retired) {
+	switch (retired->kind) {
+		case AZA_MIXER_RETIRED_GRAPH:
+			azaMixerGraphFree((azaMixerGraph*)retired->ptr);
+			break;
+		case AZA_MIXER_RETIRED_TRACK:
+			azaTrackDeinit((azaTrack*)retired->ptr);
+			aza_free(retired->ptr);
+			break;
+		case AZA_MIXER_RETIRED_ROUTE:
+			azaTrackRouteDeinit((azaTrackRoute*)retired->ptr);
+			aza_free(retired->ptr);
+			break;
+		case AZA_MIXER_RETIRED_DSP:
+			azaFreeDSP((azaDSP*)retired->ptr);
+			break;
+	}
+}
+
+// Frees everything the audio thread can't be using anymore. If all is true, we assume the audio thread is done entirely.
+// Expects the mutex to be held.
+static void azaMixerCollectRetired(azaMixer *data, bool all) {
+	uint32_t versionAudio = (uint32_t)azaAtomicLoad32(&data->graphVersionAudio);
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < data->retired.count; i++) {
+		azaMixerRetired *retired = &data->retired.data[i];
+		if (all || retired->version < versionAudio) {
+			azaMixerFreeRetired(retired);
+		} else {
+			data->retired.data[kept++] = *retired;
+		}
+	}
+	data->retired.count = kept;
+}
+
+// Whether arena needs azaSideBufferArenaOfferGrowth to do something, either offering more memory or freeing what the audio thread switched away from.
+static bool azaMixerSideBufferArenaWantsGrowth(azaSideBufferArena *arena) {
+	if (arena->blockRetired) return true;
+	return arena->highWaterMark > arena->capacity && !arena->blockOffered;
+}
+
+// The audio thread's side buffer arenas are fixed, so they only grow here. Expects the mutex to be held.
+static void azaMixerGrowSideBuffers(azaMixer *data) {
+	azaSideBufferArenaOfferGrowth(&data->sideBufferArena);
+	for (uint32_t i = 0; i < data->scheduler.workers.count; i++) {
+		azaSideBufferArenaOfferGrowth(&data->scheduler.workers.data[i].sideBufferArena);
+	}
+}
+
+int azaMixerCommit(azaMixer *data) {
+	azaMutexLock(&data->mutex);
+	azaMixerGraph *graph;
+	int err = azaMixerGraphBuild(data, &graph);
+	if (err) goto done;
+	if (data->graphPublished && azaMixerGraphsMatch(data->graphPublished, graph)) {
+		azaMixerGraphFree(graph);
+		goto done;
+	}
+	if (data->graphPublished) {
+		graph->version = data->graphPublished->version + 1;
+		azaMixerRetire(data, AZA_MIXER_RETIRED_GRAPH, data->graphPublished);
+	} else {
+		graph->version = 1;
+	}
+	data->graphPublished = graph;
+	// If the audio thread never picked up the previous one, it was already retired above.
+	azaAtomicStorePtr(&data->graphPending, graph);
+done:
+	azaMixerCollectRetired(data, false);
+	azaMixerGrowSideBuffers(data);
+	azaMutexUnlock(&data->mutex);
+	return err;
+}
+
+bool azaMixerNeedsCommit(azaMixer *data) {
+	bool result = false;
+	azaMutexLock(&data->mutex);
+	if (azaMixerSideBufferArenaWantsGrowth(&data->sideBufferArena)) result = true;
+	for (uint32_t i = 0; i < data->scheduler.workers.count; i++) {
+		if (azaMixerSideBufferArenaWantsGrowth(&data->scheduler.workers.data[i].sideBufferArena)) result = true;
+	}
+	for (uint32_t i = 0; i <= data->tracks.count; i++) {
+		azaTrack *track = i < data->tracks.count ? data->tracks.data[i] : &data->master;
+		if (azaAtomicLoad32(&track->historyFramesWanted) > azaAtomicLoad32(&track->bufferLeadingFrames)) result = true;
+	}
+	azaMutexUnlock(&data->mutex);
+	return result;
+}
+
+void azaMixerRetireDSP(azaMixer *data, azaDSP *dsp) {
+	azaMixerRetire(data, AZA_MIXER_RETIRED_DSP, dsp);
+}
+
+// Switches the audio thread over to the newest published graph, if there is one.
+static void azaMixerPickUpGraph(azaMixer *data) {
+	azaMixerGraph *graph = (azaMixerGraph*)azaAtomicExchangePtr(&data->graphPending, NULL);
+	if (!graph) return;
+	azaMixerGraph *previous = data->graphAudio;
+	if (previous) {
+		for (uint32_t i = 0; i < graph->tracks.count; i++) {
+			azaMixerGraphTrack *dst = &graph->tracks.data[i];
+			uint32_t index = dst->track->graphIndexAudio;
+			if (index >= previous->tracks.count || previous->tracks.data[index].track != dst->track) continue;
+			azaMixerGraphTrack *src = &previous->tracks.data[index];
+			// Take over the plugin history so unchanged plugins carry on seamlessly. The previous graph gets our empty buffer to free.
+			azaDSPChain tmp = dst->plugins;
+			dst->plugins.buffer = src->plugins.buffer;
+			src->plugins.buffer = tmp.buffer;
+			uint32_t steps = AZA_MIN(dst->plugins.steps.count, src->plugins.steps.count);
+			for (uint32_t s = 0; s < steps; s++) {
+				azaDSPChainStep *stepDst = &dst->plugins.steps.data[s];
+				azaDSPChainStep *stepSrc = &src->plugins.steps.data[s];
+				if (stepDst->dsp != stepSrc->dsp) break;
+				stepDst->bufferOffset = stepSrc->bufferOffset;
+				stepDst->specs = stepSrc->specs;
+				stepDst->framesSilent = stepSrc->framesSilent;
+			}
+		}
+	}
+	for (uint32_t i = 0; i < graph->tracks.count; i++) {
+		azaMixerGraphTrack *graphTrack = &graph->tracks.data[i];
+		graphTrack->track->graphIndexAudio = i;
+		// Never swap out a buffer we don't own, since whoever does would lose track of theirs and the graph would free it out from under them.
+		if (graphTrack->buffer.buffer && graphTrack->track->buffer.buffer && graphTrack->buffer.leadingFrames > graphTrack->track->buffer.leadingFrames) {
+			// Nobody else touches the track's buffer while we're not processing, and the graph frees the old one when it's retired.
+			azaBuffer tmp = graphTrack->track->buffer;
+			graphTrack->track->buffer = graphTrack->buffer;
+			graphTrack->buffer = tmp;
+			azaAtomicStore32(&graphTrack->track->bufferLeadingFrames, (int32_t)graphTrack->track->buffer.leadingFrames);
+		}
+	}
+	data->graphAudio = graph;
+	data->latencyDirty = true;
+	azaAtomicStore32(&data->graphVersionAudio, (int32_t)graph->version);
+}
+
+// Recomputes every track's total latency and the compensation delay of every route if anything changed since last time.
+// Since graph tracks are dependency-ordered, this is a single pass.
+// We only ask the plugins directly when the graph changed. Otherwise we use the specs each chain cached when it last processed, so a change in a plugin's latency gets picked up the block after it happens.
+static void azaMixerUpdateLatency(azaMixer *data, uint32_t samplerate) {
+	azaMixerGraph *graph = data->graphAudio;
+	bool graphChanged = data->latencyDirty;
+	for (uint32_t i = 0; i < graph->tracks.count; i++) {
+		azaMixerGraphTrack *graphTrack = &graph->tracks.data[i];
+		azaDSPSpecs specs = graphChanged ? azaDSPChainGetSpecs(&graphTrack->plugins, samplerate) : azaDSPChainGetSpecsCached(&graphTrack->plugins);
+		uint32_t latencyFramesOwn = specs.latencyFrames;
+		if (latencyFramesOwn != graphTrack->track->latencyFramesOwn) {
+			graphTrack->track->latencyFramesOwn = latencyFramesOwn;
+			data->latencyDirty = true;
+		}
+	}
+	if (!data->latencyDirty) return;
+	for (uint32_t i = 0; i < graph->tracks.count; i++) {
+		azaMixerGraphTrack *graphTrack = &graph->tracks.data[i];
+		uint32_t maxIncomingLatency = 0;
+		for (uint32_t r = 0; r < graphTrack->routesCount; r++) {
+			azaMixerGraphRoute *graphRoute = &graph->routes.data[graphTrack->routesStart + r];
+			maxIncomingLatency = AZA_MAX(maxIncomingLatency, graph->tracks.data[graphRoute->srcIndex].track->latencyFrames);
+		}
+		for (uint32_t r = 0; r < graphTrack->routesCount; r++) {
+			azaMixerGraphRoute *graphRoute = &graph->routes.data[graphTrack->routesStart + r];
+			graphRoute->route->latencyCompensationDelay.config.delayFrames = maxIncomingLatency - graph->tracks.data[graphRoute->srcIndex].track->latencyFrames;
+		}
+		graphTrack->track->latencyFrames = graphTrack->track->latencyFramesOwn + maxIncomingLatency;
+	}
+	data->latencyDirty = false;
+}
+
+
+
+// Parallel scheduler
+
+
+
+// Only called by the owning thread
+static void azaMixerWorkQueuePush(azaMixerWorkQueue *queue, uint32_t mask, uint32_t task) {
+	int64_t bottom = queue->bottom;
+	queue->tasks[bottom & mask] = task;
+	azaAtomicStore64(&queue->bottom, bottom + 1);
+}
+
+// Only called by the owning thread
+static bool azaMixerWorkQueuePop(azaMixerWorkQueue *queue, uint32_t mask, uint32_t *dst) {
+	int64_t bottom = queue->bottom - 1;
+	azaAtomicStore64(&queue->bottom, bottom);
+	azaAtomicFence();
+	int64_t top = azaAtomicLoad64(&queue->top);
+	if (top > bottom) {
+		// Empty
+		azaAtomicStore64(&queue->bottom, bottom + 1);
+		return false;
+	}
+	*dst = queue->tasks[bottom & mask];
+	if (top == bottom) {
+		// Last one, so we might be racing a thief for it
+		bool won = azaAtomicCompareExchange64(&queue->top, top, top + 1);
+		azaAtomicStore64(&queue->bottom, bottom + 1);
+		return won;
+	}
+	return true;
+}
+
+// Called by any thread other than the owner
+static bool azaMixerWorkQueueSteal(azaMixerWorkQueue *queue, uint32_t mask, uint32_t *dst) {
+	int64_t top = azaAtomicLoad64(&queue->top);
+	azaAtomicFence();
+	int64_t bottom = azaAtomicLoad64(&queue->bottom);
+	if (top >= bottom) return false;
+	uint32_t task = queue->tasks[top & mask];
+	if (!azaAtomicCompareExchange64(&queue->top, top, top + 1)) return false;
+	*dst = task;
+	return true;
+}
+
+// Resets the queues and distributes the tracks that are immediately ready between them.
+static void azaMixerSchedulerPrepare(azaMixerScheduler *scheduler, azaMixerGraph *graph) {
+	scheduler->graph = graph;
+	for (uint32_t i = 0; i < scheduler->queues.count; i++) {
+		azaMixerWorkQueue *queue = &scheduler->queues.data[i];
+		queue->tasks = graph->queueStorage + (size_t)graph->queueCapacity * i;
+		queue->top = 0;
+		queue->bottom = 0;
+	}
+	// Nobody else is looking at the queues yet, so just deal out the ready tasks
+	uint32_t mask = graph->queueCapacity - 1;
+	uint32_t queueIndex = 0;
+	for (uint32_t i = 0; i < graph->tracks.count; i++) {
+		azaMixerGraphTrack *graphTrack = &graph->tracks.data[i];
+		graphTrack->dependenciesRemaining = (int32_t)graphTrack->routesCount;
+		if (graphTrack->routesCount) continue;
+		azaMixerWorkQueuePush(&scheduler->queues.data[queueIndex], mask, i);
+		queueIndex = (queueIndex + 1) % scheduler->queues.count;
+	}
+	scheduler->tasksRemaining = (int32_t)graph->tracks.count;
+	scheduler->error = AZA_SUCCESS;
+}
+
+static void azaMixerSchedulerRunTask(azaMixerScheduler *scheduler, uint32_t queueIndex, uint32_t taskIndex) {
+	azaMixerGraph *graph = scheduler->graph;
+	azaMixerGraphTrack *graphTrack = &graph->tracks.data[taskIndex];
+	int err = azaMixerGraphProcessTrack(scheduler->frames, scheduler->samplerate, graph, taskIndex);
+	if (err) {
+		azaAtomicCompareExchange32(&scheduler->error, AZA_SUCCESS, err);
+	}
+	// Even on error we keep releasing dependents so that everyone can make it to the end of the block.
+	uint32_t mask = graph->queueCapacity - 1;
+	for (uint32_t i = 0; i < graphTrack->dependentsCount; i++) {
+		uint32_t dependentIndex = graph->dependents.data[graphTrack->dependentsStart + i];
+		azaMixerGraphTrack *dependent = &graph->tracks.data[dependentIndex];
+		if (azaAtomicFetchAdd32(&dependent->dependenciesRemaining, -1) == 1) {
+			azaMixerWorkQueuePush(&scheduler->queues.data[queueIndex], mask, dependentIndex);
+		}
+	}
+	azaAtomicFetchAdd32(&scheduler->tasksRemaining, -1);
+}
+
+// Does work until every task in the block is done
+static void azaMixerSchedulerRun(azaMixerScheduler *scheduler, uint32_t queueIndex) {
+	uint32_t mask = scheduler->graph->queueCapacity - 1;
+	azaMixerWorkQueue *queue = &scheduler->queues.data[queueIndex];
+	while (azaAtomicLoad32(&scheduler->tasksRemaining) > 0) {
+		uint32_t taskIndex;
+		if (azaMixerWorkQueuePop(queue, mask, &taskIndex)) {
+			azaMixerSchedulerRunTask(scheduler, queueIndex, taskIndex);
+			continue;
+		}
+		bool stole = false;
+		for (uint32_t i = 1; i < scheduler->queues.count; i++) {
+			azaMixerWorkQueue *victim = &scheduler->queues.data[(queueIndex + i) % scheduler->queues.count];
+			if (azaMixerWorkQueueSteal(victim, mask, &taskIndex)) {
+				stole = true;
+				break;
+			}
+		}
+		if (stole) {
+			azaMixerSchedulerRunTask(scheduler, queueIndex, taskIndex);
+		} else {
+			// Whatever's left is waiting on tasks that are in progress
+			azaThreadYield();
+		}
+	}
+}
+
+static AZA_THREAD_PROC_DEF(azaMixerWorkerProc, userdata) {
+	azaMixerWorker *worker = (azaMixerWorker*)userdata;
+	azaMixerScheduler *scheduler = &worker->mixer->scheduler;
+	azaSideBuffersBindArena(&worker->sideBufferArena);
+	while (true) {
+		azaSemaphoreWait(&scheduler->semaphoreWake);
+		if (azaAtomicLoad32(&scheduler->quit)) break;
+		// Announce ourselves before checking whether the block is open, so azaMixerSchedulerProcess either waits for us or we see it closed and stay out of the queues.
+		azaAtomicFetchAdd32(&scheduler->workersActive, 1);
+		if (azaAtomicLoad32(&scheduler->open)) {
+			azaMixerSchedulerRun(scheduler, worker->queueIndex);
+		}
+		azaAtomicFetchAdd32(&scheduler->workersActive, -1);
+	}
+	azaCleanupSideBuffers(NULL);
+	return 0;
+}
+
+static int azaMixerSchedulerInit(azaMixer *data, uint32_t workerThreads, uint32_t sideBufferChannels, uint32_t sideBufferDepth) {
+	azaMixerScheduler *scheduler = &data->scheduler;
+	memset(scheduler, 0, sizeof(*scheduler));
+	if (workerThreads == 0) return AZA_SUCCESS;
+	scheduler->queues.data = aza_calloc(workerThreads + 1, sizeof(azaMixerWorkQueue));
+	if (!scheduler->queues.data) return AZA_ERROR_OUT_OF_MEMORY;
+	scheduler->queues.count = workerThreads + 1;
+	scheduler->workers.data = aza_calloc(workerThreads, sizeof(azaMixerWorker));
+	if (!scheduler->workers.data) {
+		aza_free(scheduler->queues.data);
+		scheduler->queues.data = NULL;
+		scheduler->queues.count = 0;
+		return AZA_ERROR_OUT_OF_MEMORY;
+	}
+	azaSemaphoreInit(&scheduler->semaphoreWake, 0);
+	for (uint32_t i = 0; i < workerThreads; i++) {
+		azaMixerWorker *worker = &scheduler->workers.data[i];
+		worker->mixer = data;
+		worker->queueIndex = i + 1;
+		if (azaSideBufferArenaReserve(&worker->sideBufferArena, data->config.bufferFrames, sideBufferChannels, sideBufferDepth)) {
+			azaSideBufferArenaDeinit(&worker->sideBufferArena);
+			return AZA_ERROR_OUT_OF_MEMORY;
+		}
+		worker->sideBufferArena.fixed = true;
+		if (azaThreadLaunch(&worker->thread, azaMixerWorkerProc, worker)) {
+			AZA_LOG_ERR("azaMixerInit error: Failed to launch worker thread %u of %u\n", i + 1, workerThreads);
+			azaSideBufferArenaDeinit(&worker->sideBufferArena);
+			break;
+		}
+		scheduler->workers.count++;
+	}
+	if (scheduler->workers.count != workerThreads) {
+		return AZA_ERROR_BACKEND_ERROR;
+	}
+	return AZA_SUCCESS;
+}
+
+static void azaMixerSchedulerDeinit(azaMixer *data) {
+	azaMixerScheduler *scheduler = &data->scheduler;
+	if (scheduler->workers.data) {
+		azaAtomicStore32(&scheduler->quit, 1);
+		azaSemaphorePost(&scheduler->semaphoreWake, scheduler->workers.count);
+		for (uint32_t i = 0; i < scheduler->workers.count; i++) {
+			azaThreadJoin(&scheduler->workers.data[i].thread);
+			azaSideBufferArenaDeinit(&scheduler->workers.data[i].sideBufferArena);
+		}
+		aza_free(scheduler->workers.data);
+		azaSemaphoreDeinit(&scheduler->semaphoreWake);
+	}
+	if (scheduler->queues.data) aza_free(scheduler->queues.data);
+	memset(scheduler, 0, sizeof(*scheduler));
+}
+
+// Processes the whole graph with the help of our workers.
+static int azaMixerSchedulerProcess(uint32_t frames, uint32_t samplerate, azaMixer *data) {
+	azaMixerScheduler *scheduler = &data->scheduler;
+	azaMixerSchedulerPrepare(scheduler, data->graphAudio);
+	scheduler->frames = frames;
+	scheduler->samplerate = samplerate;
+	azaAtomicExchange32(&scheduler->open, 1);
+	// Workers may still be asleep from previous blocks that didn't need them, so this can overshoot. That only costs them a spurious wakeup.
+	azaSemaphorePost(&scheduler->semaphoreWake, scheduler->workers.count);
+	azaMixerSchedulerRun(scheduler, 0);
+	azaAtomicExchange32(&scheduler->open, 0);
+	// Any worker that got in before we closed has to leave before we can touch the queues again.
+	while (azaAtomicLoad32(&scheduler->workersActive) > 0) {
+		azaThreadYield();
+	}
+	return azaAtomicLoad32(&scheduler->error);
+}
+
+
+
+// Mixer
+
+
+
 int azaMixerInit(azaMixer *data, azaMixerConfig config, azaChannelLayout masterChannelLayout) {
 	int err = AZA_SUCCESS;
 	data->config = config;
 	err = azaTrackInit(&data->master, config.bufferFrames, masterChannelLayout);
 	if (err) return err;
 	azaTrackSetName(&data->master, "Master");
+	data->master.mixer = data;
 	azaMutexInit(&data->mutex);
 	data->tsOfflineStart = azaGetTimestamp();
 	data->cpuPercent = 0.0f;
+	data->graphPublished = NULL;
+	data->graphPending = NULL;
+	data->graphAudio = NULL;
+	data->graphVersionAudio = 0;
+	data->retired.data = NULL;
+	data->retired.count = 0;
+	data->retired.capacity = 0;
+	data->latencyDirty = true;
+	data->samplerateAudio = 0;
+	data->pluginErrorPending = 0;
+	uint32_t sideBufferDepth = config.sideBufferDepth ? config.sideBufferDepth : AZA_SIDE_BUFFER_DEFAULT_DEPTH;
+	memset(&data->sideBufferArena, 0, sizeof(data->sideBufferArena));
+	err = azaSideBufferArenaReserve(&data->sideBufferArena, config.bufferFrames, masterChannelLayout.count, sideBufferDepth);
+	if (err) goto fail;
+	// From here on, only azaMixerCommit grows it
+	data->sideBufferArena.fixed = true;
+	err = azaMixerSchedulerInit(data, config.workerThreads, masterChannelLayout.count, sideBufferDepth);
+	if (err) goto fail;
+	// Make sure there's always a graph for the audio thread
+	err = azaMixerCommit(data);
+	if (err) goto fail;
 	return AZA_SUCCESS;
+fail:
+	azaMixerSchedulerDeinit(data);
+	azaSideBufferArenaDeinit(&data->sideBufferArena);
+	azaMixerCollectRetired(data, true);
+	AZA_DA_DEINIT(data->retired);
+	azaMutexDeinit(&data->mutex);
+	azaTrackDeinit(&data->master);
+	return err;
 }
 
 void azaMixerDeinit(azaMixer *data) {
+	azaMixerSchedulerDeinit(data);
+	azaSideBufferArenaDeinit(&data->sideBufferArena);
+	// The audio thread is gone, so free everything it might have been using
+	azaMixerCollectRetired(data, true);
+	AZA_DA_DEINIT(data->retired);
+	if (data->graphPublished) {
+		azaMixerGraphFree(data->graphPublished);
+		data->graphPublished = NULL;
+	}
+	data->graphPending = NULL;
+	data->graphAudio = NULL;
 	for (uint32_t i = 0; i < data->tracks.count; i++) {
 		azaTrackDeinit(data->tracks.data[i]);
 		aza_free(data->tracks.data[i]);
@@ -235,6 +870,7 @@ int azaMixerAddTrack(azaMixer *data, int32_t index, azaTrack **dst, azaChannelLa
 	if (err) goto fail;
 	err = azaTrackInit(result, data->config.bufferFrames, channelLayout);
 	if (err) goto fail;
+	result->mixer = data;
 	if (connectToMaster) {
 		err = azaTrackConnect(result, &data->master, 0.0f, NULL, 0);
 		if (err) goto fail2;
@@ -242,8 +878,9 @@ int azaMixerAddTrack(azaMixer *data, int32_t index, azaTrack **dst, azaChannelLa
 	if (dst) {
 		*dst = result;
 	}
+	err = azaMixerCommit(data);
 	azaMutexUnlock(&data->mutex);
-	return AZA_SUCCESS;
+	return err;
 fail2:
 	azaTrackDeinit(result);
 fail:
@@ -263,9 +900,12 @@ void azaMixerRemoveTrack(azaMixer *data, int32_t index) {
 		azaTrack *other = data->tracks.data[i];
 		azaTrackDisconnect(track, other);
 	}
-	azaTrackDeinit(data->tracks.data[index]);
-	aza_free(track);
 	AZA_DA_ERASE(data->tracks, index, 1);
+	azaMixerRetire(data, AZA_MIXER_RETIRED_TRACK, track);
+	int err = azaMixerCommit(data);
+	if (err) {
+		AZA_LOG_ERR("azaMixerRemoveTrack error: azaMixerCommit failed (%s)\n", azaErrorString(err));
+	}
 	azaMutexUnlock(&data->mutex);
 }
 
@@ -277,39 +917,34 @@ int azaMixerGetTrackSendCount(azaMixer *mixer, azaTrack *track) {
 	return count;
 }
 
-// Modified depth-first search for directed graphs to determine whether a cycle exists.
-static int azaMixerCheckRoutingVisit(azaTrack *track) {
-	// Co-opt this search to reset whether track is processed
-	track->processed = false;
-	for (uint32_t i = 0; i < track->receives.count; i++) {
-		azaTrack *recv = track->receives.data[i].track;
-		if (!recv) break;
-		if (recv->mark == 2) continue;
-		if (recv->mark == 1) return AZA_ERROR_MIXER_ROUTING_CYCLE;
-		recv->mark = 1;
-		if (azaMixerCheckRoutingVisit(recv)) return AZA_ERROR_MIXER_ROUTING_CYCLE;
-		recv->mark = 2;
-	}
-	return AZA_SUCCESS;
-}
-
-static int azaMixerCheckRouting(azaMixer *data) {
-	for (uint32_t i = 0; i < data->tracks.count; i++) {
-		data->tracks.data[i]->mark = 0;
-	}
-	azaTrack *track = &data->master;
-	track->mark = 0;
-	return azaMixerCheckRoutingVisit(track);
-}
-
 int azaMixerProcess(uint32_t frames, uint32_t samplerate, azaMixer *data) {
-	azaMutexLock(&data->mutex);
 	int64_t tsStart = azaGetTimestamp();
 	int64_t timeOffline = tsStart - data->tsOfflineStart;
-	int err;
-	if ((err = azaMixerCheckRouting(data))) goto error;
-	if ((err = azaTrackProcess(frames, samplerate, &data->master))) goto error;
+	int err = AZA_SUCCESS;
+	azaSideBufferArena *sideBufferArenaPrevious = azaSideBuffersBindArena(&data->sideBufferArena);
+	azaAtomicStore32(&data->samplerateAudio, (int32_t)samplerate);
+	azaMixerPickUpGraph(data);
+	azaMixerGraph *graph = data->graphAudio;
+	if (graph->hasCircularRouting) {
+		err = AZA_ERROR_MIXER_ROUTING_CYCLE;
+		goto error;
+	}
+	azaMixerUpdateLatency(data, samplerate);
+	if (data->scheduler.workers.count) {
+		if ((err = azaMixerSchedulerProcess(frames, samplerate, data))) goto error;
+	} else {
+		for (uint32_t i = 0; i < graph->tracks.count; i++) {
+			if ((err = azaMixerGraphProcessTrack(frames, samplerate, graph, i))) goto error;
+		}
+	}
 error:
+	// Any workers are done with this block, so we're the only ones looking at it now.
+	if (azaAtomicLoad32(&data->pluginErrorPending)) {
+		if (azaMixerGUIIsOpen()) {
+			azaMixerGUIShowError(data->pluginErrorMessage);
+		}
+		azaAtomicStore32(&data->pluginErrorPending, 0);
+	}
 	int64_t tsEnd = azaGetTimestamp();
 	int64_t timeOnline = tsEnd - tsStart;
 	float cpuPercent = (float)(100.0 * (double)timeOnline / (double)(timeOffline + timeOnline));
@@ -319,27 +954,38 @@ error:
 		data->cpuPercentSlow = data->cpuPercent;
 	}
 	data->tsOfflineStart = tsEnd;
-	azaMutexUnlock(&data->mutex);
+	azaSideBuffersBindArena(sideBufferArenaPrevious);
 	return err;
 }
 
 int azaMixerCallback(void *userdata, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	azaMixer *mixer = (azaMixer*)userdata;
-	azaBuffer stash = mixer->master.buffer;
-	mixer->master.buffer = azaBufferView(dst);
-	if (dst != src) {
-		azaBufferCopy(dst, src);
-	}
-	int err = azaMixerProcess(dst->frames, dst->samplerate, mixer);
-	if (err == AZA_ERROR_MIXER_ROUTING_CYCLE) {
-		// Gracefully zero out audio since a cycle can be remedied with the mixer GUI now
-		mixer->hasCircularRouting = true;
+	// The master track renders into its own buffer, which has room before it for its plugins' history (see azaMixerGraphVisit), and we copy the result out.
+	if (dst->channelLayout.count != mixer->master.buffer.channelLayout.count) {
 		azaBufferZero(dst);
-		err = AZA_SUCCESS;
-	} else {
-		mixer->hasCircularRouting = false;
+		return AZA_ERROR_MISMATCHED_CHANNEL_COUNT;
+	}
+	int err = AZA_SUCCESS;
+	for (uint32_t start = 0; start < dst->frames;) {
+		uint32_t frames = AZA_MIN(dst->frames - start, mixer->master.buffer.frames);
+		azaBuffer dstSlice = azaBufferSliceEx(dst, start, frames, 0, 0);
+		err = azaMixerProcess(frames, dst->samplerate, mixer);
+		if (err == AZA_ERROR_MIXER_ROUTING_CYCLE) {
+			// Gracefully zero out audio since a cycle can be remedied with the mixer GUI now
+			mixer->hasCircularRouting = true;
+			azaBufferZero(&dstSlice);
+			err = AZA_SUCCESS;
+		} else if (err) {
+			azaBuffer dstRemaining = azaBufferSliceEx(dst, start, dst->frames - start, 0, 0);
+			azaBufferZero(&dstRemaining);
+			break;
+		} else {
+			mixer->hasCircularRouting = false;
+			azaBuffer masterSlice = azaBufferSliceEx(&mixer->master.buffer, 0, frames, 0, 0);
+			azaBufferCopy(&dstSlice, &masterSlice);
+		}
+		start += frames;
 	}
-	mixer->master.buffer = stash;
 	return err;
 }
 
@@ -23,6 +23,8 @@ typedef struct azaTrackRoute {
 	aza_byte _reserved[3];
 	azaChannelMatrix channelMatrix;
 	azaSampleDelay latencyCompensationDelay;
+	// How many frames in a row the track we receive from has been silent, so we know when latencyCompensationDelay has been flushed and we can stop mixing.
+	uint32_t framesSilent;
 } azaTrackRoute;
 
 void azaTrackRouteInit(azaTrackRoute *data);
@@ -32,10 +34,12 @@ void azaTrackRouteDeinit(azaTrackRoute *data);
 typedef struct azaTrack {
 	azaBuffer buffer;
 	// Plugin chain, including synths and samplers
+	// The audio thread processes a copy of this from the latest azaMixerGraph, so changes take effect on azaMixerCommit.
 	azaDSPChain plugins;
 	char name[32];
+	// Routes are allocated individually so they stay put while the audio thread is using them.
 	struct {
-		azaTrackRoute *data;
+		azaTrackRoute **data;
 		uint32_t count;
 		uint32_t capacity;
 	} receives;
@@ -44,8 +48,24 @@ typedef struct azaTrack {
 	azaMeters meters;
 	// Used to determine whether routing is cyclic.
 	uint8_t mark;
-	// Used to determine whether we've already processed this track
-	bool processed;
+	// The mixer we belong to, if any. Used to defer freeing anything the audio thread might still be using.
+	struct azaMixer *mixer;
+	// Our index within the azaMixerGraph being built by azaMixerCommit
+	uint32_t graphIndex;
+	// Our index within the azaMixerGraph being used by azaMixerProcess
+	uint32_t graphIndexAudio;
+	// Latency cache, kept up to date by azaMixerProcess so processing doesn't have to walk the graph to get it.
+	// Latency of our own plugin chain
+	uint32_t latencyFramesOwn;
+	// Total latency of our output, which is latencyFramesOwn plus the largest latency of all our audible receives
+	uint32_t latencyFrames;
+	// Control threads' copies of our buffer's frames and channel layout, which never change after azaTrackInit. The audio thread replaces buffer whenever it picks up a graph with a bigger one for us, so control threads read these instead.
+	uint32_t bufferFrames;
+	azaChannelLayout bufferChannelLayout;
+	// buffer.leadingFrames, published by the audio thread whenever it swaps in a bigger buffer. Only accessed atomically.
+	volatile int32_t bufferLeadingFrames;
+	// Set by azaMixerProcess when our plugins want more history than our buffer has room for before it. The audio thread can't grow the buffer itself, so azaMixerCommit does it. Only accessed atomically.
+	volatile int32_t historyFramesWanted;
 } azaTrack;
 // Initializes our buffer
 // May return any error azaBufferInit can return
@@ -58,6 +78,7 @@ void azaTrackPrependDSP(azaTrack *data, azaDSP *dsp);
 // Inserts the dsp into the place of dst, making dst come after dsp. If dst is NULL, this works the same as append.
 void azaTrackInsertDSP(azaTrack *data, azaDSP *dsp, azaDSP *dst);
 // Finds the dsp in the chain and removes it (does not free dsp)
+// If the track belongs to a mixer, the audio thread may still be using dsp until the next azaMixerCommit goes through, so free it with azaMixerRetireDSP.
 void azaTrackRemoveDSP(azaTrack *data, azaDSP *dsp);
 
 void azaTrackSetName(azaTrack *data, const char *name);
@@ -68,20 +89,153 @@ enum {
 };
 
 // Routes the output of from to the input of to (bet you had to reread that a few times)
-// if dstTrackRoute is not NULL, this outputs the connection that was just made (or the existing one). This pointer is only guaranteed to be valid until the next time you call this function, so don't hold on to it)
+// if dstTrackRoute is not NULL, this outputs the connection that was just made (or the existing one). This pointer stays valid until the tracks are disconnected.
 // May return AZA_ERROR_OUT_OF_MEMORY
 int azaTrackConnect(azaTrack *from, azaTrack *to, float gain, azaTrackRoute **dstTrackRoute, uint32_t flags);
 // Disconnects tracks if they're connected. If they're not connected, nothing happens.
+// If to belongs to a mixer, freeing the route is deferred until the audio thread is done with it.
 void azaTrackDisconnect(azaTrack *from, azaTrack *to);
 // Will return NULL if no such route exists.
 azaTrackRoute* azaTrackGetReceive(azaTrack *from, azaTrack *to);
 
-int azaTrackProcess(uint32_t frames, uint32_t samplerate, azaTrack *data);
-
 typedef struct azaMixerConfig {
 	uint32_t bufferFrames;
+	// How many additional threads to launch for processing independent tracks in parallel. The thread calling azaMixerProcess always does work too, so 0 means everything is processed on that thread alone.
+	uint32_t workerThreads;
+	// How many side buffers of bufferFrames frames and the master track's channel count we reserve for each processing thread, so processing never has to allocate them. 0 means AZA_SIDE_BUFFER_DEFAULT_DEPTH.
+	uint32_t sideBufferDepth;
+	// The most frames each track's plugins process at a time (see azaDSPChain.maxBlockFrames). Large backend buffers get split up so the whole chain works in cache. 0 processes the whole buffer at once.
+	uint32_t dspBlockFrames;
 } azaMixerConfig;
 
+
+
+// Snapshot of the routing graph
+
+
+
+// Control threads (the GUI, or anyone else changing tracks around) build a new azaMixerGraph on azaMixerCommit and publish it atomically. The audio thread picks up the newest one at the start of a block without waiting on anyone.
+// Once published, a graph is never modified by control threads. Graphs, tracks, routes, and plugins that the audio thread might still be using are freed by control threads once the audio thread has moved on to a newer graph.
+
+typedef struct azaMixerGraphRoute {
+	azaTrackRoute *route;
+	// Index into azaMixerGraph.tracks of the track we receive from
+	uint32_t srcIndex;
+	float gain;
+} azaMixerGraphRoute;
+
+typedef struct azaMixerGraphTrack {
+	azaTrack *track;
+	float gain;
+	bool mute;
+	// Range within azaMixerGraph.routes. Only includes audible routes, and is empty if we're muted.
+	uint32_t routesStart;
+	uint32_t routesCount;
+	// Range within azaMixerGraph.dependents listing the tracks that receive from us.
+	uint32_t dependentsStart;
+	uint32_t dependentsCount;
+	// Copy of the track's plugin chain. The audio thread takes over the history buffer from the previous graph when it picks this one up.
+	azaDSPChain plugins;
+	// If the track's buffer needs more leading frames for plugin history, this is its replacement, which the audio thread swaps in when it picks up this graph. The old buffer gets freed along with this graph.
+	azaBuffer buffer;
+	// Scratch space for the parallel scheduler. How many of our routes haven't been processed yet this block. We're ready to go when this hits zero.
+	volatile int32_t dependenciesRemaining;
+} azaMixerGraphTrack;
+
+typedef struct azaMixerGraph {
+	// Increases by one with every published graph
+	uint32_t version;
+	// If true, the routing was cyclic and nothing else is filled in.
+	bool hasCircularRouting;
+	// Dependency-ordered, so every track comes after all the tracks it receives from. The master track is always last.
+	struct {
+		azaMixerGraphTrack *data;
+		uint32_t count;
+	} tracks;
+	struct {
+		azaMixerGraphRoute *data;
+		uint32_t count;
+	} routes;
+	struct {
+		uint32_t *data;
+		uint32_t count;
+	} dependents;
+	// Backing memory for the scheduler's work queues with queueCapacity entries per queue. NULL if we have no workers.
+	uint32_t *queueStorage;
+	// Power of 2 that's >= tracks.count
+	uint32_t queueCapacity;
+} azaMixerGraph;
+
+enum {
+	AZA_MIXER_RETIRED_GRAPH,
+	AZA_MIXER_RETIRED_TRACK,
+	AZA_MIXER_RETIRED_ROUTE,
+	AZA_MIXER_RETIRED_DSP,
+};
+
+// Something the audio thread might still be using, to be freed once it's safe
+typedef struct azaMixerRetired {
+	void *ptr;
+	// Newest graph version that may reference ptr. We can free it once the audio thread is using a newer one.
+	uint32_t version;
+	uint32_t kind;
+} azaMixerRetired;
+
+
+
+// Parallel processing of the track graph
+
+
+
+// Work-stealing deque of indices into azaMixerGraph.tracks. The owning thread pushes and pops from the bottom, while other threads steal from the top.
+// Padded so top and bottom don't share a cache line with each other or with other queues.
+typedef struct azaMixerWorkQueue {
+	volatile int64_t top;
+	aza_byte _padTop[56];
+	volatile int64_t bottom;
+	aza_byte _padBottom[56];
+	// Points into azaMixerGraph.queueStorage
+	uint32_t *tasks;
+	aza_byte _padTasks[64 - sizeof(uint32_t*)];
+} azaMixerWorkQueue;
+
+typedef struct azaMixerWorker {
+	azaThread thread;
+	struct azaMixer *mixer;
+	// Which azaMixerWorkQueue belongs to us. Index 0 belongs to the thread calling azaMixerProcess.
+	uint32_t queueIndex;
+	azaSideBufferArena sideBufferArena;
+} azaMixerWorker;
+
+typedef struct azaMixerScheduler {
+	struct {
+		azaMixerWorker *data;
+		uint32_t count;
+	} workers;
+	// One for each worker plus one for the thread calling azaMixerProcess
+	struct {
+		azaMixerWorkQueue *data;
+		uint32_t count;
+	} queues;
+	// The graph being processed in the current block
+	azaMixerGraph *graph;
+	// Workers wait on this between blocks
+	azaSemaphore semaphoreWake;
+	// Nonzero while workers are allowed to join in on the current block
+	volatile int32_t open;
+	// How many workers are currently touching the queues
+	volatile int32_t workersActive;
+	volatile int32_t tasksRemaining;
+	// First error reported by any task this block
+	volatile int32_t error;
+	volatile int32_t quit;
+	// Parameters of the current block
+	uint32_t frames;
+	uint32_t samplerate;
+} azaMixerScheduler;
+
+
+
 typedef struct azaMixer {
 	azaMixerConfig config;
 	struct {
@@ -92,8 +246,22 @@ typedef struct azaMixer {
 	azaTrack master;
 	// We may optionally own a stream to which we output the track contents of master.
 	azaStream stream;
-	// Maybe look into other options besides a mutex? We really don't want our sound thread to wait for the GUI if we can help it.
+	// Serializes control threads with each other. The audio thread never takes this, instead getting everything it needs from graphAudio.
 	azaMutex mutex;
+	// Newest graph published by azaMixerCommit. Only touched by control threads with the mutex held.
+	azaMixerGraph *graphPublished;
+	// Newest graph that the audio thread hasn't picked up yet, or NULL.
+	void *volatile graphPending;
+	// The graph azaMixerProcess is using. Only touched by the audio thread.
+	azaMixerGraph *graphAudio;
+	// graphAudio->version, so control threads can tell what's safe to free.
+	volatile int32_t graphVersionAudio;
+	// Only touched by control threads with the mutex held.
+	struct {
+		azaMixerRetired *data;
+		uint32_t count;
+		uint32_t capacity;
+	} retired;
 	// Used to measure how long we spend not processing, so we can get a CPU use percentage.
 	int64_t tsOfflineStart;
 	float cpuPercent;
@@ -102,11 +270,24 @@ typedef struct azaMixer {
 	// How many times have we processed?
 	uint64_t times;
 	bool hasCircularRouting;
+	// Set whenever something changes that affects latency compensation (routes, mutes, plugin latency). Checked and cleared once per azaMixerProcess.
+	bool latencyDirty;
+	// Samplerate of the latest azaMixerProcess, so azaMixerCommit knows how much history plugins want without looking at track buffers. 0 until the first block. Only accessed atomically.
+	volatile int32_t samplerateAudio;
+	// Set by whichever thread hits the first plugin error in a block, which also copies the error message into pluginErrorMessage. Workers can't touch the GUI, so azaMixerProcess reports it on its own thread once they're done.
+	volatile int32_t pluginErrorPending;
+	char pluginErrorMessage[256];
+	// Only used if config.workerThreads > 0
+	azaMixerScheduler scheduler;
+	// Bound for the duration of azaMixerProcess. Each worker has its own.
+	azaSideBufferArena sideBufferArena;
 } azaMixer;
 
 // config.bufferFrames indicates how many frames our buffers should have. This should probably match the maximum size of the backend buffer, if applicable.
+// If config.workerThreads > 0, we launch that many worker threads which hold a pointer to data, so data must not move in memory until azaMixerDeinit.
 // masterChannelLayout will be used to initialize the master track's buffer channel layout, and also all other track channel layouts if config.channelLayouts is NULL or if the channel's respective channelLayout has 0 channels
-// May return AZA_ERROR_OUT_OF_MEMORY if we failed to allocate tracks, or any error azaBufferInit can return
+// May return AZA_ERROR_OUT_OF_MEMORY if we failed to allocate tracks or side buffers, or any error azaBufferInit can return
+// May return AZA_ERROR_BACKEND_ERROR if we failed to launch worker threads
 int azaMixerInit(azaMixer *data, azaMixerConfig config, azaChannelLayout masterChannelLayout);
 void azaMixerDeinit(azaMixer *data);
 
@@ -119,11 +300,28 @@ void azaMixerRemoveTrack(azaMixer *data, int32_t index);
 // Returns the total number of sends from the given track to other tracks in the mixer
 int azaMixerGetTrackSendCount(azaMixer *data, azaTrack *track);
 
-// Processes all the tracks to produce a result into the output track.
+// Publishes the current routing, gains, mutes, and plugin chains of all tracks to the audio thread, which picks them up at the start of its next block. Plugin configs are read live, so those don't need a commit.
+// azaMixerAddTrack and azaMixerRemoveTrack commit for you, but anything you change on the tracks directly needs a commit to be heard.
+// Also frees anything that was retired once the audio thread can no longer be using it.
+// The audio thread never allocates, so this is also where track buffers and side buffer arenas grow if processing found them too small (see azaMixerNeedsCommit).
+// Returns AZA_SUCCESS if nothing changed since the last commit.
+// May return AZA_ERROR_OUT_OF_MEMORY
+int azaMixerCommit(azaMixer *data);
+
+// Returns true if the audio thread ran out of room for something that only azaMixerCommit can make room for, so you should commit even if you didn't change anything.
+bool azaMixerNeedsCommit(azaMixer *data);
+
+// Frees dsp with azaFreeDSP once the audio thread can no longer be using it. Use this for plugins that were removed from a track in this mixer.
+void azaMixerRetireDSP(azaMixer *data, azaDSP *dsp);
+
+// Processes all the tracks to produce a result into the output track, according to the newest graph published by azaMixerCommit. Never waits on control threads.
+// If we have worker threads, tracks that don't depend on each other get processed in parallel, with the calling thread doing work as well.
 // frames MUST be <= data->config.bufferFrames
 int azaMixerProcess(uint32_t frames, uint32_t samplerate, azaMixer *data);
 
 // Builtin callback for processing the mixer on a stream
+// Renders the master track into its own buffer and copies it into dst, in as many pieces of up to config.bufferFrames as it takes. src is ignored.
+// May return AZA_ERROR_MISMATCHED_CHANNEL_COUNT if dst doesn't have as many channels as the master track, or any error azaMixerProcess can return except AZA_ERROR_MIXER_ROUTING_CYCLE, which zeroes dst instead.
 int azaMixerCallback(void *userdata, azaBuffer *dst, azaBuffer *src, uint32_t flags);
 
 // if onTop is true then the window will always be on top even if it loses focus
@@ -8,6 +8,7 @@
 
 #include "AzAudio.h"
 #include "math.h"
+#include "error.h"
 #include "dsp/azaDSP.h"
 #include "gui/gui.h"
 
@@ -28,6 +29,8 @@
 
 
 static azaMixer *currentMixer = NULL;
+// Set whenever we change something that goes into the azaMixerGraph, so we only azaMixerCommit when it matters.
+static bool mixerChanged = false;
 static int dspSelectionLayer = 0;
 static float dspSelectionScroll = 0;
 static azagWindow mixerWindow = AZAG_WINDOW_INVALID;
@@ -95,12 +98,13 @@ static void azagContextMenuTrack() {
 	bool doRemoveTrack = contextMenuTrackIndex > 0;
 	bool doRemoveSend = contextMenuTrackSend != NULL;
 
+	azaMutexLock(&currentMixer->mutex);
 	azagDrawContextMenuBegin(NULL);
 
 	if (azagDrawContextMenuButton("Add Track")) {
 		AZA_LOG_TRACE("Track Add at index %d!\n", contextMenuTrackIndex);
 		azaTrack *track;
-		azaMixerAddTrack(currentMixer, contextMenuTrackIndex, &track, currentMixer->master.buffer.channelLayout, true);
+		azaMixerAddTrack(currentMixer, contextMenuTrackIndex, &track, currentMixer->master.bufferChannelLayout, true);
 		// TODO: Come up with a better auto name
 		azaTrackSetName(track, azaTextFormat("Track %d", contextMenuTrackIndex));
 		AZA_DA_INSERT(azaTrackGUIMetadatas, contextMenuTrackIndex+1, (azaTrackGUIMetadata){0}, do{}while(0));
@@ -118,13 +122,16 @@ static void azagContextMenuTrack() {
 	if (doRemoveSend) {
 		if (azagDrawContextMenuButton(azaTextFormat("Remove Send to %s", contextMenuTrackSend->name))) {
 			azaTrackDisconnect(azagContextMenuTrackFromIndex(), contextMenuTrackSend);
+			mixerChanged = true;
 		}
 	}
 
 	azagDrawContextMenuEnd();
+	azaMutexUnlock(&currentMixer->mutex);
 }
 
 static void azagContextMenuTrackRemove() {
+	azaMutexLock(&currentMixer->mutex);
 	azagDrawContextMenuBegin("Really Remove Track?");
 
 	if (azagDrawContextMenuButton("Obliterate That Thang")) {
@@ -138,14 +145,17 @@ static void azagContextMenuTrackRemove() {
 	azagDrawContextMenuButton("Cancel");
 
 	azagDrawContextMenuEnd();
+	azaMutexUnlock(&currentMixer->mutex);
 }
 
 static void azagContextMenuSendAdd() {
+	azaMutexLock(&currentMixer->mutex);
 	int count = currentMixer->tracks.count; // +1 for Master, -1 for self
 	if (count == 0) {
 		azagDrawContextMenuBegin(NULL);
 		azagDrawContextMenuButton("No >:(");
 		azagDrawContextMenuEnd();
+		azaMutexUnlock(&currentMixer->mutex);
 		return;
 	}
 	azagDrawContextMenuBegin("Add Send To:");
@@ -161,16 +171,19 @@ static void azagContextMenuSendAdd() {
 		}
 		if (azagDrawContextMenuButton(target->name)) {
 			azaTrackConnect(track, target, 0.0f, NULL, 0);
+			mixerChanged = true;
 		}
 	}
 
 	azagDrawContextMenuEnd();
+	azaMutexUnlock(&currentMixer->mutex);
 }
 
 static void azagContextMenuTrackFXAdd();
 
 static void azagContextMenuTrackFX() {
 	bool doRemovePlugin = contextMenuTrackFXDSP != NULL;
+	azaMutexLock(&currentMixer->mutex);
 	azagDrawContextMenuBegin(NULL);
 
 	if (azagDrawContextMenuButton("Add Plugin")) {
@@ -179,15 +192,18 @@ static void azagContextMenuTrackFX() {
 	if (doRemovePlugin) {
 		if (azagDrawContextMenuButton(azaTextFormat("Remove %s", contextMenuTrackFXDSP->guiMetadata.name))) {
 			azaTrackRemoveDSP(azagContextMenuTrackFromIndex(), contextMenuTrackFXDSP);
-			azaFreeDSP(contextMenuTrackFXDSP);
+			azaMixerRetireDSP(currentMixer, contextMenuTrackFXDSP);
 			contextMenuTrackFXDSP = NULL;
+			mixerChanged = true;
 		}
 	}
 
 	azagDrawContextMenuEnd();
+	azaMutexUnlock(&currentMixer->mutex);
 }
 
 static void azagContextMenuTrackFXAdd() {
+	azaMutexLock(&currentMixer->mutex);
 	azaTrack *track = azagContextMenuTrackFromIndex();
 
 	azagDrawContextMenuBegin(NULL);
@@ -200,6 +216,7 @@ static void azagContextMenuTrackFXAdd() {
 			if (newDSP) {
 				newDSP->header.owned = true;
 				azaTrackInsertDSP(track, newDSP, contextMenuTrackFXDSP);
+				mixerChanged = true;
 			} else {
 				snprintf(contextMenuError, sizeof(contextMenuError), "Failed to make \"%s\": Out of memory!\n", name);
 				AZA_LOG_ERR(contextMenuError);
@@ -209,6 +226,7 @@ static void azagContextMenuTrackFXAdd() {
 	}
 
 	azagDrawContextMenuEnd();
+	azaMutexUnlock(&currentMixer->mutex);
 }
 
 
@@ -290,6 +308,17 @@ static const float trackMeterDBHeadroom = 12;
 static const float trackFaderDBRange = 72;
 static const float trackFaderDBHeadroom = 12;
 
+// Same as azagDrawFader, but notes whether the gain or mute changed so they make it into the next azaMixerCommit
+static float azagDrawTrackFader(azagRect bounds, float *gain, bool *mute, const char *label) {
+	float gainPrev = *gain;
+	bool mutePrev = *mute;
+	float result = azagDrawFader(bounds, gain, mute, false, label, trackFaderDBRange, trackFaderDBHeadroom);
+	if (*gain != gainPrev || *mute != mutePrev) {
+		mixerChanged = true;
+	}
+	return result;
+}
+
 // returns used width
 static float azagDrawTrackControls(azaTrack *track, uint32_t metadataIndex, azagRect bounds) {
 	azaTrackGUIMetadata *metadata = &azaTrackGUIMetadatas.data[metadataIndex];
@@ -305,7 +334,7 @@ static float azagDrawTrackControls(azaTrack *track, uint32_t metadataIndex, azag
 	azagDrawRectGradientV(bounds, azagThemeCurrent.track.colorControlsBGTop, azagThemeCurrent.track.colorControlsBGBot);
 	azagRectShrinkMargin(&bounds, 0.0f);
 	// Fader
-	float usedWidth = azagDrawFader(bounds, &track->gain, &track->mute, false, "Track Gain", trackFaderDBRange, trackFaderDBHeadroom);
+	float usedWidth = azagDrawTrackFader(bounds, &track->gain, &track->mute, "Track Gain");
 	usedWidth += azagThemeCurrent.margin.x;
 	metadata->width += usedWidth;
 	azagRectShrinkLeft(&bounds, usedWidth);
@@ -320,7 +349,7 @@ static float azagDrawTrackControls(azaTrack *track, uint32_t metadataIndex, azag
 	azagPushScissor(bounds);
 	azaTrackRoute *receive = azaTrackGetReceive(track, &currentMixer->master);
 	if (receive) {
-		usedWidth = azagDrawFader(bounds, &receive->gain, &receive->mute, false, "Master Send", trackFaderDBRange, trackFaderDBHeadroom);
+		usedWidth = azagDrawTrackFader(bounds, &receive->gain, &receive->mute, "Master Send");
 		usedWidth += azagThemeCurrent.margin.x;
 		metadata->width += usedWidth;
 		if (openedContextMenu && azagMouseInRectDepth((azagRect) { .xy = bounds.xy, .w = usedWidth, .h = bounds.h }, AZAG_MOUSE_DEPTH_CONTEXT_MENU)) {
@@ -331,7 +360,7 @@ static float azagDrawTrackControls(azaTrack *track, uint32_t metadataIndex, azag
 	for (uint32_t i = 0; i < currentMixer->tracks.count; i++) {
 		receive = azaTrackGetReceive(track, currentMixer->tracks.data[i]);
 		if (receive) {
-			usedWidth = azagDrawFader(bounds, &receive->gain, &receive->mute, false, azaTextFormat("%s Send", currentMixer->tracks.data[i]->name), trackFaderDBRange, trackFaderDBHeadroom);
+			usedWidth = azagDrawTrackFader(bounds, &receive->gain, &receive->mute, azaTextFormat("%s Send", currentMixer->tracks.data[i]->name));
 			usedWidth += azagThemeCurrent.margin.x;
 			metadata->width += usedWidth;
 			if (openedContextMenu && azagMouseInRectDepth((azagRect) { .xy = bounds.xy, .w = usedWidth, .h = bounds.h }, AZAG_MOUSE_DEPTH_CONTEXT_MENU)) {
@@ -393,7 +422,7 @@ static float azagDrawTrack(azaTrack *track, uint32_t metadataIndex, azagRect bou
 
 
 static void azagDrawMixer() {
-	// TODO: This granularity might get in the way of audio processing. Probably only lock the mutex when it matters most.
+	// Other control threads may be adding or removing tracks, but the audio thread never takes the mutex
 	azaMutexLock(&currentMixer->mutex);
 	float screenWidth = azagGetScreenWidth();
 	float pluginDrawHeight = azagGetScreenHeight() - (azagThemeCurrent.track.size.y + azagThemeCurrent.scrollbar.thickness + azagThemeCurrent.margin.y);
@@ -584,6 +613,14 @@ static AZA_THREAD_PROC_DEF(azaMixerGUIThreadProc, userdata) {
 			azagDrawMixer();
 			azagDrawSelectedDSP();
 		azagEndDrawing();
+		// Everything we changed this frame gets heard at once (context menus do their thing in azagEndDrawing)
+		if (mixerChanged || azaMixerNeedsCommit(currentMixer)) {
+			mixerChanged = false;
+			int err = azaMixerCommit(currentMixer);
+			if (err) {
+				AZA_LOG_ERR_ONCE("azaMixerGUI error: azaMixerCommit failed (%s)\n", azaErrorString(err));
+			}
+		}
 	}
 	isWindowOpen = false;
 	azagWindowClose();
@@ -78,6 +78,10 @@
 
 #endif
 
+#define AZA_AVX512VL azaCPUID.avx512vl
+#define AZA_AVX512DQ azaCPUID.avx512dq
+#define AZA_AVX512BW azaCPUID.avx512bw
+#define AZA_AVX512F azaCPUID.avx512f
 #define AZA_AVX2 azaCPUID.avx2
 #define AZA_FMA azaCPUID.fma
 #define AZA_AVX azaCPUID.avx
@@ -128,6 +132,85 @@ aza_mm256_hsum_ps(__m256 a) {
 	return aza_mm_hsum_ps_sse3(_mm_add_ps(lo, hi));
 }
 
+// returns the largest of all lanes
+AZA_SIMD_FEATURES("sse")
+static inline float
+aza_mm_hmax_ps_sse(__m128 a) {
+	__m128 B_B_D_D = _mm_shuffle_ps(a, a, _MM_SHUFFLER(1, 1, 3, 3));
+	__m128 AB_BB_CD_DD = _mm_max_ps(a, B_B_D_D);
+	__m128 CD_DD______ = _mm_movehl_ps(AB_BB_CD_DD, AB_BB_CD_DD);
+	__m128 ABCD_______ = _mm_max_ss(AB_BB_CD_DD, CD_DD______);
+	return _mm_cvtss_f32(ABCD_______);
+}
+
+// returns the largest of all lanes
+AZA_SIMD_FEATURES("avx")
+static inline float
+aza_mm256_hmax_ps(__m256 a) {
+	__m128 lo, hi;
+	lo = _mm256_extractf128_ps(a, 0);
+	hi = _mm256_extractf128_ps(a, 1);
+	return aza_mm_hmax_ps_sse(_mm_max_ps(lo, hi));
+}
+
+// Loads lanes floats (1 to 4) without touching memory past them. The rest of the lanes are zeroed.
+AZA_SIMD_FEATURES("sse2")
+static inline __m128
+aza_mm_loadu_lanes_ps(const float *src, uint32_t lanes) {
+	switch (lanes) {
+		case 1: return _mm_load_ss(src);
+		case 2: return _mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)src));
+		case 3: return _mm_movelh_ps(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)src)), _mm_load_ss(src+2));
+		default: return _mm_loadu_ps(src);
+	}
+}
+
+// Stores lanes floats (1 to 4) without touching memory past them
+AZA_SIMD_FEATURES("sse2")
+static inline void
+aza_mm_storeu_lanes_ps(float *dst, __m128 value, uint32_t lanes) {
+	switch (lanes) {
+		case 1: _mm_store_ss(dst, value); break;
+		case 2: _mm_storel_epi64((__m128i*)dst, _mm_castps_si128(value)); break;
+		case 3:
+			_mm_storel_epi64((__m128i*)dst, _mm_castps_si128(value));
+			_mm_store_ss(dst+2, _mm_movehl_ps(value, value));
+			break;
+		default: _mm_storeu_ps(dst, value); break;
+	}
+}
+
+// Loads lanes floats (1 to 8) without touching memory past them. The rest of the lanes are zeroed.
+AZA_SIMD_FEATURES("avx")
+static inline __m256
+aza_mm256_loadu_lanes_ps(const float *src, uint32_t lanes) {
+	if (lanes >= 8) return _mm256_loadu_ps(src);
+	if (lanes <= 4) return _mm256_zextps128_ps256(aza_mm_loadu_lanes_ps(src, lanes));
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src)), aza_mm_loadu_lanes_ps(src+4, lanes-4), 1);
+}
+
+// Stores lanes floats (1 to 8) without touching memory past them
+AZA_SIMD_FEATURES("avx")
+static inline void
+aza_mm256_storeu_lanes_ps(float *dst, __m256 value, uint32_t lanes) {
+	if (lanes >= 8) {
+		_mm256_storeu_ps(dst, value);
+	} else if (lanes <= 4) {
+		aza_mm_storeu_lanes_ps(dst, _mm256_castps256_ps128(value), lanes);
+	} else {
+		_mm_storeu_ps(dst, _mm256_castps256_ps128(value));
+		aza_mm_storeu_lanes_ps(dst+4, _mm256_extractf128_ps(value, 1), lanes-4);
+	}
+}
+
+// Mask with the first count lanes set, for handling tails with masked loads and stores rather than scalar loops.
+// count must be <= 16
+static inline __mmask16
+aza_mask16_first(uint32_t count) {
+	assert(count <= 16);
+	return (__mmask16)((1u << count) - 1u);
+}
+
 AZA_SIMD_FEATURES("sse")
 static AZA_FORCE_INLINE(__m128)
 azaLerp_x4_sse(__m128 a, __m128 b, __m128 t) {
@@ -7,6 +7,7 @@
 
 #include "../dsp/azaBuffer.h"
 #include "../simd.h"
+#include "../math.h"
 
 // Fully dynamic fallback
 
@@ -18,6 +19,15 @@ void azaBufferDeinterlace_dynamic(azaBuffer *dst, azaBuffer *src) {
 	}
 }
 
+// The AVX-512 versions do 16 frames at a time, picking the channels out with 2-source permutes.
+// Tails use masked loads and stores, so there are no scalar loops.
+// loadMask returns the mask for vector v of a block that holds lanes valid floats.
+static inline __mmask16 azaBufferDeinterlaceLoadMask(uint32_t lanes, uint32_t v) {
+	return lanes > 16*v ? aza_mask16_first(AZA_MIN(16, lanes - 16*v)) : 0;
+}
+
+
+
 // 2 channel specialized deinterlace
 
 // NOTE: SSE+SSE2 are guaranteed to be available on x86_64. Is there still any demand for 32-bit x86 support? I guess it doesn't cost us any more than we're already paying to support it.
@@ -123,11 +133,46 @@ void azaBufferDeinterlace2Ch_avx2(azaBuffer *dst, azaBuffer *src) {
 	}
 }
 
+AZA_SIMD_FEATURES("avx512f")
+static AZA_FORCE_INLINE(void)
+azaBufferDeinterlace2Ch_avx512f_block(float *dst_samples_a, float *dst_samples_b, const float *src_samples, uint32_t frames) {
+	const __m512i indexA = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+	const __m512i indexB = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+	__m512 A0_B0_to_A7_B7, A8_B8_to_A15_B15;
+	if (frames == 16) {
+		A0_B0_to_A7_B7 = _mm512_loadu_ps(src_samples);
+		A8_B8_to_A15_B15 = _mm512_loadu_ps(src_samples + 16);
+	} else {
+		A0_B0_to_A7_B7 = _mm512_maskz_loadu_ps(azaBufferDeinterlaceLoadMask(frames*2, 0), src_samples);
+		A8_B8_to_A15_B15 = _mm512_maskz_loadu_ps(azaBufferDeinterlaceLoadMask(frames*2, 1), src_samples + 16);
+	}
+	__m512 A0_to_A15 = _mm512_permutex2var_ps(A0_B0_to_A7_B7, indexA, A8_B8_to_A15_B15);
+	__m512 B0_to_B15 = _mm512_permutex2var_ps(A0_B0_to_A7_B7, indexB, A8_B8_to_A15_B15);
+	__mmask16 storeMask = aza_mask16_first(frames);
+	_mm512_mask_storeu_ps(dst_samples_a, storeMask, A0_to_A15);
+	_mm512_mask_storeu_ps(dst_samples_b, storeMask, B0_to_B15);
+}
+
+AZA_SIMD_FEATURES("avx512f")
+void azaBufferDeinterlace2Ch_avx512f(azaBuffer *dst, azaBuffer *src) {
+	uint32_t i = 0;
+	float *const dst_samples_a = dst->pSamples;
+	float *const dst_samples_b = dst_samples_a + dst->frames;
+	for (; i + 16 <= src->frames; i += 16) {
+		azaBufferDeinterlace2Ch_avx512f_block(dst_samples_a + i, dst_samples_b + i, src->pSamples + i*2, 16);
+	}
+	if (i < src->frames) {
+		azaBufferDeinterlace2Ch_avx512f_block(dst_samples_a + i, dst_samples_b + i, src->pSamples + i*2, src->frames - i);
+	}
+}
+
 void azaBufferDeinterlace2Ch_dispatch(azaBuffer*, azaBuffer*);
 void (*azaBufferDeinterlace2Ch)(azaBuffer *dst, azaBuffer *src) = azaBufferDeinterlace2Ch_dispatch;
 void azaBufferDeinterlace2Ch_dispatch(azaBuffer *dst, azaBuffer *src) {
 	assert(azaCPUID.initted);
-	if (AZA_AVX) {
+	if (AZA_AVX512F) {
+		azaBufferDeinterlace2Ch = azaBufferDeinterlace2Ch_avx512f;
+	} else if (AZA_AVX) {
 		azaBufferDeinterlace2Ch = azaBufferDeinterlace2Ch_avx;
 	} else if (AZA_SSE) {
 		azaBufferDeinterlace2Ch = azaBufferDeinterlace2Ch_sse;
@@ -355,11 +400,56 @@ void azaBufferDeinterlace3Ch_avx2(azaBuffer *dst, azaBuffer *src) {
 	}
 }
 
+// Frame j of channel c is at element 3j+c of the 3 vectors concatenated. The first 32 elements can be permuted out of the first 2 vectors, and the rest out of the last 2.
+AZA_SIMD_FEATURES("avx512f")
+static AZA_FORCE_INLINE(void)
+azaBufferDeinterlace3Ch_avx512f_block(float *dst_samples_a, float *dst_samples_b, float *dst_samples_c, const float *src_samples, uint32_t frames) {
+	const __m512i indexA01 = _mm512_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21, 24, 27, 30,  0,  0,  0,  0,  0);
+	const __m512i indexA12 = _mm512_setr_epi32(0, 0, 0, 0,  0,  0,  0,  0,  0,  0,  0, 17, 20, 23, 26, 29);
+	const __m512i indexB01 = _mm512_setr_epi32(1, 4, 7, 10, 13, 16, 19, 22, 25, 28, 31, 0,  0,  0,  0,  0);
+	const __m512i indexB12 = _mm512_setr_epi32(0, 0, 0, 0,  0,  0,  0,  0,  0,  0,  0, 18, 21, 24, 27, 30);
+	const __m512i indexC01 = _mm512_setr_epi32(2, 5, 8, 11, 14, 17, 20, 23, 26, 29, 0,  0,  0,  0,  0,  0);
+	const __m512i indexC12 = _mm512_setr_epi32(0, 0, 0, 0,  0,  0,  0,  0,  0,  0, 16, 19, 22, 25, 28, 31);
+	__m512 v0, v1, v2;
+	if (frames == 16) {
+		v0 = _mm512_loadu_ps(src_samples);
+		v1 = _mm512_loadu_ps(src_samples + 16);
+		v2 = _mm512_loadu_ps(src_samples + 32);
+	} else {
+		v0 = _mm512_maskz_loadu_ps(azaBufferDeinterlaceLoadMask(frames*3, 0), src_samples);
+		v1 = _mm512_maskz_loadu_ps(azaBufferDeinterlaceLoadMask(frames*3, 1), src_samples + 16);
+		v2 = _mm512_maskz_loadu_ps(azaBufferDeinterlaceLoadMask(frames*3, 2), src_samples + 32);
+	}
+	__m512 A0_to_A15 = _mm512_mask_permutex2var_ps(_mm512_permutex2var_ps(v0, indexA01, v1), 0xf800, indexA12, v2);
+	__m512 B0_to_B15 = _mm512_mask_permutex2var_ps(_mm512_permutex2var_ps(v0, indexB01, v1), 0xf800, indexB12, v2);
+	__m512 C0_to_C15 = _mm512_mask_permutex2var_ps(_mm512_permutex2var_ps(v0, indexC01, v1), 0xfc00, indexC12, v2);
+	__mmask16 storeMask = aza_mask16_first(frames);
+	_mm512_mask_storeu_ps(dst_samples_a, storeMask, A0_to_A15);
+	_mm512_mask_storeu_ps(dst_samples_b, storeMask, B0_to_B15);
+	_mm512_mask_storeu_ps(dst_samples_c, storeMask, C0_to_C15);
+}
+
+AZA_SIMD_FEATURES("avx512f")
+void azaBufferDeinterlace3Ch_avx512f(azaBuffer *dst, azaBuffer *src) {
+	uint32_t i = 0;
+	float *const dst_samples_a = dst->pSamples;
+	float *const dst_samples_b = dst_samples_a + dst->frames;
+	float *const dst_samples_c = dst_samples_b + dst->frames;
+	for (; i + 16 <= src->frames; i += 16) {
+		azaBufferDeinterlace3Ch_avx512f_block(dst_samples_a + i, dst_samples_b + i, dst_samples_c + i, src->pSamples + i*3, 16);
+	}
+	if (i < src->frames) {
+		azaBufferDeinterlace3Ch_avx512f_block(dst_samples_a + i, dst_samples_b + i, dst_samples_c + i, src->pSamples + i*3, src->frames - i);
+	}
+}
+
 void azaBufferDeinterlace3Ch_dispatch(azaBuffer*, azaBuffer*);
 void (*azaBufferDeinterlace3Ch)(azaBuffer *dst, azaBuffer *src) = azaBufferDeinterlace3Ch_dispatch;
 void azaBufferDeinterlace3Ch_dispatch(azaBuffer *dst, azaBuffer *src) {
 	assert(azaCPUID.initted);
-	if (AZA_AVX) {
+	if (AZA_AVX512F) {
+		azaBufferDeinterlace3Ch = azaBufferDeinterlace3Ch_avx512f;
+	} else if (AZA_AVX) {
 		azaBufferDeinterlace3Ch = azaBufferDeinterlace3Ch_avx;
 	} else if (AZA_SSE4_1) {
 		azaBufferDeinterlace3Ch = azaBufferDeinterlace3Ch_sse4_1;
@@ -580,11 +670,63 @@ void azaBufferDeinterlace4Ch_avx2(azaBuffer *dst, azaBuffer *src) {
 	}
 }
 
+// Two rounds of permutes, like a transpose: first pairs of channels for 8 frames at a time, then the two halves of each channel get joined.
+AZA_SIMD_FEATURES("avx512f")
+static AZA_FORCE_INLINE(void)
+azaBufferDeinterlace4Ch_avx512f_block(float *dst_samples_a, float *dst_samples_b, float *dst_samples_c, float *dst_samples_d, const float *src_samples, uint32_t frames) {
+	const __m512i indexAB = _mm512_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28, 1, 5, 9, 13, 17, 21, 25, 29);
+	const __m512i indexCD = _mm512_setr_epi32(2, 6, 10, 14, 18, 22, 26, 30, 3, 7, 11, 15, 19, 23, 27, 31);
+	const __m512i indexLo = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 16, 17, 18, 19, 20, 21, 22, 23);
+	const __m512i indexHi = _mm512_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15, 24, 25, 26, 27, 28, 29, 30, 31);
+	__m512 v0, v1, v2, v3;
+	if (frames == 16) {
+		v0 = _mm512_loadu_ps(src_samples);
+		v1 = _mm512_loadu_ps(src_samples + 16);
+		v2 = _mm512_loadu_ps(src_samples + 32);
+		v3 = _mm512_loadu_ps(src_samples + 48);
+	} else {
+		v0 = _mm512_maskz_loadu_ps(azaBufferDeinterlaceLoadMask(frames*4, 0), src_samples);
+		v1 = _mm512_maskz_loadu_ps(azaBufferDeinterlaceLoadMask(frames*4, 1), src_samples + 16);
+		v2 = _mm512_maskz_loadu_ps(azaBufferDeinterlaceLoadMask(frames*4, 2), src_samples + 32);
+		v3 = _mm512_maskz_loadu_ps(azaBufferDeinterlaceLoadMask(frames*4, 3), src_samples + 48);
+	}
+	__m512 A0_to_A7_B0_to_B7 = _mm512_permutex2var_ps(v0, indexAB, v1);
+	__m512 C0_to_C7_D0_to_D7 = _mm512_permutex2var_ps(v0, indexCD, v1);
+	__m512 A8_to_A15_B8_to_B15 = _mm512_permutex2var_ps(v2, indexAB, v3);
+	__m512 C8_to_C15_D8_to_D15 = _mm512_permutex2var_ps(v2, indexCD, v3);
+	__m512 A0_to_A15 = _mm512_permutex2var_ps(A0_to_A7_B0_to_B7, indexLo, A8_to_A15_B8_to_B15);
+	__m512 B0_to_B15 = _mm512_permutex2var_ps(A0_to_A7_B0_to_B7, indexHi, A8_to_A15_B8_to_B15);
+	__m512 C0_to_C15 = _mm512_permutex2var_ps(C0_to_C7_D0_to_D7, indexLo, C8_to_C15_D8_to_D15);
+	__m512 D0_to_D15 = _mm512_permutex2var_ps(C0_to_C7_D0_to_D7, indexHi, C8_to_C15_D8_to_D15);
+	__mmask16 storeMask = aza_mask16_first(frames);
+	_mm512_mask_storeu_ps(dst_samples_a, storeMask, A0_to_A15);
+	_mm512_mask_storeu_ps(dst_samples_b, storeMask, B0_to_B15);
+	_mm512_mask_storeu_ps(dst_samples_c, storeMask, C0_to_C15);
+	_mm512_mask_storeu_ps(dst_samples_d, storeMask, D0_to_D15);
+}
+
+AZA_SIMD_FEATURES("avx512f")
+void azaBufferDeinterlace4Ch_avx512f(azaBuffer *dst, azaBuffer *src) {
+	uint32_t i = 0;
+	float *const dst_samples_a = dst->pSamples;
+	float *const dst_samples_b = dst_samples_a + dst->frames;
+	float *const dst_samples_c = dst_samples_b + dst->frames;
+	float *const dst_samples_d = dst_samples_c + dst->frames;
+	for (; i + 16 <= src->frames; i += 16) {
+		azaBufferDeinterlace4Ch_avx512f_block(dst_samples_a + i, dst_samples_b + i, dst_samples_c + i, dst_samples_d + i, src->pSamples + i*4, 16);
+	}
+	if (i < src->frames) {
+		azaBufferDeinterlace4Ch_avx512f_block(dst_samples_a + i, dst_samples_b + i, dst_samples_c + i, dst_samples_d + i, src->pSamples + i*4, src->frames - i);
+	}
+}
+
 void azaBufferDeinterlace4Ch_dispatch(azaBuffer*, azaBuffer*);
 void (*azaBufferDeinterlace4Ch)(azaBuffer *dst, azaBuffer *src) = azaBufferDeinterlace4Ch_dispatch;
 void azaBufferDeinterlace4Ch_dispatch(azaBuffer *dst, azaBuffer *src) {
 	assert(azaCPUID.initted);
-	if (AZA_AVX) {
+	if (AZA_AVX512F) {
+		azaBufferDeinterlace4Ch = azaBufferDeinterlace4Ch_avx512f;
+	} else if (AZA_AVX) {
 		azaBufferDeinterlace4Ch = azaBufferDeinterlace4Ch_avx;
 	} else if (AZA_SSE) {
 		azaBufferDeinterlace4Ch = azaBufferDeinterlace4Ch_sse;
@@ -601,6 +743,7 @@ void azaBufferDeinterlace(azaBuffer *dst, azaBuffer *src) {
 	// We don't actually have to worry about dst->stride because we just kinda ignore it anyway
 	// assert(dst->stride == dst->channelLayout.count);
 	assert(dst->channelLayout.count == src->channelLayout.count);
+	dst->silent = src->silent;
 	if (src->stride == src->channelLayout.count) {
 		switch (dst->channelLayout.count) {
 			case 0:
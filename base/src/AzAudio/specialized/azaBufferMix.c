@@ -0,0 +1,587 @@
+/*
+	File: azaBufferMix.c
+	Author: Philip Haynes
+	Specialized implementations of azaBufferMix, azaBufferMixFadeLinear, azaBufferMixFadeEase, and dispatch.
+	Implements the following (declared in azaBuffer.h):
+		- azaBufferMix(4)
+		- azaBufferMixFadeLinear(6)
+		- azaBufferMixFadeEase(8)
+	All the kernels have a fast path for buffers whose stride equals their channel count, where we can treat every sample the same regardless of which channel it's in. Otherwise we go frame by frame, vectorizing across channels.
+*/
+
+#include "../dsp/azaBuffer.h"
+#include "../simd.h"
+#include "../AzAudio.h"
+
+// How many frames of eased volumes azaBufferMixFadeEase computes at a time
+#define AZA_MIX_EASE_CHUNK_FRAMES 128
+
+static inline bool azaBufferMixIsContiguous(azaBuffer *dst, azaBuffer *src) {
+	return dst->stride == dst->channelLayout.count && src->stride == src->channelLayout.count;
+}
+
+// Whether every vector of width lanes holds a whole number of frames, such that every lane always lines up with the same channel.
+static inline bool azaBufferMixFramesFitVector(azaBuffer *dst, azaBuffer *src, uint32_t lanes) {
+	return azaBufferMixIsContiguous(dst, src) && lanes % dst->channelLayout.count == 0;
+}
+
+
+
+// azaBufferMix
+
+
+
+// dst = dst*volumeDst + src*volumeSrc
+
+void azaBufferMix_scalar(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc) {
+	const uint32_t channels = dst->channelLayout.count;
+	if (azaBufferMixIsContiguous(dst, src)) {
+		const uint32_t totalSamples = dst->frames * channels;
+		for (uint32_t i = 0; i < totalSamples; i++) {
+			dst->pSamples[i] = dst->pSamples[i] * volumeDst + src->pSamples[i] * volumeSrc;
+		}
+		return;
+	}
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		for (uint32_t c = 0; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumeDst + srcFrame[c] * volumeSrc;
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("sse")
+void azaBufferMix_sse(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc) {
+	const uint32_t channels = dst->channelLayout.count;
+	const __m128 volumeDst_x4 = _mm_set1_ps(volumeDst);
+	const __m128 volumeSrc_x4 = _mm_set1_ps(volumeSrc);
+	if (azaBufferMixIsContiguous(dst, src)) {
+		const uint32_t totalSamples = dst->frames * channels;
+		uint32_t i = 0;
+		for (; i + 4 <= totalSamples; i += 4) {
+			__m128 dstSamples = _mm_mul_ps(_mm_loadu_ps(dst->pSamples + i), volumeDst_x4);
+			__m128 srcSamples = _mm_mul_ps(_mm_loadu_ps(src->pSamples + i), volumeSrc_x4);
+			_mm_storeu_ps(dst->pSamples + i, _mm_add_ps(dstSamples, srcSamples));
+		}
+		for (; i < totalSamples; i++) {
+			dst->pSamples[i] = dst->pSamples[i] * volumeDst + src->pSamples[i] * volumeSrc;
+		}
+		return;
+	}
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		uint32_t c = 0;
+		for (; c + 4 <= channels; c += 4) {
+			__m128 dstSamples = _mm_mul_ps(_mm_loadu_ps(dstFrame + c), volumeDst_x4);
+			__m128 srcSamples = _mm_mul_ps(_mm_loadu_ps(srcFrame + c), volumeSrc_x4);
+			_mm_storeu_ps(dstFrame + c, _mm_add_ps(dstSamples, srcSamples));
+		}
+		for (; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumeDst + srcFrame[c] * volumeSrc;
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("avx")
+void azaBufferMix_avx(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc) {
+	const uint32_t channels = dst->channelLayout.count;
+	const __m256 volumeDst_x8 = _mm256_set1_ps(volumeDst);
+	const __m256 volumeSrc_x8 = _mm256_set1_ps(volumeSrc);
+	if (azaBufferMixIsContiguous(dst, src)) {
+		const uint32_t totalSamples = dst->frames * channels;
+		uint32_t i = 0;
+		for (; i + 8 <= totalSamples; i += 8) {
+			__m256 dstSamples = _mm256_mul_ps(_mm256_loadu_ps(dst->pSamples + i), volumeDst_x8);
+			__m256 srcSamples = _mm256_mul_ps(_mm256_loadu_ps(src->pSamples + i), volumeSrc_x8);
+			_mm256_storeu_ps(dst->pSamples + i, _mm256_add_ps(dstSamples, srcSamples));
+		}
+		for (; i < totalSamples; i++) {
+			dst->pSamples[i] = dst->pSamples[i] * volumeDst + src->pSamples[i] * volumeSrc;
+		}
+		return;
+	}
+	const __m128 volumeDst_x4 = _mm256_castps256_ps128(volumeDst_x8);
+	const __m128 volumeSrc_x4 = _mm256_castps256_ps128(volumeSrc_x8);
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		uint32_t c = 0;
+		for (; c + 8 <= channels; c += 8) {
+			__m256 dstSamples = _mm256_mul_ps(_mm256_loadu_ps(dstFrame + c), volumeDst_x8);
+			__m256 srcSamples = _mm256_mul_ps(_mm256_loadu_ps(srcFrame + c), volumeSrc_x8);
+			_mm256_storeu_ps(dstFrame + c, _mm256_add_ps(dstSamples, srcSamples));
+		}
+		if (c + 4 <= channels) {
+			__m128 dstSamples = _mm_mul_ps(_mm_loadu_ps(dstFrame + c), volumeDst_x4);
+			__m128 srcSamples = _mm_mul_ps(_mm_loadu_ps(srcFrame + c), volumeSrc_x4);
+			_mm_storeu_ps(dstFrame + c, _mm_add_ps(dstSamples, srcSamples));
+			c += 4;
+		}
+		for (; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumeDst + srcFrame[c] * volumeSrc;
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("avx,fma")
+void azaBufferMix_avx_fma(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc) {
+	const uint32_t channels = dst->channelLayout.count;
+	const __m256 volumeDst_x8 = _mm256_set1_ps(volumeDst);
+	const __m256 volumeSrc_x8 = _mm256_set1_ps(volumeSrc);
+	if (azaBufferMixIsContiguous(dst, src)) {
+		const uint32_t totalSamples = dst->frames * channels;
+		uint32_t i = 0;
+		for (; i + 8 <= totalSamples; i += 8) {
+			__m256 dstSamples = _mm256_mul_ps(_mm256_loadu_ps(dst->pSamples + i), volumeDst_x8);
+			_mm256_storeu_ps(dst->pSamples + i, _mm256_fmadd_ps(_mm256_loadu_ps(src->pSamples + i), volumeSrc_x8, dstSamples));
+		}
+		for (; i < totalSamples; i++) {
+			dst->pSamples[i] = dst->pSamples[i] * volumeDst + src->pSamples[i] * volumeSrc;
+		}
+		return;
+	}
+	const __m128 volumeDst_x4 = _mm256_castps256_ps128(volumeDst_x8);
+	const __m128 volumeSrc_x4 = _mm256_castps256_ps128(volumeSrc_x8);
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		uint32_t c = 0;
+		for (; c + 8 <= channels; c += 8) {
+			__m256 dstSamples = _mm256_mul_ps(_mm256_loadu_ps(dstFrame + c), volumeDst_x8);
+			_mm256_storeu_ps(dstFrame + c, _mm256_fmadd_ps(_mm256_loadu_ps(srcFrame + c), volumeSrc_x8, dstSamples));
+		}
+		if (c + 4 <= channels) {
+			__m128 dstSamples = _mm_mul_ps(_mm_loadu_ps(dstFrame + c), volumeDst_x4);
+			_mm_storeu_ps(dstFrame + c, _mm_fmadd_ps(_mm_loadu_ps(srcFrame + c), volumeSrc_x4, dstSamples));
+			c += 4;
+		}
+		for (; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumeDst + srcFrame[c] * volumeSrc;
+		}
+	}
+}
+
+void azaBufferMix_dispatch(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc);
+void (*azaBufferMix_specialized)(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc) = azaBufferMix_dispatch;
+void azaBufferMix_dispatch(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc) {
+	assert(azaCPUID.initted);
+	if (AZA_AVX && AZA_FMA) {
+		AZA_LOG_TRACE("choosing azaBufferMix_avx_fma\n");
+		azaBufferMix_specialized = azaBufferMix_avx_fma;
+	} else if (AZA_AVX) {
+		AZA_LOG_TRACE("choosing azaBufferMix_avx\n");
+		azaBufferMix_specialized = azaBufferMix_avx;
+	} else if (AZA_SSE) {
+		AZA_LOG_TRACE("choosing azaBufferMix_sse\n");
+		azaBufferMix_specialized = azaBufferMix_sse;
+	} else {
+		AZA_LOG_TRACE("choosing azaBufferMix_scalar\n");
+		azaBufferMix_specialized = azaBufferMix_scalar;
+	}
+	azaBufferMix_specialized(dst, volumeDst, src, volumeSrc);
+}
+
+void azaBufferMix(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc) {
+	assert(dst->frames == src->frames);
+	assert(dst->channelLayout.count == src->channelLayout.count);
+	if (volumeDst == 1.0f && (volumeSrc == 0.0f || src->silent)) {
+		return;
+	}
+	azaBufferMixSilence(dst, volumeDst != 0.0f, src, volumeSrc != 0.0f);
+	if AZA_UNLIKELY(volumeDst == 0.0f && volumeSrc == 0.0f) {
+		azaBufferZero(dst);
+	} else {
+		azaBufferMix_specialized(dst, volumeDst, src, volumeSrc);
+	}
+}
+
+
+
+// azaBufferMixFadeLinear
+
+
+
+// dst = dst*(volumeDstStart + volumeDstStep*frame) + src*(volumeSrcStart + volumeSrcStep*frame)
+// For the contiguous fast path, laneFrames holds which frame each lane of a vector is in relative to the first frame in that vector, and we compute the volumes from the frame index rather than accumulating the steps so rounding errors can't build up over the buffer.
+
+void azaBufferMixFadeLinear_scalar(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep) {
+	const uint32_t channels = dst->channelLayout.count;
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		float volumeDst = volumeDstStart + volumeDstStep * (float)i;
+		float volumeSrc = volumeSrcStart + volumeSrcStep * (float)i;
+		for (uint32_t c = 0; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumeDst + srcFrame[c] * volumeSrc;
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("sse")
+void azaBufferMixFadeLinear_sse(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep) {
+	const uint32_t channels = dst->channelLayout.count;
+	const __m128 volumeDstStart_x4 = _mm_set1_ps(volumeDstStart);
+	const __m128 volumeDstStep_x4 = _mm_set1_ps(volumeDstStep);
+	const __m128 volumeSrcStart_x4 = _mm_set1_ps(volumeSrcStart);
+	const __m128 volumeSrcStep_x4 = _mm_set1_ps(volumeSrcStep);
+	uint32_t i = 0;
+	if (azaBufferMixFramesFitVector(dst, src, 4)) {
+		const uint32_t framesPerVector = 4 / channels;
+		const __m128 laneFrames = _mm_setr_ps(0.0f, (float)(1 / channels), (float)(2 / channels), (float)(3 / channels));
+		for (; i + framesPerVector <= dst->frames; i += framesPerVector) {
+			__m128 frame = _mm_add_ps(_mm_set1_ps((float)i), laneFrames);
+			__m128 volumeDst = _mm_add_ps(volumeDstStart_x4, _mm_mul_ps(volumeDstStep_x4, frame));
+			__m128 volumeSrc = _mm_add_ps(volumeSrcStart_x4, _mm_mul_ps(volumeSrcStep_x4, frame));
+			float *dstSamples = dst->pSamples + i * channels;
+			float *srcSamples = src->pSamples + i * channels;
+			__m128 result = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(dstSamples), volumeDst), _mm_mul_ps(_mm_loadu_ps(srcSamples), volumeSrc));
+			_mm_storeu_ps(dstSamples, result);
+		}
+	}
+	for (; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		float volumeDst = volumeDstStart + volumeDstStep * (float)i;
+		float volumeSrc = volumeSrcStart + volumeSrcStep * (float)i;
+		const __m128 volumeDst_x4 = _mm_set1_ps(volumeDst);
+		const __m128 volumeSrc_x4 = _mm_set1_ps(volumeSrc);
+		uint32_t c = 0;
+		for (; c + 4 <= channels; c += 4) {
+			__m128 result = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(dstFrame + c), volumeDst_x4), _mm_mul_ps(_mm_loadu_ps(srcFrame + c), volumeSrc_x4));
+			_mm_storeu_ps(dstFrame + c, result);
+		}
+		for (; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumeDst + srcFrame[c] * volumeSrc;
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("avx")
+void azaBufferMixFadeLinear_avx(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep) {
+	const uint32_t channels = dst->channelLayout.count;
+	const __m256 volumeDstStart_x8 = _mm256_set1_ps(volumeDstStart);
+	const __m256 volumeDstStep_x8 = _mm256_set1_ps(volumeDstStep);
+	const __m256 volumeSrcStart_x8 = _mm256_set1_ps(volumeSrcStart);
+	const __m256 volumeSrcStep_x8 = _mm256_set1_ps(volumeSrcStep);
+	uint32_t i = 0;
+	if (azaBufferMixFramesFitVector(dst, src, 8)) {
+		const uint32_t framesPerVector = 8 / channels;
+		const __m256 laneFrames = _mm256_setr_ps(0.0f, (float)(1 / channels), (float)(2 / channels), (float)(3 / channels), (float)(4 / channels), (float)(5 / channels), (float)(6 / channels), (float)(7 / channels));
+		for (; i + framesPerVector <= dst->frames; i += framesPerVector) {
+			__m256 frame = _mm256_add_ps(_mm256_set1_ps((float)i), laneFrames);
+			__m256 volumeDst = _mm256_add_ps(volumeDstStart_x8, _mm256_mul_ps(volumeDstStep_x8, frame));
+			__m256 volumeSrc = _mm256_add_ps(volumeSrcStart_x8, _mm256_mul_ps(volumeSrcStep_x8, frame));
+			float *dstSamples = dst->pSamples + i * channels;
+			float *srcSamples = src->pSamples + i * channels;
+			__m256 result = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(dstSamples), volumeDst), _mm256_mul_ps(_mm256_loadu_ps(srcSamples), volumeSrc));
+			_mm256_storeu_ps(dstSamples, result);
+		}
+	}
+	for (; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		float volumeDst = volumeDstStart + volumeDstStep * (float)i;
+		float volumeSrc = volumeSrcStart + volumeSrcStep * (float)i;
+		const __m256 volumeDst_x8 = _mm256_set1_ps(volumeDst);
+		const __m256 volumeSrc_x8 = _mm256_set1_ps(volumeSrc);
+		uint32_t c = 0;
+		for (; c + 8 <= channels; c += 8) {
+			__m256 result = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(dstFrame + c), volumeDst_x8), _mm256_mul_ps(_mm256_loadu_ps(srcFrame + c), volumeSrc_x8));
+			_mm256_storeu_ps(dstFrame + c, result);
+		}
+		if (c + 4 <= channels) {
+			__m128 result = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(dstFrame + c), _mm256_castps256_ps128(volumeDst_x8)), _mm_mul_ps(_mm_loadu_ps(srcFrame + c), _mm256_castps256_ps128(volumeSrc_x8)));
+			_mm_storeu_ps(dstFrame + c, result);
+			c += 4;
+		}
+		for (; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumeDst + srcFrame[c] * volumeSrc;
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("avx,fma")
+void azaBufferMixFadeLinear_avx_fma(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep) {
+	const uint32_t channels = dst->channelLayout.count;
+	const __m256 volumeDstStart_x8 = _mm256_set1_ps(volumeDstStart);
+	const __m256 volumeDstStep_x8 = _mm256_set1_ps(volumeDstStep);
+	const __m256 volumeSrcStart_x8 = _mm256_set1_ps(volumeSrcStart);
+	const __m256 volumeSrcStep_x8 = _mm256_set1_ps(volumeSrcStep);
+	uint32_t i = 0;
+	if (azaBufferMixFramesFitVector(dst, src, 8)) {
+		const uint32_t framesPerVector = 8 / channels;
+		const __m256 laneFrames = _mm256_setr_ps(0.0f, (float)(1 / channels), (float)(2 / channels), (float)(3 / channels), (float)(4 / channels), (float)(5 / channels), (float)(6 / channels), (float)(7 / channels));
+		for (; i + framesPerVector <= dst->frames; i += framesPerVector) {
+			__m256 frame = _mm256_add_ps(_mm256_set1_ps((float)i), laneFrames);
+			__m256 volumeDst = _mm256_fmadd_ps(volumeDstStep_x8, frame, volumeDstStart_x8);
+			__m256 volumeSrc = _mm256_fmadd_ps(volumeSrcStep_x8, frame, volumeSrcStart_x8);
+			float *dstSamples = dst->pSamples + i * channels;
+			float *srcSamples = src->pSamples + i * channels;
+			__m256 result = _mm256_fmadd_ps(_mm256_loadu_ps(srcSamples), volumeSrc, _mm256_mul_ps(_mm256_loadu_ps(dstSamples), volumeDst));
+			_mm256_storeu_ps(dstSamples, result);
+		}
+	}
+	for (; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		float volumeDst = volumeDstStart + volumeDstStep * (float)i;
+		float volumeSrc = volumeSrcStart + volumeSrcStep * (float)i;
+		const __m256 volumeDst_x8 = _mm256_set1_ps(volumeDst);
+		const __m256 volumeSrc_x8 = _mm256_set1_ps(volumeSrc);
+		uint32_t c = 0;
+		for (; c + 8 <= channels; c += 8) {
+			__m256 result = _mm256_fmadd_ps(_mm256_loadu_ps(srcFrame + c), volumeSrc_x8, _mm256_mul_ps(_mm256_loadu_ps(dstFrame + c), volumeDst_x8));
+			_mm256_storeu_ps(dstFrame + c, result);
+		}
+		if (c + 4 <= channels) {
+			__m128 result = _mm_fmadd_ps(_mm_loadu_ps(srcFrame + c), _mm256_castps256_ps128(volumeSrc_x8), _mm_mul_ps(_mm_loadu_ps(dstFrame + c), _mm256_castps256_ps128(volumeDst_x8)));
+			_mm_storeu_ps(dstFrame + c, result);
+			c += 4;
+		}
+		for (; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumeDst + srcFrame[c] * volumeSrc;
+		}
+	}
+}
+
+void azaBufferMixFadeLinear_dispatch(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep);
+void (*azaBufferMixFadeLinear_specialized)(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep) = azaBufferMixFadeLinear_dispatch;
+void azaBufferMixFadeLinear_dispatch(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep) {
+	assert(azaCPUID.initted);
+	if (AZA_AVX && AZA_FMA) {
+		AZA_LOG_TRACE("choosing azaBufferMixFadeLinear_avx_fma\n");
+		azaBufferMixFadeLinear_specialized = azaBufferMixFadeLinear_avx_fma;
+	} else if (AZA_AVX) {
+		AZA_LOG_TRACE("choosing azaBufferMixFadeLinear_avx\n");
+		azaBufferMixFadeLinear_specialized = azaBufferMixFadeLinear_avx;
+	} else if (AZA_SSE) {
+		AZA_LOG_TRACE("choosing azaBufferMixFadeLinear_sse\n");
+		azaBufferMixFadeLinear_specialized = azaBufferMixFadeLinear_sse;
+	} else {
+		AZA_LOG_TRACE("choosing azaBufferMixFadeLinear_scalar\n");
+		azaBufferMixFadeLinear_specialized = azaBufferMixFadeLinear_scalar;
+	}
+	azaBufferMixFadeLinear_specialized(dst, volumeDstStart, volumeDstStep, src, volumeSrcStart, volumeSrcStep);
+}
+
+void azaBufferMixFadeLinear(azaBuffer *dst, float volumeDstStart, float volumeDstEnd, azaBuffer *src, float volumeSrcStart, float volumeSrcEnd) {
+	if (volumeDstStart == volumeDstEnd && volumeSrcStart == volumeSrcEnd) {
+		azaBufferMix(dst, volumeDstStart, src, volumeSrcStart);
+		return;
+	}
+	assert(dst->frames == src->frames);
+	assert(dst->channelLayout.count == src->channelLayout.count);
+	azaBufferMixSilence(dst, volumeDstStart != 0.0f || volumeDstEnd != 0.0f, src, volumeSrcStart != 0.0f || volumeSrcEnd != 0.0f);
+	const float framesF = (float)dst->frames;
+	const float volumeDstStep = (volumeDstEnd - volumeDstStart) / framesF;
+	const float volumeSrcStep = (volumeSrcEnd - volumeSrcStart) / framesF;
+	azaBufferMixFadeLinear_specialized(dst, volumeDstStart, volumeDstStep, src, volumeSrcStart, volumeSrcStep);
+}
+
+
+
+// azaBufferMixFadeEase
+
+
+
+// dst = dst*volumesDst[frame] + src*volumesSrc[frame]
+// The easing functions are called through function pointers, so we evaluate them ahead of time in chunks and pass the results in here.
+// For the contiguous fast path, we spread the per-frame volumes out to each lane with a shuffle, which only works for 1, 2, or 4 channels.
+
+void azaBufferMixFadeVolumes_scalar(azaBuffer *dst, const float *volumesDst, azaBuffer *src, const float *volumesSrc) {
+	const uint32_t channels = dst->channelLayout.count;
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		for (uint32_t c = 0; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumesDst[i] + srcFrame[c] * volumesSrc[i];
+		}
+	}
+}
+
+// Gives us the volumes for 4 samples starting at frame i
+AZA_SIMD_FEATURES("sse")
+static inline __m128 azaBufferMixFadeVolumesSpread_sse(const float *volumes, uint32_t i, uint32_t channels) {
+	switch (channels) {
+		case 1: return _mm_loadu_ps(volumes + i);
+		case 2: {
+			__m128 pair = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(volumes + i));
+			return _mm_unpacklo_ps(pair, pair);
+		}
+		default: return _mm_set1_ps(volumes[i]);
+	}
+}
+
+AZA_SIMD_FEATURES("sse")
+void azaBufferMixFadeVolumes_sse(azaBuffer *dst, const float *volumesDst, azaBuffer *src, const float *volumesSrc) {
+	const uint32_t channels = dst->channelLayout.count;
+	uint32_t i = 0;
+	if (azaBufferMixFramesFitVector(dst, src, 4)) {
+		const uint32_t framesPerVector = 4 / channels;
+		for (; i + framesPerVector <= dst->frames; i += framesPerVector) {
+			__m128 volumeDst = azaBufferMixFadeVolumesSpread_sse(volumesDst, i, channels);
+			__m128 volumeSrc = azaBufferMixFadeVolumesSpread_sse(volumesSrc, i, channels);
+			float *dstSamples = dst->pSamples + i * channels;
+			float *srcSamples = src->pSamples + i * channels;
+			__m128 result = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(dstSamples), volumeDst), _mm_mul_ps(_mm_loadu_ps(srcSamples), volumeSrc));
+			_mm_storeu_ps(dstSamples, result);
+		}
+	}
+	for (; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		const __m128 volumeDst_x4 = _mm_set1_ps(volumesDst[i]);
+		const __m128 volumeSrc_x4 = _mm_set1_ps(volumesSrc[i]);
+		uint32_t c = 0;
+		for (; c + 4 <= channels; c += 4) {
+			__m128 result = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(dstFrame + c), volumeDst_x4), _mm_mul_ps(_mm_loadu_ps(srcFrame + c), volumeSrc_x4));
+			_mm_storeu_ps(dstFrame + c, result);
+		}
+		for (; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumesDst[i] + srcFrame[c] * volumesSrc[i];
+		}
+	}
+}
+
+// Gives us the volumes for 8 samples starting at frame i
+AZA_SIMD_FEATURES("avx")
+static inline __m256 azaBufferMixFadeVolumesSpread_avx(const float *volumes, uint32_t i, uint32_t channels) {
+	switch (channels) {
+		case 1: return _mm256_loadu_ps(volumes + i);
+		case 2: {
+			__m128 four = _mm_loadu_ps(volumes + i);
+			return _mm256_set_m128(_mm_unpackhi_ps(four, four), _mm_unpacklo_ps(four, four));
+		}
+		case 4: {
+			__m128 pair = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(volumes + i));
+			return _mm256_set_m128(_mm_shuffle_ps(pair, pair, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(pair, pair, _MM_SHUFFLE(0, 0, 0, 0)));
+		}
+		default: return _mm256_set1_ps(volumes[i]);
+	}
+}
+
+AZA_SIMD_FEATURES("avx")
+void azaBufferMixFadeVolumes_avx(azaBuffer *dst, const float *volumesDst, azaBuffer *src, const float *volumesSrc) {
+	const uint32_t channels = dst->channelLayout.count;
+	uint32_t i = 0;
+	if (azaBufferMixFramesFitVector(dst, src, 8)) {
+		const uint32_t framesPerVector = 8 / channels;
+		for (; i + framesPerVector <= dst->frames; i += framesPerVector) {
+			__m256 volumeDst = azaBufferMixFadeVolumesSpread_avx(volumesDst, i, channels);
+			__m256 volumeSrc = azaBufferMixFadeVolumesSpread_avx(volumesSrc, i, channels);
+			float *dstSamples = dst->pSamples + i * channels;
+			float *srcSamples = src->pSamples + i * channels;
+			__m256 result = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(dstSamples), volumeDst), _mm256_mul_ps(_mm256_loadu_ps(srcSamples), volumeSrc));
+			_mm256_storeu_ps(dstSamples, result);
+		}
+	}
+	for (; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		const __m256 volumeDst_x8 = _mm256_set1_ps(volumesDst[i]);
+		const __m256 volumeSrc_x8 = _mm256_set1_ps(volumesSrc[i]);
+		uint32_t c = 0;
+		for (; c + 8 <= channels; c += 8) {
+			__m256 result = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(dstFrame + c), volumeDst_x8), _mm256_mul_ps(_mm256_loadu_ps(srcFrame + c), volumeSrc_x8));
+			_mm256_storeu_ps(dstFrame + c, result);
+		}
+		if (c + 4 <= channels) {
+			__m128 result = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(dstFrame + c), _mm256_castps256_ps128(volumeDst_x8)), _mm_mul_ps(_mm_loadu_ps(srcFrame + c), _mm256_castps256_ps128(volumeSrc_x8)));
+			_mm_storeu_ps(dstFrame + c, result);
+			c += 4;
+		}
+		for (; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumesDst[i] + srcFrame[c] * volumesSrc[i];
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("avx,fma")
+void azaBufferMixFadeVolumes_avx_fma(azaBuffer *dst, const float *volumesDst, azaBuffer *src, const float *volumesSrc) {
+	const uint32_t channels = dst->channelLayout.count;
+	uint32_t i = 0;
+	if (azaBufferMixFramesFitVector(dst, src, 8)) {
+		const uint32_t framesPerVector = 8 / channels;
+		for (; i + framesPerVector <= dst->frames; i += framesPerVector) {
+			__m256 volumeDst = azaBufferMixFadeVolumesSpread_avx(volumesDst, i, channels);
+			__m256 volumeSrc = azaBufferMixFadeVolumesSpread_avx(volumesSrc, i, channels);
+			float *dstSamples = dst->pSamples + i * channels;
+			float *srcSamples = src->pSamples + i * channels;
+			__m256 result = _mm256_fmadd_ps(_mm256_loadu_ps(srcSamples), volumeSrc, _mm256_mul_ps(_mm256_loadu_ps(dstSamples), volumeDst));
+			_mm256_storeu_ps(dstSamples, result);
+		}
+	}
+	for (; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		const __m256 volumeDst_x8 = _mm256_set1_ps(volumesDst[i]);
+		const __m256 volumeSrc_x8 = _mm256_set1_ps(volumesSrc[i]);
+		uint32_t c = 0;
+		for (; c + 8 <= channels; c += 8) {
+			__m256 result = _mm256_fmadd_ps(_mm256_loadu_ps(srcFrame + c), volumeSrc_x8, _mm256_mul_ps(_mm256_loadu_ps(dstFrame + c), volumeDst_x8));
+			_mm256_storeu_ps(dstFrame + c, result);
+		}
+		if (c + 4 <= channels) {
+			__m128 result = _mm_fmadd_ps(_mm_loadu_ps(srcFrame + c), _mm256_castps256_ps128(volumeSrc_x8), _mm_mul_ps(_mm_loadu_ps(dstFrame + c), _mm256_castps256_ps128(volumeDst_x8)));
+			_mm_storeu_ps(dstFrame + c, result);
+			c += 4;
+		}
+		for (; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumesDst[i] + srcFrame[c] * volumesSrc[i];
+		}
+	}
+}
+
+void azaBufferMixFadeVolumes_dispatch(azaBuffer *dst, const float *volumesDst, azaBuffer *src, const float *volumesSrc);
+void (*azaBufferMixFadeVolumes_specialized)(azaBuffer *dst, const float *volumesDst, azaBuffer *src, const float *volumesSrc) = azaBufferMixFadeVolumes_dispatch;
+void azaBufferMixFadeVolumes_dispatch(azaBuffer *dst, const float *volumesDst, azaBuffer *src, const float *volumesSrc) {
+	assert(azaCPUID.initted);
+	if (AZA_AVX && AZA_FMA) {
+		AZA_LOG_TRACE("choosing azaBufferMixFadeVolumes_avx_fma\n");
+		azaBufferMixFadeVolumes_specialized = azaBufferMixFadeVolumes_avx_fma;
+	} else if (AZA_AVX) {
+		AZA_LOG_TRACE("choosing azaBufferMixFadeVolumes_avx\n");
+		azaBufferMixFadeVolumes_specialized = azaBufferMixFadeVolumes_avx;
+	} else if (AZA_SSE) {
+		AZA_LOG_TRACE("choosing azaBufferMixFadeVolumes_sse\n");
+		azaBufferMixFadeVolumes_specialized = azaBufferMixFadeVolumes_sse;
+	} else {
+		AZA_LOG_TRACE("choosing azaBufferMixFadeVolumes_scalar\n");
+		azaBufferMixFadeVolumes_specialized = azaBufferMixFadeVolumes_scalar;
+	}
+	azaBufferMixFadeVolumes_specialized(dst, volumesDst, src, volumesSrc);
+}
+
+void azaBufferMixFadeEase(azaBuffer *dst, float volumeDstStart, float volumeDstEnd, fp_azaEase_t easeDst, azaBuffer *src, float volumeSrcStart, float volumeSrcEnd, fp_azaEase_t easeSrc) {
+	if (volumeDstStart == volumeDstEnd && volumeSrcStart == volumeSrcEnd) {
+		azaBufferMix(dst, volumeDstStart, src, volumeSrcStart);
+		return;
+	}
+	if ((easeDst == azaEaseLinear || volumeDstStart == volumeDstEnd) && (easeSrc == azaEaseLinear || volumeSrcStart == volumeSrcEnd)) {
+		azaBufferMixFadeLinear(dst, volumeDstStart, volumeDstEnd, src, volumeSrcStart, volumeSrcEnd);
+		return;
+	}
+	assert(dst->frames == src->frames);
+	assert(dst->channelLayout.count == src->channelLayout.count);
+	assert(easeDst);
+	assert(easeSrc);
+	azaBufferMixSilence(dst, volumeDstStart != 0.0f || volumeDstEnd != 0.0f, src, volumeSrcStart != 0.0f || volumeSrcEnd != 0.0f);
+	const float volumeDstDelta = volumeDstEnd - volumeDstStart;
+	const float volumeSrcDelta = volumeSrcEnd - volumeSrcStart;
+	const float tStep = 1.0f / (float)dst->frames;
+	float volumesDst[AZA_MIX_EASE_CHUNK_FRAMES];
+	float volumesSrc[AZA_MIX_EASE_CHUNK_FRAMES];
+	for (uint32_t chunkStart = 0; chunkStart < dst->frames; chunkStart += AZA_MIX_EASE_CHUNK_FRAMES) {
+		uint32_t chunkFrames = AZA_MIN(AZA_MIX_EASE_CHUNK_FRAMES, dst->frames - chunkStart);
+		for (uint32_t i = 0; i < chunkFrames; i++) {
+			float t = (float)(chunkStart + i) * tStep;
+			volumesDst[i] = volumeDstDelta == 0.0f ? volumeDstStart : volumeDstStart + volumeDstDelta * easeDst(t);
+			volumesSrc[i] = volumeSrcDelta == 0.0f ? volumeSrcStart : volumeSrcStart + volumeSrcDelta * easeSrc(t);
+		}
+		azaBuffer dstChunk = azaBufferSlice(dst, chunkStart, chunkFrames);
+		azaBuffer srcChunk = azaBufferSlice(src, chunkStart, chunkFrames);
+		azaBufferMixFadeVolumes_specialized(&dstChunk, volumesDst, &srcChunk, volumesSrc);
+	}
+}
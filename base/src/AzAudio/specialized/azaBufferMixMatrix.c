@@ -2,11 +2,19 @@
 	File: azaBufferMixMatrix.c
 	Author: Philip Haynes
 	Specialized implementations of azaBufferMixMatrix and dispatch.
-	azaBufferMixMatrix(5) is declared in dsp.h
+	azaBufferMixMatrix(5) is declared in azaBuffer.h
+	Which kernel we use depends on matrix->kind, as determined by azaChannelMatrixClassify.
 */
 
 #include "../dsp/azaBuffer.h"
 #include "../simd.h"
+#include "../AzAudio.h"
+
+
+
+// AZA_CHANNEL_MATRIX_DENSE
+
+
 
 // Dynamic fallback
 
@@ -18,17 +26,17 @@ void azaBufferMixMatrix_scalar(azaBuffer *dst, float volumeDst, azaBuffer *src,
 			matPremult[r * src->channelLayout.count + c] = volumeSrc * matrix->matrix[c * matrix->outputs + r];
 		}
 	}
-	uint32_t i = 0;
-	uint32_t totalSamples = dst->frames*dst->channelLayout.count;
-	for (; i < totalSamples; i++) {
-		uint32_t dstFrame = i / dst->channelLayout.count;
-		uint32_t dstC = i % dst->channelLayout.count;
-		float accum = 0.0f;
-		float *row = matPremult + src->channelLayout.count * dstC;
-		for (uint32_t srcC = 0; srcC < src->channelLayout.count; srcC++) {
-			accum += src->pSamples[dstFrame * src->stride + srcC] * row[srcC];
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		for (uint8_t dstC = 0; dstC < dst->channelLayout.count; dstC++) {
+			float accum = 0.0f;
+			float *row = matPremult + src->channelLayout.count * dstC;
+			for (uint8_t srcC = 0; srcC < src->channelLayout.count; srcC++) {
+				accum += srcFrame[srcC] * row[srcC];
+			}
+			dstFrame[dstC] = dstFrame[dstC] * volumeDst + accum;
 		}
-		dst->pSamples[dstFrame * dst->stride + dstC] = dst->pSamples[dstFrame * dst->stride + dstC] * volumeDst + accum;
 	}
 }
 
@@ -47,7 +55,8 @@ void azaBufferMixMatrix_avx_fma(azaBuffer *dst, float volumeDst, azaBuffer *src,
 		// Process the first few as scalar to get into the right alignment
 		// _mm256_load_ps and _mm256_store_ps expects the data to be aligned on a 32-byte boundary
 		// We could instead use _mm256_loadu_ps and _mm256_storeu_ps but it's easy enough to just get into a sufficiently-aligned boundary like this. The performance differences should be minimal on modern CPUs.
-		for (; i < 8 - ((uint64_t)dst->pSamples % 32) / sizeof(float); i++) {
+		uint32_t unalignedSamples = AZA_MIN(totalSamples, 8 - ((uint64_t)dst->pSamples % 32) / sizeof(float));
+		for (; i < unalignedSamples; i++) {
 			uint32_t dstFrame = i / dst->channelLayout.count;
 			uint32_t dstC = i % dst->channelLayout.count;
 			float accum = 0.0f;
@@ -59,7 +68,7 @@ void azaBufferMixMatrix_avx_fma(azaBuffer *dst, float volumeDst, azaBuffer *src,
 		}
 	}
 	__m256 volumeDst_x8 = _mm256_set1_ps(volumeDst);
-	for (; i <= totalSamples-8; i += 8) {
+	for (; i + 8 <= totalSamples; i += 8) {
 		uint32_t dstFrame = i / dst->channelLayout.count;
 		uint32_t dstC = i % dst->channelLayout.count;
 		__m256 accum_x8 = _mm256_setzero_ps();
@@ -111,11 +120,61 @@ void azaBufferMixMatrix_avx_fma(azaBuffer *dst, float volumeDst, azaBuffer *src,
 	}
 }
 
+// Each dst frame is the sum of the matrix columns scaled by the src samples, with the dst channels across the vector. Channel counts that don't fill a vector are handled with masks, so there are no scalar tails, and it doesn't care about either stride except when it defers to avx_fma.
+AZA_SIMD_FEATURES("avx512f")
+void azaBufferMixMatrix_avx512f(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc, azaChannelMatrix *matrix) {
+	const uint8_t dstChannels = dst->channelLayout.count;
+	const uint8_t srcChannels = src->channelLayout.count;
+	if (dstChannels <= 2) {
+		// Most of every vector would be masked off, and the avx_fma version packs several frames into each vector instead. Only valid because we're never called on a non-contiguous dst.
+		azaBufferMixMatrix_avx_fma(dst, volumeDst, src, volumeSrc, matrix);
+		return;
+	}
+	// src channel count columns of dst channel count rows each, which is the same layout as matrix->matrix
+	float *columns = (float*)alloca(dstChannels * srcChannels * sizeof(float));
+	for (uint32_t i = 0; i < (uint32_t)dstChannels * srcChannels; i++) {
+		columns[i] = volumeSrc * matrix->matrix[i];
+	}
+	const __m512 volumeDst_x16 = _mm512_set1_ps(volumeDst);
+	if (dstChannels <= 16) {
+		const __mmask16 mask = aza_mask16_first(dstChannels);
+		for (uint32_t i = 0; i < dst->frames; i++) {
+			float *dstFrame = dst->pSamples + i * dst->stride;
+			float *srcFrame = src->pSamples + i * src->stride;
+			__m512 accum = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, dstFrame), volumeDst_x16);
+			for (uint8_t srcC = 0; srcC < srcChannels; srcC++) {
+				__m512 column = _mm512_maskz_loadu_ps(mask, columns + srcC * dstChannels);
+				accum = _mm512_fmadd_ps(_mm512_set1_ps(srcFrame[srcC]), column, accum);
+			}
+			_mm512_mask_storeu_ps(dstFrame, mask, accum);
+		}
+	} else {
+		static_assert(AZA_MAX_CHANNEL_POSITIONS <= 32, "azaBufferMixMatrix_avx512f only handles up to 2 vectors of dst channels");
+		const __mmask16 mask = aza_mask16_first(dstChannels - 16);
+		for (uint32_t i = 0; i < dst->frames; i++) {
+			float *dstFrame = dst->pSamples + i * dst->stride;
+			float *srcFrame = src->pSamples + i * src->stride;
+			__m512 accum0 = _mm512_mul_ps(_mm512_loadu_ps(dstFrame), volumeDst_x16);
+			__m512 accum1 = _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, dstFrame + 16), volumeDst_x16);
+			for (uint8_t srcC = 0; srcC < srcChannels; srcC++) {
+				__m512 srcSample = _mm512_set1_ps(srcFrame[srcC]);
+				float *column = columns + srcC * dstChannels;
+				accum0 = _mm512_fmadd_ps(srcSample, _mm512_loadu_ps(column), accum0);
+				accum1 = _mm512_fmadd_ps(srcSample, _mm512_maskz_loadu_ps(mask, column + 16), accum1);
+			}
+			_mm512_storeu_ps(dstFrame, accum0);
+			_mm512_mask_storeu_ps(dstFrame + 16, mask, accum1);
+		}
+	}
+}
+
 void azaBufferMixMatrix_dispatch(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc, azaChannelMatrix *matrix);
 void (*azaBufferMixMatrix_general)(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc, azaChannelMatrix *matrix) = azaBufferMixMatrix_dispatch;
 void azaBufferMixMatrix_dispatch(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc, azaChannelMatrix *matrix) {
 	assert(azaCPUID.initted);
-	if (AZA_AVX) {
+	if (AZA_AVX512F) {
+		azaBufferMixMatrix_general = azaBufferMixMatrix_avx512f;
+	} else if (AZA_AVX && AZA_FMA) {
 		azaBufferMixMatrix_general = azaBufferMixMatrix_avx_fma;
 	// } else if (AZA_SSE) {
 	// 	azaBufferMixMatrix_general = azaBufferMixMatrix_sse;
@@ -125,18 +184,174 @@ void azaBufferMixMatrix_dispatch(azaBuffer *dst, float volumeDst, azaBuffer *src
 	azaBufferMixMatrix_general(dst, volumeDst, src, volumeSrc, matrix);
 }
 
+
+
+// AZA_CHANNEL_MATRIX_DIAGONAL
+
+
+
+// dst[c] = dst[c]*volumeDst + src[c]*gains[c], where gains already has volumeSrc in it.
+// For the contiguous fast path, the gains repeat across a vector as long as it holds a whole number of frames.
+
+void azaBufferMixMatrixDiagonal_scalar(azaBuffer *dst, float volumeDst, azaBuffer *src, const float *gains) {
+	const uint8_t channels = dst->channelLayout.count;
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		for (uint8_t c = 0; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumeDst + srcFrame[c] * gains[c];
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("sse")
+void azaBufferMixMatrixDiagonal_sse(azaBuffer *dst, float volumeDst, azaBuffer *src, const float *gains) {
+	const uint8_t channels = dst->channelLayout.count;
+	uint32_t i = 0;
+	if (dst->stride == channels && src->stride == channels && 4 % channels == 0) {
+		const uint32_t framesPerVector = 4 / channels;
+		const __m128 volumeDst_x4 = _mm_set1_ps(volumeDst);
+		const __m128 gains_x4 = _mm_setr_ps(gains[0], gains[1 % channels], gains[2 % channels], gains[3 % channels]);
+		for (; i + framesPerVector <= dst->frames; i += framesPerVector) {
+			float *dstSamples = dst->pSamples + i * channels;
+			float *srcSamples = src->pSamples + i * channels;
+			__m128 result = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(dstSamples), volumeDst_x4), _mm_mul_ps(_mm_loadu_ps(srcSamples), gains_x4));
+			_mm_storeu_ps(dstSamples, result);
+		}
+	}
+	for (; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		for (uint8_t c = 0; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumeDst + srcFrame[c] * gains[c];
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("avx")
+void azaBufferMixMatrixDiagonal_avx(azaBuffer *dst, float volumeDst, azaBuffer *src, const float *gains) {
+	const uint8_t channels = dst->channelLayout.count;
+	uint32_t i = 0;
+	if (dst->stride == channels && src->stride == channels && 8 % channels == 0) {
+		const uint32_t framesPerVector = 8 / channels;
+		const __m256 volumeDst_x8 = _mm256_set1_ps(volumeDst);
+		const __m256 gains_x8 = _mm256_setr_ps(gains[0], gains[1 % channels], gains[2 % channels], gains[3 % channels], gains[4 % channels], gains[5 % channels], gains[6 % channels], gains[7 % channels]);
+		for (; i + framesPerVector <= dst->frames; i += framesPerVector) {
+			float *dstSamples = dst->pSamples + i * channels;
+			float *srcSamples = src->pSamples + i * channels;
+			__m256 result = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(dstSamples), volumeDst_x8), _mm256_mul_ps(_mm256_loadu_ps(srcSamples), gains_x8));
+			_mm256_storeu_ps(dstSamples, result);
+		}
+	}
+	for (; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		uint8_t c = 0;
+		if (channels >= 8) {
+			// Channel counts that don't fit evenly in a vector can still do whole vectors per frame
+			__m256 volumeDst_x8 = _mm256_set1_ps(volumeDst);
+			for (; c + 8 <= channels; c += 8) {
+				__m256 result = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(dstFrame + c), volumeDst_x8), _mm256_mul_ps(_mm256_loadu_ps(srcFrame + c), _mm256_loadu_ps(gains + c)));
+				_mm256_storeu_ps(dstFrame + c, result);
+			}
+		}
+		for (; c < channels; c++) {
+			dstFrame[c] = dstFrame[c] * volumeDst + srcFrame[c] * gains[c];
+		}
+	}
+}
+
+void azaBufferMixMatrixDiagonal_dispatch(azaBuffer *dst, float volumeDst, azaBuffer *src, const float *gains);
+void (*azaBufferMixMatrixDiagonal_specialized)(azaBuffer *dst, float volumeDst, azaBuffer *src, const float *gains) = azaBufferMixMatrixDiagonal_dispatch;
+void azaBufferMixMatrixDiagonal_dispatch(azaBuffer *dst, float volumeDst, azaBuffer *src, const float *gains) {
+	assert(azaCPUID.initted);
+	if (AZA_AVX) {
+		AZA_LOG_TRACE("choosing azaBufferMixMatrixDiagonal_avx\n");
+		azaBufferMixMatrixDiagonal_specialized = azaBufferMixMatrixDiagonal_avx;
+	} else if (AZA_SSE) {
+		AZA_LOG_TRACE("choosing azaBufferMixMatrixDiagonal_sse\n");
+		azaBufferMixMatrixDiagonal_specialized = azaBufferMixMatrixDiagonal_sse;
+	} else {
+		AZA_LOG_TRACE("choosing azaBufferMixMatrixDiagonal_scalar\n");
+		azaBufferMixMatrixDiagonal_specialized = azaBufferMixMatrixDiagonal_scalar;
+	}
+	azaBufferMixMatrixDiagonal_specialized(dst, volumeDst, src, gains);
+}
+
+
+
+// AZA_CHANNEL_MATRIX_PERMUTATION and AZA_CHANNEL_MATRIX_SPARSE
+
+
+
+// Only visits the nonzero entries. Every output may take from any input, so there's nothing to vectorize, but this is still far cheaper than the dense multiply for the matrices that get here.
+static void azaBufferMixMatrixSparse(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc, azaChannelMatrix *matrix) {
+	const uint8_t channels = dst->channelLayout.count;
+	const uint16_t entryCount = matrix->entryCount;
+	const azaChannelMatrixEntry *entries = matrix->entries;
+	float *gains = (float*)alloca(entryCount * sizeof(float));
+	for (uint16_t e = 0; e < entryCount; e++) {
+		gains[e] = volumeSrc * entries[e].gain;
+	}
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		float *srcFrame = src->pSamples + i * src->stride;
+		if (volumeDst != 1.0f) {
+			for (uint8_t c = 0; c < channels; c++) {
+				dstFrame[c] *= volumeDst;
+			}
+		}
+		for (uint16_t e = 0; e < entryCount; e++) {
+			dstFrame[entries[e].output] += srcFrame[entries[e].input] * gains[e];
+		}
+	}
+}
+
+
+
 // Specialization dispatch
 
+
+
 void azaBufferMixMatrix(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc, azaChannelMatrix *matrix) {
 	assert(matrix);
 	assert(matrix->inputs == src->channelLayout.count);
 	assert(matrix->outputs == dst->channelLayout.count);
 	assert(dst->frames == src->frames);
-	if AZA_UNLIKELY(volumeDst == 1.0f && volumeSrc == 0.0f) {
+	if (matrix->kind == AZA_CHANNEL_MATRIX_IDENTITY) {
+		azaBufferMix(dst, volumeDst, src, volumeSrc);
+		return;
+	}
+	if (matrix->kind != AZA_CHANNEL_MATRIX_DENSE && matrix->entryCount == 0) {
+		volumeSrc = 0.0f;
+	}
+	if (volumeDst == 1.0f && (volumeSrc == 0.0f || src->silent)) {
 		return;
-	} else if AZA_UNLIKELY(volumeDst == 0.0f && volumeSrc == 0.0f) {
+	}
+	azaBufferMixSilence(dst, volumeDst != 0.0f, src, volumeSrc != 0.0f);
+	if AZA_UNLIKELY(volumeDst == 0.0f && volumeSrc == 0.0f) {
 		azaBufferZero(dst);
-	} else {
-		azaBufferMixMatrix_general(dst, volumeDst, src, volumeSrc, matrix);
+		return;
 	}
-}
\ No newline at end of file
+	switch (matrix->kind) {
+		case AZA_CHANNEL_MATRIX_DIAGONAL: {
+			float gains[AZA_MAX_CHANNEL_POSITIONS];
+			for (uint8_t c = 0; c < matrix->outputs; c++) {
+				gains[c] = volumeSrc * matrix->matrix[c * matrix->outputs + c];
+			}
+			azaBufferMixMatrixDiagonal_specialized(dst, volumeDst, src, gains);
+		} break;
+		case AZA_CHANNEL_MATRIX_PERMUTATION:
+		case AZA_CHANNEL_MATRIX_SPARSE:
+			azaBufferMixMatrixSparse(dst, volumeDst, src, volumeSrc, matrix);
+			break;
+		default:
+			if (dst->stride == dst->channelLayout.count) {
+				azaBufferMixMatrix_general(dst, volumeDst, src, volumeSrc, matrix);
+			} else {
+				// azaBufferMixMatrix_avx_fma walks dst as though it's contiguous
+				azaBufferMixMatrix_scalar(dst, volumeDst, src, volumeSrc, matrix);
+			}
+			break;
+	}
+}
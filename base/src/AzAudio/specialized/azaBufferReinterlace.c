@@ -357,6 +357,7 @@ void azaBufferReinterlace(azaBuffer *dst, azaBuffer *src) {
 	// We don't actually have to worry about src->stride because we just kinda ignore it anyway
 	// assert(src->stride == src->channelLayout.count);
 	assert(dst->channelLayout.count == src->channelLayout.count);
+	dst->silent = src->silent;
 	if (dst->stride == dst->channelLayout.count) {
 		switch (dst->channelLayout.count) {
 			case 0:
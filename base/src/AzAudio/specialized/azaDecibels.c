@@ -0,0 +1,122 @@
+/*
+	File: azaDecibels.c
+	Author: Philip Haynes
+	Specialized implementations of the fast dB conversions over arrays and dispatch.
+	Implements the following (declared in math.h):
+		- aza_amp_to_dbf_array(3)
+		- aza_db_to_ampf_array(3)
+	The vector kernels live in math.h next to the scalar ones, this just walks the arrays with them.
+	The AVX versions need AVX2 for the 256-bit integer ops on the exponent bits.
+*/
+
+#include "../math.h"
+#include "../simd.h"
+#include "../AzAudio.h"
+
+
+
+void aza_amp_to_dbf_array_scalar(float *dst, const float *src, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		dst[i] = aza_amp_to_dbf_fast(src[i]);
+	}
+}
+
+AZA_SIMD_FEATURES("sse2")
+void aza_amp_to_dbf_array_sse(float *dst, const float *src, uint32_t count) {
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(dst + i, aza_amp_to_db_x4_sse(_mm_loadu_ps(src + i)));
+	}
+	if (i < count) {
+		aza_mm_storeu_lanes_ps(dst + i, aza_amp_to_db_x4_sse(aza_mm_loadu_lanes_ps(src + i, count - i)), count - i);
+	}
+}
+
+AZA_SIMD_FEATURES("avx2")
+void aza_amp_to_dbf_array_avx2(float *dst, const float *src, uint32_t count) {
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(dst + i, aza_amp_to_db_x8_avx2(_mm256_loadu_ps(src + i)));
+	}
+	if (i < count) {
+		aza_mm256_storeu_lanes_ps(dst + i, aza_amp_to_db_x8_avx2(aza_mm256_loadu_lanes_ps(src + i, count - i)), count - i);
+	}
+}
+
+void aza_amp_to_dbf_array_dispatch(float *dst, const float *src, uint32_t count);
+void (*aza_amp_to_dbf_array_specialized)(float *dst, const float *src, uint32_t count) = aza_amp_to_dbf_array_dispatch;
+void aza_amp_to_dbf_array_dispatch(float *dst, const float *src, uint32_t count) {
+	assert(azaCPUID.initted);
+	if (AZA_AVX2) {
+		AZA_LOG_TRACE("choosing aza_amp_to_dbf_array_avx2\n");
+		aza_amp_to_dbf_array_specialized = aza_amp_to_dbf_array_avx2;
+	} else
+	if (AZA_SSE2) {
+		AZA_LOG_TRACE("choosing aza_amp_to_dbf_array_sse\n");
+		aza_amp_to_dbf_array_specialized = aza_amp_to_dbf_array_sse;
+	} else
+	{
+		AZA_LOG_TRACE("choosing aza_amp_to_dbf_array_scalar\n");
+		aza_amp_to_dbf_array_specialized = aza_amp_to_dbf_array_scalar;
+	}
+	aza_amp_to_dbf_array_specialized(dst, src, count);
+}
+
+// This only exists for ABI compatibility so we don't export a function pointer that changes
+void aza_amp_to_dbf_array(float *dst, const float *src, uint32_t count) {
+	aza_amp_to_dbf_array_specialized(dst, src, count);
+}
+
+
+
+void aza_db_to_ampf_array_scalar(float *dst, const float *src, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		dst[i] = aza_db_to_ampf_fast(src[i]);
+	}
+}
+
+AZA_SIMD_FEATURES("sse2")
+void aza_db_to_ampf_array_sse(float *dst, const float *src, uint32_t count) {
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(dst + i, aza_db_to_amp_x4_sse(_mm_loadu_ps(src + i)));
+	}
+	if (i < count) {
+		aza_mm_storeu_lanes_ps(dst + i, aza_db_to_amp_x4_sse(aza_mm_loadu_lanes_ps(src + i, count - i)), count - i);
+	}
+}
+
+AZA_SIMD_FEATURES("avx2")
+void aza_db_to_ampf_array_avx2(float *dst, const float *src, uint32_t count) {
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(dst + i, aza_db_to_amp_x8_avx2(_mm256_loadu_ps(src + i)));
+	}
+	if (i < count) {
+		aza_mm256_storeu_lanes_ps(dst + i, aza_db_to_amp_x8_avx2(aza_mm256_loadu_lanes_ps(src + i, count - i)), count - i);
+	}
+}
+
+void aza_db_to_ampf_array_dispatch(float *dst, const float *src, uint32_t count);
+void (*aza_db_to_ampf_array_specialized)(float *dst, const float *src, uint32_t count) = aza_db_to_ampf_array_dispatch;
+void aza_db_to_ampf_array_dispatch(float *dst, const float *src, uint32_t count) {
+	assert(azaCPUID.initted);
+	if (AZA_AVX2) {
+		AZA_LOG_TRACE("choosing aza_db_to_ampf_array_avx2\n");
+		aza_db_to_ampf_array_specialized = aza_db_to_ampf_array_avx2;
+	} else
+	if (AZA_SSE2) {
+		AZA_LOG_TRACE("choosing aza_db_to_ampf_array_sse\n");
+		aza_db_to_ampf_array_specialized = aza_db_to_ampf_array_sse;
+	} else
+	{
+		AZA_LOG_TRACE("choosing aza_db_to_ampf_array_scalar\n");
+		aza_db_to_ampf_array_specialized = aza_db_to_ampf_array_scalar;
+	}
+	aza_db_to_ampf_array_specialized(dst, src, count);
+}
+
+// This only exists for ABI compatibility so we don't export a function pointer that changes
+void aza_db_to_ampf_array(float *dst, const float *src, uint32_t count) {
+	aza_db_to_ampf_array_specialized(dst, src, count);
+}
@@ -0,0 +1,357 @@
+/*
+	File: azaFFT.c
+	Author: Philip Haynes
+	Specialized implementations of the azaFFTPlan transform and dispatch.
+	Non-specialized code still lives in fft.c
+	Implements the following (declared in fft.h):
+		- azaFFTPlanTransform(4)
+		- azaFFTSpectrumMultiplyAccumulate(4)
+*/
+
+#include "../fft.h"
+#include "../simd.h"
+#include "../AzAudio.h"
+
+// All versions do the same passes in-place:
+// 1. Bit-reversal permutation, which is just a table lookup so it doesn't get specialized.
+// 2. If log2n is odd, one radix-2 pass that combines pairs of single points.
+// 3. Radix-4 passes that each combine 4 transforms of size m into one of size 4m.
+//    After bit reversal, the sub-transforms at offsets 0, m, 2m, 3m are of the inputs whose index mod 4 is 0, 2, 1, 3 respectively.
+//    With A, B, C, D being their values at k, and w = e^(-i*tau/4m):
+//    B' = B*w^2k, C' = C*w^k, D' = D*w^3k
+//    t0 = A+B', t1 = A-B', t2 = C'+D', t3 = C'-D'
+//    X[k] = t0+t2, X[k+m] = t1-i*t3, X[k+2m] = t0-t2, X[k+3m] = t1+i*t3
+// This is 3 complex multiplies per 4 points, compared to the 4 that 2 radix-2 passes would use.
+// The vector versions vectorize over k, so passes with m smaller than the vector width fall back to narrower versions.
+
+static void azaFFTBitReverse(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t log2n) {
+	uint32_t n = 1u << log2n;
+	uint32_t shift = plan->log2Len - log2n;
+	for (uint32_t i = 0; i < n; i++) {
+		uint32_t j = plan->bitReverse[i] >> shift;
+		if (i < j) {
+			float tmp;
+			tmp = valReal[i]; valReal[i] = valReal[j]; valReal[j] = tmp;
+			tmp = valImag[i]; valImag[i] = valImag[j]; valImag[j] = tmp;
+		}
+	}
+}
+
+static void azaFFTRadix2Pass(float * restrict valReal, float * restrict valImag, uint32_t n) {
+	for (uint32_t i = 0; i < n; i += 2) {
+		float aR = valReal[i+0], aI = valImag[i+0];
+		float bR = valReal[i+1], bI = valImag[i+1];
+		valReal[i+0] = aR + bR; valImag[i+0] = aI + bI;
+		valReal[i+1] = aR - bR; valImag[i+1] = aI - bI;
+	}
+}
+
+static void azaFFTRadix4Pass_scalar(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t n, uint32_t m) {
+	const float *twiddles = plan->radix4Twiddles + 6*(m-1);
+	for (uint32_t start = 0; start < n; start += 4*m) {
+		float *re = valReal + start;
+		float *im = valImag + start;
+		for (uint32_t k = 0; k < m; k++) {
+			float w1R = twiddles[0*m+k], w1I = twiddles[1*m+k];
+			float w2R = twiddles[2*m+k], w2I = twiddles[3*m+k];
+			float w3R = twiddles[4*m+k], w3I = twiddles[5*m+k];
+			float aR = re[k], aI = im[k];
+			float bR = re[k+m]*w2R - im[k+m]*w2I;
+			float bI = re[k+m]*w2I + im[k+m]*w2R;
+			float cR = re[k+2*m]*w1R - im[k+2*m]*w1I;
+			float cI = re[k+2*m]*w1I + im[k+2*m]*w1R;
+			float dR = re[k+3*m]*w3R - im[k+3*m]*w3I;
+			float dI = re[k+3*m]*w3I + im[k+3*m]*w3R;
+			float t0R = aR + bR, t0I = aI + bI;
+			float t1R = aR - bR, t1I = aI - bI;
+			float t2R = cR + dR, t2I = cI + dI;
+			float t3R = cR - dR, t3I = cI - dI;
+			re[k]     = t0R + t2R; im[k]     = t0I + t2I;
+			re[k+m]   = t1R + t3I; im[k+m]   = t1I - t3R;
+			re[k+2*m] = t0R - t2R; im[k+2*m] = t0I - t2I;
+			re[k+3*m] = t1R - t3I; im[k+3*m] = t1I + t3R;
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("sse")
+static void azaFFTRadix4Pass_sse(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t n, uint32_t m) {
+	assert(m >= 4);
+	const float *twiddles = plan->radix4Twiddles + 6*(m-1);
+	for (uint32_t start = 0; start < n; start += 4*m) {
+		float *re = valReal + start;
+		float *im = valImag + start;
+		for (uint32_t k = 0; k < m; k += 4) {
+			__m128 w1R = _mm_loadu_ps(twiddles + 0*m+k), w1I = _mm_loadu_ps(twiddles + 1*m+k);
+			__m128 w2R = _mm_loadu_ps(twiddles + 2*m+k), w2I = _mm_loadu_ps(twiddles + 3*m+k);
+			__m128 w3R = _mm_loadu_ps(twiddles + 4*m+k), w3I = _mm_loadu_ps(twiddles + 5*m+k);
+			__m128 aR = _mm_loadu_ps(re + k),     aI = _mm_loadu_ps(im + k);
+			__m128 xR = _mm_loadu_ps(re + k+m),   xI = _mm_loadu_ps(im + k+m);
+			__m128 bR = _mm_sub_ps(_mm_mul_ps(xR, w2R), _mm_mul_ps(xI, w2I));
+			__m128 bI = _mm_add_ps(_mm_mul_ps(xR, w2I), _mm_mul_ps(xI, w2R));
+			xR = _mm_loadu_ps(re + k+2*m); xI = _mm_loadu_ps(im + k+2*m);
+			__m128 cR = _mm_sub_ps(_mm_mul_ps(xR, w1R), _mm_mul_ps(xI, w1I));
+			__m128 cI = _mm_add_ps(_mm_mul_ps(xR, w1I), _mm_mul_ps(xI, w1R));
+			xR = _mm_loadu_ps(re + k+3*m); xI = _mm_loadu_ps(im + k+3*m);
+			__m128 dR = _mm_sub_ps(_mm_mul_ps(xR, w3R), _mm_mul_ps(xI, w3I));
+			__m128 dI = _mm_add_ps(_mm_mul_ps(xR, w3I), _mm_mul_ps(xI, w3R));
+			__m128 t0R = _mm_add_ps(aR, bR), t0I = _mm_add_ps(aI, bI);
+			__m128 t1R = _mm_sub_ps(aR, bR), t1I = _mm_sub_ps(aI, bI);
+			__m128 t2R = _mm_add_ps(cR, dR), t2I = _mm_add_ps(cI, dI);
+			__m128 t3R = _mm_sub_ps(cR, dR), t3I = _mm_sub_ps(cI, dI);
+			_mm_storeu_ps(re + k,     _mm_add_ps(t0R, t2R)); _mm_storeu_ps(im + k,     _mm_add_ps(t0I, t2I));
+			_mm_storeu_ps(re + k+m,   _mm_add_ps(t1R, t3I)); _mm_storeu_ps(im + k+m,   _mm_sub_ps(t1I, t3R));
+			_mm_storeu_ps(re + k+2*m, _mm_sub_ps(t0R, t2R)); _mm_storeu_ps(im + k+2*m, _mm_sub_ps(t0I, t2I));
+			_mm_storeu_ps(re + k+3*m, _mm_sub_ps(t1R, t3I)); _mm_storeu_ps(im + k+3*m, _mm_add_ps(t1I, t3R));
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("avx")
+static void azaFFTRadix4Pass_avx(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t n, uint32_t m) {
+	assert(m >= 8);
+	const float *twiddles = plan->radix4Twiddles + 6*(m-1);
+	for (uint32_t start = 0; start < n; start += 4*m) {
+		float *re = valReal + start;
+		float *im = valImag + start;
+		for (uint32_t k = 0; k < m; k += 8) {
+			__m256 w1R = _mm256_loadu_ps(twiddles + 0*m+k), w1I = _mm256_loadu_ps(twiddles + 1*m+k);
+			__m256 w2R = _mm256_loadu_ps(twiddles + 2*m+k), w2I = _mm256_loadu_ps(twiddles + 3*m+k);
+			__m256 w3R = _mm256_loadu_ps(twiddles + 4*m+k), w3I = _mm256_loadu_ps(twiddles + 5*m+k);
+			__m256 aR = _mm256_loadu_ps(re + k),     aI = _mm256_loadu_ps(im + k);
+			__m256 xR = _mm256_loadu_ps(re + k+m),   xI = _mm256_loadu_ps(im + k+m);
+			__m256 bR = _mm256_sub_ps(_mm256_mul_ps(xR, w2R), _mm256_mul_ps(xI, w2I));
+			__m256 bI = _mm256_add_ps(_mm256_mul_ps(xR, w2I), _mm256_mul_ps(xI, w2R));
+			xR = _mm256_loadu_ps(re + k+2*m); xI = _mm256_loadu_ps(im + k+2*m);
+			__m256 cR = _mm256_sub_ps(_mm256_mul_ps(xR, w1R), _mm256_mul_ps(xI, w1I));
+			__m256 cI = _mm256_add_ps(_mm256_mul_ps(xR, w1I), _mm256_mul_ps(xI, w1R));
+			xR = _mm256_loadu_ps(re + k+3*m); xI = _mm256_loadu_ps(im + k+3*m);
+			__m256 dR = _mm256_sub_ps(_mm256_mul_ps(xR, w3R), _mm256_mul_ps(xI, w3I));
+			__m256 dI = _mm256_add_ps(_mm256_mul_ps(xR, w3I), _mm256_mul_ps(xI, w3R));
+			__m256 t0R = _mm256_add_ps(aR, bR), t0I = _mm256_add_ps(aI, bI);
+			__m256 t1R = _mm256_sub_ps(aR, bR), t1I = _mm256_sub_ps(aI, bI);
+			__m256 t2R = _mm256_add_ps(cR, dR), t2I = _mm256_add_ps(cI, dI);
+			__m256 t3R = _mm256_sub_ps(cR, dR), t3I = _mm256_sub_ps(cI, dI);
+			_mm256_storeu_ps(re + k,     _mm256_add_ps(t0R, t2R)); _mm256_storeu_ps(im + k,     _mm256_add_ps(t0I, t2I));
+			_mm256_storeu_ps(re + k+m,   _mm256_add_ps(t1R, t3I)); _mm256_storeu_ps(im + k+m,   _mm256_sub_ps(t1I, t3R));
+			_mm256_storeu_ps(re + k+2*m, _mm256_sub_ps(t0R, t2R)); _mm256_storeu_ps(im + k+2*m, _mm256_sub_ps(t0I, t2I));
+			_mm256_storeu_ps(re + k+3*m, _mm256_sub_ps(t1R, t3I)); _mm256_storeu_ps(im + k+3*m, _mm256_add_ps(t1I, t3R));
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("avx,fma")
+static void azaFFTRadix4Pass_avx_fma(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t n, uint32_t m) {
+	assert(m >= 8);
+	const float *twiddles = plan->radix4Twiddles + 6*(m-1);
+	for (uint32_t start = 0; start < n; start += 4*m) {
+		float *re = valReal + start;
+		float *im = valImag + start;
+		for (uint32_t k = 0; k < m; k += 8) {
+			__m256 w1R = _mm256_loadu_ps(twiddles + 0*m+k), w1I = _mm256_loadu_ps(twiddles + 1*m+k);
+			__m256 w2R = _mm256_loadu_ps(twiddles + 2*m+k), w2I = _mm256_loadu_ps(twiddles + 3*m+k);
+			__m256 w3R = _mm256_loadu_ps(twiddles + 4*m+k), w3I = _mm256_loadu_ps(twiddles + 5*m+k);
+			__m256 aR = _mm256_loadu_ps(re + k),     aI = _mm256_loadu_ps(im + k);
+			__m256 xR = _mm256_loadu_ps(re + k+m),   xI = _mm256_loadu_ps(im + k+m);
+			__m256 bR = _mm256_fmsub_ps(xR, w2R, _mm256_mul_ps(xI, w2I));
+			__m256 bI = _mm256_fmadd_ps(xR, w2I, _mm256_mul_ps(xI, w2R));
+			xR = _mm256_loadu_ps(re + k+2*m); xI = _mm256_loadu_ps(im + k+2*m);
+			__m256 cR = _mm256_fmsub_ps(xR, w1R, _mm256_mul_ps(xI, w1I));
+			__m256 cI = _mm256_fmadd_ps(xR, w1I, _mm256_mul_ps(xI, w1R));
+			xR = _mm256_loadu_ps(re + k+3*m); xI = _mm256_loadu_ps(im + k+3*m);
+			__m256 dR = _mm256_fmsub_ps(xR, w3R, _mm256_mul_ps(xI, w3I));
+			__m256 dI = _mm256_fmadd_ps(xR, w3I, _mm256_mul_ps(xI, w3R));
+			__m256 t0R = _mm256_add_ps(aR, bR), t0I = _mm256_add_ps(aI, bI);
+			__m256 t1R = _mm256_sub_ps(aR, bR), t1I = _mm256_sub_ps(aI, bI);
+			__m256 t2R = _mm256_add_ps(cR, dR), t2I = _mm256_add_ps(cI, dI);
+			__m256 t3R = _mm256_sub_ps(cR, dR), t3I = _mm256_sub_ps(cI, dI);
+			_mm256_storeu_ps(re + k,     _mm256_add_ps(t0R, t2R)); _mm256_storeu_ps(im + k,     _mm256_add_ps(t0I, t2I));
+			_mm256_storeu_ps(re + k+m,   _mm256_add_ps(t1R, t3I)); _mm256_storeu_ps(im + k+m,   _mm256_sub_ps(t1I, t3R));
+			_mm256_storeu_ps(re + k+2*m, _mm256_sub_ps(t0R, t2R)); _mm256_storeu_ps(im + k+2*m, _mm256_sub_ps(t0I, t2I));
+			_mm256_storeu_ps(re + k+3*m, _mm256_sub_ps(t1R, t3I)); _mm256_storeu_ps(im + k+3*m, _mm256_add_ps(t1I, t3R));
+		}
+	}
+}
+
+
+
+void azaFFTPlanTransform_scalar(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t log2n) {
+	uint32_t n = 1u << log2n;
+	azaFFTBitReverse(plan, valReal, valImag, log2n);
+	uint32_t m = 1;
+	if (log2n & 1) {
+		azaFFTRadix2Pass(valReal, valImag, n);
+		m = 2;
+	}
+	for (; m < n; m *= 4) {
+		azaFFTRadix4Pass_scalar(plan, valReal, valImag, n, m);
+	}
+}
+
+AZA_SIMD_FEATURES("sse")
+void azaFFTPlanTransform_sse(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t log2n) {
+	uint32_t n = 1u << log2n;
+	azaFFTBitReverse(plan, valReal, valImag, log2n);
+	uint32_t m = 1;
+	if (log2n & 1) {
+		azaFFTRadix2Pass(valReal, valImag, n);
+		m = 2;
+	}
+	for (; m < n; m *= 4) {
+		if (m >= 4) {
+			azaFFTRadix4Pass_sse(plan, valReal, valImag, n, m);
+		} else {
+			azaFFTRadix4Pass_scalar(plan, valReal, valImag, n, m);
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("avx")
+void azaFFTPlanTransform_avx(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t log2n) {
+	uint32_t n = 1u << log2n;
+	azaFFTBitReverse(plan, valReal, valImag, log2n);
+	uint32_t m = 1;
+	if (log2n & 1) {
+		azaFFTRadix2Pass(valReal, valImag, n);
+		m = 2;
+	}
+	for (; m < n; m *= 4) {
+		if (m >= 8) {
+			azaFFTRadix4Pass_avx(plan, valReal, valImag, n, m);
+		} else if (m >= 4) {
+			azaFFTRadix4Pass_sse(plan, valReal, valImag, n, m);
+		} else {
+			azaFFTRadix4Pass_scalar(plan, valReal, valImag, n, m);
+		}
+	}
+}
+
+AZA_SIMD_FEATURES("avx,fma")
+void azaFFTPlanTransform_avx_fma(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t log2n) {
+	uint32_t n = 1u << log2n;
+	azaFFTBitReverse(plan, valReal, valImag, log2n);
+	uint32_t m = 1;
+	if (log2n & 1) {
+		azaFFTRadix2Pass(valReal, valImag, n);
+		m = 2;
+	}
+	for (; m < n; m *= 4) {
+		if (m >= 8) {
+			azaFFTRadix4Pass_avx_fma(plan, valReal, valImag, n, m);
+		} else if (m >= 4) {
+			azaFFTRadix4Pass_sse(plan, valReal, valImag, n, m);
+		} else {
+			azaFFTRadix4Pass_scalar(plan, valReal, valImag, n, m);
+		}
+	}
+}
+
+void azaFFTPlanTransform_dispatch(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t log2n);
+void (*azaFFTPlanTransform_specialized)(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t log2n) = azaFFTPlanTransform_dispatch;
+void azaFFTPlanTransform_dispatch(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t log2n) {
+	assert(azaCPUID.initted);
+	if (AZA_AVX && AZA_FMA) {
+		AZA_LOG_TRACE("choosing azaFFTPlanTransform_avx_fma\n");
+		azaFFTPlanTransform_specialized = azaFFTPlanTransform_avx_fma;
+	} else
+	if (AZA_AVX) {
+		AZA_LOG_TRACE("choosing azaFFTPlanTransform_avx\n");
+		azaFFTPlanTransform_specialized = azaFFTPlanTransform_avx;
+	} else
+	if (AZA_SSE) {
+		AZA_LOG_TRACE("choosing azaFFTPlanTransform_sse\n");
+		azaFFTPlanTransform_specialized = azaFFTPlanTransform_sse;
+	} else
+	{
+		AZA_LOG_TRACE("choosing azaFFTPlanTransform_scalar\n");
+		azaFFTPlanTransform_specialized = azaFFTPlanTransform_scalar;
+	}
+	azaFFTPlanTransform_specialized(plan, valReal, valImag, log2n);
+}
+
+// This only exists for ABI compatibility so we don't export a function pointer that changes
+void azaFFTPlanTransform(azaFFTPlan *plan, float * restrict valReal, float * restrict valImag, uint32_t log2n) {
+	assert(log2n <= plan->log2Len);
+	azaFFTPlanTransform_specialized(plan, valReal, valImag, log2n);
+}
+
+
+
+void azaFFTSpectrumMultiplyAccumulate_scalar(float * restrict accReal, float * restrict accImag, const float *aReal, const float *aImag, const float *bReal, const float *bImag, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		accReal[i] += aReal[i]*bReal[i] - aImag[i]*bImag[i];
+		accImag[i] += aReal[i]*bImag[i] + aImag[i]*bReal[i];
+	}
+}
+
+AZA_SIMD_FEATURES("sse")
+void azaFFTSpectrumMultiplyAccumulate_sse(float * restrict accReal, float * restrict accImag, const float *aReal, const float *aImag, const float *bReal, const float *bImag, uint32_t count) {
+	uint32_t i = 0;
+	for (; i+4 <= count; i += 4) {
+		__m128 aR = _mm_loadu_ps(aReal + i), aI = _mm_loadu_ps(aImag + i);
+		__m128 bR = _mm_loadu_ps(bReal + i), bI = _mm_loadu_ps(bImag + i);
+		__m128 real = _mm_sub_ps(_mm_mul_ps(aR, bR), _mm_mul_ps(aI, bI));
+		__m128 imag = _mm_add_ps(_mm_mul_ps(aR, bI), _mm_mul_ps(aI, bR));
+		_mm_storeu_ps(accReal + i, _mm_add_ps(_mm_loadu_ps(accReal + i), real));
+		_mm_storeu_ps(accImag + i, _mm_add_ps(_mm_loadu_ps(accImag + i), imag));
+	}
+	azaFFTSpectrumMultiplyAccumulate_scalar(accReal + i, accImag + i, aReal + i, aImag + i, bReal + i, bImag + i, count - i);
+}
+
+AZA_SIMD_FEATURES("avx")
+void azaFFTSpectrumMultiplyAccumulate_avx(float * restrict accReal, float * restrict accImag, const float *aReal, const float *aImag, const float *bReal, const float *bImag, uint32_t count) {
+	uint32_t i = 0;
+	for (; i+8 <= count; i += 8) {
+		__m256 aR = _mm256_loadu_ps(aReal + i), aI = _mm256_loadu_ps(aImag + i);
+		__m256 bR = _mm256_loadu_ps(bReal + i), bI = _mm256_loadu_ps(bImag + i);
+		__m256 real = _mm256_sub_ps(_mm256_mul_ps(aR, bR), _mm256_mul_ps(aI, bI));
+		__m256 imag = _mm256_add_ps(_mm256_mul_ps(aR, bI), _mm256_mul_ps(aI, bR));
+		_mm256_storeu_ps(accReal + i, _mm256_add_ps(_mm256_loadu_ps(accReal + i), real));
+		_mm256_storeu_ps(accImag + i, _mm256_add_ps(_mm256_loadu_ps(accImag + i), imag));
+	}
+	azaFFTSpectrumMultiplyAccumulate_scalar(accReal + i, accImag + i, aReal + i, aImag + i, bReal + i, bImag + i, count - i);
+}
+
+AZA_SIMD_FEATURES("avx,fma")
+void azaFFTSpectrumMultiplyAccumulate_avx_fma(float * restrict accReal, float * restrict accImag, const float *aReal, const float *aImag, const float *bReal, const float *bImag, uint32_t count) {
+	uint32_t i = 0;
+	for (; i+8 <= count; i += 8) {
+		__m256 aR = _mm256_loadu_ps(aReal + i), aI = _mm256_loadu_ps(aImag + i);
+		__m256 bR = _mm256_loadu_ps(bReal + i), bI = _mm256_loadu_ps(bImag + i);
+		__m256 real = _mm256_fmadd_ps(aR, bR, _mm256_loadu_ps(accReal + i));
+		__m256 imag = _mm256_fmadd_ps(aR, bI, _mm256_loadu_ps(accImag + i));
+		real = _mm256_fnmadd_ps(aI, bI, real);
+		imag = _mm256_fmadd_ps(aI, bR, imag);
+		_mm256_storeu_ps(accReal + i, real);
+		_mm256_storeu_ps(accImag + i, imag);
+	}
+	azaFFTSpectrumMultiplyAccumulate_scalar(accReal + i, accImag + i, aReal + i, aImag + i, bReal + i, bImag + i, count - i);
+}
+
+void azaFFTSpectrumMultiplyAccumulate_dispatch(float * restrict accReal, float * restrict accImag, const float *aReal, const float *aImag, const float *bReal, const float *bImag, uint32_t count);
+void (*azaFFTSpectrumMultiplyAccumulate_specialized)(float * restrict accReal, float * restrict accImag, const float *aReal, const float *aImag, const float *bReal, const float *bImag, uint32_t count) = azaFFTSpectrumMultiplyAccumulate_dispatch;
+void azaFFTSpectrumMultiplyAccumulate_dispatch(float * restrict accReal, float * restrict accImag, const float *aReal, const float *aImag, const float *bReal, const float *bImag, uint32_t count) {
+	assert(azaCPUID.initted);
+	if (AZA_AVX && AZA_FMA) {
+		AZA_LOG_TRACE("choosing azaFFTSpectrumMultiplyAccumulate_avx_fma\n");
+		azaFFTSpectrumMultiplyAccumulate_specialized = azaFFTSpectrumMultiplyAccumulate_avx_fma;
+	} else
+	if (AZA_AVX) {
+		AZA_LOG_TRACE("choosing azaFFTSpectrumMultiplyAccumulate_avx\n");
+		azaFFTSpectrumMultiplyAccumulate_specialized = azaFFTSpectrumMultiplyAccumulate_avx;
+	} else
+	if (AZA_SSE) {
+		AZA_LOG_TRACE("choosing azaFFTSpectrumMultiplyAccumulate_sse\n");
+		azaFFTSpectrumMultiplyAccumulate_specialized = azaFFTSpectrumMultiplyAccumulate_sse;
+	} else
+	{
+		AZA_LOG_TRACE("choosing azaFFTSpectrumMultiplyAccumulate_scalar\n");
+		azaFFTSpectrumMultiplyAccumulate_specialized = azaFFTSpectrumMultiplyAccumulate_scalar;
+	}
+	azaFFTSpectrumMultiplyAccumulate_specialized(accReal, accImag, aReal, aImag, bReal, bImag, count);
+}
+
+// This only exists for ABI compatibility so we don't export a function pointer that changes
+void azaFFTSpectrumMultiplyAccumulate(float * restrict accReal, float * restrict accImag, const float *aReal, const float *aImag, const float *bReal, const float *bImag, uint32_t count) {
+	azaFFTSpectrumMultiplyAccumulate_specialized(accReal, accImag, aReal, aImag, bReal, bImag, count);
+}
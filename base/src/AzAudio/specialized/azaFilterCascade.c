@@ -0,0 +1,381 @@
+/*
+	File: azaFilterCascade.c
+	Author: Philip Haynes
+	Specialized implementations of the azaFilter cascade and dispatch.
+	Non-specialized code still lives in azaFilter.c
+	Implements the following (declared in azaFilter.h):
+		- azaFilterProcessCascade(5)
+	The vector versions run a group of channels side by side in vector lanes, which is why azaFilter keeps its state and coefficients interleaved by channel.
+	Every version runs each frame through all the stages before moving on to the next frame. Each stage only depends on its own state from the last frame, so the CPU can overlap the stages of consecutive frames, whereas running one stage over many frames at a time would leave us waiting on that stage's feedback every frame.
+	While the cutoff ramps, every coefficient moves by its step each frame, starting from channels - steps*frames so the last frame lands on channels. When it isn't ramping the steps are all 0, which leaves the coefficients exactly where they are.
+*/
+
+#include "../dsp/plugins/azaFilter.h"
+#include "../simd.h"
+#include "../AzAudio.h"
+
+// How many rows of data->state the stages use
+static inline uint32_t azaFilterGetStateRows(const azaFilterCoefficients *coefficients) {
+	return coefficients->topology == AZA_FILTER_TOPOLOGY_SVF ? 2 * coefficients->stageCount : coefficients->stageCount;
+}
+
+
+
+static void azaFilterProcessCascadeChannel_scalar(azaFilter *data, azaBuffer *dst, azaBuffer *src, uint8_t channel, float amountWet, float amountDry) {
+	const azaFilterCoefficients *coefficients = &data->coefficients;
+	const uint32_t stageCount = coefficients->stageCount;
+	const uint32_t stateRows = azaFilterGetStateRows(coefficients);
+	// Local copies can't alias dst or src, so they can stay in registers
+	float state[AZAUDIO_FILTER_MAX_STAGES];
+	for (uint32_t i = 0; i < stateRows; i++) {
+		state[i] = data->state[i][channel];
+	}
+	const float frames = (float)dst->frames;
+	const float *srcSamples = src->pSamples + channel;
+	float *dstSamples = dst->pSamples + channel;
+	if (coefficients->topology == AZA_FILTER_TOPOLOGY_SVF) {
+		float a1[AZAUDIO_FILTER_MAX_POLES], a2[AZAUDIO_FILTER_MAX_POLES], a3[AZAUDIO_FILTER_MAX_POLES];
+		float a1Step[AZAUDIO_FILTER_MAX_POLES], a2Step[AZAUDIO_FILTER_MAX_POLES], a3Step[AZAUDIO_FILTER_MAX_POLES];
+		for (uint32_t s = 0; s < stageCount; s++) {
+			uint32_t row = coefficients->stages[s].row;
+			a1Step[s] = coefficients->steps[row+0][channel];
+			a2Step[s] = coefficients->steps[row+1][channel];
+			a3Step[s] = coefficients->steps[row+2][channel];
+			a1[s] = coefficients->channels[row+0][channel] - a1Step[s] * frames;
+			a2[s] = coefficients->channels[row+1][channel] - a2Step[s] * frames;
+			a3[s] = coefficients->channels[row+2][channel] - a3Step[s] * frames;
+		}
+		for (uint32_t i = 0; i < dst->frames; i++) {
+			float sample = srcSamples[i * src->stride];
+			float x = sample;
+			for (uint32_t s = 0; s < stageCount; s++) {
+				const float *mix = coefficients->stages[s].mix;
+				a1[s] += a1Step[s];
+				a2[s] += a2Step[s];
+				a3[s] += a3Step[s];
+				float ic1 = state[2*s+0];
+				float ic2 = state[2*s+1];
+				float v3 = x - ic2;
+				float v1 = a1[s] * ic1 + a2[s] * v3;
+				float v2 = ic2 + a2[s] * ic1 + a3[s] * v3;
+				state[2*s+0] = 2.0f * v1 - ic1;
+				state[2*s+1] = 2.0f * v2 - ic2;
+				x = mix[0] * x + mix[1] * v1 + mix[2] * v2;
+			}
+			dstSamples[i * dst->stride] = x * amountWet + sample * amountDry;
+		}
+	} else {
+		const float decayStep = coefficients->steps[0][channel];
+		float decay = coefficients->channels[0][channel] - decayStep * frames;
+		switch (coefficients->kind) {
+			case AZA_FILTER_HIGH_PASS: {
+				for (uint32_t i = 0; i < dst->frames; i++) {
+					float sample = srcSamples[i * src->stride];
+					float x = sample;
+					decay += decayStep;
+					for (uint32_t s = 0; s < stageCount; s++) {
+						state[s] = x + decay * (state[s] - x);
+						x -= state[s];
+					}
+					dstSamples[i * dst->stride] = x * amountWet + sample * amountDry;
+				}
+			} break;
+			case AZA_FILTER_LOW_PASS: {
+				for (uint32_t i = 0; i < dst->frames; i++) {
+					float sample = srcSamples[i * src->stride];
+					float x = sample;
+					decay += decayStep;
+					for (uint32_t s = 0; s < stageCount; s++) {
+						state[s] = x + decay * (state[s] - x);
+						x = state[s];
+					}
+					dstSamples[i * dst->stride] = x * amountWet + sample * amountDry;
+				}
+			} break;
+			case AZA_FILTER_BAND_PASS: {
+				for (uint32_t i = 0; i < dst->frames; i++) {
+					float sample = srcSamples[i * src->stride];
+					float x = sample;
+					decay += decayStep;
+					for (uint32_t s = 0; s < stageCount; s += 2) {
+						state[s+0] = x + decay * (state[s+0] - x);
+						x = state[s+0];
+						state[s+1] = x + decay * (state[s+1] - x);
+						x = (x - state[s+1]) * 2.0f;
+					}
+					dstSamples[i * dst->stride] = x * amountWet + sample * amountDry;
+				}
+			} break;
+			case AZA_FILTER_KIND_COUNT: break;
+		}
+	}
+	for (uint32_t i = 0; i < stateRows; i++) {
+		data->state[i][channel] = state[i];
+	}
+}
+
+void azaFilterProcessCascade_scalar(azaFilter *data, azaBuffer *dst, azaBuffer *src, float amountWet, float amountDry) {
+	for (uint8_t c = 0; c < dst->channelLayout.count; c++) {
+		azaFilterProcessCascadeChannel_scalar(data, dst, src, c, amountWet, amountDry);
+	}
+}
+
+// Does up to 4 channels starting at firstChannel in the lanes of one vector. Lanes past the end start out as zeroes, and only ever produce zeroes.
+AZA_SIMD_FEATURES("sse2")
+static void azaFilterProcessCascadeGroup_sse(azaFilter *data, azaBuffer *dst, azaBuffer *src, uint8_t firstChannel, uint8_t lanes, float amountWet, float amountDry) {
+	const azaFilterCoefficients *coefficients = &data->coefficients;
+	const uint32_t stageCount = coefficients->stageCount;
+	const uint32_t stateRows = azaFilterGetStateRows(coefficients);
+	const __m128 wet = _mm_set1_ps(amountWet);
+	const __m128 dry = _mm_set1_ps(amountDry);
+	const __m128 frames = _mm_set1_ps((float)dst->frames);
+	// Local copies can't alias dst or src, so they can stay in registers
+	__m128 state[AZAUDIO_FILTER_MAX_STAGES];
+	for (uint32_t i = 0; i < stateRows; i++) {
+		state[i] = _mm_loadu_ps(data->state[i] + firstChannel);
+	}
+	const float *srcSamples = src->pSamples + firstChannel;
+	float *dstSamples = dst->pSamples + firstChannel;
+	if (coefficients->topology == AZA_FILTER_TOPOLOGY_SVF) {
+		const __m128 two = _mm_set1_ps(2.0f);
+		__m128 a1[AZAUDIO_FILTER_MAX_POLES], a2[AZAUDIO_FILTER_MAX_POLES], a3[AZAUDIO_FILTER_MAX_POLES];
+		__m128 a1Step[AZAUDIO_FILTER_MAX_POLES], a2Step[AZAUDIO_FILTER_MAX_POLES], a3Step[AZAUDIO_FILTER_MAX_POLES];
+		__m128 mix[AZAUDIO_FILTER_MAX_POLES][3];
+		for (uint32_t s = 0; s < stageCount; s++) {
+			const azaFilterStage *stage = &coefficients->stages[s];
+			a1Step[s] = _mm_loadu_ps(coefficients->steps[stage->row+0] + firstChannel);
+			a2Step[s] = _mm_loadu_ps(coefficients->steps[stage->row+1] + firstChannel);
+			a3Step[s] = _mm_loadu_ps(coefficients->steps[stage->row+2] + firstChannel);
+			a1[s] = _mm_sub_ps(_mm_loadu_ps(coefficients->channels[stage->row+0] + firstChannel), _mm_mul_ps(a1Step[s], frames));
+			a2[s] = _mm_sub_ps(_mm_loadu_ps(coefficients->channels[stage->row+1] + firstChannel), _mm_mul_ps(a2Step[s], frames));
+			a3[s] = _mm_sub_ps(_mm_loadu_ps(coefficients->channels[stage->row+2] + firstChannel), _mm_mul_ps(a3Step[s], frames));
+			for (uint32_t j = 0; j < 3; j++) {
+				mix[s][j] = _mm_set1_ps(stage->mix[j]);
+			}
+		}
+		for (uint32_t i = 0; i < dst->frames; i++) {
+			__m128 sample = aza_mm_loadu_lanes_ps(srcSamples + i * src->stride, lanes);
+			__m128 x = sample;
+			for (uint32_t s = 0; s < stageCount; s++) {
+				a1[s] = _mm_add_ps(a1[s], a1Step[s]);
+				a2[s] = _mm_add_ps(a2[s], a2Step[s]);
+				a3[s] = _mm_add_ps(a3[s], a3Step[s]);
+				__m128 ic1 = state[2*s+0];
+				__m128 ic2 = state[2*s+1];
+				__m128 v3 = _mm_sub_ps(x, ic2);
+				__m128 v1 = _mm_add_ps(_mm_mul_ps(a1[s], ic1), _mm_mul_ps(a2[s], v3));
+				__m128 v2 = _mm_add_ps(_mm_add_ps(ic2, _mm_mul_ps(a2[s], ic1)), _mm_mul_ps(a3[s], v3));
+				state[2*s+0] = _mm_sub_ps(_mm_mul_ps(two, v1), ic1);
+				state[2*s+1] = _mm_sub_ps(_mm_mul_ps(two, v2), ic2);
+				x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(mix[s][0], x), _mm_mul_ps(mix[s][1], v1)), _mm_mul_ps(mix[s][2], v2));
+			}
+			aza_mm_storeu_lanes_ps(dstSamples + i * dst->stride, _mm_add_ps(_mm_mul_ps(x, wet), _mm_mul_ps(sample, dry)), lanes);
+		}
+	} else {
+		const __m128 decayStep = _mm_loadu_ps(coefficients->steps[0] + firstChannel);
+		__m128 decay = _mm_sub_ps(_mm_loadu_ps(coefficients->channels[0] + firstChannel), _mm_mul_ps(decayStep, frames));
+		switch (coefficients->kind) {
+			case AZA_FILTER_HIGH_PASS: {
+				for (uint32_t i = 0; i < dst->frames; i++) {
+					__m128 sample = aza_mm_loadu_lanes_ps(srcSamples + i * src->stride, lanes);
+					__m128 x = sample;
+					decay = _mm_add_ps(decay, decayStep);
+					for (uint32_t s = 0; s < stageCount; s++) {
+						state[s] = _mm_add_ps(x, _mm_mul_ps(decay, _mm_sub_ps(state[s], x)));
+						x = _mm_sub_ps(x, state[s]);
+					}
+					aza_mm_storeu_lanes_ps(dstSamples + i * dst->stride, _mm_add_ps(_mm_mul_ps(x, wet), _mm_mul_ps(sample, dry)), lanes);
+				}
+			} break;
+			case AZA_FILTER_LOW_PASS: {
+				for (uint32_t i = 0; i < dst->frames; i++) {
+					__m128 sample = aza_mm_loadu_lanes_ps(srcSamples + i * src->stride, lanes);
+					__m128 x = sample;
+					decay = _mm_add_ps(decay, decayStep);
+					for (uint32_t s = 0; s < stageCount; s++) {
+						state[s] = _mm_add_ps(x, _mm_mul_ps(decay, _mm_sub_ps(state[s], x)));
+						x = state[s];
+					}
+					aza_mm_storeu_lanes_ps(dstSamples + i * dst->stride, _mm_add_ps(_mm_mul_ps(x, wet), _mm_mul_ps(sample, dry)), lanes);
+				}
+			} break;
+			case AZA_FILTER_BAND_PASS: {
+				const __m128 two = _mm_set1_ps(2.0f);
+				for (uint32_t i = 0; i < dst->frames; i++) {
+					__m128 sample = aza_mm_loadu_lanes_ps(srcSamples + i * src->stride, lanes);
+					__m128 x = sample;
+					decay = _mm_add_ps(decay, decayStep);
+					for (uint32_t s = 0; s < stageCount; s += 2) {
+						state[s+0] = _mm_add_ps(x, _mm_mul_ps(decay, _mm_sub_ps(state[s+0], x)));
+						x = state[s+0];
+						state[s+1] = _mm_add_ps(x, _mm_mul_ps(decay, _mm_sub_ps(state[s+1], x)));
+						x = _mm_mul_ps(_mm_sub_ps(x, state[s+1]), two);
+					}
+					aza_mm_storeu_lanes_ps(dstSamples + i * dst->stride, _mm_add_ps(_mm_mul_ps(x, wet), _mm_mul_ps(sample, dry)), lanes);
+				}
+			} break;
+			case AZA_FILTER_KIND_COUNT: break;
+		}
+	}
+	for (uint32_t i = 0; i < stateRows; i++) {
+		_mm_storeu_ps(data->state[i] + firstChannel, state[i]);
+	}
+}
+
+AZA_SIMD_FEATURES("sse2")
+void azaFilterProcessCascade_sse(azaFilter *data, azaBuffer *dst, azaBuffer *src, float amountWet, float amountDry) {
+	const uint8_t channels = dst->channelLayout.count;
+	uint8_t c = 0;
+	for (; c + 4 <= channels; c += 4) {
+		azaFilterProcessCascadeGroup_sse(data, dst, src, c, 4, amountWet, amountDry);
+	}
+	// A lone channel is no faster in a vector
+	if (c + 1 < channels) {
+		azaFilterProcessCascadeGroup_sse(data, dst, src, c, channels - c, amountWet, amountDry);
+	} else if (c < channels) {
+		azaFilterProcessCascadeChannel_scalar(data, dst, src, c, amountWet, amountDry);
+	}
+}
+
+// Does up to 8 channels starting at firstChannel in the lanes of one vector. Lanes past the end start out as zeroes, and only ever produce zeroes.
+AZA_SIMD_FEATURES("avx")
+static void azaFilterProcessCascadeGroup_avx(azaFilter *data, azaBuffer *dst, azaBuffer *src, uint8_t firstChannel, uint8_t lanes, float amountWet, float amountDry) {
+	const azaFilterCoefficients *coefficients = &data->coefficients;
+	const uint32_t stageCount = coefficients->stageCount;
+	const uint32_t stateRows = azaFilterGetStateRows(coefficients);
+	const __m256 wet = _mm256_set1_ps(amountWet);
+	const __m256 dry = _mm256_set1_ps(amountDry);
+	const __m256 frames = _mm256_set1_ps((float)dst->frames);
+	// Local copies can't alias dst or src, so they can stay in registers
+	__m256 state[AZAUDIO_FILTER_MAX_STAGES];
+	for (uint32_t i = 0; i < stateRows; i++) {
+		state[i] = _mm256_loadu_ps(data->state[i] + firstChannel);
+	}
+	const float *srcSamples = src->pSamples + firstChannel;
+	float *dstSamples = dst->pSamples + firstChannel;
+	if (coefficients->topology == AZA_FILTER_TOPOLOGY_SVF) {
+		const __m256 two = _mm256_set1_ps(2.0f);
+		__m256 a1[AZAUDIO_FILTER_MAX_POLES], a2[AZAUDIO_FILTER_MAX_POLES], a3[AZAUDIO_FILTER_MAX_POLES];
+		__m256 a1Step[AZAUDIO_FILTER_MAX_POLES], a2Step[AZAUDIO_FILTER_MAX_POLES], a3Step[AZAUDIO_FILTER_MAX_POLES];
+		__m256 mix[AZAUDIO_FILTER_MAX_POLES][3];
+		for (uint32_t s = 0; s < stageCount; s++) {
+			const azaFilterStage *stage = &coefficients->stages[s];
+			a1Step[s] = _mm256_loadu_ps(coefficients->steps[stage->row+0] + firstChannel);
+			a2Step[s] = _mm256_loadu_ps(coefficients->steps[stage->row+1] + firstChannel);
+			a3Step[s] = _mm256_loadu_ps(coefficients->steps[stage->row+2] + firstChannel);
+			a1[s] = _mm256_sub_ps(_mm256_loadu_ps(coefficients->channels[stage->row+0] + firstChannel), _mm256_mul_ps(a1Step[s], frames));
+			a2[s] = _mm256_sub_ps(_mm256_loadu_ps(coefficients->channels[stage->row+1] + firstChannel), _mm256_mul_ps(a2Step[s], frames));
+			a3[s] = _mm256_sub_ps(_mm256_loadu_ps(coefficients->channels[stage->row+2] + firstChannel), _mm256_mul_ps(a3Step[s], frames));
+			for (uint32_t j = 0; j < 3; j++) {
+				mix[s][j] = _mm256_set1_ps(stage->mix[j]);
+			}
+		}
+		for (uint32_t i = 0; i < dst->frames; i++) {
+			__m256 sample = aza_mm256_loadu_lanes_ps(srcSamples + i * src->stride, lanes);
+			__m256 x = sample;
+			for (uint32_t s = 0; s < stageCount; s++) {
+				a1[s] = _mm256_add_ps(a1[s], a1Step[s]);
+				a2[s] = _mm256_add_ps(a2[s], a2Step[s]);
+				a3[s] = _mm256_add_ps(a3[s], a3Step[s]);
+				__m256 ic1 = state[2*s+0];
+				__m256 ic2 = state[2*s+1];
+				__m256 v3 = _mm256_sub_ps(x, ic2);
+				__m256 v1 = _mm256_add_ps(_mm256_mul_ps(a1[s], ic1), _mm256_mul_ps(a2[s], v3));
+				__m256 v2 = _mm256_add_ps(_mm256_add_ps(ic2, _mm256_mul_ps(a2[s], ic1)), _mm256_mul_ps(a3[s], v3));
+				state[2*s+0] = _mm256_sub_ps(_mm256_mul_ps(two, v1), ic1);
+				state[2*s+1] = _mm256_sub_ps(_mm256_mul_ps(two, v2), ic2);
+				x = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(mix[s][0], x), _mm256_mul_ps(mix[s][1], v1)), _mm256_mul_ps(mix[s][2], v2));
+			}
+			aza_mm256_storeu_lanes_ps(dstSamples + i * dst->stride, _mm256_add_ps(_mm256_mul_ps(x, wet), _mm256_mul_ps(sample, dry)), lanes);
+		}
+	} else {
+		const __m256 decayStep = _mm256_loadu_ps(coefficients->steps[0] + firstChannel);
+		__m256 decay = _mm256_sub_ps(_mm256_loadu_ps(coefficients->channels[0] + firstChannel), _mm256_mul_ps(decayStep, frames));
+		switch (coefficients->kind) {
+			case AZA_FILTER_HIGH_PASS: {
+				for (uint32_t i = 0; i < dst->frames; i++) {
+					__m256 sample = aza_mm256_loadu_lanes_ps(srcSamples + i * src->stride, lanes);
+					__m256 x = sample;
+					decay = _mm256_add_ps(decay, decayStep);
+					for (uint32_t s = 0; s < stageCount; s++) {
+						state[s] = _mm256_add_ps(x, _mm256_mul_ps(decay, _mm256_sub_ps(state[s], x)));
+						x = _mm256_sub_ps(x, state[s]);
+					}
+					aza_mm256_storeu_lanes_ps(dstSamples + i * dst->stride, _mm256_add_ps(_mm256_mul_ps(x, wet), _mm256_mul_ps(sample, dry)), lanes);
+				}
+			} break;
+			case AZA_FILTER_LOW_PASS: {
+				for (uint32_t i = 0; i < dst->frames; i++) {
+					__m256 sample = aza_mm256_loadu_lanes_ps(srcSamples + i * src->stride, lanes);
+					__m256 x = sample;
+					decay = _mm256_add_ps(decay, decayStep);
+					for (uint32_t s = 0; s < stageCount; s++) {
+						state[s] = _mm256_add_ps(x, _mm256_mul_ps(decay, _mm256_sub_ps(state[s], x)));
+						x = state[s];
+					}
+					aza_mm256_storeu_lanes_ps(dstSamples + i * dst->stride, _mm256_add_ps(_mm256_mul_ps(x, wet), _mm256_mul_ps(sample, dry)), lanes);
+				}
+			} break;
+			case AZA_FILTER_BAND_PASS: {
+				const __m256 two = _mm256_set1_ps(2.0f);
+				for (uint32_t i = 0; i < dst->frames; i++) {
+					__m256 sample = aza_mm256_loadu_lanes_ps(srcSamples + i * src->stride, lanes);
+					__m256 x = sample;
+					decay = _mm256_add_ps(decay, decayStep);
+					for (uint32_t s = 0; s < stageCount; s += 2) {
+						state[s+0] = _mm256_add_ps(x, _mm256_mul_ps(decay, _mm256_sub_ps(state[s+0], x)));
+						x = state[s+0];
+						state[s+1] = _mm256_add_ps(x, _mm256_mul_ps(decay, _mm256_sub_ps(state[s+1], x)));
+						x = _mm256_mul_ps(_mm256_sub_ps(x, state[s+1]), two);
+					}
+					aza_mm256_storeu_lanes_ps(dstSamples + i * dst->stride, _mm256_add_ps(_mm256_mul_ps(x, wet), _mm256_mul_ps(sample, dry)), lanes);
+				}
+			} break;
+			case AZA_FILTER_KIND_COUNT: break;
+		}
+	}
+	for (uint32_t i = 0; i < stateRows; i++) {
+		_mm256_storeu_ps(data->state[i] + firstChannel, state[i]);
+	}
+}
+
+AZA_SIMD_FEATURES("avx")
+void azaFilterProcessCascade_avx(azaFilter *data, azaBuffer *dst, azaBuffer *src, float amountWet, float amountDry) {
+	const uint8_t channels = dst->channelLayout.count;
+	uint8_t c = 0;
+	for (; c + 8 <= channels; c += 8) {
+		azaFilterProcessCascadeGroup_avx(data, dst, src, c, 8, amountWet, amountDry);
+	}
+	// With 4 or fewer left, half a vector does the same work for less, and a lone channel is no faster in a vector.
+	if (c + 4 < channels) {
+		azaFilterProcessCascadeGroup_avx(data, dst, src, c, channels - c, amountWet, amountDry);
+	} else if (c + 1 < channels) {
+		azaFilterProcessCascadeGroup_sse(data, dst, src, c, channels - c, amountWet, amountDry);
+	} else if (c < channels) {
+		azaFilterProcessCascadeChannel_scalar(data, dst, src, c, amountWet, amountDry);
+	}
+}
+
+void azaFilterProcessCascade_dispatch(azaFilter *data, azaBuffer *dst, azaBuffer *src, float amountWet, float amountDry);
+void (*azaFilterProcessCascade_specialized)(azaFilter *data, azaBuffer *dst, azaBuffer *src, float amountWet, float amountDry) = azaFilterProcessCascade_dispatch;
+void azaFilterProcessCascade_dispatch(azaFilter *data, azaBuffer *dst, azaBuffer *src, float amountWet, float amountDry) {
+	assert(azaCPUID.initted);
+	if (AZA_AVX) {
+		AZA_LOG_TRACE("choosing azaFilterProcessCascade_avx\n");
+		azaFilterProcessCascade_specialized = azaFilterProcessCascade_avx;
+	} else
+	if (AZA_SSE2) {
+		AZA_LOG_TRACE("choosing azaFilterProcessCascade_sse\n");
+		azaFilterProcessCascade_specialized = azaFilterProcessCascade_sse;
+	} else
+	{
+		AZA_LOG_TRACE("choosing azaFilterProcessCascade_scalar\n");
+		azaFilterProcessCascade_specialized = azaFilterProcessCascade_scalar;
+	}
+	azaFilterProcessCascade_specialized(data, dst, src, amountWet, amountDry);
+}
+
+// This only exists for ABI compatibility so we don't export a function pointer that changes
+void azaFilterProcessCascade(azaFilter *data, azaBuffer *dst, azaBuffer *src, float amountWet, float amountDry) {
+	azaFilterProcessCascade_specialized(data, dst, src, amountWet, amountDry);
+}
@@ -6,6 +6,7 @@
 	Implements the following (declared in dsp.h):
 		- azaKernelSample(2)
 		- azaSampleWithKernel(11)
+		- azaSampleWithKernelBlock(16)
 */
 
 #include "../dsp/azaKernel.h"
@@ -376,6 +377,51 @@ static __m256 azaKernelSample_x8_avx2_fma(azaKernel *kernel, float pos, float ra
 	return result;
 }
 
+AZA_SIMD_FEATURES("avx512f")
+static __m512 azaKernelSample_x16_avx512f_rate1(azaKernel *kernel, float pos, uint32_t count) {
+	azaKernelVectorSamples += count;
+	float actualPos = pos + (float)kernel->sampleZero;
+	// Same as the scalar version, the kernel is 0 outside of its length. Lanes out there aren't loaded at all, so unlike the AVX version we can run right up to the end of the kernel, and we're fine when clamping to minFrame and maxFrame puts us entirely outside of it.
+	if (!(actualPos > -16.0f && actualPos < (float)kernel->length)) return _mm512_setzero_ps();
+	int32_t index = (int32_t)floorf(actualPos);
+	int32_t laneFirst = AZA_MAX(0, -index);
+	int32_t laneEnd = AZA_MIN((int32_t)count, (int32_t)kernel->length - index);
+	if (laneFirst >= laneEnd) return _mm512_setzero_ps();
+	__mmask16 mask = aza_mask16_first((uint32_t)laneEnd) & ~aza_mask16_first((uint32_t)laneFirst);
+	actualPos -= (float)index;
+	actualPos *= kernel->scale;
+	int32_t subsample = (int32_t)actualPos;
+	actualPos -= (float)subsample;
+	assert(subsample < (int32_t)kernel->scale);
+	float *srcSubsample0 = kernel->packed + ((subsample+0) * kernel->length);
+	float *srcSubsample1 = kernel->packed + ((subsample+1) * kernel->length);
+	__m512 samples0 = _mm512_maskz_loadu_ps(mask, srcSubsample0 + index);
+	__m512 samples1 = _mm512_maskz_loadu_ps(mask, srcSubsample1 + index);
+	__m512 result = _mm512_fmadd_ps(_mm512_sub_ps(samples1, samples0), _mm512_set1_ps(actualPos), samples0);
+	return result;
+}
+
+AZA_SIMD_FEATURES("avx512f")
+static __m512 azaKernelSample_x16_avx512f(azaKernel *kernel, float pos, float rate, uint32_t count) {
+	azaKernelVectorSamples += count;
+	// We have to sample according to our rate
+	__m512 offset_x16 = _mm512_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f);
+	__m512 rate_x16 = _mm512_set1_ps(rate * (float)kernel->scale);
+	float actualPos = (pos + (float)kernel->sampleZero) * (float)kernel->scale;
+	__m512 actualPos_x16 = _mm512_fmadd_ps(rate_x16, offset_x16, _mm512_set1_ps(actualPos));
+	// Same as the scalar version, the kernel is 0 outside of the table. We check the positions before converting them, since anything too big to fit in an int32 would wrap around to negative.
+	__mmask16 mask = aza_mask16_first(count)
+		& _mm512_cmp_ps_mask(actualPos_x16, _mm512_setzero_ps(), _CMP_GE_OQ)
+		& _mm512_cmp_ps_mask(actualPos_x16, _mm512_set1_ps((float)(kernel->size - 1)), _CMP_LT_OQ);
+	__m512i index_x16 = _mm512_cvttps_epi32(actualPos_x16);
+	__m512 t_x16 = _mm512_sub_ps(actualPos_x16, _mm512_cvtepi32_ps(index_x16));
+	__m512 samples0 = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, index_x16, kernel->table, sizeof(float));
+	index_x16 = _mm512_add_epi32(index_x16, _mm512_set1_epi32(1));
+	__m512 samples1 = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, index_x16, kernel->table, sizeof(float));
+	__m512 result = _mm512_fmadd_ps(_mm512_sub_ps(samples1, samples0), t_x16, samples0);
+	return result;
+}
+
 void azaSampleWithKernel_scalar(float *dst, int dstChannels, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t frame, float fraction, float rate) {
 	memset(dst, 0, sizeof(*dst)*dstChannels);
 	float kernelIntegral = 0.0f;
@@ -1238,6 +1284,175 @@ void azaSampleWithKernel_avx2_fma(float *dst, int dstChannels, azaKernel *kernel
 	}
 }
 
+// Tails are handled with masks, so the only scalar taps left are the ones that wrap around.
+// Every channel keeps its own vector accumulator, so there's only one horizontal sum per channel at the very end.
+// Unlike on the Ryzen mentioned in the dispatch function, gathers are worth it on the AVX-512 Xeons this was measured on.
+AZA_SIMD_FEATURES("avx512f")
+void azaSampleWithKernel_avx512f(float *dst, int dstChannels, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t frame, float fraction, float rate) {
+	assert(dstChannels <= AZA_MAX_CHANNEL_POSITIONS);
+	memset(dst, 0, sizeof(*dst)*dstChannels);
+	__m512 accum_x16[AZA_MAX_CHANNEL_POSITIONS];
+	for (int c = 0; c < dstChannels; c++) {
+		accum_x16[c] = _mm512_setzero_ps();
+	}
+	__m512 kernelIntegral_x16 = _mm512_setzero_ps();
+	float kernelIntegral = 0.0f;
+	int srcStart = frame + (int)ceilf(-(float)kernel->sampleZero / rate);
+	int srcLen = (int)ceilf((float)kernel->length / rate) - 1;
+	int srcEnd = srcStart + srcLen;
+	float kernelPos = rate * (1.0f-fraction) - (float)kernel->sampleZero;
+	if (!wrap) {
+		int srcStartActual = AZA_CLAMP(srcStart, minFrame, maxFrame-1);
+		kernelPos += (float)(srcStartActual - srcStart) * rate;
+		srcStart = srcStartActual;
+		srcEnd = AZA_CLAMP(srcEnd, minFrame+1, maxFrame);
+	}
+	int srcIndex = srcStart;
+	int endVector = AZA_MIN(srcEnd, maxFrame);
+	const bool packed = USE_PACKED_KERNEL && rate == 1.0f;
+	if (wrap) {
+		for (; srcIndex < minFrame; srcIndex++) {
+			int i = azaWrapi2(srcIndex, minFrame, maxFrame);
+			float k = packed ? azaKernelSample_sse_fma_rate1(kernel, kernelPos) : azaKernelSample_sse_fma(kernel, kernelPos);
+			kernelIntegral += k;
+			kernelPos += rate;
+			for (int c = 0; c < dstChannels; c++) {
+				float s = src[i * srcStride + c];
+				dst[c] += s * k;
+			}
+		}
+	}
+	const __m512i sampleOffsets_x16 = _mm512_mullo_epi32(_mm512_set1_epi32(srcStride), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+	while (srcIndex < endVector) {
+		uint32_t count = (uint32_t)AZA_MIN(16, endVector - srcIndex);
+		__mmask16 mask = aza_mask16_first(count);
+		__m512 kernelSamples = packed ? azaKernelSample_x16_avx512f_rate1(kernel, kernelPos, count) : azaKernelSample_x16_avx512f(kernel, kernelPos, rate, count);
+		kernelIntegral_x16 = _mm512_add_ps(kernelIntegral_x16, kernelSamples);
+		kernelPos += rate * (float)count;
+		float *pSamples = src + srcIndex * srcStride;
+		if (srcStride == 1) {
+			for (int c = 0; c < dstChannels; c++) {
+				__m512 srcSamples_x16 = _mm512_maskz_loadu_ps(mask, pSamples + c);
+				accum_x16[c] = _mm512_fmadd_ps(kernelSamples, srcSamples_x16, accum_x16[c]);
+			}
+		} else {
+			for (int c = 0; c < dstChannels; c++) {
+				__m512 srcSamples_x16 = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, sampleOffsets_x16, pSamples + c, sizeof(float));
+				accum_x16[c] = _mm512_fmadd_ps(kernelSamples, srcSamples_x16, accum_x16[c]);
+			}
+		}
+		srcIndex += (int)count;
+	}
+	if (wrap) {
+		for (; srcIndex < srcEnd; srcIndex++) {
+			int i = azaWrapi2(srcIndex, minFrame, maxFrame);
+			float k = packed ? azaKernelSample_sse_fma_rate1(kernel, kernelPos) : azaKernelSample_sse_fma(kernel, kernelPos);
+			kernelIntegral += k;
+			kernelPos += rate;
+			for (int c = 0; c < dstChannels; c++) {
+				float s = src[i * srcStride + c];
+				dst[c] += s * k;
+			}
+		}
+	}
+	for (int c = 0; c < dstChannels; c++) {
+		dst[c] += _mm512_reduce_add_ps(accum_x16[c]);
+	}
+	kernelIntegral += _mm512_reduce_add_ps(kernelIntegral_x16);
+	if (kernelIntegral > 0.0f) {
+		for (int c = 0; c < dstChannels; c++) {
+			dst[c] /= kernelIntegral;
+		}
+	}
+}
+
+// Copies a single frame when there's nothing to interpolate, treating everything outside of minFrame and maxFrame like azaSampleWithKernel does.
+static inline void azaSampleWithKernelBlockCopyFrame(float *dst, int dstChannels, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t frame) {
+	if (wrap) {
+		frame = azaWrapi2(frame, minFrame, maxFrame);
+	} else if (frame < minFrame || frame >= maxFrame) {
+		memset(dst, 0, sizeof(*dst)*dstChannels);
+		return;
+	}
+	for (int c = 0; c < dstChannels; c++) {
+		dst[c] = src[frame * srcStride + c];
+	}
+}
+
+// Walking the sampling location is the same in every version, so it's up here. Calling the single-frame version directly skips the dispatch and argument checks, and lets the compiler inline it where it wants to.
+#define AZA_SAMPLE_WITH_KERNEL_BLOCK(sampleWithKernel) \
+	int32_t frameCurrent = *frame;\
+	float fractionCurrent = *fraction;\
+	uint32_t i = 0;\
+	while (i < frames) {\
+		float *dstFrame = dst + i * dstStride;\
+		float speed = speeds[i];\
+		if (fractionCurrent == 0.0f && (speed == 1.0f || speed == -1.0f)) {\
+			/* Stays on whole frames for as long as the speed doesn't change, so copy the whole run without touching fraction */\
+			int32_t step = (int32_t)speed;\
+			do {\
+				azaSampleWithKernelBlockCopyFrame(dst + i * dstStride, dstChannels, src, srcStride, minFrame, maxFrame, wrap, frameCurrent);\
+				i++;\
+				frameCurrent += step;\
+			} while (i < frames && speeds[i] == speed && frameCurrent > boundStart && frameCurrent < boundEnd);\
+			if (frameCurrent <= boundStart || frameCurrent >= boundEnd) break;\
+			continue;\
+		} else if (fractionCurrent < 0.0f) {\
+			/* Going backwards leaves fraction negative, but the kernel wants it between 0 and 1 */\
+			float fractionPositive = fractionCurrent + 1.0f;\
+			if (fractionPositive < 1.0f) {\
+				sampleWithKernel(dstFrame, dstChannels, kernel, src, srcStride, minFrame, maxFrame, wrap, frameCurrent-1, fractionPositive, rate);\
+			} else {\
+				sampleWithKernel(dstFrame, dstChannels, kernel, src, srcStride, minFrame, maxFrame, wrap, frameCurrent, 0.0f, rate);\
+			}\
+		} else {\
+			sampleWithKernel(dstFrame, dstChannels, kernel, src, srcStride, minFrame, maxFrame, wrap, frameCurrent, fractionCurrent, rate);\
+		}\
+		i++;\
+		fractionCurrent += speed;\
+		int32_t framesToAdd = (int32_t)truncf(fractionCurrent);\
+		frameCurrent += framesToAdd;\
+		fractionCurrent -= (float)framesToAdd;\
+		if (frameCurrent <= boundStart || frameCurrent >= boundEnd) break;\
+	}\
+	*frame = frameCurrent;\
+	*fraction = fractionCurrent;\
+	return i;
+
+uint32_t azaSampleWithKernelBlock_scalar(float *dst, int dstStride, int dstChannels, uint32_t frames, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t *frame, float *fraction, const float *speeds, int32_t boundStart, int32_t boundEnd, float rate) {
+	AZA_SAMPLE_WITH_KERNEL_BLOCK(azaSampleWithKernel_scalar)
+}
+
+AZA_SIMD_FEATURES("sse")
+uint32_t azaSampleWithKernelBlock_sse(float *dst, int dstStride, int dstChannels, uint32_t frames, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t *frame, float *fraction, const float *speeds, int32_t boundStart, int32_t boundEnd, float rate) {
+	AZA_SAMPLE_WITH_KERNEL_BLOCK(azaSampleWithKernel_sse)
+}
+
+AZA_SIMD_FEATURES("sse2")
+uint32_t azaSampleWithKernelBlock_sse2(float *dst, int dstStride, int dstChannels, uint32_t frames, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t *frame, float *fraction, const float *speeds, int32_t boundStart, int32_t boundEnd, float rate) {
+	AZA_SAMPLE_WITH_KERNEL_BLOCK(azaSampleWithKernel_sse2)
+}
+
+AZA_SIMD_FEATURES("sse3")
+uint32_t azaSampleWithKernelBlock_sse3(float *dst, int dstStride, int dstChannels, uint32_t frames, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t *frame, float *fraction, const float *speeds, int32_t boundStart, int32_t boundEnd, float rate) {
+	AZA_SAMPLE_WITH_KERNEL_BLOCK(azaSampleWithKernel_sse3)
+}
+
+AZA_SIMD_FEATURES("avx")
+uint32_t azaSampleWithKernelBlock_avx(float *dst, int dstStride, int dstChannels, uint32_t frames, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t *frame, float *fraction, const float *speeds, int32_t boundStart, int32_t boundEnd, float rate) {
+	AZA_SAMPLE_WITH_KERNEL_BLOCK(azaSampleWithKernel_avx)
+}
+
+AZA_SIMD_FEATURES("avx,fma")
+uint32_t azaSampleWithKernelBlock_avx_fma(float *dst, int dstStride, int dstChannels, uint32_t frames, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t *frame, float *fraction, const float *speeds, int32_t boundStart, int32_t boundEnd, float rate) {
+	AZA_SAMPLE_WITH_KERNEL_BLOCK(azaSampleWithKernel_avx_fma)
+}
+
+AZA_SIMD_FEATURES("avx512f")
+uint32_t azaSampleWithKernelBlock_avx512f(float *dst, int dstStride, int dstChannels, uint32_t frames, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t *frame, float *fraction, const float *speeds, int32_t boundStart, int32_t boundEnd, float rate) {
+	AZA_SAMPLE_WITH_KERNEL_BLOCK(azaSampleWithKernel_avx512f)
+}
+
 void azaSampleWithKernel_dispatch(float *dst, int dstChannels, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t frame, float fraction, float rate);
 void (*azaSampleWithKernel_specialized)(float *dst, int dstChannels, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t frame, float fraction, float rate) = azaSampleWithKernel_dispatch;
 void azaSampleWithKernel_dispatch(float *dst, int dstChannels, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t frame, float fraction, float rate) {
@@ -1249,6 +1464,10 @@ void azaSampleWithKernel_dispatch(float *dst, int dstChannels, azaKernel *kernel
 	// 	AZA_LOG_TRACE("choosing azaSampleWithKernel_avx2_fma\n");
 	// 	azaSampleWithKernel_specialized = azaSampleWithKernel_avx2_fma;
 	// } else
+	if (AZA_AVX512F) {
+		AZA_LOG_TRACE("choosing azaSampleWithKernel_avx512f\n");
+		azaSampleWithKernel_specialized = azaSampleWithKernel_avx512f;
+	} else
 	if (AZA_AVX && AZA_FMA) {
 		AZA_LOG_TRACE("choosing azaSampleWithKernel_avx_fma\n");
 		azaSampleWithKernel_specialized = azaSampleWithKernel_avx_fma;
@@ -1283,4 +1502,51 @@ void azaSampleWithKernel(float *dst, int dstChannels, azaKernel *kernel, float *
 	assert(rate > 0.01f && "Are you crazy?!");
 	assert(dstChannels >= srcStride);
 	azaSampleWithKernel_specialized(dst, dstChannels, kernel, src, srcStride, minFrame, maxFrame, wrap, frame, fraction, rate);
+}
+
+
+
+uint32_t azaSampleWithKernelBlock_dispatch(float *dst, int dstStride, int dstChannels, uint32_t frames, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t *frame, float *fraction, const float *speeds, int32_t boundStart, int32_t boundEnd, float rate);
+uint32_t (*azaSampleWithKernelBlock_specialized)(float *dst, int dstStride, int dstChannels, uint32_t frames, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t *frame, float *fraction, const float *speeds, int32_t boundStart, int32_t boundEnd, float rate) = azaSampleWithKernelBlock_dispatch;
+uint32_t azaSampleWithKernelBlock_dispatch(float *dst, int dstStride, int dstChannels, uint32_t frames, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t *frame, float *fraction, const float *speeds, int32_t boundStart, int32_t boundEnd, float rate) {
+	assert(azaCPUID.initted);
+	// Same choices as azaSampleWithKernel_dispatch
+	if (AZA_AVX512F) {
+		AZA_LOG_TRACE("choosing azaSampleWithKernelBlock_avx512f\n");
+		azaSampleWithKernelBlock_specialized = azaSampleWithKernelBlock_avx512f;
+	} else
+	if (AZA_AVX && AZA_FMA) {
+		AZA_LOG_TRACE("choosing azaSampleWithKernelBlock_avx_fma\n");
+		azaSampleWithKernelBlock_specialized = azaSampleWithKernelBlock_avx_fma;
+	} else
+	if (AZA_AVX) {
+		AZA_LOG_TRACE("choosing azaSampleWithKernelBlock_avx\n");
+		azaSampleWithKernelBlock_specialized = azaSampleWithKernelBlock_avx;
+	} else
+	if (AZA_SSE3) {
+		AZA_LOG_TRACE("choosing azaSampleWithKernelBlock_sse3\n");
+		azaSampleWithKernelBlock_specialized = azaSampleWithKernelBlock_sse3;
+	} else
+	if (AZA_SSE2) {
+		AZA_LOG_TRACE("choosing azaSampleWithKernelBlock_sse2\n");
+		azaSampleWithKernelBlock_specialized = azaSampleWithKernelBlock_sse2;
+	} else
+	if (AZA_SSE) {
+		AZA_LOG_TRACE("choosing azaSampleWithKernelBlock_sse\n");
+		azaSampleWithKernelBlock_specialized = azaSampleWithKernelBlock_sse;
+	} else
+	{
+		AZA_LOG_TRACE("choosing azaSampleWithKernelBlock_scalar\n");
+		azaSampleWithKernelBlock_specialized = azaSampleWithKernelBlock_scalar;
+	}
+	return azaSampleWithKernelBlock_specialized(dst, dstStride, dstChannels, frames, kernel, src, srcStride, minFrame, maxFrame, wrap, frame, fraction, speeds, boundStart, boundEnd, rate);
+}
+
+// This only exists for ABI compatibility so we don't export a function pointer that changes
+uint32_t azaSampleWithKernelBlock(float *dst, int dstStride, int dstChannels, uint32_t frames, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t *frame, float *fraction, const float *speeds, int32_t boundStart, int32_t boundEnd, float rate) {
+	assert(*fraction > -1.0f && *fraction < 1.0f && "fraction should be > -1 and < 1");
+	assert(rate <= 1.0f && "rate should be > 0.01f and <= 1");
+	assert(rate > 0.01f && "Are you crazy?!");
+	assert(dstStride >= dstChannels);
+	return azaSampleWithKernelBlock_specialized(dst, dstStride, dstChannels, frames, kernel, src, srcStride, minFrame, maxFrame, wrap, frame, fraction, speeds, boundStart, boundEnd, rate);
 }
\ No newline at end of file
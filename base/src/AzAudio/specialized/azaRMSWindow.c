@@ -0,0 +1,331 @@
+/*
+	File: azaRMSWindow.c
+	Author: Philip Haynes
+	Specialized implementations of the azaRMS window and dispatch.
+	Non-specialized code still lives in azaRMS.c
+	Implements the following (declared in azaRMS.h):
+		- azaRMSProcessWindow(3)
+	When combining channels, each frame's channels are squared together in vector lanes and reduced with a horizontal add or max, leaving only the running sum itself to go one frame at a time.
+	Otherwise every channel's running sum lives in its own vector lane, which is why azaRMS.buffer keeps each frame's channels side by side.
+*/
+
+#include "../dsp/plugins/azaRMS.h"
+#include "../simd.h"
+#include "../math.h"
+#include "../AzAudio.h"
+
+// Sums a channel's values in the window from scratch
+static float azaRMSResum_scalar(const azaRMS *data, uint8_t channel) {
+	float result = 0.0f;
+	for (uint32_t i = 0; i < data->bufferWindow; i++) {
+		result += data->buffer[i * data->bufferStride + channel];
+	}
+	return result;
+}
+
+void azaRMSProcessWindow_scalar(azaRMS *data, azaBuffer *dst, azaBuffer *src) {
+	const uint32_t window = data->bufferWindow;
+	const uint32_t stride = data->bufferStride;
+	uint32_t index = data->index;
+	if (dst->channelLayout.count == 1 && src->channelLayout.count != 1) {
+		// Combine channels
+		fp_azaOp op = data->config.combineOp ? data->config.combineOp : azaOpMax;
+		const float denominator = (float)(window * src->channelLayout.count);
+		float squaredSum = data->channelData[0].squaredSum;
+		for (uint32_t i = 0; i < src->frames; i++) {
+			float value = 0.0f;
+			for (uint8_t c = 0; c < src->channelLayout.count; c++) {
+				op(&value, azaSqrf(src->pSamples[i * src->stride + c]));
+			}
+			squaredSum += value - data->buffer[index];
+			data->buffer[index] = value;
+			// Deal with potential rounding errors making sqrtf emit NaNs
+			dst->pSamples[i * dst->stride] = sqrtf(azaMaxf(squaredSum, 0.0f) / denominator);
+			if (++index >= window) {
+				index = 0;
+				squaredSum = azaRMSResum_scalar(data, 0);
+			}
+		}
+		data->channelData[0].squaredSum = squaredSum;
+	} else {
+		// Individual channels
+		const uint8_t channels = dst->channelLayout.count;
+		const float denominator = (float)window;
+		for (uint32_t i = 0; i < src->frames; i++) {
+			float *bufferFrame = data->buffer + index * stride;
+			for (uint8_t c = 0; c < channels; c++) {
+				azaRMSChannelData *channelData = &data->channelData[c];
+				float value = azaSqrf(src->pSamples[i * src->stride + c]);
+				channelData->squaredSum += value - bufferFrame[c];
+				bufferFrame[c] = value;
+				// Deal with potential rounding errors making sqrtf emit NaNs
+				dst->pSamples[i * dst->stride + c] = sqrtf(azaMaxf(channelData->squaredSum, 0.0f) / denominator);
+			}
+			if (++index >= window) {
+				index = 0;
+				for (uint8_t c = 0; c < channels; c++) {
+					data->channelData[c].squaredSum = azaRMSResum_scalar(data, c);
+				}
+			}
+		}
+	}
+	data->index = index;
+}
+
+// Sums the combined values in the window from scratch
+AZA_SIMD_FEATURES("sse2")
+static float azaRMSResumCombined_sse(const azaRMS *data) {
+	__m128 sum = _mm_setzero_ps();
+	uint32_t i = 0;
+	for (; i + 4 <= data->bufferWindow; i += 4) {
+		sum = _mm_add_ps(sum, _mm_loadu_ps(data->buffer + i));
+	}
+	float result = aza_mm_hsum_ps_sse(sum);
+	for (; i < data->bufferWindow; i++) {
+		result += data->buffer[i];
+	}
+	return result;
+}
+
+AZA_SIMD_FEATURES("sse2")
+static void azaRMSProcessWindowCombined_sse(azaRMS *data, azaBuffer *dst, azaBuffer *src, bool useMax) {
+	const uint8_t srcChannels = src->channelLayout.count;
+	const uint32_t window = data->bufferWindow;
+	const float denominator = (float)(window * srcChannels);
+	uint32_t index = data->index;
+	float squaredSum = data->channelData[0].squaredSum;
+	for (uint32_t i = 0; i < src->frames; i++) {
+		const float *srcFrame = src->pSamples + i * src->stride;
+		__m128 values = _mm_setzero_ps();
+		for (uint8_t c = 0; c < srcChannels; c += 4) {
+			__m128 x = aza_mm_loadu_lanes_ps(srcFrame + c, AZA_MIN(srcChannels - c, 4));
+			// Lanes past the end are 0, which does nothing to either op since squares can't be negative.
+			values = useMax ? _mm_max_ps(values, _mm_mul_ps(x, x)) : _mm_add_ps(values, _mm_mul_ps(x, x));
+		}
+		float value = useMax ? aza_mm_hmax_ps_sse(values) : aza_mm_hsum_ps_sse(values);
+		squaredSum += value - data->buffer[index];
+		data->buffer[index] = value;
+		// Deal with potential rounding errors making sqrtf emit NaNs
+		dst->pSamples[i * dst->stride] = sqrtf(azaMaxf(squaredSum, 0.0f) / denominator);
+		if (++index >= window) {
+			index = 0;
+			squaredSum = azaRMSResumCombined_sse(data);
+		}
+	}
+	data->channelData[0].squaredSum = squaredSum;
+	data->index = index;
+}
+
+// Sums each channel's values in the window from scratch, 4 channels to a vector
+AZA_SIMD_FEATURES("sse2")
+static void azaRMSResumChannels_sse(const azaRMS *data, uint8_t channels, __m128 squaredSum[]) {
+	for (uint8_t c = 0; c < channels; c += 4) {
+		__m128 sum = _mm_setzero_ps();
+		for (uint32_t i = 0; i < data->bufferWindow; i++) {
+			sum = _mm_add_ps(sum, _mm_loadu_ps(data->buffer + i * data->bufferStride + c));
+		}
+		squaredSum[c/4] = sum;
+	}
+}
+
+AZA_SIMD_FEATURES("sse2")
+static void azaRMSProcessWindowChannels_sse(azaRMS *data, azaBuffer *dst, azaBuffer *src) {
+	const uint8_t channels = dst->channelLayout.count;
+	const uint32_t window = data->bufferWindow;
+	const uint32_t stride = data->bufferStride;
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 denominator = _mm_set1_ps((float)window);
+	uint32_t index = data->index;
+	// channelData isn't padded out to whole vectors, so the sums go through here
+	float squaredSums[AZAUDIO_RMS_MAX_STRIDE] = {0};
+	for (uint8_t c = 0; c < channels; c++) {
+		squaredSums[c] = data->channelData[c].squaredSum;
+	}
+	__m128 squaredSum[AZAUDIO_RMS_MAX_STRIDE/4];
+	for (uint8_t c = 0; c < channels; c += 4) {
+		squaredSum[c/4] = _mm_loadu_ps(squaredSums + c);
+	}
+	for (uint32_t i = 0; i < src->frames; i++) {
+		const float *srcFrame = src->pSamples + i * src->stride;
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		// stride is a multiple of 8, so whole vectors always fit here. Lanes past the end only ever hold 0.
+		float *bufferFrame = data->buffer + index * stride;
+		for (uint8_t c = 0; c < channels; c += 4) {
+			uint32_t lanes = AZA_MIN(channels - c, 4);
+			__m128 x = aza_mm_loadu_lanes_ps(srcFrame + c, lanes);
+			__m128 value = _mm_mul_ps(x, x);
+			squaredSum[c/4] = _mm_add_ps(squaredSum[c/4], _mm_sub_ps(value, _mm_loadu_ps(bufferFrame + c)));
+			_mm_storeu_ps(bufferFrame + c, value);
+			// Deal with potential rounding errors making sqrt emit NaNs
+			aza_mm_storeu_lanes_ps(dstFrame + c, _mm_sqrt_ps(_mm_div_ps(_mm_max_ps(squaredSum[c/4], zero), denominator)), lanes);
+		}
+		if (++index >= window) {
+			index = 0;
+			azaRMSResumChannels_sse(data, channels, squaredSum);
+		}
+	}
+	for (uint8_t c = 0; c < channels; c += 4) {
+		_mm_storeu_ps(squaredSums + c, squaredSum[c/4]);
+	}
+	for (uint8_t c = 0; c < channels; c++) {
+		data->channelData[c].squaredSum = squaredSums[c];
+	}
+	data->index = index;
+}
+
+AZA_SIMD_FEATURES("sse2")
+void azaRMSProcessWindow_sse(azaRMS *data, azaBuffer *dst, azaBuffer *src) {
+	if (dst->channelLayout.count == 1 && src->channelLayout.count != 1) {
+		fp_azaOp op = data->config.combineOp ? data->config.combineOp : azaOpMax;
+		if (op == azaOpMax || op == azaOpAdd) {
+			azaRMSProcessWindowCombined_sse(data, dst, src, op == azaOpMax);
+			return;
+		}
+	} else if (dst->channelLayout.count > 1) {
+		azaRMSProcessWindowChannels_sse(data, dst, src);
+		return;
+	}
+	// A lone channel or an op we can't do in a vector
+	azaRMSProcessWindow_scalar(data, dst, src);
+}
+
+// Sums the combined values in the window from scratch
+AZA_SIMD_FEATURES("avx")
+static float azaRMSResumCombined_avx(const azaRMS *data) {
+	__m256 sum = _mm256_setzero_ps();
+	uint32_t i = 0;
+	for (; i + 8 <= data->bufferWindow; i += 8) {
+		sum = _mm256_add_ps(sum, _mm256_loadu_ps(data->buffer + i));
+	}
+	float result = aza_mm256_hsum_ps(sum);
+	for (; i < data->bufferWindow; i++) {
+		result += data->buffer[i];
+	}
+	return result;
+}
+
+AZA_SIMD_FEATURES("avx")
+static void azaRMSProcessWindowCombined_avx(azaRMS *data, azaBuffer *dst, azaBuffer *src, bool useMax) {
+	const uint8_t srcChannels = src->channelLayout.count;
+	const uint32_t window = data->bufferWindow;
+	const float denominator = (float)(window * srcChannels);
+	uint32_t index = data->index;
+	float squaredSum = data->channelData[0].squaredSum;
+	for (uint32_t i = 0; i < src->frames; i++) {
+		const float *srcFrame = src->pSamples + i * src->stride;
+		__m256 values = _mm256_setzero_ps();
+		for (uint8_t c = 0; c < srcChannels; c += 8) {
+			__m256 x = aza_mm256_loadu_lanes_ps(srcFrame + c, AZA_MIN(srcChannels - c, 8));
+			// Lanes past the end are 0, which does nothing to either op since squares can't be negative.
+			values = useMax ? _mm256_max_ps(values, _mm256_mul_ps(x, x)) : _mm256_add_ps(values, _mm256_mul_ps(x, x));
+		}
+		float value = useMax ? aza_mm256_hmax_ps(values) : aza_mm256_hsum_ps(values);
+		squaredSum += value - data->buffer[index];
+		data->buffer[index] = value;
+		// Deal with potential rounding errors making sqrtf emit NaNs
+		dst->pSamples[i * dst->stride] = sqrtf(azaMaxf(squaredSum, 0.0f) / denominator);
+		if (++index >= window) {
+			index = 0;
+			squaredSum = azaRMSResumCombined_avx(data);
+		}
+	}
+	data->channelData[0].squaredSum = squaredSum;
+	data->index = index;
+}
+
+// Sums each channel's values in the window from scratch, 8 channels to a vector
+AZA_SIMD_FEATURES("avx")
+static void azaRMSResumChannels_avx(const azaRMS *data, uint8_t channels, __m256 squaredSum[]) {
+	for (uint8_t c = 0; c < channels; c += 8) {
+		__m256 sum = _mm256_setzero_ps();
+		for (uint32_t i = 0; i < data->bufferWindow; i++) {
+			sum = _mm256_add_ps(sum, _mm256_loadu_ps(data->buffer + i * data->bufferStride + c));
+		}
+		squaredSum[c/8] = sum;
+	}
+}
+
+AZA_SIMD_FEATURES("avx")
+static void azaRMSProcessWindowChannels_avx(azaRMS *data, azaBuffer *dst, azaBuffer *src) {
+	const uint8_t channels = dst->channelLayout.count;
+	const uint32_t window = data->bufferWindow;
+	const uint32_t stride = data->bufferStride;
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 denominator = _mm256_set1_ps((float)window);
+	uint32_t index = data->index;
+	// channelData isn't padded out to whole vectors, so the sums go through here
+	float squaredSums[AZAUDIO_RMS_MAX_STRIDE] = {0};
+	for (uint8_t c = 0; c < channels; c++) {
+		squaredSums[c] = data->channelData[c].squaredSum;
+	}
+	__m256 squaredSum[AZAUDIO_RMS_MAX_STRIDE/8];
+	for (uint8_t c = 0; c < channels; c += 8) {
+		squaredSum[c/8] = _mm256_loadu_ps(squaredSums + c);
+	}
+	for (uint32_t i = 0; i < src->frames; i++) {
+		const float *srcFrame = src->pSamples + i * src->stride;
+		float *dstFrame = dst->pSamples + i * dst->stride;
+		// stride is a multiple of 8, so whole vectors always fit here. Lanes past the end only ever hold 0.
+		float *bufferFrame = data->buffer + index * stride;
+		for (uint8_t c = 0; c < channels; c += 8) {
+			uint32_t lanes = AZA_MIN(channels - c, 8);
+			__m256 x = aza_mm256_loadu_lanes_ps(srcFrame + c, lanes);
+			__m256 value = _mm256_mul_ps(x, x);
+			squaredSum[c/8] = _mm256_add_ps(squaredSum[c/8], _mm256_sub_ps(value, _mm256_loadu_ps(bufferFrame + c)));
+			_mm256_storeu_ps(bufferFrame + c, value);
+			// Deal with potential rounding errors making sqrt emit NaNs
+			aza_mm256_storeu_lanes_ps(dstFrame + c, _mm256_sqrt_ps(_mm256_div_ps(_mm256_max_ps(squaredSum[c/8], zero), denominator)), lanes);
+		}
+		if (++index >= window) {
+			index = 0;
+			azaRMSResumChannels_avx(data, channels, squaredSum);
+		}
+	}
+	for (uint8_t c = 0; c < channels; c += 8) {
+		_mm256_storeu_ps(squaredSums + c, squaredSum[c/8]);
+	}
+	for (uint8_t c = 0; c < channels; c++) {
+		data->channelData[c].squaredSum = squaredSums[c];
+	}
+	data->index = index;
+}
+
+AZA_SIMD_FEATURES("avx")
+void azaRMSProcessWindow_avx(azaRMS *data, azaBuffer *dst, azaBuffer *src) {
+	// With 4 or fewer channels there's nothing to put in the other half of the vector
+	if (dst->channelLayout.count == 1 && src->channelLayout.count > 4) {
+		fp_azaOp op = data->config.combineOp ? data->config.combineOp : azaOpMax;
+		if (op == azaOpMax || op == azaOpAdd) {
+			azaRMSProcessWindowCombined_avx(data, dst, src, op == azaOpMax);
+			return;
+		}
+	} else if (dst->channelLayout.count > 4) {
+		azaRMSProcessWindowChannels_avx(data, dst, src);
+		return;
+	}
+	azaRMSProcessWindow_sse(data, dst, src);
+}
+
+void azaRMSProcessWindow_dispatch(azaRMS *data, azaBuffer *dst, azaBuffer *src);
+void (*azaRMSProcessWindow_specialized)(azaRMS *data, azaBuffer *dst, azaBuffer *src) = azaRMSProcessWindow_dispatch;
+void azaRMSProcessWindow_dispatch(azaRMS *data, azaBuffer *dst, azaBuffer *src) {
+	assert(azaCPUID.initted);
+	if (AZA_AVX) {
+		AZA_LOG_TRACE("choosing azaRMSProcessWindow_avx\n");
+		azaRMSProcessWindow_specialized = azaRMSProcessWindow_avx;
+	} else
+	if (AZA_SSE2) {
+		AZA_LOG_TRACE("choosing azaRMSProcessWindow_sse\n");
+		azaRMSProcessWindow_specialized = azaRMSProcessWindow_sse;
+	} else
+	{
+		AZA_LOG_TRACE("choosing azaRMSProcessWindow_scalar\n");
+		azaRMSProcessWindow_specialized = azaRMSProcessWindow_scalar;
+	}
+	azaRMSProcessWindow_specialized(data, dst, src);
+}
+
+// This only exists for ABI compatibility so we don't export a function pointer that changes
+void azaRMSProcessWindow(azaRMS *data, azaBuffer *dst, azaBuffer *src) {
+	azaRMSProcessWindow_specialized(data, dst, src);
+}
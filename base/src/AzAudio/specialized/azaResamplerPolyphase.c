@@ -0,0 +1,134 @@
+/*
+	File: azaResamplerPolyphase.c
+	Author: Philip Haynes
+	Specialized implementations of the azaResamplerPolyphase dot products and dispatch.
+	Non-specialized code still lives in dsp/azaResamplerPolyphase.c
+	Implements the following (declared in azaResamplerPolyphase.h):
+		- azaResamplerPolyphaseConvolve(5)
+*/
+
+#include "../dsp/azaResamplerPolyphase.h"
+#include "../simd.h"
+#include "../AzAudio.h"
+
+// The phases and the history both go forward in time, so every dst frame is a plain dot product of taps floats, with taps always a multiple of 8.
+// Walking inputIndex and phase is the same in every version, so it's up here.
+#define AZA_RESAMPLER_POLYPHASE_LOOP(dotProduct) \
+	uint32_t taps = data->taps;\
+	uint32_t quotient = data->downFactor / data->upFactor;\
+	uint32_t remainder = data->downFactor % data->upFactor;\
+	uint32_t inputIndex = data->inputIndex;\
+	uint32_t phase = data->phase;\
+	for (uint32_t i = 0; i < dstFrames; i++) {\
+		const float *coefficients = data->phases + phase * taps;\
+		const float *samples = history + inputIndex - (taps-1);\
+		dst[i * dstStride] = dotProduct(coefficients, samples, taps);\
+		inputIndex += quotient;\
+		phase += remainder;\
+		if (phase >= data->upFactor) {\
+			phase -= data->upFactor;\
+			inputIndex++;\
+		}\
+	}
+
+static inline float azaDotProduct_scalar(const float *a, const float *b, uint32_t count) {
+	float sum[4] = {0.0f};
+	for (uint32_t i = 0; i < count; i += 4) {
+		sum[0] += a[i+0] * b[i+0];
+		sum[1] += a[i+1] * b[i+1];
+		sum[2] += a[i+2] * b[i+2];
+		sum[3] += a[i+3] * b[i+3];
+	}
+	return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+void azaResamplerPolyphaseConvolve_scalar(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history) {
+	AZA_RESAMPLER_POLYPHASE_LOOP(azaDotProduct_scalar)
+}
+
+AZA_SIMD_FEATURES("sse")
+static AZA_FORCE_INLINE(float)
+azaDotProduct_sse(const float *a, const float *b, uint32_t count) {
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	for (uint32_t i = 0; i < count; i += 8) {
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i + 0), _mm_loadu_ps(b + i + 0)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+	}
+	return aza_mm_hsum_ps_sse(_mm_add_ps(sum0, sum1));
+}
+
+AZA_SIMD_FEATURES("sse")
+void azaResamplerPolyphaseConvolve_sse(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history) {
+	AZA_RESAMPLER_POLYPHASE_LOOP(azaDotProduct_sse)
+}
+
+AZA_SIMD_FEATURES("avx")
+static AZA_FORCE_INLINE(float)
+azaDotProduct_avx(const float *a, const float *b, uint32_t count) {
+	__m256 sum0 = _mm256_setzero_ps();
+	__m256 sum1 = _mm256_setzero_ps();
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(a + i + 0), _mm256_loadu_ps(b + i + 0)));
+		sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+	}
+	if (i < count) {
+		sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+	}
+	return aza_mm256_hsum_ps(_mm256_add_ps(sum0, sum1));
+}
+
+AZA_SIMD_FEATURES("avx")
+void azaResamplerPolyphaseConvolve_avx(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history) {
+	AZA_RESAMPLER_POLYPHASE_LOOP(azaDotProduct_avx)
+}
+
+AZA_SIMD_FEATURES("avx,fma")
+static AZA_FORCE_INLINE(float)
+azaDotProduct_avx_fma(const float *a, const float *b, uint32_t count) {
+	__m256 sum0 = _mm256_setzero_ps();
+	__m256 sum1 = _mm256_setzero_ps();
+	uint32_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 0), _mm256_loadu_ps(b + i + 0), sum0);
+		sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), sum1);
+	}
+	if (i < count) {
+		sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+	}
+	return aza_mm256_hsum_ps(_mm256_add_ps(sum0, sum1));
+}
+
+AZA_SIMD_FEATURES("avx,fma")
+void azaResamplerPolyphaseConvolve_avx_fma(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history) {
+	AZA_RESAMPLER_POLYPHASE_LOOP(azaDotProduct_avx_fma)
+}
+
+void azaResamplerPolyphaseConvolve_dispatch(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history);
+void (*azaResamplerPolyphaseConvolve_specialized)(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history) = azaResamplerPolyphaseConvolve_dispatch;
+void azaResamplerPolyphaseConvolve_dispatch(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history) {
+	assert(azaCPUID.initted);
+	if (AZA_AVX && AZA_FMA) {
+		AZA_LOG_TRACE("choosing azaResamplerPolyphaseConvolve_avx_fma\n");
+		azaResamplerPolyphaseConvolve_specialized = azaResamplerPolyphaseConvolve_avx_fma;
+	} else
+	if (AZA_AVX) {
+		AZA_LOG_TRACE("choosing azaResamplerPolyphaseConvolve_avx\n");
+		azaResamplerPolyphaseConvolve_specialized = azaResamplerPolyphaseConvolve_avx;
+	} else
+	if (AZA_SSE) {
+		AZA_LOG_TRACE("choosing azaResamplerPolyphaseConvolve_sse\n");
+		azaResamplerPolyphaseConvolve_specialized = azaResamplerPolyphaseConvolve_sse;
+	} else
+	{
+		AZA_LOG_TRACE("choosing azaResamplerPolyphaseConvolve_scalar\n");
+		azaResamplerPolyphaseConvolve_specialized = azaResamplerPolyphaseConvolve_scalar;
+	}
+	azaResamplerPolyphaseConvolve_specialized(data, dst, dstStride, dstFrames, history);
+}
+
+// This only exists for ABI compatibility so we don't export a function pointer that changes
+void azaResamplerPolyphaseConvolve(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history) {
+	azaResamplerPolyphaseConvolve_specialized(data, dst, dstStride, dstFrames, history);
+}
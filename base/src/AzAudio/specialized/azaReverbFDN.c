@@ -0,0 +1,210 @@
+/*
+	File: azaReverbFDN.c
+	Author: Philip Haynes
+	Specialized implementations of the azaReverb feedback delay network and dispatch.
+	Non-specialized code still lives in azaReverb.c
+	Implements the following (declared in azaReverb.h):
+		- azaReverbFDNProcess(3)
+*/
+
+#include "../dsp/plugins/azaReverb.h"
+#include "../simd.h"
+#include "../AzAudio.h"
+
+#define FDN_LINES AZAUDIO_REVERB_FDN_LINES
+
+static_assert(FDN_LINES % 8 == 0, "The vector versions of azaReverbFDNProcess expect the lines to fill whole vectors");
+
+// Which rows of fdn->signs each channel uses. Row 0 is all ones, which the Householder matrix only ever flips, so we skip it.
+static inline const float* azaReverbFDNGetInputSigns(azaReverbFDN *fdn, uint8_t channel) {
+	return fdn->signs[1 + (2*channel) % (FDN_LINES-1)];
+}
+static inline const float* azaReverbFDNGetOutputSigns(azaReverbFDN *fdn, uint8_t channel) {
+	return fdn->signs[1 + (2*channel+1) % (FDN_LINES-1)];
+}
+
+// Scales both the input spread and the output sum so that the total gain through the network stays reasonable regardless of the number of lines
+static const float azaReverbFDNIOScale = 0.25f;
+static_assert(FDN_LINES == 16, "Update azaReverbFDNIOScale to 1/sqrt(FDN_LINES)");
+
+void azaReverbFDNProcess_scalar(azaReverbFDN *fdn, azaBuffer *buffer) {
+	uint32_t mask = fdn->delayMemoryFrames - 1;
+	uint8_t channels = buffer->channelLayout.count;
+	float householder = 2.0f / (float)FDN_LINES;
+	for (uint32_t i = 0; i < buffer->frames; i++) {
+		float *frame = buffer->pSamples + i * buffer->stride;
+		float lines[FDN_LINES];
+		float feedback[FDN_LINES];
+		float sum = 0.0f;
+		for (uint32_t j = 0; j < FDN_LINES; j++) {
+			lines[j] = fdn->delayMemory[((fdn->writeIndex - fdn->delays[j]) & mask) * FDN_LINES + j];
+			fdn->damping[j] += fdn->dampingCoefficient * (lines[j] - fdn->damping[j]);
+			feedback[j] = fdn->damping[j] * fdn->gains[j];
+			sum += feedback[j];
+		}
+		sum *= householder;
+		for (uint32_t j = 0; j < FDN_LINES; j++) {
+			feedback[j] -= sum;
+		}
+		for (uint8_t c = 0; c < channels; c++) {
+			const float *signs = azaReverbFDNGetInputSigns(fdn, c);
+			float input = frame[c] * azaReverbFDNIOScale;
+			for (uint32_t j = 0; j < FDN_LINES; j++) {
+				feedback[j] += input * signs[j];
+			}
+		}
+		for (uint8_t c = 0; c < channels; c++) {
+			const float *signs = azaReverbFDNGetOutputSigns(fdn, c);
+			float output = 0.0f;
+			for (uint32_t j = 0; j < FDN_LINES; j++) {
+				output += lines[j] * signs[j];
+			}
+			frame[c] = output * azaReverbFDNIOScale;
+		}
+		float *row = fdn->delayMemory + fdn->writeIndex * FDN_LINES;
+		for (uint32_t j = 0; j < FDN_LINES; j++) {
+			row[j] = feedback[j];
+		}
+		fdn->writeIndex = (fdn->writeIndex + 1) & mask;
+	}
+}
+
+AZA_SIMD_FEATURES("sse")
+void azaReverbFDNProcess_sse(azaReverbFDN *fdn, azaBuffer *buffer) {
+	enum { VECTORS = FDN_LINES / 4 };
+	uint32_t mask = fdn->delayMemoryFrames - 1;
+	uint8_t channels = buffer->channelLayout.count;
+	__m128 householder = _mm_set1_ps(2.0f / (float)FDN_LINES);
+	__m128 dampingCoefficient = _mm_set1_ps(fdn->dampingCoefficient);
+	__m128 damping[VECTORS], gains[VECTORS];
+	for (uint32_t v = 0; v < VECTORS; v++) {
+		damping[v] = _mm_loadu_ps(fdn->damping + v*4);
+		gains[v] = _mm_loadu_ps(fdn->gains + v*4);
+	}
+	for (uint32_t i = 0; i < buffer->frames; i++) {
+		float *frame = buffer->pSamples + i * buffer->stride;
+		// Gathering from every line is the only part that can't be done with whole vectors
+		float gathered[FDN_LINES];
+		for (uint32_t j = 0; j < FDN_LINES; j++) {
+			gathered[j] = fdn->delayMemory[((fdn->writeIndex - fdn->delays[j]) & mask) * FDN_LINES + j];
+		}
+		__m128 lines[VECTORS], feedback[VECTORS];
+		__m128 sum = _mm_setzero_ps();
+		for (uint32_t v = 0; v < VECTORS; v++) {
+			lines[v] = _mm_loadu_ps(gathered + v*4);
+			damping[v] = _mm_add_ps(damping[v], _mm_mul_ps(dampingCoefficient, _mm_sub_ps(lines[v], damping[v])));
+			feedback[v] = _mm_mul_ps(damping[v], gains[v]);
+			sum = _mm_add_ps(sum, feedback[v]);
+		}
+		sum = _mm_mul_ps(_mm_set1_ps(aza_mm_hsum_ps_sse(sum)), householder);
+		for (uint32_t v = 0; v < VECTORS; v++) {
+			feedback[v] = _mm_sub_ps(feedback[v], sum);
+		}
+		for (uint8_t c = 0; c < channels; c++) {
+			const float *signs = azaReverbFDNGetInputSigns(fdn, c);
+			__m128 input = _mm_set1_ps(frame[c] * azaReverbFDNIOScale);
+			for (uint32_t v = 0; v < VECTORS; v++) {
+				feedback[v] = _mm_add_ps(feedback[v], _mm_mul_ps(input, _mm_loadu_ps(signs + v*4)));
+			}
+		}
+		for (uint8_t c = 0; c < channels; c++) {
+			const float *signs = azaReverbFDNGetOutputSigns(fdn, c);
+			__m128 output = _mm_setzero_ps();
+			for (uint32_t v = 0; v < VECTORS; v++) {
+				output = _mm_add_ps(output, _mm_mul_ps(lines[v], _mm_loadu_ps(signs + v*4)));
+			}
+			frame[c] = aza_mm_hsum_ps_sse(output) * azaReverbFDNIOScale;
+		}
+		float *row = fdn->delayMemory + fdn->writeIndex * FDN_LINES;
+		for (uint32_t v = 0; v < VECTORS; v++) {
+			_mm_storeu_ps(row + v*4, feedback[v]);
+		}
+		fdn->writeIndex = (fdn->writeIndex + 1) & mask;
+	}
+	for (uint32_t v = 0; v < VECTORS; v++) {
+		_mm_storeu_ps(fdn->damping + v*4, damping[v]);
+	}
+}
+
+AZA_SIMD_FEATURES("avx")
+void azaReverbFDNProcess_avx(azaReverbFDN *fdn, azaBuffer *buffer) {
+	enum { VECTORS = FDN_LINES / 8 };
+	uint32_t mask = fdn->delayMemoryFrames - 1;
+	uint8_t channels = buffer->channelLayout.count;
+	__m256 householder = _mm256_set1_ps(2.0f / (float)FDN_LINES);
+	__m256 dampingCoefficient = _mm256_set1_ps(fdn->dampingCoefficient);
+	__m256 damping[VECTORS], gains[VECTORS];
+	for (uint32_t v = 0; v < VECTORS; v++) {
+		damping[v] = _mm256_loadu_ps(fdn->damping + v*8);
+		gains[v] = _mm256_loadu_ps(fdn->gains + v*8);
+	}
+	for (uint32_t i = 0; i < buffer->frames; i++) {
+		float *frame = buffer->pSamples + i * buffer->stride;
+		// Gathering from every line is the only part that can't be done with whole vectors
+		// NOTE: We could use AVX2 gather instructions here, but as noted in azaKernel.c they're no faster than individual loads.
+		float gathered[FDN_LINES];
+		for (uint32_t j = 0; j < FDN_LINES; j++) {
+			gathered[j] = fdn->delayMemory[((fdn->writeIndex - fdn->delays[j]) & mask) * FDN_LINES + j];
+		}
+		__m256 lines[VECTORS], feedback[VECTORS];
+		__m256 sum = _mm256_setzero_ps();
+		for (uint32_t v = 0; v < VECTORS; v++) {
+			lines[v] = _mm256_loadu_ps(gathered + v*8);
+			damping[v] = _mm256_add_ps(damping[v], _mm256_mul_ps(dampingCoefficient, _mm256_sub_ps(lines[v], damping[v])));
+			feedback[v] = _mm256_mul_ps(damping[v], gains[v]);
+			sum = _mm256_add_ps(sum, feedback[v]);
+		}
+		sum = _mm256_mul_ps(_mm256_set1_ps(aza_mm256_hsum_ps(sum)), householder);
+		for (uint32_t v = 0; v < VECTORS; v++) {
+			feedback[v] = _mm256_sub_ps(feedback[v], sum);
+		}
+		for (uint8_t c = 0; c < channels; c++) {
+			const float *signs = azaReverbFDNGetInputSigns(fdn, c);
+			__m256 input = _mm256_set1_ps(frame[c] * azaReverbFDNIOScale);
+			for (uint32_t v = 0; v < VECTORS; v++) {
+				feedback[v] = _mm256_add_ps(feedback[v], _mm256_mul_ps(input, _mm256_loadu_ps(signs + v*8)));
+			}
+		}
+		for (uint8_t c = 0; c < channels; c++) {
+			const float *signs = azaReverbFDNGetOutputSigns(fdn, c);
+			__m256 output = _mm256_setzero_ps();
+			for (uint32_t v = 0; v < VECTORS; v++) {
+				output = _mm256_add_ps(output, _mm256_mul_ps(lines[v], _mm256_loadu_ps(signs + v*8)));
+			}
+			frame[c] = aza_mm256_hsum_ps(output) * azaReverbFDNIOScale;
+		}
+		float *row = fdn->delayMemory + fdn->writeIndex * FDN_LINES;
+		for (uint32_t v = 0; v < VECTORS; v++) {
+			_mm256_storeu_ps(row + v*8, feedback[v]);
+		}
+		fdn->writeIndex = (fdn->writeIndex + 1) & mask;
+	}
+	for (uint32_t v = 0; v < VECTORS; v++) {
+		_mm256_storeu_ps(fdn->damping + v*8, damping[v]);
+	}
+}
+
+void azaReverbFDNProcess_dispatch(azaReverbFDN *fdn, azaBuffer *buffer);
+void (*azaReverbFDNProcess_specialized)(azaReverbFDN *fdn, azaBuffer *buffer) = azaReverbFDNProcess_dispatch;
+void azaReverbFDNProcess_dispatch(azaReverbFDN *fdn, azaBuffer *buffer) {
+	assert(azaCPUID.initted);
+	if (AZA_AVX) {
+		AZA_LOG_TRACE("choosing azaReverbFDNProcess_avx\n");
+		azaReverbFDNProcess_specialized = azaReverbFDNProcess_avx;
+	} else
+	if (AZA_SSE) {
+		AZA_LOG_TRACE("choosing azaReverbFDNProcess_sse\n");
+		azaReverbFDNProcess_specialized = azaReverbFDNProcess_sse;
+	} else
+	{
+		AZA_LOG_TRACE("choosing azaReverbFDNProcess_scalar\n");
+		azaReverbFDNProcess_specialized = azaReverbFDNProcess_scalar;
+	}
+	azaReverbFDNProcess_specialized(fdn, buffer);
+}
+
+// This only exists for ABI compatibility so we don't export a function pointer that changes
+void azaReverbFDNProcess(azaReverbFDN *fdn, azaBuffer *buffer) {
+	assert(fdn->delayMemory != NULL);
+	azaReverbFDNProcess_specialized(fdn, buffer);
+}
@@ -59,6 +59,7 @@ int main(int argumentCount, char** argumentValues) {
 	limiter = azaLookaheadLimiterMake((azaLookaheadLimiterConfig) {
 		.gainInput  =  10.0f,
 		.gainOutput = -10.0f,
+		.lookahead_ms = AZAUDIO_LOOKAHEAD_DEFAULT_MS,
 	});
 
 	azaStreamSetActive(&streamOutput, 1);
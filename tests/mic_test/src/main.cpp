@@ -83,6 +83,7 @@ struct SideBufferPopper {
 int processCallbackOutput(void *userdata, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
 	SideBufferPopper popper{1};
 	azaBuffer srcBuffer = azaPushSideBufferZero(dst->frames, 0, 0, 1, dst->samplerate);
+	if (!srcBuffer.pSamples) return AZA_ERROR_OUT_OF_MEMORY;
 	numOutputBuffers++;
 	if (micBuffer.size() == lastMicBufferSize && micBuffer.size() > dst->frames*2) {
 		sys::cout << "Shrunk!" << std::endl;
@@ -352,6 +353,7 @@ int main(int argumentCount, char** argumentValues) {
 		limiter = azaLookaheadLimiterMake(azaLookaheadLimiterConfig{
 			/* .gainInput  = */ 6.0f,
 			/* .gainOutput = */-6.0f,
+			/* .lookahead_ms = */ AZAUDIO_LOOKAHEAD_DEFAULT_MS,
 		});
 
 		delayDynamic = azaDelayDynamicMake(azaDelayDynamicConfig{
@@ -409,7 +409,7 @@ int main(int argumentCount, char** argumentValues) {
 	azaTrack *track1;
 	// azaChannelLayout track1Layout = azaChannelLayoutMono();
 	// azaChannelLayout track1Layout = azaChannelLayout_9_1();
-	azaChannelLayout track1Layout = mixer.master.buffer.channelLayout;
+	azaChannelLayout track1Layout = mixer.master.bufferChannelLayout;
 	if ((err = azaMixerAddTrack(&mixer, -1, &track1, track1Layout, true))) {
 		fprintf(stderr, "Failed to azaMixerAddTrack (%s)\n", azaErrorString(err));
 		return 1;
@@ -449,7 +449,7 @@ int main(int argumentCount, char** argumentValues) {
 
 	azaTrack *track2;
 	// azaChannelLayout track2Layout = azaChannelLayout_9_0();
-	azaChannelLayout track2Layout = mixer.master.buffer.channelLayout;
+	azaChannelLayout track2Layout = mixer.master.bufferChannelLayout;
 	if ((err = azaMixerAddTrack(&mixer, -1, &track2, track2Layout, true))) {
 		fprintf(stderr, "Failed to azaMixerAddTrack (%s)\n", azaErrorString(err));
 		return 1;
@@ -497,6 +497,7 @@ int main(int argumentCount, char** argumentValues) {
 	azaLookaheadLimiter *limiter = azaLookaheadLimiterMake((azaLookaheadLimiterConfig) {
 		.gainInput  =  0.0f,
 		.gainOutput = -0.1f,
+		.lookahead_ms = 5.0f,
 	});
 	// limiter->header.bypass = true;
 	azaTrackAppendDSP(&mixer.master, (azaDSP*)limiter);
@@ -506,6 +507,8 @@ int main(int argumentCount, char** argumentValues) {
 	// Uncomment this to test if cyclic routing is detected
 	// azaTrackConnect(&mixer.master, &mixer.tracks[0], 0.0f, NULL, 0);
 
+	azaMixerCommit(&mixer);
+
 	azaMixerStreamSetActive(&mixer, true);
 
 
@@ -7,9 +7,19 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 
 #include <AzAudio/AzAudio.h>
 #include <AzAudio/timer.h>
+#include <AzAudio/fft.h>
+#include <AzAudio/cpuid.h>
+#include <AzAudio/dsp/azaKernel.h>
+#include <AzAudio/dsp/azaResamplerPolyphase.h>
+#include <AzAudio/dsp/plugins/azaFilter.h>
+#include <AzAudio/dsp/plugins/azaRMS.h>
+#include <AzAudio/dsp/plugins/azaCompressor.h>
+#include <AzAudio/dsp/plugins/azaLookaheadLimiter.h>
+#include <AzAudio/dsp/plugins/azaCubicLimiter.h>
 
 #define TEST_BUFFERS_FRAME_COUNT 1234
 #define TEST_ITERATIONS 10000ull
@@ -20,17 +30,20 @@ void azaBufferDeinterlace2Ch_scalar(azaBuffer *dst, azaBuffer *src);
 void azaBufferDeinterlace2Ch_sse(azaBuffer *dst, azaBuffer *src);
 void azaBufferDeinterlace2Ch_avx(azaBuffer *dst, azaBuffer *src);
 void azaBufferDeinterlace2Ch_avx2(azaBuffer *dst, azaBuffer *src);
+void azaBufferDeinterlace2Ch_avx512f(azaBuffer *dst, azaBuffer *src);
 
 void azaBufferDeinterlace3Ch_scalar(azaBuffer *dst, azaBuffer *src);
 void azaBufferDeinterlace3Ch_sse(azaBuffer *dst, azaBuffer *src);
 void azaBufferDeinterlace3Ch_sse4_1(azaBuffer *dst, azaBuffer *src);
 void azaBufferDeinterlace3Ch_avx(azaBuffer *dst, azaBuffer *src);
 void azaBufferDeinterlace3Ch_avx2(azaBuffer *dst, azaBuffer *src);
+void azaBufferDeinterlace3Ch_avx512f(azaBuffer *dst, azaBuffer *src);
 
 void azaBufferDeinterlace4Ch_scalar(azaBuffer *dst, azaBuffer *src);
 void azaBufferDeinterlace4Ch_sse(azaBuffer *dst, azaBuffer *src);
 void azaBufferDeinterlace4Ch_avx(azaBuffer *dst, azaBuffer *src);
 void azaBufferDeinterlace4Ch_avx2(azaBuffer *dst, azaBuffer *src);
+void azaBufferDeinterlace4Ch_avx512f(azaBuffer *dst, azaBuffer *src);
 
 
 void azaBufferReinterlace_dynamic(azaBuffer *dst, azaBuffer *src);
@@ -46,6 +59,103 @@ void azaBufferReinterlace4Ch_scalar(azaBuffer *dst, azaBuffer *src);
 void azaBufferReinterlace4Ch_sse(azaBuffer *dst, azaBuffer *src);
 void azaBufferReinterlace4Ch_avx(azaBuffer *dst, azaBuffer *src);
 
+#define TEST_FFT_LOG2_LEN 13
+#define TEST_FFT_CHANNELS 16
+#define TEST_FFT_ITERATIONS 100ull
+
+void azaFFTPlanTransform_scalar(azaFFTPlan *plan, float *valReal, float *valImag, uint32_t log2n);
+void azaFFTPlanTransform_sse(azaFFTPlan *plan, float *valReal, float *valImag, uint32_t log2n);
+void azaFFTPlanTransform_avx(azaFFTPlan *plan, float *valReal, float *valImag, uint32_t log2n);
+void azaFFTPlanTransform_avx_fma(azaFFTPlan *plan, float *valReal, float *valImag, uint32_t log2n);
+
+// Adapts the original radix-2 azaFFT to the plan signature for comparison
+void azaFFTPlanTransform_legacy(azaFFTPlan *plan, float *valReal, float *valImag, uint32_t log2n) {
+	azaFFT(valReal, valImag, 1u << log2n);
+}
+
+void azaFFTPlanTransform_mainAPI(azaFFTPlan *plan, float *valReal, float *valImag, uint32_t log2n) {
+	azaFFTPlanForward(plan, valReal, valImag);
+}
+
+void azaBufferMix_scalar(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc);
+void azaBufferMix_sse(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc);
+void azaBufferMix_avx(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc);
+void azaBufferMix_avx_fma(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc);
+
+void azaBufferMixFadeLinear_scalar(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep);
+void azaBufferMixFadeLinear_sse(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep);
+void azaBufferMixFadeLinear_avx(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep);
+void azaBufferMixFadeLinear_avx_fma(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep);
+
+// The original double loop with a division every frame, for comparison
+void azaBufferMixFadeLinear_legacy(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep) {
+	const float framesF = (float)dst->frames;
+	const float volumeDstDelta = volumeDstStep * framesF;
+	const float volumeSrcDelta = volumeSrcStep * framesF;
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		float t = (float)i / framesF;
+		float volumeDst = volumeDstStart + volumeDstDelta * t;
+		float volumeSrc = volumeSrcStart + volumeSrcDelta * t;
+		for (uint32_t c = 0; c < dst->channelLayout.count; c++) {
+			dst->pSamples[i * dst->stride + c] = dst->pSamples[i * dst->stride + c] * volumeDst + src->pSamples[i * src->stride + c] * volumeSrc;
+		}
+	}
+}
+
+void azaBufferMixFadeLinear_mainAPI(azaBuffer *dst, float volumeDstStart, float volumeDstStep, azaBuffer *src, float volumeSrcStart, float volumeSrcStep) {
+	const float framesF = (float)dst->frames;
+	azaBufferMixFadeLinear(dst, volumeDstStart, volumeDstStart + volumeDstStep * framesF, src, volumeSrcStart, volumeSrcStart + volumeSrcStep * framesF);
+}
+
+#define TEST_RESAMPLE_SRC_SAMPLERATE 44100
+#define TEST_RESAMPLE_DST_SAMPLERATE 48000
+#define TEST_RESAMPLE_RADIUS 32
+// Rounded up, because how many frames a block makes varies by one depending on the streaming state
+#define TEST_RESAMPLE_DST_FRAMES ((TEST_BUFFERS_FRAME_COUNT * TEST_RESAMPLE_DST_SAMPLERATE + TEST_RESAMPLE_SRC_SAMPLERATE-1) / TEST_RESAMPLE_SRC_SAMPLERATE)
+
+extern void (*azaResamplerPolyphaseConvolve_specialized)(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history);
+void azaResamplerPolyphaseConvolve_scalar(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history);
+void azaResamplerPolyphaseConvolve_sse(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history);
+void azaResamplerPolyphaseConvolve_avx(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history);
+void azaResamplerPolyphaseConvolve_avx_fma(azaResamplerPolyphase *data, float *dst, uint32_t dstStride, uint32_t dstFrames, const float *history);
+
+void azaBufferMixMatrix_scalar(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc, azaChannelMatrix *matrix);
+void azaBufferMixMatrix_avx_fma(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc, azaChannelMatrix *matrix);
+void azaBufferMixMatrix_avx512f(azaBuffer *dst, float volumeDst, azaBuffer *src, float volumeSrc, azaChannelMatrix *matrix);
+
+#define TEST_KERNEL_RADIUS 32
+#define TEST_KERNEL_ITERATIONS 1000000ull
+
+void azaSampleWithKernel_scalar(float *dst, int dstChannels, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t frame, float fraction, float rate);
+void azaSampleWithKernel_avx_fma(float *dst, int dstChannels, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t frame, float fraction, float rate);
+void azaSampleWithKernel_avx512f(float *dst, int dstChannels, azaKernel *kernel, float *src, int srcStride, int minFrame, int maxFrame, bool wrap, int32_t frame, float fraction, float rate);
+
+void azaFilterProcessCascade_scalar(azaFilter *data, azaBuffer *dst, azaBuffer *src, float amountWet, float amountDry);
+void azaFilterProcessCascade_sse(azaFilter *data, azaBuffer *dst, azaBuffer *src, float amountWet, float amountDry);
+void azaFilterProcessCascade_avx(azaFilter *data, azaBuffer *dst, azaBuffer *src, float amountWet, float amountDry);
+
+#define TEST_FILTER_ITERATIONS 1000ull
+
+void azaRMSProcessWindow_scalar(azaRMS *data, azaBuffer *dst, azaBuffer *src);
+void azaRMSProcessWindow_sse(azaRMS *data, azaBuffer *dst, azaBuffer *src);
+void azaRMSProcessWindow_avx(azaRMS *data, azaBuffer *dst, azaBuffer *src);
+
+#define TEST_RMS_ITERATIONS 1000ull
+
+void aza_amp_to_dbf_array_scalar(float *dst, const float *src, uint32_t count);
+void aza_amp_to_dbf_array_sse(float *dst, const float *src, uint32_t count);
+void aza_amp_to_dbf_array_avx2(float *dst, const float *src, uint32_t count);
+void aza_db_to_ampf_array_scalar(float *dst, const float *src, uint32_t count);
+void aza_db_to_ampf_array_sse(float *dst, const float *src, uint32_t count);
+void aza_db_to_ampf_array_avx2(float *dst, const float *src, uint32_t count);
+
+#define TEST_DECIBELS_ITERATIONS 10000ull
+
+// Big enough that one callback's worth of samples doesn't fit in L1, like a 7.1 track on a backend that asks for big buffers
+#define TEST_CHAIN_CALLBACK_FRAMES 2048
+#define TEST_CHAIN_CHANNELS 8
+#define TEST_CHAIN_ITERATIONS 1000ull
+
 // For the purpose of testing the theoretical maximum throughput (this is by no means a realistic goal, but provides some context)
 void azaBufferDeinterlace_memcpy(azaBuffer *dst, azaBuffer *src) {
 	memcpy(dst->pSamples, src->pSamples, sizeof(float) * dst->frames * dst->channelLayout.count);
@@ -128,6 +238,606 @@ int64_t TestReinterlace(void(*fp_reinterlace)(azaBuffer*,azaBuffer*), uint8_t ch
 	return nanoseconds;
 }
 
+// Returns the total time in nanoseconds
+// Every iteration transforms TEST_FFT_CHANNELS channels, each needing a fresh copy of the input since the transforms are in-place. The copies are included in the timing.
+int64_t TestFFT(void(*fp_fft)(azaFFTPlan*,float*,float*,uint32_t), const char *name) {
+	uint32_t len = 1u << TEST_FFT_LOG2_LEN;
+	azaFFTPlan plan;
+	if (azaFFTPlanInit(&plan, len)) {
+		fprintf(stderr, "Failed to azaFFTPlanInit!\n");
+		exit(1);
+	}
+	float *srcReal = malloc(sizeof(float) * len * TEST_FFT_CHANNELS);
+	float *srcImag = malloc(sizeof(float) * len * TEST_FFT_CHANNELS);
+	float *real = malloc(sizeof(float) * len * TEST_FFT_CHANNELS);
+	float *imag = malloc(sizeof(float) * len * TEST_FFT_CHANNELS);
+	float *refReal = malloc(sizeof(float) * len);
+	float *refImag = malloc(sizeof(float) * len);
+	srand(1337);
+	for (uint32_t i = 0; i < len * TEST_FFT_CHANNELS; i++) {
+		srcReal[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+		srcImag[i] = 0.0f;
+	}
+
+	int64_t start = azaGetTimestamp();
+
+	for (uint32_t i = 0; i < TEST_FFT_ITERATIONS; i++) {
+		memcpy(real, srcReal, sizeof(float) * len * TEST_FFT_CHANNELS);
+		memcpy(imag, srcImag, sizeof(float) * len * TEST_FFT_CHANNELS);
+		for (uint32_t c = 0; c < TEST_FFT_CHANNELS; c++) {
+			fp_fft(&plan, real + c * len, imag + c * len, TEST_FFT_LOG2_LEN);
+		}
+	}
+
+	int64_t end = azaGetTimestamp();
+	int64_t nanoseconds = azaGetTimestampDeltaNanoseconds(end - start);
+
+	// azaFFT only gives us the first len/2+1 bins, so that's all we can compare against
+	bool error = false;
+	for (uint32_t c = 0; c < TEST_FFT_CHANNELS; c++) {
+		memcpy(refReal, srcReal + c * len, sizeof(float) * len);
+		memcpy(refImag, srcImag + c * len, sizeof(float) * len);
+		azaFFT(refReal, refImag, len);
+		for (uint32_t i = 0; i <= len/2; i++) {
+			if (fabsf(real[c * len + i] - refReal[i]) > 0.001f || fabsf(imag[c * len + i] - refImag[i]) > 0.001f) error = true;
+		}
+	}
+	if (error) {
+		printf("%s: \033[91mWRONGE\033[0m\n", name);
+	} else {
+		printf("%s: \033[92mCORRECTE\033[0m\n", name);
+	}
+	free(srcReal);
+	free(srcImag);
+	free(real);
+	free(imag);
+	free(refReal);
+	free(refImag);
+	azaFFTPlanDeinit(&plan);
+	printf("\ttook %6lld nanoseconds on average per %u point transform\n", nanoseconds / (TEST_FFT_ITERATIONS * TEST_FFT_CHANNELS), len);
+	return nanoseconds;
+}
+
+// Returns the total time in nanoseconds
+// Fades dst out and src in, then checks the result against azaBufferMixFadeLinear_scalar. The volumes keep dst bounded across iterations.
+int64_t TestMixFadeLinear(void(*fp_mix)(azaBuffer*,float,float,azaBuffer*,float,float), uint8_t channelCount, const char *name) {
+	azaBuffer dst, src, ref;
+	azaBufferInit(&dst, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	azaBufferInit(&src, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	azaBufferInit(&ref, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	srand(1337);
+	for (uint32_t i = 0; i < src.frames * channelCount; i++) {
+		src.pSamples[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	}
+	azaBufferZero(&dst);
+	const float volumeDstStep = -0.5f / (float)TEST_BUFFERS_FRAME_COUNT;
+	const float volumeSrcStep = 0.5f / (float)TEST_BUFFERS_FRAME_COUNT;
+
+	int64_t start = azaGetTimestamp();
+
+	for (uint32_t i = 0; i < TEST_ITERATIONS; i++) {
+		fp_mix(&dst, 1.0f, volumeDstStep, &src, 0.0f, volumeSrcStep);
+	}
+
+	int64_t end = azaGetTimestamp();
+	int64_t nanoseconds = azaGetTimestampDeltaNanoseconds(end - start);
+
+	azaBufferCopy(&ref, &dst);
+	fp_mix(&dst, 1.0f, volumeDstStep, &src, 0.0f, volumeSrcStep);
+	azaBufferMixFadeLinear_scalar(&ref, 1.0f, volumeDstStep, &src, 0.0f, volumeSrcStep);
+	bool error = false;
+	for (uint32_t i = 0; i < dst.frames * channelCount; i++) {
+		if (fabsf(dst.pSamples[i] - ref.pSamples[i]) > 0.0001f) error = true;
+	}
+	if (error) {
+		printf("%s: \033[91mWRONGE\033[0m\n", name);
+	} else {
+		printf("%s: \033[92mCORRECTE\033[0m\n", name);
+	}
+	azaBufferDeinit(&dst, true);
+	azaBufferDeinit(&src, true);
+	azaBufferDeinit(&ref, true);
+	printf("\ttook %6lld nanoseconds on average\n", nanoseconds / TEST_ITERATIONS);
+	return nanoseconds;
+}
+
+// Returns the total time in nanoseconds
+int64_t TestMix(void(*fp_mix)(azaBuffer*,float,azaBuffer*,float), uint8_t channelCount, const char *name) {
+	azaBuffer dst, src, ref;
+	azaBufferInit(&dst, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	azaBufferInit(&src, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	azaBufferInit(&ref, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	srand(1337);
+	for (uint32_t i = 0; i < src.frames * channelCount; i++) {
+		src.pSamples[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	}
+	azaBufferZero(&dst);
+
+	int64_t start = azaGetTimestamp();
+
+	for (uint32_t i = 0; i < TEST_ITERATIONS; i++) {
+		fp_mix(&dst, 0.5f, &src, 0.5f);
+	}
+
+	int64_t end = azaGetTimestamp();
+	int64_t nanoseconds = azaGetTimestampDeltaNanoseconds(end - start);
+
+	azaBufferCopy(&ref, &dst);
+	fp_mix(&dst, 0.5f, &src, 0.5f);
+	azaBufferMix_scalar(&ref, 0.5f, &src, 0.5f);
+	bool error = false;
+	for (uint32_t i = 0; i < dst.frames * channelCount; i++) {
+		if (fabsf(dst.pSamples[i] - ref.pSamples[i]) > 0.0001f) error = true;
+	}
+	if (error) {
+		printf("%s: \033[91mWRONGE\033[0m\n", name);
+	} else {
+		printf("%s: \033[92mCORRECTE\033[0m\n", name);
+	}
+	azaBufferDeinit(&dst, true);
+	azaBufferDeinit(&src, true);
+	azaBufferDeinit(&ref, true);
+	printf("\ttook %6lld nanoseconds on average\n", nanoseconds / TEST_ITERATIONS);
+	return nanoseconds;
+}
+
+// Returns the total time in nanoseconds
+// Mixes through a random dense matrix, then checks the result against azaBufferMixMatrix_scalar
+int64_t TestMixMatrix(void(*fp_mix)(azaBuffer*,float,azaBuffer*,float,azaChannelMatrix*), uint8_t srcChannelCount, uint8_t dstChannelCount, const char *name) {
+	azaBuffer dst, src, ref;
+	azaBufferInit(&dst, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(dstChannelCount));
+	azaBufferInit(&src, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(srcChannelCount));
+	azaBufferInit(&ref, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(dstChannelCount));
+	azaChannelMatrix matrix;
+	azaChannelMatrixInit(&matrix, srcChannelCount, dstChannelCount);
+	srand(1337);
+	for (uint32_t i = 0; i < src.frames * srcChannelCount; i++) {
+		src.pSamples[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	}
+	for (uint32_t i = 0; i < (uint32_t)srcChannelCount * dstChannelCount; i++) {
+		matrix.matrix[i] = (float)rand() / (float)RAND_MAX;
+	}
+	azaBufferZero(&dst);
+
+	int64_t start = azaGetTimestamp();
+
+	for (uint32_t i = 0; i < TEST_ITERATIONS; i++) {
+		fp_mix(&dst, 0.5f, &src, 0.5f, &matrix);
+	}
+
+	int64_t end = azaGetTimestamp();
+	int64_t nanoseconds = azaGetTimestampDeltaNanoseconds(end - start);
+
+	azaBufferCopy(&ref, &dst);
+	fp_mix(&dst, 0.5f, &src, 0.5f, &matrix);
+	azaBufferMixMatrix_scalar(&ref, 0.5f, &src, 0.5f, &matrix);
+	bool error = false;
+	for (uint32_t i = 0; i < dst.frames * dstChannelCount; i++) {
+		if (fabsf(dst.pSamples[i] - ref.pSamples[i]) > 0.0001f) error = true;
+	}
+	if (error) {
+		printf("%s: \033[91mWRONGE\033[0m\n", name);
+	} else {
+		printf("%s: \033[92mCORRECTE\033[0m\n", name);
+	}
+	azaChannelMatrixDeinit(&matrix);
+	azaBufferDeinit(&dst, true);
+	azaBufferDeinit(&src, true);
+	azaBufferDeinit(&ref, true);
+	printf("\ttook %6lld nanoseconds on average\n", nanoseconds / TEST_ITERATIONS);
+	return nanoseconds;
+}
+
+// Returns the total time in nanoseconds
+// Samples an interlaced buffer at TEST_KERNEL_ITERATIONS different positions, and checks every result against azaSampleWithKernel_scalar
+int64_t TestSampleWithKernel(void(*fp_sample)(float*,int,azaKernel*,float*,int,int,int,bool,int32_t,float,float), uint8_t channelCount, float rate, const char *name) {
+	azaKernel *kernel = azaKernelGetDefaultLanczos(TEST_KERNEL_RADIUS);
+	azaBuffer src;
+	azaBufferInit(&src, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	srand(1337);
+	for (uint32_t i = 0; i < src.frames * channelCount; i++) {
+		src.pSamples[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	}
+	float result[AZA_MAX_CHANNEL_POSITIONS];
+	float sum = 0.0f;
+
+	int64_t start = azaGetTimestamp();
+
+	for (uint32_t i = 0; i < TEST_KERNEL_ITERATIONS; i++) {
+		fp_sample(result, channelCount, kernel, src.pSamples, src.stride, 0, (int)src.frames, false, (int32_t)(i % src.frames), 0.37f, rate);
+		sum += result[0];
+	}
+
+	int64_t end = azaGetTimestamp();
+	int64_t nanoseconds = azaGetTimestampDeltaNanoseconds(end - start);
+
+	bool error = false;
+	for (uint32_t i = 0; i < src.frames; i++) {
+		float reference[AZA_MAX_CHANNEL_POSITIONS];
+		// Wrap the odd ones so both edge cases get covered
+		bool wrap = i % 2;
+		fp_sample(result, channelCount, kernel, src.pSamples, src.stride, 0, (int)src.frames, wrap, (int32_t)i, 0.37f, rate);
+		azaSampleWithKernel_scalar(reference, channelCount, kernel, src.pSamples, src.stride, 0, (int)src.frames, wrap, (int32_t)i, 0.37f, rate);
+		for (uint8_t c = 0; c < channelCount; c++) {
+			if (fabsf(result[c] - reference[c]) > 0.001f) error = true;
+		}
+	}
+	if (error) {
+		printf("%s: \033[91mWRONGE\033[0m\n", name);
+	} else {
+		printf("%s: \033[92mCORRECTE\033[0m\n", name);
+	}
+	azaBufferDeinit(&src, true);
+	// Printing the sum keeps the compiler from throwing the work away
+	printf("\ttook %6lld nanoseconds on average (%.1f)\n", nanoseconds / TEST_KERNEL_ITERATIONS, sum);
+	return nanoseconds;
+}
+
+// Returns the total time in nanoseconds
+// Plays an interlaced buffer back at a speed ramping from 0.8 to 0.9, TEST_BUFFERS_FRAME_COUNT frames at a time from the start, for TEST_KERNEL_ITERATIONS frames in total.
+// If block is true this uses azaSampleWithKernelBlock, otherwise it calls azaSampleWithKernel for every frame like azaSampler used to. Every frame is checked against the other way.
+int64_t TestSampleWithKernelBlock(bool block, uint8_t channelCount, const char *name) {
+	azaKernel *kernel = azaKernelGetDefaultLanczos(TEST_KERNEL_RADIUS);
+	const float rate = 0.8f;
+	azaBuffer src, dst, ref;
+	azaBufferInit(&src, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	azaBufferInit(&dst, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	azaBufferInit(&ref, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	srand(1337);
+	for (uint32_t i = 0; i < src.frames * channelCount; i++) {
+		src.pSamples[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	}
+	float speeds[TEST_BUFFERS_FRAME_COUNT];
+	for (uint32_t i = 0; i < TEST_BUFFERS_FRAME_COUNT; i++) {
+		speeds[i] = 0.8f + 0.1f * (float)i / (float)TEST_BUFFERS_FRAME_COUNT;
+	}
+	int32_t frame;
+	float fraction;
+	float sum = 0.0f;
+
+	int64_t start = azaGetTimestamp();
+
+	for (uint32_t i = 0; i < TEST_KERNEL_ITERATIONS; i += TEST_BUFFERS_FRAME_COUNT) {
+		// Start over every time so we never run off the end of src
+		frame = 0;
+		fraction = 0.0f;
+		if (block) {
+			azaSampleWithKernelBlock(dst.pSamples, dst.stride, channelCount, dst.frames, kernel, src.pSamples, src.stride, 0, (int)src.frames, true, &frame, &fraction, speeds, INT32_MIN, INT32_MAX, rate);
+		} else {
+			for (uint32_t j = 0; j < dst.frames; j++) {
+				azaSampleWithKernel(dst.pSamples + j * dst.stride, channelCount, kernel, src.pSamples, src.stride, 0, (int)src.frames, true, frame, fraction, rate);
+				fraction += speeds[j];
+				int32_t framesToAdd = (int32_t)truncf(fraction);
+				frame += framesToAdd;
+				fraction -= (float)framesToAdd;
+			}
+		}
+		sum += dst.pSamples[0];
+	}
+
+	int64_t end = azaGetTimestamp();
+	int64_t nanoseconds = azaGetTimestampDeltaNanoseconds(end - start);
+
+	frame = 7;
+	fraction = 0.0f;
+	azaSampleWithKernelBlock(dst.pSamples, dst.stride, channelCount, dst.frames, kernel, src.pSamples, src.stride, 0, (int)src.frames, true, &frame, &fraction, speeds, INT32_MIN, INT32_MAX, rate);
+	frame = 7;
+	fraction = 0.0f;
+	bool error = false;
+	for (uint32_t j = 0; j < ref.frames; j++) {
+		azaSampleWithKernel(ref.pSamples + j * ref.stride, channelCount, kernel, src.pSamples, src.stride, 0, (int)src.frames, true, frame, fraction, rate);
+		fraction += speeds[j];
+		int32_t framesToAdd = (int32_t)truncf(fraction);
+		frame += framesToAdd;
+		fraction -= (float)framesToAdd;
+		for (uint8_t c = 0; c < channelCount; c++) {
+			if (fabsf(dst.pSamples[j * dst.stride + c] - ref.pSamples[j * ref.stride + c]) > 0.0001f) error = true;
+		}
+	}
+	if (error) {
+		printf("%s: \033[91mWRONGE\033[0m\n", name);
+	} else {
+		printf("%s: \033[92mCORRECTE\033[0m\n", name);
+	}
+	azaBufferDeinit(&src, true);
+	azaBufferDeinit(&dst, true);
+	azaBufferDeinit(&ref, true);
+	// Printing the sum keeps the compiler from throwing the work away
+	printf("\ttook %6lld nanoseconds per frame (%.1f)\n", nanoseconds / TEST_KERNEL_ITERATIONS, sum);
+	return nanoseconds;
+}
+
+// Returns the total time in nanoseconds
+// Streams TEST_BUFFERS_FRAME_COUNT frames at a time through an azaResamplerPolyphase, using fp_convolve for the dot products, or the dispatched version if it's NULL.
+int64_t TestResamplePolyphase(void(*fp_convolve)(azaResamplerPolyphase*,float*,uint32_t,uint32_t,const float*), uint8_t channelCount, const char *name) {
+	azaResamplerPolyphaseConfig config = {
+		.srcSamplerate = TEST_RESAMPLE_SRC_SAMPLERATE,
+		.dstSamplerate = TEST_RESAMPLE_DST_SAMPLERATE,
+		.radius = TEST_RESAMPLE_RADIUS,
+		.channels = channelCount,
+	};
+	azaResamplerPolyphase resampler, reference;
+	azaResamplerPolyphaseInit(&resampler, config);
+	azaResamplerPolyphaseInit(&reference, config);
+	azaBuffer dst, src, ref;
+	azaBufferInit(&dst, TEST_RESAMPLE_DST_FRAMES, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	azaBufferInit(&src, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	azaBufferInit(&ref, TEST_RESAMPLE_DST_FRAMES, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	srand(1337);
+	for (uint32_t i = 0; i < src.frames * channelCount; i++) {
+		src.pSamples[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	}
+	void (*fp_original)(azaResamplerPolyphase*,float*,uint32_t,uint32_t,const float*) = azaResamplerPolyphaseConvolve_specialized;
+	if (fp_convolve) {
+		azaResamplerPolyphaseConvolve_specialized = fp_convolve;
+	}
+
+	int64_t start = azaGetTimestamp();
+
+	for (uint32_t i = 0; i < TEST_ITERATIONS; i++) {
+		azaResamplerPolyphaseProcess(&resampler, &dst, &src, NULL);
+	}
+
+	int64_t end = azaGetTimestamp();
+	int64_t nanoseconds = azaGetTimestampDeltaNanoseconds(end - start);
+
+	azaResamplerPolyphaseReset(&resampler);
+	uint32_t framesWritten;
+	azaResamplerPolyphaseProcess(&resampler, &dst, &src, &framesWritten);
+	azaResamplerPolyphaseConvolve_specialized = azaResamplerPolyphaseConvolve_scalar;
+	azaResamplerPolyphaseProcess(&reference, &ref, &src, NULL);
+	azaResamplerPolyphaseConvolve_specialized = fp_original;
+	bool error = false;
+	for (uint32_t i = 0; i < framesWritten * channelCount; i++) {
+		if (fabsf(dst.pSamples[i] - ref.pSamples[i]) > 0.0001f) error = true;
+	}
+	if (error) {
+		printf("%s: \033[91mWRONGE\033[0m\n", name);
+	} else {
+		printf("%s: \033[92mCORRECTE\033[0m\n", name);
+	}
+	azaBufferDeinit(&dst, true);
+	azaBufferDeinit(&src, true);
+	azaBufferDeinit(&ref, true);
+	azaResamplerPolyphaseDeinit(&resampler);
+	azaResamplerPolyphaseDeinit(&reference);
+	printf("\ttook %6lld nanoseconds on average\n", nanoseconds / TEST_ITERATIONS);
+	return nanoseconds;
+}
+
+// Returns the total time in nanoseconds
+// Does the same conversion with azaResample and a Lanczos kernel of the same radius, which evaluates the kernel for every tap of every dst frame. The filters differ, so there's nothing to check against.
+int64_t TestResampleKernel(uint8_t channelCount, const char *name) {
+	azaKernel *kernel = azaKernelGetDefaultLanczos(TEST_RESAMPLE_RADIUS);
+	uint32_t dstFrames = TEST_RESAMPLE_DST_FRAMES;
+	float factor = (float)TEST_RESAMPLE_SRC_SAMPLERATE / (float)TEST_RESAMPLE_DST_SAMPLERATE;
+	// azaResample only does one channel at a time, so give it deinterlaced buffers
+	float *dst = malloc(sizeof(float) * dstFrames * channelCount);
+	float *src = malloc(sizeof(float) * TEST_BUFFERS_FRAME_COUNT * channelCount);
+	srand(1337);
+	for (uint32_t i = 0; i < TEST_BUFFERS_FRAME_COUNT * channelCount; i++) {
+		src[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	}
+
+	int64_t start = azaGetTimestamp();
+
+	for (uint32_t i = 0; i < TEST_ITERATIONS; i++) {
+		for (uint8_t c = 0; c < channelCount; c++) {
+			azaResample(kernel, factor, dst + c * dstFrames, 1, (int)dstFrames, src + c * TEST_BUFFERS_FRAME_COUNT, 1, 0, TEST_BUFFERS_FRAME_COUNT, 0.0f);
+		}
+	}
+
+	int64_t end = azaGetTimestamp();
+	int64_t nanoseconds = azaGetTimestampDeltaNanoseconds(end - start);
+
+	free(dst);
+	free(src);
+	printf("%s:\n", name);
+	printf("\ttook %6lld nanoseconds on average\n", nanoseconds / TEST_ITERATIONS);
+	return nanoseconds;
+}
+
+// Returns the total time in nanoseconds
+// Runs TEST_CHAIN_CALLBACK_FRAMES frames at a time through a chain of cheap plugins that each make a full pass over the buffer, so the time is mostly spent waiting on memory unless maxBlockFrames keeps it all in cache.
+int64_t TestDSPChainBlock(uint32_t maxBlockFrames, const char *name) {
+	azaDSPChain chain;
+	azaDSPChainInit(&chain, 8);
+	chain.maxBlockFrames = maxBlockFrames;
+	for (int i = 0; i < 4; i++) {
+		azaDSPChainAppend(&chain, azaFilterMakeDefault());
+	}
+	azaDSPChainAppend(&chain, azaCompressorMakeDefault());
+	azaDSPChainAppend(&chain, azaLookaheadLimiterMakeDefault());
+	azaDSPChainAppend(&chain, azaCubicLimiterMakeDefault());
+	azaBuffer buffer;
+	azaBufferInit(&buffer, TEST_CHAIN_CALLBACK_FRAMES, 0, 0, azaChannelLayoutStandardFromCount(TEST_CHAIN_CHANNELS));
+	buffer.samplerate = 48000;
+	srand(1337);
+	for (uint32_t i = 0; i < buffer.frames * TEST_CHAIN_CHANNELS; i++) {
+		buffer.pSamples[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	}
+	float sum = 0.0f;
+
+	int64_t start = azaGetTimestamp();
+
+	for (uint32_t i = 0; i < TEST_CHAIN_ITERATIONS; i++) {
+		buffer.silent = false;
+		azaDSPChainProcess(&chain, &buffer, &buffer, 0);
+		sum += buffer.pSamples[0];
+	}
+
+	int64_t end = azaGetTimestamp();
+	int64_t nanoseconds = azaGetTimestampDeltaNanoseconds(end - start);
+
+	// Frees the plugins too, since they're owned
+	azaDSPChainDeinit(&chain);
+	azaBufferDeinit(&buffer, true);
+	printf("%s:\n", name);
+	// Printing the sum keeps the compiler from throwing the work away
+	printf("\ttook %6lld nanoseconds per callback (%.1f)\n", nanoseconds / TEST_CHAIN_ITERATIONS, sum);
+	return nanoseconds;
+}
+
+// Returns the total time in nanoseconds
+// Runs a 48dB/oct low pass over TEST_BUFFERS_FRAME_COUNT frames using fp_cascade, then checks the result against azaFilterProcessCascade_scalar running the same filter from the same state.
+int64_t TestFilterCascade(void(*fp_cascade)(azaFilter*,azaBuffer*,azaBuffer*,float,float), uint8_t channelCount, azaFilterTopology topology, const char *name) {
+	azaFilterConfig config = {
+		.kind = AZA_FILTER_LOW_PASS,
+		.poles = AZA_FILTER_48_DB,
+		.topology = topology,
+		.frequency = 500.0f,
+	};
+	azaFilter *filter = azaFilterMake(config);
+	azaFilter *ref = azaFilterMake(config);
+	azaBuffer dst, src, refDst;
+	azaBufferInit(&dst, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	azaBufferInit(&src, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	azaBufferInit(&refDst, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	dst.samplerate = src.samplerate = refDst.samplerate = 48000;
+	srand(1337);
+	for (uint32_t i = 0; i < src.frames * channelCount; i++) {
+		src.pSamples[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	}
+	// Let azaFilterProcess compute the coefficients
+	azaFilterProcess(filter, &dst, &src, 0);
+
+	int64_t start = azaGetTimestamp();
+
+	for (uint32_t i = 0; i < TEST_FILTER_ITERATIONS; i++) {
+		fp_cascade(filter, &dst, &src, 1.0f, 0.0f);
+	}
+
+	int64_t end = azaGetTimestamp();
+	int64_t nanoseconds = azaGetTimestampDeltaNanoseconds(end - start);
+
+	azaFilterProcess(ref, &refDst, &src, 0);
+	memcpy(ref->state, filter->state, sizeof(filter->state));
+	fp_cascade(filter, &dst, &src, 1.0f, 0.0f);
+	azaFilterProcessCascade_scalar(ref, &refDst, &src, 1.0f, 0.0f);
+	bool error = false;
+	for (uint32_t i = 0; i < dst.frames * channelCount; i++) {
+		if (fabsf(dst.pSamples[i] - refDst.pSamples[i]) > 0.0001f) error = true;
+	}
+	if (error) {
+		printf("%s: \033[91mWRONGE\033[0m\n", name);
+	} else {
+		printf("%s: \033[92mCORRECTE\033[0m\n", name);
+	}
+	azaFilterFree(&filter->dsp);
+	azaFilterFree(&ref->dsp);
+	azaBufferDeinit(&dst, true);
+	azaBufferDeinit(&src, true);
+	azaBufferDeinit(&refDst, true);
+	printf("\ttook %6lld nanoseconds on average\n", nanoseconds / TEST_FILTER_ITERATIONS);
+	return nanoseconds;
+}
+
+// combine determines whether all the channels go into 1 RMS value per frame, like azaCompressor and azaGate do
+int64_t TestRMSWindow(void(*fp_window)(azaRMS*,azaBuffer*,azaBuffer*), uint8_t channelCount, bool combine, const char *name) {
+	azaRMSConfig config = {
+		.windowSamples = 128,
+		.combineOp = azaOpMax,
+	};
+	azaRMS *rms = azaRMSMake(config);
+	azaRMS *ref = azaRMSMake(config);
+	uint8_t dstChannelCount = combine ? 1 : channelCount;
+	azaBuffer dst, src, refDst;
+	azaBufferInit(&dst, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(dstChannelCount));
+	azaBufferInit(&src, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(channelCount));
+	azaBufferInit(&refDst, TEST_BUFFERS_FRAME_COUNT, 0, 0, azaChannelLayoutStandardFromCount(dstChannelCount));
+	dst.samplerate = src.samplerate = refDst.samplerate = 48000;
+	srand(1337);
+	for (uint32_t i = 0; i < src.frames * channelCount; i++) {
+		src.pSamples[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	}
+	// Let azaRMSProcess set up the buffers
+	azaRMSProcess(rms, &dst, &src, 0);
+	azaRMSProcess(ref, &refDst, &src, 0);
+	fp_window(rms, &dst, &src);
+	azaRMSProcessWindow_scalar(ref, &refDst, &src);
+	bool error = false;
+	for (uint32_t i = 0; i < dst.frames * dstChannelCount; i++) {
+		if (fabsf(dst.pSamples[i] - refDst.pSamples[i]) > 0.0001f) error = true;
+	}
+	if (error) {
+		printf("%s: \033[91mWRONGE\033[0m\n", name);
+	} else {
+		printf("%s: \033[92mCORRECTE\033[0m\n", name);
+	}
+
+	int64_t start = azaGetTimestamp();
+
+	for (uint32_t i = 0; i < TEST_RMS_ITERATIONS; i++) {
+		fp_window(rms, &dst, &src);
+	}
+
+	int64_t end = azaGetTimestamp();
+	int64_t nanoseconds = azaGetTimestampDeltaNanoseconds(end - start);
+
+	azaRMSFree(&rms->dsp);
+	azaRMSFree(&ref->dsp);
+	azaBufferDeinit(&dst, true);
+	azaBufferDeinit(&src, true);
+	azaBufferDeinit(&refDst, true);
+	printf("\ttook %6lld nanoseconds on average\n", nanoseconds / TEST_RMS_ITERATIONS);
+	return nanoseconds;
+}
+
+// The precise versions one at a time, like azaCompressor and azaGate used to do every frame
+void aza_amp_to_dbf_array_libm(float *dst, const float *src, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		dst[i] = aza_amp_to_dbf(src[i]);
+	}
+}
+void aza_db_to_ampf_array_libm(float *dst, const float *src, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		dst[i] = aza_db_to_ampf(src[i]);
+	}
+}
+
+// Returns the total time in nanoseconds
+// Converts TEST_BUFFERS_FRAME_COUNT values spread over the range a compressor would see, then checks the result against the libm version to within 0.001dB.
+int64_t TestDecibels(void(*fp_convert)(float*,const float*,uint32_t), bool toDB, const char *name) {
+	float *src = malloc(sizeof(float) * TEST_BUFFERS_FRAME_COUNT);
+	float *dst = malloc(sizeof(float) * TEST_BUFFERS_FRAME_COUNT);
+	float *refDst = malloc(sizeof(float) * TEST_BUFFERS_FRAME_COUNT);
+	for (uint32_t i = 0; i < TEST_BUFFERS_FRAME_COUNT; i++) {
+		float db = -120.0f + 144.0f * (float)i / (float)TEST_BUFFERS_FRAME_COUNT;
+		src[i] = toDB ? aza_db_to_ampf(db) : db;
+	}
+	if (toDB) {
+		aza_amp_to_dbf_array_libm(refDst, src, TEST_BUFFERS_FRAME_COUNT);
+	} else {
+		aza_db_to_ampf_array_libm(refDst, src, TEST_BUFFERS_FRAME_COUNT);
+	}
+	fp_convert(dst, src, TEST_BUFFERS_FRAME_COUNT);
+	bool error = false;
+	for (uint32_t i = 0; i < TEST_BUFFERS_FRAME_COUNT; i++) {
+		float errorDB = toDB ? dst[i] - refDst[i] : aza_amp_to_dbf(dst[i]) - aza_amp_to_dbf(refDst[i]);
+		if (fabsf(errorDB) > 0.001f) error = true;
+	}
+	if (error) {
+		printf("%s: \033[91mWRONGE\033[0m\n", name);
+	} else {
+		printf("%s: \033[92mCORRECTE\033[0m\n", name);
+	}
+
+	int64_t start = azaGetTimestamp();
+
+	for (uint32_t i = 0; i < TEST_DECIBELS_ITERATIONS; i++) {
+		fp_convert(dst, src, TEST_BUFFERS_FRAME_COUNT);
+	}
+
+	int64_t end = azaGetTimestamp();
+	int64_t nanoseconds = azaGetTimestampDeltaNanoseconds(end - start);
+
+	free(src);
+	free(dst);
+	free(refDst);
+	printf("\ttook %6lld nanoseconds on average\n", nanoseconds / TEST_DECIBELS_ITERATIONS);
+	return nanoseconds;
+}
+
 int main(int argumentCount, char** argumentValues) {
 	int err = azaInit();
 	if (err) {
@@ -144,6 +854,7 @@ int main(int argumentCount, char** argumentValues) {
 		int64_t time_sse = TestDeinterlace(azaBufferDeinterlace2Ch_sse      , 2, "     sse");
 		int64_t time_avx = TestDeinterlace(azaBufferDeinterlace2Ch_avx      , 2, "     avx");
 		int64_t time_avx2 = TestDeinterlace(azaBufferDeinterlace2Ch_avx2    , 2, "    avx2");
+		int64_t time_avx512f = azaCPUID.avx512f ? TestDeinterlace(azaBufferDeinterlace2Ch_avx512f, 2, " avx512f") : 0;
 		int64_t time_main = TestDeinterlace(azaBufferDeinterlace            , 2, "main_api");
 		TestDeinterlace(azaBufferDeinterlace_memcpy, 2, "  memcpy");
 		printf("scalar was %.2f times speed of dynamic\n", (float)time_dynamic / (float)time_scalar);
@@ -151,6 +862,10 @@ int main(int argumentCount, char** argumentValues) {
 		printf("avx    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_avx);
 		printf("avx    was %.2f times speed of sse\n", (float)time_sse / (float)time_avx);
 		printf("avx2   was %.2f times speed of avx\n", (float)time_avx / (float)time_avx2);
+		if (time_avx512f) {
+			printf("avx512 was %.2f times speed of avx2\n", (float)time_avx2 / (float)time_avx512f);
+			printf("avx512 was %.2f times speed of avx\n", (float)time_avx / (float)time_avx512f);
+		}
 		printf("main   was %.2f times speed of scalar\n", (float)time_scalar / (float)time_main);
 		printf("main   was %.2f times speed of sse\n", (float)time_sse / (float)time_main);
 	}
@@ -162,6 +877,7 @@ int main(int argumentCount, char** argumentValues) {
 		int64_t time_sse4_1 = TestDeinterlace(azaBufferDeinterlace3Ch_sse4_1, 3, "  sse4.1");
 		int64_t time_avx = TestDeinterlace(azaBufferDeinterlace3Ch_avx      , 3, "     avx");
 		int64_t time_avx2 = TestDeinterlace(azaBufferDeinterlace3Ch_avx2    , 3, "    avx2");
+		int64_t time_avx512f = azaCPUID.avx512f ? TestDeinterlace(azaBufferDeinterlace3Ch_avx512f, 3, " avx512f") : 0;
 		int64_t time_main = TestDeinterlace(azaBufferDeinterlace            , 3, "main_api");
 		TestDeinterlace(azaBufferDeinterlace_memcpy, 3, "  memcpy");
 		printf("scalar was %.2f times speed of dynamic\n", (float)time_dynamic / (float)time_scalar);
@@ -171,6 +887,10 @@ int main(int argumentCount, char** argumentValues) {
 		printf("avx    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_avx);
 		printf("avx    was %.2f times speed of sse\n", (float)time_sse / (float)time_avx);
 		printf("avx2   was %.2f times speed of avx\n", (float)time_avx / (float)time_avx2);
+		if (time_avx512f) {
+			printf("avx512 was %.2f times speed of avx2\n", (float)time_avx2 / (float)time_avx512f);
+			printf("avx512 was %.2f times speed of avx\n", (float)time_avx / (float)time_avx512f);
+		}
 		printf("main   was %.2f times speed of scalar\n", (float)time_scalar / (float)time_main);
 		printf("main   was %.2f times speed of sse\n", (float)time_sse / (float)time_main);
 	}
@@ -181,6 +901,7 @@ int main(int argumentCount, char** argumentValues) {
 		int64_t time_sse = TestDeinterlace(azaBufferDeinterlace4Ch_sse      , 4, "     sse");
 		int64_t time_avx = TestDeinterlace(azaBufferDeinterlace4Ch_avx      , 4, "     avx");
 		int64_t time_avx2 = TestDeinterlace(azaBufferDeinterlace4Ch_avx2    , 4, "    avx2");
+		int64_t time_avx512f = azaCPUID.avx512f ? TestDeinterlace(azaBufferDeinterlace4Ch_avx512f, 4, " avx512f") : 0;
 		int64_t time_main = TestDeinterlace(azaBufferDeinterlace            , 4, "main_api");
 		TestDeinterlace(azaBufferDeinterlace_memcpy, 4, "  memcpy");
 		printf("scalar was %.2f times speed of dynamic\n", (float)time_dynamic / (float)time_scalar);
@@ -188,6 +909,10 @@ int main(int argumentCount, char** argumentValues) {
 		printf("avx    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_avx);
 		printf("avx    was %.2f times speed of sse\n", (float)time_sse / (float)time_avx);
 		printf("avx2   was %.2f times speed of avx\n", (float)time_avx / (float)time_avx2);
+		if (time_avx512f) {
+			printf("avx512 was %.2f times speed of avx2\n", (float)time_avx2 / (float)time_avx512f);
+			printf("avx512 was %.2f times speed of avx\n", (float)time_avx / (float)time_avx512f);
+		}
 		printf("main   was %.2f times speed of scalar\n", (float)time_scalar / (float)time_main);
 		printf("main   was %.2f times speed of sse\n", (float)time_sse / (float)time_main);
 	}
@@ -240,6 +965,179 @@ int main(int argumentCount, char** argumentValues) {
 		printf("main   was %.2f times speed of sse\n", (float)time_sse / (float)time_main);
 	}
 
+	// Mixing
+
+	for (uint8_t channelCount = 1; channelCount <= 6; channelCount++) {
+		if (channelCount == 3 || channelCount == 5) continue;
+		printf("\n%hhu channel mix tests:\n\n", channelCount);
+		int64_t time_scalar = TestMix(azaBufferMix_scalar    , channelCount, "  scalar");
+		int64_t time_sse = TestMix(azaBufferMix_sse          , channelCount, "     sse");
+		int64_t time_avx = TestMix(azaBufferMix_avx          , channelCount, "     avx");
+		int64_t time_avx_fma = TestMix(azaBufferMix_avx_fma  , channelCount, " avx_fma");
+		int64_t time_main = TestMix(azaBufferMix             , channelCount, "main_api");
+		printf("sse    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_sse);
+		printf("avx    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_avx);
+		printf("avxfma was %.2f times speed of avx\n", (float)time_avx / (float)time_avx_fma);
+		printf("main   was %.2f times speed of scalar\n", (float)time_scalar / (float)time_main);
+
+		printf("\n%hhu channel linear fade mix tests:\n\n", channelCount);
+		int64_t time_legacy = TestMixFadeLinear(azaBufferMixFadeLinear_legacy    , channelCount, "  legacy");
+		time_scalar = TestMixFadeLinear(azaBufferMixFadeLinear_scalar            , channelCount, "  scalar");
+		time_sse = TestMixFadeLinear(azaBufferMixFadeLinear_sse                  , channelCount, "     sse");
+		time_avx = TestMixFadeLinear(azaBufferMixFadeLinear_avx                  , channelCount, "     avx");
+		time_avx_fma = TestMixFadeLinear(azaBufferMixFadeLinear_avx_fma          , channelCount, " avx_fma");
+		time_main = TestMixFadeLinear(azaBufferMixFadeLinear_mainAPI             , channelCount, "main_api");
+		printf("scalar was %.2f times speed of legacy\n", (float)time_legacy / (float)time_scalar);
+		printf("sse    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_sse);
+		printf("avx    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_avx);
+		printf("avxfma was %.2f times speed of avx\n", (float)time_avx / (float)time_avx_fma);
+		printf("main   was %.2f times speed of legacy\n", (float)time_legacy / (float)time_main);
+	}
+
+	// Matrix mixing
+
+	{
+		const uint8_t channelCounts[][2] = {
+			{2, 2},
+			{6, 2},
+			{2, 6},
+			{8, 8},
+		};
+		for (uint32_t i = 0; i < sizeof(channelCounts) / sizeof(channelCounts[0]); i++) {
+			uint8_t srcChannelCount = channelCounts[i][0];
+			uint8_t dstChannelCount = channelCounts[i][1];
+			printf("\n%hhu to %hhu channel dense matrix mix tests:\n\n", srcChannelCount, dstChannelCount);
+			int64_t time_scalar = TestMixMatrix(azaBufferMixMatrix_scalar      , srcChannelCount, dstChannelCount, "  scalar");
+			int64_t time_avx_fma = TestMixMatrix(azaBufferMixMatrix_avx_fma    , srcChannelCount, dstChannelCount, " avx_fma");
+			int64_t time_avx512f = azaCPUID.avx512f ? TestMixMatrix(azaBufferMixMatrix_avx512f, srcChannelCount, dstChannelCount, " avx512f") : 0;
+			int64_t time_main = TestMixMatrix(azaBufferMixMatrix               , srcChannelCount, dstChannelCount, "main_api");
+			printf("avxfma was %.2f times speed of scalar\n", (float)time_scalar / (float)time_avx_fma);
+			if (time_avx512f) {
+				printf("avx512 was %.2f times speed of avx_fma\n", (float)time_avx_fma / (float)time_avx512f);
+			}
+			printf("main   was %.2f times speed of scalar\n", (float)time_scalar / (float)time_main);
+		}
+	}
+
+	// Kernel sampling
+
+	for (uint8_t channelCount = 1; channelCount <= 4; channelCount *= 2) {
+		for (uint32_t r = 0; r < 2; r++) {
+			float rate = r ? 0.7f : 1.0f;
+			printf("\n%hhu channel kernel sampling tests at rate %.1f:\n\n", channelCount, rate);
+			int64_t time_scalar = TestSampleWithKernel(azaSampleWithKernel_scalar      , channelCount, rate, "  scalar");
+			int64_t time_avx_fma = TestSampleWithKernel(azaSampleWithKernel_avx_fma    , channelCount, rate, " avx_fma");
+			int64_t time_avx512f = azaCPUID.avx512f ? TestSampleWithKernel(azaSampleWithKernel_avx512f, channelCount, rate, " avx512f") : 0;
+			int64_t time_main = TestSampleWithKernel(azaSampleWithKernel               , channelCount, rate, "main_api");
+			printf("avxfma was %.2f times speed of scalar\n", (float)time_scalar / (float)time_avx_fma);
+			if (time_avx512f) {
+				printf("avx512 was %.2f times speed of avx_fma\n", (float)time_avx_fma / (float)time_avx512f);
+			}
+			printf("main   was %.2f times speed of scalar\n", (float)time_scalar / (float)time_main);
+		}
+	}
+
+	for (uint8_t channelCount = 1; channelCount <= 2; channelCount++) {
+		printf("\n%hhu channel block kernel sampling tests:\n\n", channelCount);
+		int64_t time_frames = TestSampleWithKernelBlock(false, channelCount, "  frames");
+		int64_t time_block = TestSampleWithKernelBlock(true, channelCount, "   block");
+		printf("block  was %.2f times speed of frames\n", (float)time_frames / (float)time_block);
+	}
+
+	// Resampling
+
+	for (uint8_t channelCount = 1; channelCount <= 2; channelCount++) {
+		printf("\n%hhu channel %u to %u resample tests:\n\n", channelCount, TEST_RESAMPLE_SRC_SAMPLERATE, TEST_RESAMPLE_DST_SAMPLERATE);
+		int64_t time_kernel = TestResampleKernel(channelCount                                   , "  kernel");
+		int64_t time_scalar = TestResamplePolyphase(azaResamplerPolyphaseConvolve_scalar      , channelCount, "  scalar");
+		int64_t time_sse = TestResamplePolyphase(azaResamplerPolyphaseConvolve_sse            , channelCount, "     sse");
+		int64_t time_avx = TestResamplePolyphase(azaResamplerPolyphaseConvolve_avx            , channelCount, "     avx");
+		int64_t time_avx_fma = TestResamplePolyphase(azaResamplerPolyphaseConvolve_avx_fma    , channelCount, " avx_fma");
+		int64_t time_main = TestResamplePolyphase(NULL                                        , channelCount, "main_api");
+		printf("scalar was %.2f times speed of kernel\n", (float)time_kernel / (float)time_scalar);
+		printf("sse    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_sse);
+		printf("avx    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_avx);
+		printf("avxfma was %.2f times speed of avx\n", (float)time_avx / (float)time_avx_fma);
+		printf("main   was %.2f times speed of kernel\n", (float)time_kernel / (float)time_main);
+	}
+
+	// Filters
+
+	for (int topology = 0; topology < AZA_FILTER_TOPOLOGY_COUNT; topology++) {
+		uint8_t channelCounts[] = { 2, 8 };
+		for (int i = 0; i < 2; i++) {
+			uint8_t channelCount = channelCounts[i];
+			printf("\n%u channel %s filter tests:\n\n", channelCount, azaFilterTopologyString[topology]);
+			int64_t time_scalar = TestFilterCascade(azaFilterProcessCascade_scalar, channelCount, (azaFilterTopology)topology, "  scalar");
+			int64_t time_sse = TestFilterCascade(azaFilterProcessCascade_sse      , channelCount, (azaFilterTopology)topology, "     sse");
+			int64_t time_avx = TestFilterCascade(azaFilterProcessCascade_avx      , channelCount, (azaFilterTopology)topology, "     avx");
+			printf("sse    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_sse);
+			printf("avx    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_avx);
+			printf("avx    was %.2f times speed of sse\n", (float)time_sse / (float)time_avx);
+		}
+	}
+
+	// RMS
+
+	for (int combine = 0; combine < 2; combine++) {
+		uint8_t channelCounts[] = { 2, 8 };
+		for (int i = 0; i < 2; i++) {
+			uint8_t channelCount = channelCounts[i];
+			printf("\n%u channel %s RMS tests:\n\n", channelCount, combine ? "combined" : "individual");
+			int64_t time_scalar = TestRMSWindow(azaRMSProcessWindow_scalar, channelCount, combine, "  scalar");
+			int64_t time_sse = TestRMSWindow(azaRMSProcessWindow_sse      , channelCount, combine, "     sse");
+			int64_t time_avx = TestRMSWindow(azaRMSProcessWindow_avx      , channelCount, combine, "     avx");
+			printf("sse    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_sse);
+			printf("avx    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_avx);
+			printf("avx    was %.2f times speed of sse\n", (float)time_sse / (float)time_avx);
+		}
+	}
+
+	// Decibels
+
+	for (int toDB = 1; toDB >= 0; toDB--) {
+		printf("\n%s conversion tests:\n\n", toDB ? "amp to dB" : "dB to amp");
+		int64_t time_libm = TestDecibels(toDB ? aza_amp_to_dbf_array_libm : aza_db_to_ampf_array_libm      , toDB, "    libm");
+		int64_t time_scalar = TestDecibels(toDB ? aza_amp_to_dbf_array_scalar : aza_db_to_ampf_array_scalar, toDB, "  scalar");
+		int64_t time_sse = TestDecibels(toDB ? aza_amp_to_dbf_array_sse : aza_db_to_ampf_array_sse         , toDB, "     sse");
+		int64_t time_avx2 = TestDecibels(toDB ? aza_amp_to_dbf_array_avx2 : aza_db_to_ampf_array_avx2      , toDB, "    avx2");
+		printf("scalar was %.2f times speed of libm\n", (float)time_libm / (float)time_scalar);
+		printf("sse    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_sse);
+		printf("avx2   was %.2f times speed of sse\n", (float)time_sse / (float)time_avx2);
+	}
+
+	// DSP chains
+
+	{
+		printf("\n%u channel DSP chain tests with %u frame callbacks:\n\n", TEST_CHAIN_CHANNELS, TEST_CHAIN_CALLBACK_FRAMES);
+		int64_t time_whole = TestDSPChainBlock(0, "   whole");
+		int64_t time_64 = TestDSPChainBlock(64, "      64");
+		int64_t time_128 = TestDSPChainBlock(128, "     128");
+		int64_t time_256 = TestDSPChainBlock(256, "     256");
+		printf("64     was %.2f times speed of whole\n", (float)time_whole / (float)time_64);
+		printf("128    was %.2f times speed of whole\n", (float)time_whole / (float)time_128);
+		printf("256    was %.2f times speed of whole\n", (float)time_whole / (float)time_256);
+	}
+
+	// FFT
+
+	{
+		printf("\n%u channel %u point FFT tests:\n\n", TEST_FFT_CHANNELS, 1u << TEST_FFT_LOG2_LEN);
+		int64_t time_legacy = TestFFT(azaFFTPlanTransform_legacy    , "  legacy");
+		int64_t time_scalar = TestFFT(azaFFTPlanTransform_scalar    , "  scalar");
+		int64_t time_sse = TestFFT(azaFFTPlanTransform_sse          , "     sse");
+		int64_t time_avx = TestFFT(azaFFTPlanTransform_avx          , "     avx");
+		int64_t time_avx_fma = TestFFT(azaFFTPlanTransform_avx_fma  , " avx_fma");
+		int64_t time_main = TestFFT(azaFFTPlanTransform_mainAPI     , "main_api");
+		printf("scalar was %.2f times speed of legacy\n", (float)time_legacy / (float)time_scalar);
+		printf("sse    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_sse);
+		printf("avx    was %.2f times speed of scalar\n", (float)time_scalar / (float)time_avx);
+		printf("avx    was %.2f times speed of sse\n", (float)time_sse / (float)time_avx);
+		printf("avxfma was %.2f times speed of avx\n", (float)time_avx / (float)time_avx_fma);
+		printf("main   was %.2f times speed of legacy\n", (float)time_legacy / (float)time_main);
+		printf("main   was %.2f times speed of scalar\n", (float)time_scalar / (float)time_main);
+	}
+
 	azaDeinit();
 	return 0;
 }
@@ -213,6 +213,7 @@ int main(int argumentCount, char** argumentValues) {
 	limiter = azaLookaheadLimiterMake((azaLookaheadLimiterConfig) {
 		.gainInput  =  3.0f,
 		.gainOutput = -0.1f,
+		.lookahead_ms = AZAUDIO_LOOKAHEAD_DEFAULT_MS,
 	});
 
 	azaStreamSetActive(&streamOutput, 1);
@@ -32,8 +32,28 @@ const char *utReportKindVTColor[UT_ENUM_COUNT] = {
 void runAllTests() {
 	void ut_run_azaBufferResize();
 	ut_run_azaBufferResize();
+	void ut_run_azaChannelMatrix();
+	ut_run_azaChannelMatrix();
+	void ut_run_azaConvolutionReverb();
+	ut_run_azaConvolutionReverb();
+	void ut_run_azaFFT();
+	ut_run_azaFFT();
+	void ut_run_azaFilter();
+	ut_run_azaFilter();
+	void ut_run_azaLookaheadLimiter();
+	ut_run_azaLookaheadLimiter();
+	void ut_run_azaMixer();
+	ut_run_azaMixer();
+	void ut_run_azaQueue();
+	ut_run_azaQueue();
+	void ut_run_azaResamplerPolyphase();
+	ut_run_azaResamplerPolyphase();
 	void ut_run_azaSampleDelay();
 	ut_run_azaSampleDelay();
+	void ut_run_azaSampleDelayMixMatrix();
+	ut_run_azaSampleDelayMixMatrix();
+	void ut_run_azaSampler();
+	ut_run_azaSampler();
 }
 
 
@@ -0,0 +1,209 @@
+/*
+	File: azaChannelMatrix.c
+	Author: Philip Haynes
+	Testing the correctness of channel matrix classification, and that mixing with every kind of matrix matches dense mixing.
+*/
+
+#include "../testing.h"
+
+#include <AzAudio/error.h>
+#include <AzAudio/math.h>
+#include <AzAudio/dsp/azaBuffer.h>
+
+#include <math.h>
+
+static const char *ut_ChannelMatrixKindString[] = {
+	"dense",
+	"sparse",
+	"permutation",
+	"diagonal",
+	"identity",
+};
+
+// Fills the matrix with values whose nonzero pattern should be classified as kind
+static void ut_fillMatrix(azaChannelMatrix *matrix, azaChannelMatrixKind kind) {
+	const uint8_t inputs = matrix->inputs;
+	const uint8_t outputs = matrix->outputs;
+	for (uint8_t c = 0; c < inputs; c++) {
+		for (uint8_t r = 0; r < outputs; r++) {
+			float value = 0.0f;
+			switch (kind) {
+				case AZA_CHANNEL_MATRIX_DENSE:
+					value = 0.25f + 0.125f * (float)((c * 3 + r * 5) % 7);
+					break;
+				case AZA_CHANNEL_MATRIX_SPARSE:
+					// The first output takes two inputs, and every odd output takes one
+					if ((r == 0 && c < 2) || (r % 2 == 1 && c == r % inputs)) {
+						value = 0.5f + 0.125f * (float)c;
+					}
+					break;
+				case AZA_CHANNEL_MATRIX_PERMUTATION:
+					// Never the same index for the first output, so it can't be diagonal
+					if (c == (r * 3 + 1) % inputs) {
+						value = 0.75f - 0.0625f * (float)r;
+					}
+					break;
+				case AZA_CHANNEL_MATRIX_DIAGONAL:
+					if (c == r) {
+						value = 0.5f + 0.25f * (float)c;
+					}
+					break;
+				case AZA_CHANNEL_MATRIX_IDENTITY:
+					if (c == r) {
+						value = 1.0f;
+					}
+					break;
+			}
+			matrix->matrix[c * outputs + r] = value;
+		}
+	}
+	azaChannelMatrixClassify(matrix);
+}
+
+static const float ut_paddingValue = 12345.0f;
+
+// If padded, stride has room for a few channels we don't use, so we can tell that they're left alone.
+static void ut_initBuffer(azaBuffer *buffer, uint32_t frames, uint8_t channels, bool padded) {
+	uint8_t stride = padded ? channels + 3 : channels;
+	azaBufferInit(buffer, frames, 0, 0, (azaChannelLayout) { .count = stride });
+	buffer->channelLayout.count = channels;
+}
+
+static void ut_fillBuffer(azaBuffer *buffer, float phase) {
+	for (uint32_t i = 0; i < buffer->frames; i++) {
+		for (uint8_t c = 0; c < buffer->stride; c++) {
+			buffer->pSamples[i * buffer->stride + c] = c < buffer->channelLayout.count ? sinf(0.43f * (float)i + 0.9f * (float)c + phase) : ut_paddingValue;
+		}
+	}
+	buffer->silent = false;
+}
+
+static void ut_test_azaChannelMatrix(uint32_t frames, uint8_t inputs, uint8_t outputs, azaChannelMatrixKind kind, bool padded) {
+	azaChannelMatrix matrix;
+	int err = azaChannelMatrixInit(&matrix, inputs, outputs);
+	if (err) {
+		UT_SUBMIT_FAIL("azaChannelMatrixInit returned an error: %s", azaErrorString(err));
+		return;
+	}
+	ut_fillMatrix(&matrix, kind);
+
+	utBeginSubtest("Classification");
+	UT_EXPECT_EQUAL(UT_FAIL, matrix.kind, kind, "matrix.kind = %s, expected = %s", ut_ChannelMatrixKindString[matrix.kind], ut_ChannelMatrixKindString[kind]);
+	if (matrix.kind != AZA_CHANNEL_MATRIX_DENSE) {
+		uint16_t nonzero = 0;
+		for (uint16_t i = 0; i < (uint16_t)inputs * outputs; i++) {
+			nonzero += matrix.matrix[i] != 0.0f;
+		}
+		UT_EXPECT_EQUAL(UT_FAIL, matrix.entryCount, nonzero, "matrix.entryCount = %hu, nonzero = %hu", matrix.entryCount, nonzero);
+		for (uint16_t e = 0; e < matrix.entryCount; e++) {
+			azaChannelMatrixEntry entry = matrix.entries[e];
+			UT_EXPECT_EQUAL(UT_FAIL, entry.gain, matrix.matrix[entry.input * outputs + entry.output], "entry = %hu, input = %hhu, output = %hhu", e, entry.input, entry.output);
+		}
+	}
+	utEndSubtest();
+
+	// The same values, but mixed the slow way
+	azaChannelMatrix matrixDense = matrix;
+	matrixDense.kind = AZA_CHANNEL_MATRIX_DENSE;
+
+	azaBuffer src, dst, dstDense;
+	ut_initBuffer(&src, frames, inputs, padded);
+	ut_initBuffer(&dst, frames, outputs, padded);
+	ut_initBuffer(&dstDense, frames, outputs, padded);
+
+	const struct {
+		float volumeDst, volumeSrc;
+	} volumes[] = {
+		{ 1.0f, 1.0f },
+		{ 1.0f, 0.5f },
+		{ 0.0f, 1.0f },
+		{ 0.5f, 2.0f },
+	};
+	for (uint32_t v = 0; v < sizeof(volumes) / sizeof(volumes[0]); v++) {
+		const float volumeDst = volumes[v].volumeDst;
+		const float volumeSrc = volumes[v].volumeSrc;
+		ut_fillBuffer(&src, 0.0f);
+		ut_fillBuffer(&dst, 2.0f);
+		ut_fillBuffer(&dstDense, 2.0f);
+
+		azaBufferMixMatrix(&dst, volumeDst, &src, volumeSrc, &matrix);
+		azaBufferMixMatrix(&dstDense, volumeDst, &src, volumeSrc, &matrixDense);
+
+		utBeginSubtest(azaTextFormat("Mix Against Dense (volumeDst = %.2f, volumeSrc = %.2f)", volumeDst, volumeSrc));
+		for (uint32_t i = 0; i < frames; i++) {
+			for (uint8_t c = 0; c < dst.stride; c++) {
+				float actual = dst.pSamples[i * dst.stride + c];
+				float expected = dstDense.pSamples[i * dstDense.stride + c];
+				// Negated so NaNs fail too
+				if (!(fabsf(actual - expected) <= 0.00001f * (1.0f + fabsf(expected)))) {
+					UT_SUBMIT_FAIL("dst.pSamples[i] = %f, expected = %f, frame = %u, channel = %hhu", actual, expected, i, c);
+				}
+			}
+		}
+		utEndSubtest();
+
+		utBeginSubtest(azaTextFormat("Mix Against Reference (volumeDst = %.2f, volumeSrc = %.2f)", volumeDst, volumeSrc));
+		azaBuffer dstBefore;
+		ut_initBuffer(&dstBefore, frames, outputs, padded);
+		ut_fillBuffer(&dstBefore, 2.0f);
+		for (uint32_t i = 0; i < frames; i++) {
+			for (uint8_t r = 0; r < outputs; r++) {
+				float expected = volumeDst * dstBefore.pSamples[i * dstBefore.stride + r];
+				for (uint8_t c = 0; c < inputs; c++) {
+					expected += volumeSrc * src.pSamples[i * src.stride + c] * matrix.matrix[c * outputs + r];
+				}
+				float actual = dst.pSamples[i * dst.stride + r];
+				if (!(fabsf(actual - expected) <= 0.00001f * (1.0f + fabsf(expected)))) {
+					UT_SUBMIT_FAIL("dst.pSamples[i] = %f, expected = %f, frame = %u, channel = %hhu", actual, expected, i, r);
+				}
+			}
+			for (uint8_t c = outputs; c < dst.stride; c++) {
+				UT_EXPECT_EQUAL(UT_FAIL, dst.pSamples[i * dst.stride + c], ut_paddingValue, "padding was overwritten, frame = %u, channel = %hhu", i, c);
+			}
+		}
+		azaBufferDeinit(&dstBefore, true);
+		utEndSubtest();
+	}
+
+	azaBufferDeinit(&src, true);
+	azaBufferDeinit(&dst, true);
+	azaBufferDeinit(&dstDense, true);
+	azaChannelMatrixDeinit(&matrix);
+}
+
+void ut_run_azaChannelMatrix() {
+	const struct {
+		uint8_t inputs, outputs;
+		azaChannelMatrixKind kind;
+	} matrices[] = {
+		{  1,  1, AZA_CHANNEL_MATRIX_IDENTITY },
+		{  2,  2, AZA_CHANNEL_MATRIX_IDENTITY },
+		{  6,  6, AZA_CHANNEL_MATRIX_IDENTITY },
+		{  1,  1, AZA_CHANNEL_MATRIX_DIAGONAL },
+		{  2,  2, AZA_CHANNEL_MATRIX_DIAGONAL },
+		{  3,  3, AZA_CHANNEL_MATRIX_DIAGONAL },
+		{  8,  8, AZA_CHANNEL_MATRIX_DIAGONAL },
+		{ 12, 12, AZA_CHANNEL_MATRIX_DIAGONAL },
+		{  2,  2, AZA_CHANNEL_MATRIX_PERMUTATION },
+		{  5,  5, AZA_CHANNEL_MATRIX_PERMUTATION },
+		{  2,  6, AZA_CHANNEL_MATRIX_PERMUTATION },
+		{  6,  2, AZA_CHANNEL_MATRIX_PERMUTATION },
+		{  4,  4, AZA_CHANNEL_MATRIX_SPARSE },
+		{  6,  2, AZA_CHANNEL_MATRIX_SPARSE },
+		{  2,  8, AZA_CHANNEL_MATRIX_SPARSE },
+		{  8,  8, AZA_CHANNEL_MATRIX_SPARSE },
+		{  2,  1, AZA_CHANNEL_MATRIX_DENSE },
+		{  2,  2, AZA_CHANNEL_MATRIX_DENSE },
+		{  6,  2, AZA_CHANNEL_MATRIX_DENSE },
+		{  3,  5, AZA_CHANNEL_MATRIX_DENSE },
+		{  8,  8, AZA_CHANNEL_MATRIX_DENSE },
+		{ 20, 20, AZA_CHANNEL_MATRIX_DENSE },
+	};
+	for (uint32_t m = 0; m < sizeof(matrices) / sizeof(matrices[0]); m++) {
+		for (int padded = 0; padded <= 1; padded++) {
+			utBeginTest(azaTextFormat("azaChannelMatrix.c %s %hhu->%hhu (%s)", ut_ChannelMatrixKindString[matrices[m].kind], matrices[m].inputs, matrices[m].outputs, padded ? "padded stride" : "contiguous"));
+			ut_test_azaChannelMatrix(13, matrices[m].inputs, matrices[m].outputs, matrices[m].kind, padded);
+			utEndTest();
+		}
+	}
+}
@@ -0,0 +1,235 @@
+/*
+	File: azaConvolutionReverb.c
+	Author: Philip Haynes
+	Testing the correctness of partitioned convolution against direct convolution.
+*/
+
+#include "../testing.h"
+
+#include <AzAudio/error.h>
+#include <AzAudio/math.h>
+#include <AzAudio/dsp/plugins/azaConvolutionReverb.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static float ut_random() {
+	return (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+}
+
+// A decaying noise burst, which is roughly what a real impulse response looks like
+static void ut_makeImpulseResponse(azaBuffer *impulseResponse, uint32_t frames, uint8_t channels) {
+	azaBufferInit(impulseResponse, frames, 0, 0, (azaChannelLayout) { .count = channels });
+	impulseResponse->samplerate = 48000;
+	for (uint32_t i = 0; i < frames; i++) {
+		for (uint8_t c = 0; c < channels; c++) {
+			impulseResponse->pSamples[i * channels + c] = ut_random() * expf(-4.0f * (float)i / (float)frames);
+		}
+	}
+}
+
+// Direct convolution of channel c of input starting at frame start, for the output frame that's partitionFrames late.
+// Frames before start count as silence, since that's where the stream (re)started.
+static double ut_convolveDirect(azaBuffer *input, uint32_t start, uint32_t frame, uint8_t c, azaBuffer *impulseResponse, uint32_t partitionFrames, double amountDry, double amountWet) {
+	int64_t inputFrame = (int64_t)frame - partitionFrames;
+	if (inputFrame < (int64_t)start) return 0.0;
+	const uint8_t channels = input->channelLayout.count;
+	const uint8_t irChannels = impulseResponse->channelLayout.count;
+	double result = amountDry * input->pSamples[inputFrame * channels + c];
+	double wet = 0.0;
+	for (uint32_t k = 0; k < impulseResponse->frames && inputFrame - k >= (int64_t)start; k++) {
+		wet += (double)impulseResponse->pSamples[k * irChannels + c % irChannels] * input->pSamples[(inputFrame - k) * channels + c];
+	}
+	return result + amountWet * wet;
+}
+
+static float ut_sumAbs(azaBuffer *buffer) {
+	float result = 0.0f;
+	for (uint32_t i = 0; i < buffer->frames * buffer->channelLayout.count; i++) {
+		result += fabsf(buffer->pSamples[i]);
+	}
+	return result;
+}
+
+// Processes input in blocks of blockFrames, switching to a second impulse response of irFrames2 at frame switchFrame if irFrames2 isn't 0.
+static void ut_test_azaConvolutionReverb(uint32_t partitionFramesConfig, uint32_t irFrames, uint8_t irChannels, uint8_t channels, uint32_t blockFrames, uint32_t switchFrame, uint32_t irFrames2) {
+	const uint32_t frames = 1536;
+	// What config.partitionFrames should get rounded up to
+	uint32_t partitionFrames = AZAUDIO_CONVOLUTION_REVERB_MIN_PARTITION_FRAMES;
+	while (partitionFrames < partitionFramesConfig) partitionFrames <<= 1;
+	const float gainWet = -3.0f;
+	const float gainDry = -6.0f;
+	const double amountWet = aza_db_to_ampf(gainWet);
+	const double amountDry = aza_db_to_ampf(gainDry);
+	srand(partitionFramesConfig * 31 + irFrames * 7 + irChannels + channels * 3 + blockFrames);
+
+	azaBuffer impulseResponse, impulseResponse2 = {0};
+	ut_makeImpulseResponse(&impulseResponse, irFrames, irChannels);
+	if (irFrames2) {
+		ut_makeImpulseResponse(&impulseResponse2, irFrames2, irChannels);
+	}
+	azaBuffer input, output;
+	azaBufferInit(&input, frames, 0, 0, (azaChannelLayout) { .count = channels });
+	azaBufferInit(&output, frames, 0, 0, (azaChannelLayout) { .count = channels });
+	input.samplerate = output.samplerate = 48000;
+	for (uint32_t i = 0; i < frames * channels; i++) {
+		input.pSamples[i] = ut_random();
+	}
+
+	azaConvolutionReverb reverb;
+	azaConvolutionReverbInit(&reverb, (azaConvolutionReverbConfig) {
+		.gainWet = gainWet,
+		.gainDry = gainDry,
+		.partitionFrames = partitionFramesConfig,
+	});
+	int err = azaConvolutionReverbSetImpulseResponse(&reverb, &impulseResponse);
+	if (err) {
+		UT_SUBMIT_FAIL("azaConvolutionReverbSetImpulseResponse returned an error: %s", azaErrorString(err));
+	}
+	UT_EXPECT_EQUAL(UT_FAIL, azaConvolutionReverbGetSpecs(&reverb.dsp, 48000).latencyFrames, partitionFrames, "partitionFrames = %u", partitionFrames);
+
+	bool switched = irFrames2 == 0;
+	for (uint32_t start = 0; start < frames && !err;) {
+		uint32_t count = AZA_MIN(blockFrames, frames - start);
+		if (!switched && start + count > switchFrame) {
+			// The audio thread picks it up at the start of a block, so cut this one short
+			count = switchFrame - start;
+			if (count == 0) {
+				err = azaConvolutionReverbSetImpulseResponse(&reverb, &impulseResponse2);
+				if (err) {
+					UT_SUBMIT_FAIL("azaConvolutionReverbSetImpulseResponse returned an error: %s", azaErrorString(err));
+				}
+				switched = true;
+				continue;
+			}
+		}
+		azaBuffer dst = azaBufferSlice(&output, start, count);
+		azaBuffer src = azaBufferSlice(&input, start, count);
+		err = azaConvolutionReverbProcess(&reverb, &dst, &src, 0);
+		if (err) {
+			UT_SUBMIT_FAIL("azaConvolutionReverbProcess returned an error: %s", azaErrorString(err));
+		}
+		start += count;
+	}
+
+	// Frequency domain convolution has an error that grows with the size of the impulse response
+	const float toleranceScale = 1.0e-5f * (1.0f + ut_sumAbs(&impulseResponse) + (irFrames2 ? ut_sumAbs(&impulseResponse2) : 0.0f));
+	utBeginSubtest("Against Direct Convolution");
+	for (uint32_t i = 0; i < frames; i++) {
+		switched = irFrames2 && i >= switchFrame;
+		for (uint8_t c = 0; c < channels; c++) {
+			// Switching starts the stream over, so whatever came before is gone
+			double expected = switched
+				? ut_convolveDirect(&input, switchFrame, i, c, &impulseResponse2, partitionFrames, amountDry, amountWet)
+				: ut_convolveDirect(&input, 0, i, c, &impulseResponse, partitionFrames, amountDry, amountWet);
+			float actual = output.pSamples[i * channels + c];
+			// Negated so NaNs fail too
+			if (!(fabs((double)actual - expected) <= toleranceScale)) {
+				UT_SUBMIT_FAIL("output.pSamples[i] = %f, expected = %f, frame = %u, channel = %hhu", actual, expected, i, c);
+			}
+		}
+	}
+	utEndSubtest();
+
+	azaConvolutionReverbDeinit(&reverb);
+	azaBufferDeinit(&input, true);
+	azaBufferDeinit(&output, true);
+	azaBufferDeinit(&impulseResponse, true);
+	if (irFrames2) {
+		azaBufferDeinit(&impulseResponse2, true);
+	}
+}
+
+// The specs have to describe the partitions the audio thread is processing with, since that's what the mixer compensates for, even when the control side has moved on.
+static void ut_test_azaConvolutionReverbSpecs(uint32_t irFrames) {
+	const uint32_t frames = 100;
+	azaBuffer impulseResponse;
+	ut_makeImpulseResponse(&impulseResponse, irFrames, 1);
+	azaBuffer input, output;
+	azaBufferInit(&input, frames, 0, 0, (azaChannelLayout) { .count = 1 });
+	azaBufferInit(&output, frames, 0, 0, (azaChannelLayout) { .count = 1 });
+	input.samplerate = output.samplerate = 48000;
+	memset(input.pSamples, 0, sizeof(float) * frames);
+
+	azaConvolutionReverb reverb;
+	azaConvolutionReverbInit(&reverb, (azaConvolutionReverbConfig) {
+		.partitionFrames = 64,
+	});
+	azaDSPSpecs specs = azaConvolutionReverbGetSpecs(&reverb.dsp, 48000);
+	UT_EXPECT_EQUAL(UT_FAIL, specs.latencyFrames, 64, "before processing, irFrames = %u", irFrames);
+	UT_EXPECT_EQUAL(UT_FAIL, specs.tailFrames, 64, "before processing, irFrames = %u", irFrames);
+
+	int err = azaConvolutionReverbSetImpulseResponse(&reverb, &impulseResponse);
+	if (err) {
+		UT_SUBMIT_FAIL("azaConvolutionReverbSetImpulseResponse returned an error: %s", azaErrorString(err));
+	}
+	specs = azaConvolutionReverbGetSpecs(&reverb.dsp, 48000);
+	UT_EXPECT_EQUAL(UT_FAIL, specs.tailFrames, 64, "before picking up the impulse response, irFrames = %u", irFrames);
+	if ((err = azaConvolutionReverbProcess(&reverb, &output, &input, 0))) {
+		UT_SUBMIT_FAIL("azaConvolutionReverbProcess returned an error: %s", azaErrorString(err));
+	}
+	uint32_t partitionCount = (irFrames + 63) / 64;
+	specs = azaConvolutionReverbGetSpecs(&reverb.dsp, 48000);
+	UT_EXPECT_EQUAL(UT_FAIL, specs.latencyFrames, 64, "after picking up the impulse response, irFrames = %u", irFrames);
+	UT_EXPECT_EQUAL(UT_FAIL, specs.tailFrames, (partitionCount + 1) * 64, "after picking up the impulse response, irFrames = %u", irFrames);
+
+	// Changing the config alone doesn't change what we process with
+	reverb.config.partitionFrames = 256;
+	specs = azaConvolutionReverbGetSpecs(&reverb.dsp, 48000);
+	UT_EXPECT_EQUAL(UT_FAIL, specs.latencyFrames, 64, "before azaConvolutionReverbUpdatePartitions, irFrames = %u", irFrames);
+	if ((err = azaConvolutionReverbUpdatePartitions(&reverb))) {
+		UT_SUBMIT_FAIL("azaConvolutionReverbUpdatePartitions returned an error: %s", azaErrorString(err));
+	}
+	specs = azaConvolutionReverbGetSpecs(&reverb.dsp, 48000);
+	UT_EXPECT_EQUAL(UT_FAIL, specs.latencyFrames, 64, "before picking up the new partitions, irFrames = %u", irFrames);
+	if ((err = azaConvolutionReverbProcess(&reverb, &output, &input, 0))) {
+		UT_SUBMIT_FAIL("azaConvolutionReverbProcess returned an error: %s", azaErrorString(err));
+	}
+	partitionCount = (irFrames + 255) / 256;
+	specs = azaConvolutionReverbGetSpecs(&reverb.dsp, 48000);
+	UT_EXPECT_EQUAL(UT_FAIL, specs.latencyFrames, 256, "after picking up the new partitions, irFrames = %u", irFrames);
+	UT_EXPECT_EQUAL(UT_FAIL, specs.tailFrames, (partitionCount + 1) * 256, "after picking up the new partitions, irFrames = %u", irFrames);
+
+	azaConvolutionReverbDeinit(&reverb);
+	azaBufferDeinit(&input, true);
+	azaBufferDeinit(&output, true);
+	azaBufferDeinit(&impulseResponse, true);
+}
+
+void ut_run_azaConvolutionReverb() {
+	const struct {
+		uint32_t partitionFrames, irFrames;
+		uint8_t irChannels, channels;
+		uint32_t blockFrames;
+	} cases[] = {
+		// Shorter than a partition
+		{  32,    1, 1, 1, 100 },
+		{  32,   20, 1, 1,  32 },
+		// Exactly some partitions
+		{  32,  128, 1, 2,   7 },
+		// Some partitions and a bit
+		{  64,  300, 1, 2, 100 },
+		{  64,  300, 2, 2, 256 },
+		// More channels than the impulse response has
+		{ 128,  500, 2, 3,  64 },
+		// Rounds up to 64
+		{  50,  777, 1, 1,  33 },
+		// Longer than the whole input
+		{  32, 2000, 1, 1, 512 },
+	};
+	for (uint32_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		utBeginTest(azaTextFormat("azaConvolutionReverb.c %u frame impulse response (%hhu channels) in %u frame partitions, %hhu channels in blocks of %u", cases[i].irFrames, cases[i].irChannels, cases[i].partitionFrames, cases[i].channels, cases[i].blockFrames));
+		ut_test_azaConvolutionReverb(cases[i].partitionFrames, cases[i].irFrames, cases[i].irChannels, cases[i].channels, cases[i].blockFrames, 0, 0);
+		utEndTest();
+	}
+	utBeginTest("azaConvolutionReverb.c switching impulse responses while processing");
+	ut_test_azaConvolutionReverb(64, 300, 1, 2, 100, 700, 200);
+	utEndTest();
+	const uint32_t specsIRFrames[] = { 1, 300, 1000 };
+	for (uint32_t i = 0; i < sizeof(specsIRFrames) / sizeof(specsIRFrames[0]); i++) {
+		utBeginTest(azaTextFormat("azaConvolutionReverb.c specs follow the audio thread with a %u frame impulse response", specsIRFrames[i]));
+		ut_test_azaConvolutionReverbSpecs(specsIRFrames[i]);
+		utEndTest();
+	}
+}
@@ -0,0 +1,229 @@
+/*
+	File: azaFFT.c
+	Author: Philip Haynes
+	Testing the correctness of the FFT and azaFFTPlan transforms against a direct DFT.
+*/
+
+#include "../testing.h"
+
+#include <AzAudio/error.h>
+#include <AzAudio/math.h>
+#include <AzAudio/fft.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+// Every bin of a direct DFT of len complex values, done in double precision
+static void ut_dft(double *dstReal, double *dstImag, const float *srcReal, const float *srcImag, uint32_t len) {
+	for (uint32_t k = 0; k < len; k++) {
+		double accumReal = 0.0, accumImag = 0.0;
+		for (uint32_t n = 0; n < len; n++) {
+			// Reducing k*n first keeps the angle exact for big transforms
+			double angle = -AZA_TAU_D * (double)(((uint64_t)k * n) % len) / (double)len;
+			double c = cos(angle), s = sin(angle);
+			accumReal += (double)srcReal[n] * c - (double)srcImag[n] * s;
+			accumImag += (double)srcReal[n] * s + (double)srcImag[n] * c;
+		}
+		dstReal[k] = accumReal;
+		dstImag[k] = accumImag;
+	}
+}
+
+static void ut_fillRandom(float *values, uint32_t count) {
+	for (uint32_t i = 0; i < count; i++) {
+		values[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+	}
+}
+
+// Square root of the sum of the squares of both arrays. The error of an FFT grows with this, so tolerances are relative to it.
+static double ut_norm(const float *real, const float *imag, uint32_t count) {
+	double sum = 0.0;
+	for (uint32_t i = 0; i < count; i++) {
+		sum += (double)real[i] * real[i];
+		if (imag) sum += (double)imag[i] * imag[i];
+	}
+	return sqrt(sum);
+}
+
+static void ut_expectSpectrum(const float *real, const float *imag, const double *expectedReal, const double *expectedImag, uint32_t count, double tolerance) {
+	for (uint32_t k = 0; k < count; k++) {
+		double errorReal = fabs((double)real[k] - expectedReal[k]);
+		double errorImag = fabs((double)imag[k] - expectedImag[k]);
+		// Negated so NaNs fail too
+		if (!(errorReal <= tolerance && errorImag <= tolerance)) {
+			UT_SUBMIT_FAIL("bin %u = (%f, %f), expected = (%f, %f), tolerance = %g", k, real[k], imag[k], expectedReal[k], expectedImag[k], tolerance);
+		}
+	}
+}
+
+static void ut_expectSamples(const float *actual, const float *expected, uint32_t count, double tolerance, const char *name) {
+	for (uint32_t i = 0; i < count; i++) {
+		if (!(fabs((double)actual[i] - (double)expected[i]) <= tolerance)) {
+			UT_SUBMIT_FAIL("%s[%u] = %f, expected = %f, tolerance = %g", name, i, actual[i], expected[i], tolerance);
+		}
+	}
+}
+
+static void ut_test_azaFFTPlan(uint32_t log2Len) {
+	const uint32_t len = 1 << log2Len;
+	azaFFTPlan plan;
+	int err = azaFFTPlanInit(&plan, len);
+	if (err) {
+		UT_SUBMIT_FAIL("azaFFTPlanInit returned an error: %s", azaErrorString(err));
+		return;
+	}
+	float *inputReal = malloc(sizeof(float) * len * 4);
+	float *inputImag = inputReal + len;
+	float *real = inputImag + len;
+	float *imag = real + len;
+	double *expectedReal = malloc(sizeof(double) * len * 2);
+	double *expectedImag = expectedReal + len;
+	// Single precision should be good to a few ulps per pass over the data
+	const double epsilon = 1.0e-6 * (double)(log2Len + 1);
+
+	srand(1337 + log2Len);
+	ut_fillRandom(inputReal, len * 2);
+
+	utBeginSubtest("Forward");
+	{
+		double tolerance = epsilon * ut_norm(inputReal, inputImag, len);
+		memcpy(real, inputReal, sizeof(float) * len);
+		memcpy(imag, inputImag, sizeof(float) * len);
+		azaFFTPlanForward(&plan, real, imag);
+		ut_dft(expectedReal, expectedImag, inputReal, inputImag, len);
+		ut_expectSpectrum(real, imag, expectedReal, expectedImag, len, tolerance);
+	}
+	utEndSubtest();
+
+	utBeginSubtest("Inverse");
+	{
+		// real and imag still hold the forward transform
+		azaFFTPlanInverse(&plan, real, imag);
+		double tolerance = epsilon * 2.0;
+		ut_expectSamples(real, inputReal, len, tolerance, "real");
+		ut_expectSamples(imag, inputImag, len, tolerance, "imag");
+	}
+	utEndSubtest();
+
+	utBeginSubtest("Smaller Transforms");
+	// The plan's tables work for any power of 2 up to len
+	for (uint32_t log2n = 1; log2n < log2Len; log2n++) {
+		uint32_t n = 1 << log2n;
+		double tolerance = epsilon * ut_norm(inputReal, inputImag, n);
+		memcpy(real, inputReal, sizeof(float) * n);
+		memcpy(imag, inputImag, sizeof(float) * n);
+		azaFFTPlanTransform(&plan, real, imag, log2n);
+		ut_dft(expectedReal, expectedImag, inputReal, inputImag, n);
+		ut_expectSpectrum(real, imag, expectedReal, expectedImag, n, tolerance);
+	}
+	utEndSubtest();
+
+	utBeginSubtest("Forward Real");
+	{
+		double tolerance = epsilon * ut_norm(inputReal, NULL, len);
+		memset(imag, 0, sizeof(float) * len);
+		azaFFTPlanForwardReal(&plan, inputReal, real, imag);
+		// The DFT of real samples is what the complex DFT gives with the imaginary parts all zero
+		float *zeroes = calloc(len, sizeof(float));
+		ut_dft(expectedReal, expectedImag, inputReal, zeroes, len);
+		free(zeroes);
+		ut_expectSpectrum(real, imag, expectedReal, expectedImag, len/2+1, tolerance);
+	}
+	utEndSubtest();
+
+	utBeginSubtest("Inverse Real");
+	{
+		// real and imag still hold the forward real transform, which get destroyed here
+		float *samples = malloc(sizeof(float) * len);
+		azaFFTPlanInverseReal(&plan, samples, real, imag);
+		ut_expectSamples(samples, inputReal, len, epsilon * 2.0, "samples");
+		free(samples);
+	}
+	utEndSubtest();
+
+	utBeginSubtest("Forward Real In-Place");
+	{
+		double tolerance = epsilon * ut_norm(inputReal, NULL, len);
+		memcpy(real, inputReal, sizeof(float) * len);
+		azaFFTPlanForwardReal(&plan, real, real, imag);
+		ut_expectSpectrum(real, imag, expectedReal, expectedImag, len/2+1, tolerance);
+	}
+	utEndSubtest();
+
+	free(inputReal);
+	free(expectedReal);
+	azaFFTPlanDeinit(&plan);
+}
+
+static void ut_test_azaFFT(uint32_t log2Len) {
+	const uint32_t len = 1 << log2Len;
+	float *inputReal = malloc(sizeof(float) * len * 3);
+	float *real = inputReal + len;
+	float *imag = real + len;
+	double *expectedReal = malloc(sizeof(double) * len * 2);
+	double *expectedImag = expectedReal + len;
+	// azaFFT computes its twiddles with cosf and sinf of growing angles, which loses a bit more precision
+	const double epsilon = 4.0e-6 * (double)(log2Len + 1);
+
+	srand(7331 + log2Len);
+	ut_fillRandom(inputReal, len);
+	memcpy(real, inputReal, sizeof(float) * len);
+	memset(imag, 0, sizeof(float) * len);
+	azaFFT(real, imag, len);
+	float *zeroes = calloc(len, sizeof(float));
+	ut_dft(expectedReal, expectedImag, inputReal, zeroes, len);
+	free(zeroes);
+	utBeginSubtest("Forward");
+	ut_expectSpectrum(real, imag, expectedReal, expectedImag, len/2+1, epsilon * ut_norm(inputReal, NULL, len));
+	utEndSubtest();
+
+	free(inputReal);
+	free(expectedReal);
+}
+
+static void ut_test_azaFFTSpectrumMultiplyAccumulate(uint32_t count) {
+	float *values = malloc(sizeof(float) * count * 6);
+	float *accReal = values;
+	float *accImag = accReal + count;
+	float *aReal = accImag + count;
+	float *aImag = aReal + count;
+	float *bReal = aImag + count;
+	float *bImag = bReal + count;
+	float *expectedReal = malloc(sizeof(float) * count * 2);
+	float *expectedImag = expectedReal + count;
+
+	srand(4242 + count);
+	ut_fillRandom(values, count * 6);
+	for (uint32_t i = 0; i < count; i++) {
+		expectedReal[i] = (float)((double)accReal[i] + (double)aReal[i] * bReal[i] - (double)aImag[i] * bImag[i]);
+		expectedImag[i] = (float)((double)accImag[i] + (double)aReal[i] * bImag[i] + (double)aImag[i] * bReal[i]);
+	}
+	azaFFTSpectrumMultiplyAccumulate(accReal, accImag, aReal, aImag, bReal, bImag, count);
+	utBeginSubtest("Multiply Accumulate");
+	ut_expectSamples(accReal, expectedReal, count, 1.0e-6, "accReal");
+	ut_expectSamples(accImag, expectedImag, count, 1.0e-6, "accImag");
+	utEndSubtest();
+
+	free(values);
+	free(expectedReal);
+}
+
+void ut_run_azaFFT() {
+	for (uint32_t log2Len = 1; log2Len <= 11; log2Len++) {
+		utBeginTest(azaTextFormat("azaFFT.c azaFFTPlan with len %u", 1 << log2Len));
+		ut_test_azaFFTPlan(log2Len);
+		utEndTest();
+	}
+	for (uint32_t log2Len = 1; log2Len <= 11; log2Len++) {
+		utBeginTest(azaTextFormat("azaFFT.c azaFFT with len %u", 1 << log2Len));
+		ut_test_azaFFT(log2Len);
+		utEndTest();
+	}
+	// Counts that don't fill whole vectors
+	const uint32_t counts[] = { 1, 3, 8, 17, 129 };
+	for (uint32_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+		utBeginTest(azaTextFormat("azaFFT.c azaFFTSpectrumMultiplyAccumulate with count %u", counts[i]));
+		ut_test_azaFFTSpectrumMultiplyAccumulate(counts[i]);
+		utEndTest();
+	}
+}
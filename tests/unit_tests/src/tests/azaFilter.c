@@ -0,0 +1,158 @@
+/*
+	File: azaFilter.c
+	Author: Philip Haynes
+	Testing the correctness of azaFilter's frequency responses for every kind and topology, measured from the impulse response.
+*/
+
+#include "../testing.h"
+
+#include <AzAudio/error.h>
+#include <AzAudio/math.h>
+#include <AzAudio/dsp/plugins/azaFilter.h>
+
+#include <math.h>
+
+typedef struct ut_Complex {
+	double real, imag;
+} ut_Complex;
+
+static ut_Complex ut_complexMul(ut_Complex a, ut_Complex b) {
+	return (ut_Complex) { a.real * b.real - a.imag * b.imag, a.real * b.imag + a.imag * b.real };
+}
+
+static ut_Complex ut_complexDiv(ut_Complex a, ut_Complex b) {
+	double denom = b.real * b.real + b.imag * b.imag;
+	return (ut_Complex) { (a.real * b.real + a.imag * b.imag) / denom, (a.imag * b.real - a.real * b.imag) / denom };
+}
+
+static double ut_complexAbs(ut_Complex a) {
+	return sqrt(a.real * a.real + a.imag * a.imag);
+}
+
+// Exact response of the cascaded one-poles at frequency, where each low pass stage is (1-a) / (1 - a*z^-1)
+static ut_Complex ut_responseOnePole(azaFilterKind kind, uint32_t poles, double cutoff, double frequency, double samplerate) {
+	const double a = exp(-AZA_TAU_D * cutoff / samplerate);
+	const double omega = AZA_TAU_D * frequency / samplerate;
+	const ut_Complex one = { 1.0, 0.0 };
+	ut_Complex lowPass = ut_complexDiv((ut_Complex) { 1.0 - a, 0.0 }, (ut_Complex) { 1.0 - a * cos(omega), a * sin(omega) });
+	ut_Complex highPass = { 1.0 - lowPass.real, -lowPass.imag };
+	ut_Complex stage;
+	switch (kind) {
+		case AZA_FILTER_HIGH_PASS: stage = highPass; break;
+		case AZA_FILTER_LOW_PASS: stage = lowPass; break;
+		case AZA_FILTER_BAND_PASS: stage = ut_complexMul((ut_Complex) { 2.0, 0.0 }, ut_complexMul(lowPass, highPass)); break;
+		default: stage = one; break;
+	}
+	ut_Complex result = one;
+	for (uint32_t i = 0; i < poles; i++) {
+		result = ut_complexMul(result, stage);
+	}
+	return result;
+}
+
+// Magnitude of the analog prototype that the SVF cascade is a bilinear transform of, where omega is the prewarped frequency relative to the cutoff
+static double ut_responseSVF(azaFilterKind kind, uint32_t poles, double cutoff, double frequency, double samplerate) {
+	const double omega = tan(AZA_PI_D * frequency / samplerate) / tan(AZA_PI_D * cutoff / samplerate);
+	switch (kind) {
+		// Butterworth
+		case AZA_FILTER_HIGH_PASS: return pow(omega, (double)poles) / sqrt(1.0 + pow(omega, 2.0 * poles));
+		case AZA_FILTER_LOW_PASS: return 1.0 / sqrt(1.0 + pow(omega, 2.0 * poles));
+		// 2s / (s+1)^2 per pole
+		case AZA_FILTER_BAND_PASS: return pow(2.0 * omega / (1.0 + omega * omega), (double)poles);
+		default: return 1.0;
+	}
+}
+
+static void ut_test_azaFilter(azaFilterKind kind, azaFilterTopology topology, uint32_t poles, uint8_t channels) {
+	const uint32_t samplerate = 48000;
+	const float cutoff = 1000.0f;
+	// Long enough for the most resonant sections to ring out past float precision
+	const uint32_t frames = 16384;
+	// Sizes of each call to azaFilterProcess, cycled through, so the state has to carry over between them
+	const uint32_t blockFrames[] = { 100, 1, 4096, 37 };
+	azaFilter filter;
+	azaFilterInit(&filter, (azaFilterConfig) {
+		.kind = kind,
+		.poles = poles - 1,
+		.frequency = cutoff,
+		.topology = topology,
+	});
+
+	azaBuffer buffer;
+	azaBufferInit(&buffer, frames, 0, 0, (azaChannelLayout) { .count = channels });
+	buffer.samplerate = samplerate;
+	azaBufferZero(&buffer);
+	for (uint8_t c = 0; c < channels; c++) {
+		// Each channel gets a differently scaled impulse so we can tell if they got mixed up
+		buffer.pSamples[c] = 1.0f + 0.5f * (float)c;
+	}
+	for (uint32_t start = 0, block = 0; start < frames; block++) {
+		uint32_t count = AZA_MIN(blockFrames[block % (sizeof(blockFrames) / sizeof(blockFrames[0]))], frames - start);
+		azaBuffer slice = azaBufferSlice(&buffer, start, count);
+		int err = azaFilterProcess(&filter, &slice, &slice, 0);
+		if (err) {
+			UT_SUBMIT_FAIL("azaFilterProcess returned an error: %s", azaErrorString(err));
+			break;
+		}
+		start += count;
+	}
+
+	const float frequencies[] = { 125.0f, 500.0f, 707.0f, 1000.0f, 1414.0f, 2000.0f, 8000.0f };
+	utBeginSubtest("Frequency Response");
+	for (uint32_t f = 0; f < sizeof(frequencies) / sizeof(frequencies[0]); f++) {
+		const double omega = AZA_TAU_D * frequencies[f] / (double)samplerate;
+		ut_Complex measured[AZA_MAX_CHANNEL_POSITIONS] = {0};
+		for (uint32_t i = 0; i < frames; i++) {
+			double c = cos(omega * (double)i), s = -sin(omega * (double)i);
+			for (uint8_t ch = 0; ch < channels; ch++) {
+				double sample = (double)buffer.pSamples[i * channels + ch] / (1.0 + 0.5 * ch);
+				measured[ch].real += sample * c;
+				measured[ch].imag += sample * s;
+			}
+		}
+		for (uint8_t ch = 0; ch < channels; ch++) {
+			if (topology == AZA_FILTER_TOPOLOGY_ONE_POLE) {
+				// We know the exact transfer function, so we can check phase too
+				ut_Complex expected = ut_responseOnePole(kind, poles, cutoff, frequencies[f], samplerate);
+				double error = ut_complexAbs((ut_Complex) { measured[ch].real - expected.real, measured[ch].imag - expected.imag });
+				// Negated so NaNs fail too
+				if (!(error <= 1.0e-5)) {
+					UT_SUBMIT_FAIL("response at %.0fHz = (%f, %f), expected = (%f, %f), channel = %hhu", frequencies[f], measured[ch].real, measured[ch].imag, expected.real, expected.imag, ch);
+				}
+			} else {
+				double expected = ut_responseSVF(kind, poles, cutoff, frequencies[f], samplerate);
+				double actual = ut_complexAbs(measured[ch]);
+				if (!(fabs(actual - expected) <= 1.0e-5)) {
+					UT_SUBMIT_FAIL("magnitude at %.0fHz = %f, expected = %f, channel = %hhu", frequencies[f], actual, expected, ch);
+				}
+			}
+		}
+		if (topology == AZA_FILTER_TOPOLOGY_SVF && kind != AZA_FILTER_BAND_PASS && frequencies[f] == cutoff) {
+			// The whole point of tuning them as Butterworth filters is that they're exactly -3dB at the cutoff no matter how many poles there are
+			double actual = aza_amp_to_dbf((float)ut_complexAbs(measured[0]));
+			if (!(fabs(actual - -3.0103) <= 1.0e-4)) {
+				UT_SUBMIT_FAIL("gain at the cutoff = %fdB, expected = -3.0103dB", actual);
+			}
+		}
+	}
+	utEndSubtest();
+
+	azaBufferDeinit(&buffer, true);
+	azaFilterDeinit(&filter);
+}
+
+void ut_run_azaFilter() {
+	const uint32_t poleCounts[] = { 1, 2, 3, 4, 7, 8, 16 };
+	const uint8_t channelCounts[] = { 1, 5 };
+	for (uint32_t topology = 0; topology < AZA_FILTER_TOPOLOGY_COUNT; topology++) {
+		for (uint32_t kind = 0; kind < AZA_FILTER_KIND_COUNT; kind++) {
+			for (uint32_t p = 0; p < sizeof(poleCounts) / sizeof(poleCounts[0]); p++) {
+				for (uint32_t c = 0; c < sizeof(channelCounts) / sizeof(channelCounts[0]); c++) {
+					utBeginTest(azaTextFormat("azaFilter.c %s %s with %u poles (%hhu channels)", azaFilterTopologyString[topology], azaFilterKindString[kind], poleCounts[p], channelCounts[c]));
+					ut_test_azaFilter((azaFilterKind)kind, (azaFilterTopology)topology, poleCounts[p], channelCounts[c]);
+					utEndTest();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,214 @@
+/*
+	File: azaLookaheadLimiter.c
+	Author: Philip Haynes
+	Testing the correctness of the lookahead limiter's peak bound, latency, and that it leaves quiet signals alone.
+*/
+
+#include "../testing.h"
+
+#include <AzAudio/error.h>
+#include <AzAudio/math.h>
+#include <AzAudio/dsp/plugins/azaLookaheadLimiter.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+typedef enum ut_LimiterSignal {
+	// A quiet sine with loud bursts in it
+	UT_LIMITER_SIGNAL_BURSTS,
+	// Silence with single-sample spikes, which need the whole lookahead to ramp down for
+	UT_LIMITER_SIGNAL_IMPULSES,
+	// Loud noise that's over the limit almost all of the time
+	UT_LIMITER_SIGNAL_NOISE,
+} ut_LimiterSignal;
+
+static const char *ut_LimiterSignalString[] = {
+	"bursts",
+	"impulses",
+	"noise",
+};
+
+static float ut_random() {
+	return (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+}
+
+static float ut_limiterSignal(ut_LimiterSignal signal, uint32_t frame) {
+	switch (signal) {
+		case UT_LIMITER_SIGNAL_BURSTS: {
+			float amp = (frame % 1500) >= 700 && (frame % 1500) < 900 ? 4.0f : 0.3f;
+			return amp * sinf(0.05f * (float)frame);
+		}
+		case UT_LIMITER_SIGNAL_IMPULSES:
+			return frame % 397 == 200 ? (frame % 2 ? -10.0f : 10.0f) : 0.0f;
+		case UT_LIMITER_SIGNAL_NOISE:
+			return 3.0f * ut_random();
+	}
+	return 0.0f;
+}
+
+// Sizes of each call to azaLookaheadLimiterProcess, cycled through, so the state has to carry over between them
+static const uint32_t ut_blockFrames[] = { 1, 64, 333, 17, 1024 };
+
+// Runs input through the limiter in uneven blocks, writing the result into output
+static int ut_processLimiter(azaLookaheadLimiter *limiter, azaBuffer *output, azaBuffer *input) {
+	for (uint32_t start = 0, block = 0; start < input->frames; block++) {
+		uint32_t count = AZA_MIN(ut_blockFrames[block % (sizeof(ut_blockFrames) / sizeof(ut_blockFrames[0]))], input->frames - start);
+		azaBuffer dst = azaBufferSlice(output, start, count);
+		azaBuffer src = azaBufferSlice(input, start, count);
+		int err = azaLookaheadLimiterProcess(limiter, &dst, &src, 0);
+		if (err) return err;
+		start += count;
+	}
+	return AZA_SUCCESS;
+}
+
+static void ut_test_azaLookaheadLimiterPeakBound(ut_LimiterSignal signal, float lookahead_ms, float gainInput, float gainOutput) {
+	const uint32_t samplerate = 48000;
+	const uint32_t frames = 8000;
+	const float amountInput = aza_db_to_ampf(gainInput);
+	const float amountOutput = aza_db_to_ampf(gainOutput);
+	srand(4321);
+	azaLookaheadLimiter limiter;
+	azaLookaheadLimiterInit(&limiter, (azaLookaheadLimiterConfig) {
+		.gainInput = gainInput,
+		.gainOutput = gainOutput,
+		.lookahead_ms = lookahead_ms,
+	});
+	const uint32_t latency = azaLookaheadLimiterGetSpecs(&limiter.dsp, samplerate).latencyFrames;
+	const float gainTolerance = 1.0e-5f + 2.0e-7f * (float)latency;
+
+	// The second channel is the first scaled by -0.5, so it should always come out that way if the gain is shared and nothing got clipped
+	azaBuffer input, output;
+	azaBufferInit(&input, frames, 0, 0, (azaChannelLayout) { .count = 2 });
+	azaBufferInit(&output, frames, 0, 0, (azaChannelLayout) { .count = 2 });
+	input.samplerate = output.samplerate = samplerate;
+	for (uint32_t i = 0; i < frames; i++) {
+		float sample = ut_limiterSignal(signal, i);
+		input.pSamples[i * 2 + 0] = sample;
+		input.pSamples[i * 2 + 1] = -0.5f * sample;
+	}
+
+	int err = ut_processLimiter(&limiter, &output, &input);
+	if (err) {
+		UT_SUBMIT_FAIL("azaLookaheadLimiterProcess returned an error: %s", azaErrorString(err));
+	}
+	UT_EXPECT_EQUAL(UT_FAIL, latency, limiter.lookaheadFrames, "latency = %u, lookaheadFrames = %u", latency, limiter.lookaheadFrames);
+
+	utBeginSubtest("Peak Bound");
+	for (uint32_t i = 0; i < frames * 2; i++) {
+		// Negated so NaNs fail too
+		if (!(fabsf(output.pSamples[i]) <= amountOutput * (1.0f + 1.0e-6f))) {
+			UT_SUBMIT_FAIL("output.pSamples[i] = %f, limit = %f, frame = %u", output.pSamples[i], amountOutput, i / 2);
+		}
+	}
+	utEndSubtest();
+
+	utBeginSubtest("Gain Instead Of Clipping");
+	for (uint32_t i = 0; i < frames; i++) {
+		float loud = output.pSamples[i * 2 + 0];
+		float quiet = output.pSamples[i * 2 + 1];
+		// If the gain didn't get all the way down in time, the output clamp would clip the loud channel but not the quiet one.
+		// Peaks land right on the limit, so allow for the clamp shaving off the rounding error of the gain, which is a running sum over the lookahead.
+		if (!(fabsf(quiet - -0.5f * loud) <= gainTolerance)) {
+			UT_SUBMIT_FAIL("output = (%f, %f), expected the second channel to be %f, frame = %u", loud, quiet, -0.5f * loud, i);
+		}
+	}
+	utEndSubtest();
+
+	utBeginSubtest("Latency");
+	for (uint32_t i = 0; i < frames; i++) {
+		float actual = output.pSamples[i * 2];
+		if (i < latency) {
+			UT_EXPECT_EQUAL(UT_FAIL, actual, 0.0f, "frame = %u, latency = %u", i, latency);
+			continue;
+		}
+		// The output is the input from latency frames ago times a gain that can only turn it down
+		float in = input.pSamples[(i - latency) * 2] * amountInput * amountOutput;
+		if (fabsf(in) < 1.0e-3f) continue;
+		float gain = actual / in;
+		if (!(gain > 0.0f && gain <= 1.0f + gainTolerance)) {
+			UT_SUBMIT_FAIL("output = %f, delayed input = %f, gain = %f, frame = %u", actual, in, gain, i);
+		}
+	}
+	utEndSubtest();
+
+	azaBufferDeinit(&input, true);
+	azaBufferDeinit(&output, true);
+	azaLookaheadLimiterDeinit(&limiter);
+}
+
+static void ut_test_azaLookaheadLimiterQuiet(float lookahead_ms) {
+	const uint32_t samplerate = 48000;
+	// Loud enough to need limiting for a while in the middle
+	const uint32_t burstStart = 1000;
+	const uint32_t burstEnd = 1100;
+	azaLookaheadLimiter limiter;
+	azaLookaheadLimiterInit(&limiter, (azaLookaheadLimiterConfig) {
+		.lookahead_ms = lookahead_ms,
+	});
+	const uint32_t latency = azaLookaheadLimiterGetSpecs(&limiter.dsp, samplerate).latencyFrames;
+	// The gain comes back up with a time constant of 5 lookaheads, so after 10 time constants it's within 0.005%
+	const uint32_t recoveredFrame = burstEnd + latency + 50 * latency;
+	const uint32_t frames = recoveredFrame + 1000;
+
+	azaBuffer input, output;
+	azaBufferInit(&input, frames, 0, 0, (azaChannelLayout) { .count = 1 });
+	azaBufferInit(&output, frames, 0, 0, (azaChannelLayout) { .count = 1 });
+	input.samplerate = output.samplerate = samplerate;
+	for (uint32_t i = 0; i < frames; i++) {
+		float amp = i >= burstStart && i < burstEnd ? 3.0f : 0.9f;
+		input.pSamples[i] = amp * sinf(0.031f * (float)i);
+	}
+
+	int err = ut_processLimiter(&limiter, &output, &input);
+	if (err) {
+		UT_SUBMIT_FAIL("azaLookaheadLimiterProcess returned an error: %s", azaErrorString(err));
+	}
+
+	utBeginSubtest("Untouched Before The Burst");
+	// The gain starts ramping down a lookahead before the burst comes out
+	for (uint32_t i = 0; i < burstStart; i++) {
+		float expected = i < latency ? 0.0f : input.pSamples[i - latency];
+		if (!(fabsf(output.pSamples[i] - expected) <= 1.0e-6f)) {
+			UT_SUBMIT_FAIL("output.pSamples[i] = %f, expected = %f, frame = %u", output.pSamples[i], expected, i);
+		}
+	}
+	utEndSubtest();
+
+	utBeginSubtest("Recovers After The Burst");
+	for (uint32_t i = recoveredFrame; i < frames; i++) {
+		float expected = input.pSamples[i - latency];
+		if (!(fabsf(output.pSamples[i] - expected) <= 1.0e-3f)) {
+			UT_SUBMIT_FAIL("output.pSamples[i] = %f, expected = %f, frame = %u", output.pSamples[i], expected, i);
+		}
+	}
+	utEndSubtest();
+
+	azaBufferDeinit(&input, true);
+	azaBufferDeinit(&output, true);
+	azaLookaheadLimiterDeinit(&limiter);
+}
+
+void ut_run_azaLookaheadLimiter() {
+	// About 5, 130, and 480 frames at 48kHz
+	const float lookaheads[] = { 0.1f, AZAUDIO_LOOKAHEAD_DEFAULT_MS, 10.0f };
+	const struct {
+		float gainInput, gainOutput;
+	} gains[] = {
+		{  0.0f,  0.0f },
+		{ 12.0f,  0.0f },
+		{  0.0f, -6.0f },
+	};
+	for (uint32_t l = 0; l < sizeof(lookaheads) / sizeof(lookaheads[0]); l++) {
+		for (uint32_t signal = 0; signal < sizeof(ut_LimiterSignalString) / sizeof(ut_LimiterSignalString[0]); signal++) {
+			for (uint32_t g = 0; g < sizeof(gains) / sizeof(gains[0]); g++) {
+				utBeginTest(azaTextFormat("azaLookaheadLimiter.c %s with %.1fms lookahead, gainInput %+.0fdB, gainOutput %+.0fdB", ut_LimiterSignalString[signal], lookaheads[l], gains[g].gainInput, gains[g].gainOutput));
+				ut_test_azaLookaheadLimiterPeakBound((ut_LimiterSignal)signal, lookaheads[l], gains[g].gainInput, gains[g].gainOutput);
+				utEndTest();
+			}
+		}
+		utBeginTest(azaTextFormat("azaLookaheadLimiter.c quiet signal with %.1fms lookahead", lookaheads[l]));
+		ut_test_azaLookaheadLimiterQuiet(lookaheads[l]);
+		utEndTest();
+	}
+}
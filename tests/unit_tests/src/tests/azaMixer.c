@@ -0,0 +1,203 @@
+/*
+	File: azaMixer.c
+	Author: Philip Haynes
+	Testing that the parallel track scheduler produces exactly the same output as processing every track on one thread.
+*/
+
+#include "../testing.h"
+
+#include <AzAudio/error.h>
+#include <AzAudio/math.h>
+#include <AzAudio/mixer.h>
+#include <AzAudio/dsp/plugins/azaDelay.h>
+#include <AzAudio/dsp/plugins/azaFilter.h>
+#include <AzAudio/dsp/plugins/azaLookaheadLimiter.h>
+
+#include <string.h>
+
+// Deterministic noise plugin so every mixer gets the same input
+typedef struct ut_Source {
+	azaDSP dsp;
+	uint32_t seed;
+} ut_Source;
+
+static int ut_sourceProcess(void *data, azaBuffer *dst, azaBuffer *src, uint32_t flags) {
+	ut_Source *source = (ut_Source*)data;
+	for (uint32_t i = 0; i < dst->frames; i++) {
+		for (uint8_t c = 0; c < dst->channelLayout.count; c++) {
+			source->seed = source->seed * 1664525u + 1013904223u;
+			float noise = (float)(source->seed >> 8) / 16777216.0f - 0.5f;
+			dst->pSamples[i * dst->stride + c] = src->pSamples[i * src->stride + c] + noise;
+		}
+	}
+	dst->silent = false;
+	return AZA_SUCCESS;
+}
+
+static const azaDSPFuncs ut_sourceFuncs = {
+	.fp_process = ut_sourceProcess,
+};
+
+#define UT_MIXER_SOURCES 12
+#define UT_MIXER_BUSES 4
+
+typedef struct ut_MixerSetup {
+	azaMixer mixer;
+	// Whether mixer needs azaMixerDeinit, since azaMixerInit cleans up after itself if it fails
+	bool initialized;
+	ut_Source sources[UT_MIXER_SOURCES];
+	azaTrack *sourceTracks[UT_MIXER_SOURCES];
+	azaTrack *busTracks[UT_MIXER_BUSES];
+} ut_MixerSetup;
+
+static void ut_appendOwned(azaTrack *track, azaDSP *dsp) {
+	// Owned, so azaTrackDeinit frees them with the mixer
+	dsp->header.owned = true;
+	azaTrackAppendDSP(track, dsp);
+}
+
+// Builds the same graph no matter how many worker threads there are. Sources feed buses, some of which feed other buses, with plugins that have latency and history along the way.
+static int ut_buildMixer(ut_MixerSetup *setup, uint32_t workerThreads) {
+	const azaChannelLayout stereo = azaChannelLayoutStandardFromCount(2);
+	const azaChannelLayout mono = azaChannelLayoutStandardFromCount(1);
+	int err = azaMixerInit(&setup->mixer, (azaMixerConfig) {
+		.bufferFrames = 512,
+		.workerThreads = workerThreads,
+		.dspBlockFrames = 128,
+	}, stereo);
+	if (err) return err;
+	setup->initialized = true;
+	for (uint32_t i = 0; i < UT_MIXER_BUSES; i++) {
+		err = azaMixerAddTrack(&setup->mixer, -1, &setup->busTracks[i], stereo, i != 2);
+		if (err) return err;
+		setup->busTracks[i]->gain = -1.0f * (float)i;
+	}
+	// Bus 2 goes through bus 3, so there's a chain of dependencies as well as a wide layer
+	err = azaTrackConnect(setup->busTracks[2], setup->busTracks[3], -2.0f, NULL, 0);
+	if (err) return err;
+	ut_appendOwned(setup->busTracks[0], &azaFilterMake((azaFilterConfig) { .kind = AZA_FILTER_LOW_PASS, .poles = 1, .frequency = 3000.0f, .topology = AZA_FILTER_TOPOLOGY_SVF })->dsp);
+	ut_appendOwned(setup->busTracks[1], &azaDelayMake((azaDelayConfig) { .gainWet = -6.0f, .delay_ms = 3.0f, .feedback = 0.3f, .pingpong = 0.2f })->dsp);
+	ut_appendOwned(setup->busTracks[3], &azaLookaheadLimiterMake((azaLookaheadLimiterConfig) { .gainInput = 6.0f })->dsp);
+	for (uint32_t i = 0; i < UT_MIXER_SOURCES; i++) {
+		azaTrack *track;
+		err = azaMixerAddTrack(&setup->mixer, -1, &track, i % 4 == 1 ? mono : stereo, i % 5 == 0);
+		if (err) return err;
+		setup->sourceTracks[i] = track;
+		track->gain = -0.5f * (float)(i % 3);
+		setup->sources[i] = (ut_Source) {
+			.dsp = {
+				.header = { .size = sizeof(ut_Source) },
+				.pFuncs = &ut_sourceFuncs,
+			},
+			.seed = i * 7919 + 1,
+		};
+		azaTrackAppendDSP(track, &setup->sources[i].dsp);
+		if (i % 3 == 0) {
+			// Different latencies on different tracks, so the buses need latency compensation
+			ut_appendOwned(track, &azaLookaheadLimiterMake((azaLookaheadLimiterConfig) { .lookahead_ms = 1.0f + (float)i * 0.5f })->dsp);
+		}
+		err = azaTrackConnect(track, setup->busTracks[i % UT_MIXER_BUSES], -3.0f, NULL, 0);
+		if (err) return err;
+	}
+	return azaMixerCommit(&setup->mixer);
+}
+
+// The same changes to routing for every mixer, so the graph gets republished while processing
+static int ut_changeMixer(ut_MixerSetup *setup, uint32_t block) {
+	switch (block) {
+		case 20:
+			setup->sourceTracks[2]->mute = true;
+			break;
+		case 35:
+			azaTrackGetReceive(setup->sourceTracks[5], setup->busTracks[1])->mute = true;
+			break;
+		case 50:
+			setup->sourceTracks[2]->mute = false;
+			azaTrackDisconnect(setup->sourceTracks[7], setup->busTracks[3]);
+			break;
+		case 65: {
+			int err = azaTrackConnect(setup->sourceTracks[7], setup->busTracks[0], 0.0f, NULL, 0);
+			if (err) return err;
+		} break;
+		default: return AZA_SUCCESS;
+	}
+	return azaMixerCommit(&setup->mixer);
+}
+
+static void ut_test_azaMixerScheduler(uint32_t workerThreads) {
+	// Sizes of each call to azaMixerProcess, cycled through
+	const uint32_t blockFrames[] = { 256, 37, 512, 1, 300 };
+	const uint32_t blocks = 80;
+	ut_MixerSetup *reference = aza_calloc(1, sizeof(ut_MixerSetup));
+	ut_MixerSetup *parallel = aza_calloc(1, sizeof(ut_MixerSetup));
+	if (!reference || !parallel) {
+		UT_SUBMIT_FAIL("Out of memory allocating %u bytes", (uint32_t)sizeof(ut_MixerSetup));
+		goto done;
+	}
+	int err = ut_buildMixer(reference, 0);
+	if (err) {
+		UT_SUBMIT_FAIL("Failed to build the reference mixer: %s", azaErrorString(err));
+		goto done;
+	}
+	err = ut_buildMixer(parallel, workerThreads);
+	if (err) {
+		UT_SUBMIT_FAIL("Failed to build the mixer with %u worker threads: %s", workerThreads, azaErrorString(err));
+		goto done;
+	}
+
+	utBeginSubtest("Same Output");
+	uint32_t failures = 0;
+	double energy = 0.0;
+	for (uint32_t block = 0; block < blocks; block++) {
+		uint32_t frames = blockFrames[block % (sizeof(blockFrames) / sizeof(blockFrames[0]))];
+		if ((err = ut_changeMixer(reference, block)) || (err = ut_changeMixer(parallel, block))) {
+			UT_SUBMIT_FAIL("Failed to change the mixers on block %u: %s", block, azaErrorString(err));
+			break;
+		}
+		if ((err = azaMixerProcess(frames, 48000, &reference->mixer))) {
+			UT_SUBMIT_FAIL("azaMixerProcess returned an error for the reference on block %u: %s", block, azaErrorString(err));
+			break;
+		}
+		if ((err = azaMixerProcess(frames, 48000, &parallel->mixer))) {
+			UT_SUBMIT_FAIL("azaMixerProcess returned an error with %u worker threads on block %u: %s", workerThreads, block, azaErrorString(err));
+			break;
+		}
+		azaBuffer *expected = &reference->mixer.master.buffer;
+		azaBuffer *actual = &parallel->mixer.master.buffer;
+		for (uint32_t i = 0; i < frames * expected->channelLayout.count; i++) {
+			energy += (double)expected->pSamples[i] * (double)expected->pSamples[i];
+			// Every track mixes its routes in the same order no matter which thread gets to it, so there's no excuse for even a rounding difference
+			if (memcmp(&actual->pSamples[i], &expected->pSamples[i], sizeof(float)) != 0) {
+				// Only report the first few, since one mistake tends to carry over into everything after it
+				if (failures < 10) {
+					UT_SUBMIT_FAIL("master = %f, expected = %f, block = %u, frame = %u, channel = %u", actual->pSamples[i], expected->pSamples[i], block, i / expected->channelLayout.count, i % expected->channelLayout.count);
+				}
+				failures++;
+			}
+		}
+	}
+	// Make sure we actually compared something
+	if (!(energy > 1.0)) {
+		UT_SUBMIT_FAIL("The master track was silent (energy = %f)", energy);
+	}
+	utEndSubtest();
+
+done:
+	if (reference) {
+		if (reference->initialized) azaMixerDeinit(&reference->mixer);
+		aza_free(reference);
+	}
+	if (parallel) {
+		if (parallel->initialized) azaMixerDeinit(&parallel->mixer);
+		aza_free(parallel);
+	}
+}
+
+void ut_run_azaMixer() {
+	const uint32_t workerThreadCounts[] = { 1, 2, 4 };
+	for (uint32_t i = 0; i < sizeof(workerThreadCounts) / sizeof(workerThreadCounts[0]); i++) {
+		utBeginTest(azaTextFormat("azaMixer.c scheduler with %u worker threads against none", workerThreadCounts[i]));
+		ut_test_azaMixerScheduler(workerThreadCounts[i]);
+		utEndTest();
+	}
+}
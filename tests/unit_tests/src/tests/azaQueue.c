@@ -0,0 +1,350 @@
+/*
+	File: azaQueue.c
+	Author: Philip Haynes
+	Testing the correctness of azaQueue event ordering, capacity, block splitting, and enqueueing from several threads at once.
+*/
+
+#include "../testing.h"
+
+#include <AzAudio/error.h>
+#include <AzAudio/math.h>
+#include <AzAudio/atomic.h>
+#include <AzAudio/dsp/utility.h>
+#include <AzAudio/backend/threads.h>
+
+#include <stdlib.h>
+
+typedef struct ut_QueueEntry {
+	azaQueueEntry header;
+	// Counts up in the order entries were enqueued, so ties in time can be checked
+	uint32_t id;
+	// Derived from id, so we can tell if an entry got torn or mixed up with another
+	uint32_t check;
+} ut_QueueEntry;
+
+static ut_QueueEntry ut_makeEntry(int64_t time, uint32_t id) {
+	return (ut_QueueEntry) {
+		.header = { .time = { .time = time } },
+		.id = id,
+		.check = id * 2654435761u,
+	};
+}
+
+static void ut_expectEntry(azaQueueEntry *actual, ut_QueueEntry expected) {
+	if (!actual) {
+		UT_SUBMIT_FAIL("got NULL, expected id %u at time %lld", expected.id, (long long)expected.header.time.time);
+		return;
+	}
+	ut_QueueEntry *entry = (ut_QueueEntry*)actual;
+	UT_EXPECT_EQUAL(UT_FAIL, entry->id, expected.id, "time = %lld, expected time = %lld", (long long)entry->header.time.time, (long long)expected.header.time.time);
+	UT_EXPECT_EQUAL(UT_FAIL, entry->header.time.time, expected.header.time.time, "id = %u", entry->id);
+	UT_EXPECT_EQUAL(UT_FAIL, entry->check, expected.check, "id = %u", entry->id);
+}
+
+// Index of the entry in pending that should come out next, which is the earliest time and then the earliest enqueued
+static uint32_t ut_findEarliest(ut_QueueEntry *pending, uint32_t count) {
+	uint32_t result = 0;
+	for (uint32_t i = 1; i < count; i++) {
+		if (pending[i].header.time.time < pending[result].header.time.time) {
+			result = i;
+		}
+	}
+	return result;
+}
+
+static void ut_removeAt(ut_QueueEntry *pending, uint32_t *count, uint32_t index) {
+	memmove(pending + index, pending + index + 1, sizeof(*pending) * (*count - index - 1));
+	(*count)--;
+}
+
+static void ut_test_azaQueueOrdering() {
+	azaQueue queue;
+	int err = azaQueueInit(&queue, sizeof(ut_QueueEntry), 50);
+	if (err) {
+		UT_SUBMIT_FAIL("azaQueueInit returned an error: %s", azaErrorString(err));
+		return;
+	}
+	// countLimit should round up to a power of 2
+	UT_EXPECT_EQUAL(UT_FAIL, queue.countLimit, 64, "countLimit = %hu", queue.countLimit);
+	srand(1234);
+	// Enqueue and dequeue in uneven bursts so the sorted buffer has to shift and wrap, with only a few distinct times so there are plenty of ties
+	ut_QueueEntry pending[64];
+	uint32_t pendingCount = 0;
+	uint32_t nextId = 0;
+	for (uint32_t round = 0; round < 200; round++) {
+		uint32_t toEnqueue = (uint32_t)rand() % 8;
+		for (uint32_t i = 0; i < toEnqueue && pendingCount < 50; i++) {
+			// Times only ever move forward by a little, like they do when scheduling ahead of the audio thread
+			ut_QueueEntry entry = ut_makeEntry((int64_t)round + rand() % 5, nextId++);
+			UT_EXPECT_EQUAL(UT_FAIL, azaQueueEnqueue(&queue, &entry.header), true, "id = %u", entry.id);
+			pending[pendingCount++] = entry;
+		}
+		utBeginSubtest("GetSorted");
+		azaQueueSort(&queue);
+		// Every pending entry is in the sorted buffer now, so GetSorted should walk them all in order
+		ut_QueueEntry sorted[64];
+		uint32_t sortedCount = pendingCount;
+		memcpy(sorted, pending, sizeof(*pending) * pendingCount);
+		for (uint32_t i = 0; i < pendingCount; i++) {
+			uint32_t index = ut_findEarliest(sorted, sortedCount);
+			ut_expectEntry(azaQueueGetSorted(&queue, i), sorted[index]);
+			ut_removeAt(sorted, &sortedCount, index);
+		}
+		UT_EXPECT_EQUAL(UT_FAIL, azaQueueGetSorted(&queue, pendingCount), NULL, "pendingCount = %u", pendingCount);
+		utEndSubtest();
+		utBeginSubtest("Dequeue");
+		uint32_t toDequeue = (uint32_t)rand() % 8;
+		for (uint32_t i = 0; i < toDequeue && pendingCount; i++) {
+			uint32_t index = ut_findEarliest(pending, pendingCount);
+			ut_expectEntry(azaQueuePeek(&queue), pending[index]);
+			ut_expectEntry(azaQueueDequeue(&queue), pending[index]);
+			ut_removeAt(pending, &pendingCount, index);
+		}
+		utEndSubtest();
+	}
+	utBeginSubtest("Drain");
+	while (pendingCount) {
+		uint32_t index = ut_findEarliest(pending, pendingCount);
+		ut_expectEntry(azaQueueDequeue(&queue), pending[index]);
+		ut_removeAt(pending, &pendingCount, index);
+	}
+	UT_EXPECT_EQUAL(UT_FAIL, azaQueueDequeue(&queue), NULL, "count = %hu", queue.count);
+	UT_EXPECT_EQUAL(UT_FAIL, azaQueuePeek(&queue), NULL, "count = %hu", queue.count);
+	utEndSubtest();
+	azaQueueDeinit(&queue);
+}
+
+static void ut_test_azaQueueFull() {
+	azaQueue queue;
+	int err = azaQueueInit(&queue, sizeof(ut_QueueEntry), 8);
+	if (err) {
+		UT_SUBMIT_FAIL("azaQueueInit returned an error: %s", azaErrorString(err));
+		return;
+	}
+	uint32_t nextId = 0;
+	utBeginSubtest("Ring Full");
+	for (uint32_t i = 0; i < 8; i++) {
+		ut_QueueEntry entry = ut_makeEntry(nextId, nextId);
+		UT_EXPECT_EQUAL(UT_FAIL, azaQueueEnqueue(&queue, &entry.header), true, "id = %u", nextId);
+		nextId++;
+	}
+	ut_QueueEntry overflow = ut_makeEntry(1000, 1000);
+	UT_EXPECT_EQUAL(UT_FAIL, azaQueueEnqueue(&queue, &overflow.header), false, "head = %d, tail = %u", queue.head, queue.tail);
+	utEndSubtest();
+
+	utBeginSubtest("Ring And Buffer Full");
+	// Taking everything out of the ring frees it up for another lap
+	azaQueueSort(&queue);
+	for (uint32_t i = 0; i < 8; i++) {
+		ut_QueueEntry entry = ut_makeEntry(nextId, nextId);
+		UT_EXPECT_EQUAL(UT_FAIL, azaQueueEnqueue(&queue, &entry.header), true, "id = %u", nextId);
+		nextId++;
+	}
+	// The sorted buffer is full too, so sorting can't take any more out of the ring
+	azaQueueSort(&queue);
+	UT_EXPECT_EQUAL(UT_FAIL, azaQueueEnqueue(&queue, &overflow.header), false, "head = %d, tail = %u, count = %hu", queue.head, queue.tail, queue.count);
+	utEndSubtest();
+
+	utBeginSubtest("Room After Dequeue");
+	ut_expectEntry(azaQueueDequeue(&queue), ut_makeEntry(0, 0));
+	azaQueueSort(&queue);
+	ut_QueueEntry entry = ut_makeEntry(nextId, nextId);
+	UT_EXPECT_EQUAL(UT_FAIL, azaQueueEnqueue(&queue, &entry.header), true, "id = %u", nextId);
+	nextId++;
+	for (uint32_t id = 1; id < nextId; id++) {
+		ut_expectEntry(azaQueueDequeue(&queue), ut_makeEntry(id, id));
+	}
+	UT_EXPECT_EQUAL(UT_FAIL, azaQueueDequeue(&queue), NULL, "count = %hu", queue.count);
+	utEndSubtest();
+
+	utBeginSubtest("Clear");
+	for (uint32_t i = 0; i < 8; i++) {
+		ut_QueueEntry entry = ut_makeEntry(nextId, nextId);
+		azaQueueEnqueue(&queue, &entry.header);
+		nextId++;
+	}
+	azaQueueClear(&queue);
+	UT_EXPECT_EQUAL(UT_FAIL, azaQueuePeek(&queue), NULL, "count = %hu", queue.count);
+	utEndSubtest();
+	azaQueueDeinit(&queue);
+}
+
+static void ut_test_azaQueueBlockSplitting() {
+	const uint32_t samplerate = 48000;
+	const uint32_t frames = 128;
+	const azaTime timePerFrame = azaTimePerSample(samplerate);
+	const azaTime timeStart = { .time = 10 * azaTimeOneSecond.time + 12345 };
+	azaQueue queue;
+	int err = azaQueueInit(&queue, sizeof(ut_QueueEntry), 16);
+	if (err) {
+		UT_SUBMIT_FAIL("azaQueueInit returned an error: %s", azaErrorString(err));
+		return;
+	}
+	const struct {
+		int64_t time;
+		// Which frame of the first block it should be applied on, where frames means it belongs to the next block
+		uint32_t frame;
+	} events[] = {
+		// Late events happen right away
+		{ timeStart.time - 1000 * timePerFrame.time, 0 },
+		{ timeStart.time, 0 },
+		// Rounded up so nothing happens early
+		{ timeStart.time + 1, 1 },
+		{ timeStart.time + timePerFrame.time / 2, 1 },
+		{ timeStart.time + 3 * timePerFrame.time, 3 },
+		// Same time, so this one comes after the one above
+		{ timeStart.time + 3 * timePerFrame.time, 3 },
+		{ timeStart.time + 100 * timePerFrame.time + 1, 101 },
+		{ timeStart.time + (int64_t)(frames - 1) * timePerFrame.time, frames - 1 },
+		// After this block
+		{ timeStart.time + (int64_t)frames * timePerFrame.time + 1, frames },
+	};
+	const uint32_t eventCount = sizeof(events) / sizeof(events[0]);
+	// Out of order so they have to be sorted, except for the two with the same time
+	const uint32_t enqueueOrder[] = { 8, 2, 6, 0, 4, 7, 1, 5, 3 };
+	static_assert(sizeof(enqueueOrder) == sizeof(events) / sizeof(events[0]) * sizeof(uint32_t), "enqueueOrder needs every event");
+	for (uint32_t i = 0; i < eventCount; i++) {
+		ut_QueueEntry entry = ut_makeEntry(events[enqueueOrder[i]].time, enqueueOrder[i]);
+		azaQueueEnqueue(&queue, &entry.header);
+	}
+
+	utBeginSubtest("First Block");
+	uint32_t applied = 0;
+	uint32_t frame = 0;
+	uint32_t segments = 0;
+	while (frame < frames) {
+		azaQueueEntry *entry;
+		while ((entry = azaQueueDequeueDue(&queue, timeStart, timePerFrame, frame))) {
+			uint32_t id = ((ut_QueueEntry*)entry)->id;
+			UT_EXPECT_EQUAL(UT_FAIL, id, applied, "events should be applied in order, frame = %u", frame);
+			UT_EXPECT_EQUAL(UT_FAIL, frame, events[id].frame, "id = %u", id);
+			applied++;
+		}
+		uint32_t frameNext = azaQueueGetNextFrame(&queue, timeStart, timePerFrame, frames);
+		if (frameNext <= frame) {
+			UT_SUBMIT_FAIL("azaQueueGetNextFrame returned %u, which doesn't move past frame %u", frameNext, frame);
+			break;
+		}
+		frame = frameNext;
+		segments++;
+	}
+	// The segments should end at the end of the block
+	UT_EXPECT_EQUAL(UT_FAIL, frame, frames, "frame = %u", frame);
+	// Only the last event belongs to the next block
+	UT_EXPECT_EQUAL(UT_FAIL, applied, eventCount - 1, "applied = %u", applied);
+	// Every distinct frame with an event on it starts a new segment, so it's split at frames 1, 3, 101, and 127
+	UT_EXPECT_EQUAL(UT_FAIL, segments, 5, "segments = %u", segments);
+	utEndSubtest();
+
+	utBeginSubtest("Next Block");
+	azaTime timeStartNext = { .time = timeStart.time + (int64_t)frames * timePerFrame.time };
+	// The last event is just after the start of the next block, so it's not due on frame 0
+	UT_EXPECT_EQUAL(UT_FAIL, azaQueueGetNextFrame(&queue, timeStartNext, timePerFrame, frames), 1, "timeStartNext = %lld", (long long)timeStartNext.time);
+	UT_EXPECT_EQUAL(UT_FAIL, azaQueueDequeueDue(&queue, timeStartNext, timePerFrame, 0), NULL, "timeStartNext = %lld", (long long)timeStartNext.time);
+	ut_expectEntry(azaQueueDequeueDue(&queue, timeStartNext, timePerFrame, 1), ut_makeEntry(events[eventCount-1].time, eventCount-1));
+	UT_EXPECT_EQUAL(UT_FAIL, azaQueueGetNextFrame(&queue, timeStartNext, timePerFrame, frames), frames, "count = %hu", queue.count);
+	utEndSubtest();
+	azaQueueDeinit(&queue);
+}
+
+#define UT_QUEUE_PRODUCERS 4
+#define UT_QUEUE_ENTRIES_PER_PRODUCER 20000
+
+typedef struct ut_QueueProducer {
+	azaQueue *queue;
+	uint32_t index;
+	azaThread thread;
+	// Shared between all of them, counting how many have enqueued everything
+	volatile int32_t *producersDone;
+} ut_QueueProducer;
+
+static AZA_THREAD_PROC_DEF(ut_queueProducerProc, userdata) {
+	ut_QueueProducer *producer = (ut_QueueProducer*)userdata;
+	for (uint32_t i = 0; i < UT_QUEUE_ENTRIES_PER_PRODUCER; i++) {
+		// Every producer's times go forward, but they all overlap with each other
+		ut_QueueEntry entry = ut_makeEntry(i, producer->index * UT_QUEUE_ENTRIES_PER_PRODUCER + i);
+		while (!azaQueueEnqueue(producer->queue, &entry.header)) {
+			azaThreadYield();
+		}
+	}
+	azaAtomicFetchAdd32(producer->producersDone, 1);
+	return 0;
+}
+
+static void ut_test_azaQueueMultipleProducers() {
+	azaQueue queue;
+	int err = azaQueueInit(&queue, sizeof(ut_QueueEntry), 64);
+	if (err) {
+		UT_SUBMIT_FAIL("azaQueueInit returned an error: %s", azaErrorString(err));
+		return;
+	}
+	ut_QueueProducer producers[UT_QUEUE_PRODUCERS];
+	volatile int32_t producersDone = 0;
+	uint32_t producersLaunched = 0;
+	for (uint32_t p = 0; p < UT_QUEUE_PRODUCERS; p++) {
+		producers[p] = (ut_QueueProducer) { .queue = &queue, .index = p, .producersDone = &producersDone };
+		err = azaThreadLaunch(&producers[p].thread, ut_queueProducerProc, &producers[p]);
+		if (err) {
+			UT_SUBMIT_FAIL("azaThreadLaunch returned an error: %d", err);
+			break;
+		}
+		producersLaunched++;
+	}
+	utBeginSubtest("Every Entry Once And In Order Per Producer");
+	const uint32_t total = producersLaunched * UT_QUEUE_ENTRIES_PER_PRODUCER;
+	// Next entry we expect from each producer
+	uint32_t expected[UT_QUEUE_PRODUCERS] = {0};
+	uint32_t received = 0;
+	uint32_t failures = 0;
+	// Keep going until every producer is done, even if things go wrong, otherwise they could be stuck waiting on a full queue forever
+	while (true) {
+		// Checked before dequeueing, so once they're all done we know we've seen everything they enqueued
+		bool allDone = azaAtomicLoad32(&producersDone) == (int32_t)producersLaunched;
+		ut_QueueEntry *entry = (ut_QueueEntry*)azaQueueDequeue(&queue);
+		if (!entry) {
+			if (allDone) break;
+			azaThreadYield();
+			continue;
+		}
+		received++;
+		if (received > total) {
+			// Getting entries nobody enqueued, so there's nothing more to learn
+			if (allDone) break;
+			continue;
+		}
+		uint32_t p = entry->id / UT_QUEUE_ENTRIES_PER_PRODUCER;
+		uint32_t i = entry->id % UT_QUEUE_ENTRIES_PER_PRODUCER;
+		// Entries from one producer take up slots in the ring in the order they were enqueued, so they can't overtake each other
+		if (p >= producersLaunched || i != expected[p] || entry->check != entry->id * 2654435761u || entry->header.time.time != (int64_t)i) {
+			// Only report the first few, since one mistake tends to cause a lot more
+			if (failures < 10) {
+				UT_SUBMIT_FAIL("id = %u, time = %lld, expected index %u from producer %u", entry->id, (long long)entry->header.time.time, p < producersLaunched ? expected[p] : 0, p);
+			}
+			failures++;
+		}
+		if (p < producersLaunched) {
+			expected[p] = i + 1;
+		}
+	}
+	UT_EXPECT_EQUAL(UT_FAIL, received, total, "failures = %u", failures);
+	for (uint32_t p = 0; p < producersLaunched; p++) {
+		azaThreadJoin(&producers[p].thread);
+	}
+	utEndSubtest();
+	azaQueueDeinit(&queue);
+}
+
+void ut_run_azaQueue() {
+	utBeginTest("azaQueue.c ordering with interleaved enqueues and dequeues");
+	ut_test_azaQueueOrdering();
+	utEndTest();
+	utBeginTest("azaQueue.c full queue");
+	ut_test_azaQueueFull();
+	utEndTest();
+	utBeginTest("azaQueue.c splitting a block at event boundaries");
+	ut_test_azaQueueBlockSplitting();
+	utEndTest();
+	utBeginTest("azaQueue.c enqueueing from several threads");
+	ut_test_azaQueueMultipleProducers();
+	utEndTest();
+}
@@ -0,0 +1,161 @@
+/*
+	File: azaResamplerPolyphase.c
+	Author: Philip Haynes
+	Testing the correctness of the polyphase resampler against the kernel resampler, and that streaming it in pieces doesn't change anything.
+*/
+
+#include "../testing.h"
+
+#include <AzAudio/error.h>
+#include <AzAudio/math.h>
+#include <AzAudio/dsp/azaKernel.h>
+#include <AzAudio/dsp/azaResamplerPolyphase.h>
+
+#include <math.h>
+
+// The two resamplers use different filters, so we can only expect them to agree on what's well inside both of their passbands.
+// Frequencies in cycles per frame at the lower of the two samplerates.
+static const float ut_frequencies[] = { 0.013f, 0.05f, 0.11f };
+
+// Sum of sines at ut_frequencies, where each channel has its own phases
+static float ut_signal(double timeInLowerFrames, uint8_t channel) {
+	double result = 0.0;
+	for (uint32_t i = 0; i < sizeof(ut_frequencies) / sizeof(ut_frequencies[0]); i++) {
+		result += 0.3 * sin(AZA_TAU_D * ut_frequencies[i] * timeInLowerFrames + 0.7 * (i + 1) * (channel + 1));
+	}
+	return (float)result;
+}
+
+// Sizes of each call to azaResamplerPolyphaseProcess, cycled through, including some that are bigger than AZA_RESAMPLER_POLYPHASE_CHUNK_FRAMES
+static const uint32_t ut_chunkFrames[] = { 37, 1, 512, 1000, 3, 200 };
+
+static void ut_test_azaResamplerPolyphase(uint32_t srcSamplerate, uint32_t dstSamplerate, uint8_t channels) {
+	const uint32_t srcFrames = 4096;
+	azaResamplerPolyphaseConfig config = {
+		.srcSamplerate = srcSamplerate,
+		.dstSamplerate = dstSamplerate,
+		.channels = channels,
+	};
+	azaResamplerPolyphase streamed, oneShot;
+	int err = azaResamplerPolyphaseInit(&streamed, config);
+	if (err) {
+		UT_SUBMIT_FAIL("azaResamplerPolyphaseInit returned an error: %s", azaErrorString(err));
+		return;
+	}
+	azaResamplerPolyphaseInit(&oneShot, config);
+
+	const uint32_t lowerSamplerate = AZA_MIN(srcSamplerate, dstSamplerate);
+	azaBuffer src;
+	azaBufferInit(&src, srcFrames, 0, 0, (azaChannelLayout) { .count = channels });
+	src.samplerate = srcSamplerate;
+	for (uint32_t i = 0; i < srcFrames; i++) {
+		for (uint8_t c = 0; c < channels; c++) {
+			src.pSamples[i * channels + c] = ut_signal((double)i * lowerSamplerate / srcSamplerate, c);
+		}
+	}
+
+	const uint32_t dstFrames = azaResamplerPolyphaseGetDstFrames(&oneShot, srcFrames);
+	azaBuffer dstStreamed, dstOneShot;
+	azaBufferInit(&dstStreamed, dstFrames, 0, 0, (azaChannelLayout) { .count = channels });
+	azaBufferInit(&dstOneShot, dstFrames, 0, 0, (azaChannelLayout) { .count = channels });
+
+	utBeginSubtest("Frame Counts");
+	uint32_t framesWritten = 0;
+	azaResamplerPolyphaseProcess(&oneShot, &dstOneShot, &src, &framesWritten);
+	UT_EXPECT_EQUAL(UT_FAIL, framesWritten, dstFrames, "framesWritten = %u, dstFrames = %u", framesWritten, dstFrames);
+	uint32_t dstFrame = 0;
+	for (uint32_t srcFrame = 0, chunk = 0; srcFrame < srcFrames; chunk++) {
+		uint32_t frames = AZA_MIN(ut_chunkFrames[chunk % (sizeof(ut_chunkFrames) / sizeof(ut_chunkFrames[0]))], srcFrames - srcFrame);
+		azaBuffer srcChunk = azaBufferSlice(&src, srcFrame, frames);
+		uint32_t expected = azaResamplerPolyphaseGetDstFrames(&streamed, frames);
+		if (expected) {
+			// GetSrcFrames should agree on the least we need to get that many
+			uint32_t srcFramesNeeded = azaResamplerPolyphaseGetSrcFrames(&streamed, expected);
+			UT_EXPECT_EQUAL(UT_FAIL, azaResamplerPolyphaseGetDstFrames(&streamed, srcFramesNeeded), expected, "srcFramesNeeded = %u, srcFrame = %u", srcFramesNeeded, srcFrame);
+			if (srcFramesNeeded > 1) {
+				UT_EXPECT_EQUAL(UT_FAIL, azaResamplerPolyphaseGetDstFrames(&streamed, srcFramesNeeded - 1) < expected, true, "srcFramesNeeded = %u, srcFrame = %u", srcFramesNeeded, srcFrame);
+			}
+		}
+		azaBuffer dstChunk = dstStreamed;
+		dstChunk.pSamples += dstFrame * channels;
+		dstChunk.frames = dstFrames - dstFrame;
+		err = azaResamplerPolyphaseProcess(&streamed, &dstChunk, &srcChunk, &framesWritten);
+		if (err) {
+			UT_SUBMIT_FAIL("azaResamplerPolyphaseProcess returned an error: %s", azaErrorString(err));
+			break;
+		}
+		UT_EXPECT_EQUAL(UT_FAIL, framesWritten, expected, "framesWritten = %u, expected = %u, srcFrame = %u", framesWritten, expected, srcFrame);
+		dstFrame += framesWritten;
+		srcFrame += frames;
+	}
+	UT_EXPECT_EQUAL(UT_FAIL, dstFrame, dstFrames, "dstFrame = %u, dstFrames = %u", dstFrame, dstFrames);
+	utEndSubtest();
+
+	utBeginSubtest("Streamed Against One Shot");
+	for (uint32_t i = 0; i < AZA_MIN(dstFrame, dstFrames) * channels; i++) {
+		float actual = dstStreamed.pSamples[i];
+		float expected = dstOneShot.pSamples[i];
+		// Negated so NaNs fail too
+		if (!(fabsf(actual - expected) <= 1.0e-6f)) {
+			UT_SUBMIT_FAIL("dstStreamed.pSamples[i] = %f, dstOneShot.pSamples[i] = %f, i = %u", actual, expected, i);
+		}
+	}
+	utEndSubtest();
+
+	// Where each dst frame lands in src, which is half the filter length behind the dst frame
+	const double srcFramesPerDstFrame = (double)oneShot.downFactor / (double)oneShot.upFactor;
+	const double delay = (double)oneShot.taps / 2.0;
+	azaKernel *kernel = azaKernelGetDefaultLanczos(AZA_RESAMPLER_POLYPHASE_RADIUS_DEFAULT);
+	// Our frequencies are well below both Nyquists, so the kernel doesn't need to low-pass anything and we can always traverse it at full rate.
+	// Both resamplers fade in and out at the ends, which we don't expect them to agree on
+	const double margin = delay + (double)kernel->length;
+	utBeginSubtest("Against Kernel Resampler");
+	for (uint32_t i = 0; i < dstFrames; i++) {
+		double pos = (double)i * srcFramesPerDstFrame - delay;
+		if (pos < margin || pos > (double)srcFrames - margin) continue;
+		// azaSampleWithKernel centers the kernel one frame behind frame + fraction
+		int32_t frame = (int32_t)floor(pos) + 1;
+		float fraction = (float)(pos - floor(pos));
+		float expected[AZA_MAX_CHANNEL_POSITIONS];
+		azaSampleWithKernel(expected, channels, kernel, src.pSamples, channels, 0, (int)srcFrames, false, frame, fraction, 1.0f);
+		for (uint8_t c = 0; c < channels; c++) {
+			float actual = dstOneShot.pSamples[i * channels + c];
+			float ideal = ut_signal(pos * lowerSamplerate / srcSamplerate, c);
+			// The kernel has a little interpolation error from its table. Negated so NaNs fail too.
+			if (!(fabsf(actual - expected[c]) <= 2.0e-4f)) {
+				UT_SUBMIT_FAIL("polyphase = %f, kernel = %f, ideal = %f, frame = %u, channel = %hhu", actual, expected[c], ideal, i, c);
+			}
+			// The polyphase filter should be flat to within float precision at our frequencies
+			if (!(fabsf(actual - ideal) <= 2.0e-5f)) {
+				UT_SUBMIT_FAIL("polyphase = %f, ideal = %f, frame = %u, channel = %hhu", actual, ideal, i, c);
+			}
+		}
+	}
+	utEndSubtest();
+
+	azaBufferDeinit(&src, true);
+	azaBufferDeinit(&dstStreamed, true);
+	azaBufferDeinit(&dstOneShot, true);
+	azaResamplerPolyphaseDeinit(&streamed);
+	azaResamplerPolyphaseDeinit(&oneShot);
+}
+
+void ut_run_azaResamplerPolyphase() {
+	const struct {
+		uint32_t srcSamplerate, dstSamplerate;
+	} ratios[] = {
+		{ 44100, 48000 },
+		{ 48000, 44100 },
+		{ 48000, 96000 },
+		{ 96000, 48000 },
+		{ 22050, 48000 },
+		{ 48000, 48000 },
+	};
+	for (uint32_t i = 0; i < sizeof(ratios) / sizeof(ratios[0]); i++) {
+		for (uint8_t channels = 1; channels <= 3; channels += 2) {
+			utBeginTest(azaTextFormat("azaResamplerPolyphase.c %u to %u (%hhu channels)", ratios[i].srcSamplerate, ratios[i].dstSamplerate, channels));
+			ut_test_azaResamplerPolyphase(ratios[i].srcSamplerate, ratios[i].dstSamplerate, channels);
+			utEndTest();
+		}
+	}
+}
@@ -0,0 +1,158 @@
+/*
+	File: azaSampleDelayMixMatrix.c
+	Author: Philip Haynes
+	Testing the correctness of the fused route mixing that azaMixer uses for latency compensation, against doing the gain, matrix, and delay one at a time.
+*/
+
+#include "../testing.h"
+
+#include <AzAudio/error.h>
+#include <AzAudio/math.h>
+#include <AzAudio/dsp/azaSampleDelay.h>
+
+#include <math.h>
+
+typedef enum ut_MatrixShape {
+	UT_MATRIX_SHAPE_DENSE,
+	UT_MATRIX_SHAPE_IDENTITY,
+	UT_MATRIX_SHAPE_SPARSE,
+} ut_MatrixShape;
+
+static const char *ut_MatrixShapeString[] = {
+	"dense",
+	"identity",
+	"sparse",
+};
+
+static void ut_fillMatrix(azaChannelMatrix *matrix, ut_MatrixShape shape) {
+	for (uint8_t c = 0; c < matrix->inputs; c++) {
+		for (uint8_t r = 0; r < matrix->outputs; r++) {
+			float value = 0.0f;
+			switch (shape) {
+				case UT_MATRIX_SHAPE_DENSE:
+					value = 0.25f + 0.125f * (float)((c * 3 + r * 5) % 7);
+					break;
+				case UT_MATRIX_SHAPE_IDENTITY:
+					value = c == r ? 1.0f : 0.0f;
+					break;
+				case UT_MATRIX_SHAPE_SPARSE:
+					value = (c + r) % 3 == 0 ? 0.5f + 0.25f * (float)c : 0.0f;
+					break;
+			}
+			matrix->matrix[c * matrix->outputs + r] = value;
+		}
+	}
+	azaChannelMatrixClassify(matrix);
+}
+
+// What goes into src at the given absolute frame and channel
+static float ut_srcSample(int64_t frame, uint8_t channel) {
+	return sinf(0.37f * (float)frame + 1.1f * (float)channel) + 0.01f * (float)channel;
+}
+
+// What's in dst at the given absolute frame and channel before mixing
+static float ut_dstSample(int64_t frame, uint8_t channel) {
+	return cosf(0.21f * (float)frame - 0.7f * (float)channel);
+}
+
+// Every third block is silent, and its samples are garbage so we can tell whether they got read
+static bool ut_blockIsSilent(uint32_t block, bool withSilence) {
+	return withSilence && block % 3 == 1;
+}
+
+static void ut_test_azaSampleDelayMixMatrix(uint32_t frames, uint32_t delayFrames, uint8_t inputs, uint8_t outputs, ut_MatrixShape shape, float volumeDst, float volumeSrc, bool withSilence) {
+	azaBuffer dst, src;
+	azaBufferInit(&src, frames, 0, 0, (azaChannelLayout) { .count = inputs });
+	azaBufferInit(&dst, frames, 0, 0, (azaChannelLayout) { .count = outputs });
+	azaChannelMatrix matrix;
+	int err = azaChannelMatrixInit(&matrix, inputs, outputs);
+	if (err) {
+		UT_SUBMIT_FAIL("azaChannelMatrixInit returned an error: %s", azaErrorString(err));
+		azaBufferDeinit(&src, true);
+		azaBufferDeinit(&dst, true);
+		return;
+	}
+	ut_fillMatrix(&matrix, shape);
+	azaSampleDelay sampleDelay;
+	azaSampleDelayInit(&sampleDelay, (azaSampleDelayConfig) {
+		.delayFrames = delayFrames
+	});
+
+	uint32_t blocksToDo = AZA_MAX(3, 2 + delayFrames / frames);
+	for (uint32_t block = 0; block < blocksToDo; block++) {
+		int64_t blockStart = (int64_t)block * frames;
+		src.silent = ut_blockIsSilent(block, withSilence);
+		for (uint32_t i = 0; i < frames; i++) {
+			for (uint8_t c = 0; c < inputs; c++) {
+				src.pSamples[i * src.stride + c] = src.silent ? 1000.0f : ut_srcSample(blockStart + i, c);
+			}
+			for (uint8_t c = 0; c < outputs; c++) {
+				// If volumeDst is 0, dst shouldn't be read at all
+				dst.pSamples[i * dst.stride + c] = volumeDst == 0.0f ? NAN : ut_dstSample(blockStart + i, c);
+			}
+		}
+		dst.silent = false;
+
+		err = azaSampleDelayMixMatrix(&sampleDelay, &dst, volumeDst, &src, volumeSrc, &matrix);
+		if (err) {
+			UT_SUBMIT_FAIL("azaSampleDelayMixMatrix returned an error: %s", azaErrorString(err));
+			break;
+		}
+
+		utBeginSubtest(azaTextFormat("Body Frames (call #%u)", block));
+		for (uint32_t i = 0; i < frames; i++) {
+			int64_t frameIn = blockStart + i - delayFrames;
+			bool inputAudible = frameIn >= 0 && !ut_blockIsSilent((uint32_t)(frameIn / frames), withSilence);
+			for (uint8_t r = 0; r < outputs; r++) {
+				float expected = volumeDst == 0.0f ? 0.0f : volumeDst * ut_dstSample(blockStart + i, r);
+				if (inputAudible) {
+					float mixed = 0.0f;
+					for (uint8_t c = 0; c < inputs; c++) {
+						mixed += ut_srcSample(frameIn, c) * matrix.matrix[c * outputs + r];
+					}
+					expected += volumeSrc * mixed;
+				}
+				float actual = dst.pSamples[i * dst.stride + r];
+				// Negated so NaNs fail too
+				if (!(fabsf(actual - expected) <= 0.00001f * (1.0f + fabsf(expected)))) {
+					UT_SUBMIT_FAIL("dst.pSamples[i] = %f, expected = %f, frame = %u, channel = %hhu", actual, expected, i, r);
+				}
+			}
+		}
+		utEndSubtest();
+	}
+
+	azaSampleDelayDeinit(&sampleDelay);
+	azaChannelMatrixDeinit(&matrix);
+	azaBufferDeinit(&src, true);
+	azaBufferDeinit(&dst, true);
+}
+
+void ut_run_azaSampleDelayMixMatrix() {
+	const struct {
+		uint8_t inputs, outputs;
+		ut_MatrixShape shape;
+	} matrices[] = {
+		{ 1, 1, UT_MATRIX_SHAPE_IDENTITY },
+		{ 2, 2, UT_MATRIX_SHAPE_IDENTITY },
+		{ 2, 2, UT_MATRIX_SHAPE_DENSE },
+		{ 1, 2, UT_MATRIX_SHAPE_DENSE },
+		{ 6, 2, UT_MATRIX_SHAPE_DENSE },
+		{ 6, 2, UT_MATRIX_SHAPE_SPARSE },
+		{ 2, 6, UT_MATRIX_SHAPE_SPARSE },
+	};
+	const uint32_t delays[] = { 0, 3, 8, 19 };
+	for (uint32_t m = 0; m < sizeof(matrices) / sizeof(matrices[0]); m++) {
+		for (uint32_t d = 0; d < sizeof(delays) / sizeof(delays[0]); d++) {
+			utBeginTest(azaTextFormat("azaSampleDelayMixMatrix.c %s %hhu->%hhu, delay %u, overwriting dst", ut_MatrixShapeString[matrices[m].shape], matrices[m].inputs, matrices[m].outputs, delays[d]));
+			ut_test_azaSampleDelayMixMatrix(8, delays[d], matrices[m].inputs, matrices[m].outputs, matrices[m].shape, 0.0f, 0.5f, false);
+			utEndTest();
+			utBeginTest(azaTextFormat("azaSampleDelayMixMatrix.c %s %hhu->%hhu, delay %u, mixing into dst", ut_MatrixShapeString[matrices[m].shape], matrices[m].inputs, matrices[m].outputs, delays[d]));
+			ut_test_azaSampleDelayMixMatrix(8, delays[d], matrices[m].inputs, matrices[m].outputs, matrices[m].shape, 1.0f, 0.5f, false);
+			utEndTest();
+			utBeginTest(azaTextFormat("azaSampleDelayMixMatrix.c %s %hhu->%hhu, delay %u, scaling dst with silent blocks", ut_MatrixShapeString[matrices[m].shape], matrices[m].inputs, matrices[m].outputs, delays[d]));
+			ut_test_azaSampleDelayMixMatrix(8, delays[d], matrices[m].inputs, matrices[m].outputs, matrices[m].shape, 0.75f, 2.0f, true);
+			utEndTest();
+		}
+	}
+}
@@ -0,0 +1,103 @@
+/*
+	File: azaSampler.c
+	Author: Philip Haynes
+	Testing that the sampler's published instance states survive changes to maxInstances, and that the tables they were published in get freed once nobody is reading them.
+*/
+
+#include "../testing.h"
+
+#include <AzAudio/error.h>
+#include <AzAudio/dsp/plugins/azaSampler.h>
+
+static uint32_t ut_countRetiredStateTables(azaSampler *sampler) {
+	uint32_t result = 0;
+	for (azaSamplerStateTable *table = sampler->stateTable->previous; table; table = table->previous) {
+		result++;
+	}
+	return result;
+}
+
+static void ut_test_azaSamplerStateTables(uint32_t changes) {
+	const uint32_t samplerate = 48000;
+	azaBuffer sound, output;
+	azaBufferInit(&sound, 1000, 0, 0, (azaChannelLayout) { .count = 1 });
+	azaBufferInit(&output, 256, 0, 0, (azaChannelLayout) { .count = 1 });
+	sound.samplerate = output.samplerate = samplerate;
+	for (uint32_t i = 0; i < sound.frames; i++) {
+		sound.pSamples[i] = 0.5f;
+	}
+
+	azaSampler sampler, source;
+	int err = azaSamplerInit(&sampler, (azaSamplerConfig) { .speedTransitionTimeMs = 50.0f, .volumeTransitionTimeMs = 50.0f });
+	if (err) {
+		UT_SUBMIT_FAIL("azaSamplerInit returned an error: %s", azaErrorString(err));
+		goto done_sound;
+	}
+	err = azaSamplerInit(&source, sampler.config);
+	if (err) {
+		UT_SUBMIT_FAIL("azaSamplerInit returned an error: %s", azaErrorString(err));
+		goto done_sampler;
+	}
+	// Loops forever with full sustain, so it's still playing no matter how many blocks go by
+	uint32_t id = azaSamplerLoop(&sampler, &sound, 1.0f, 0.0f, (azaADSRConfig) { .attack = 1.0f, .release = 10.0f });
+	if (id == 0) {
+		UT_SUBMIT_FAIL("azaSamplerLoop returned an invalid id (%u)", id);
+	}
+
+	utBeginSubtest("Freed Without Readers");
+	for (uint32_t i = 0; i < changes; i++) {
+		source.config.maxInstances = sampler.config.maxInstances == 8 ? 24 : 8;
+		if ((err = azaSamplerCopyConfig(&sampler.dsp, &source.dsp))) {
+			UT_SUBMIT_FAIL("azaSamplerCopyConfig returned an error: %s", azaErrorString(err));
+			break;
+		}
+		uint32_t retired = ut_countRetiredStateTables(&sampler);
+		UT_EXPECT_EQUAL(UT_FAIL, retired, 0, "change = %u", i);
+		if ((err = azaSamplerProcess(&sampler, &output, NULL, 0))) {
+			UT_SUBMIT_FAIL("azaSamplerProcess returned an error: %s", azaErrorString(err));
+			break;
+		}
+		azaSamplerInstanceState state;
+		if (!azaSamplerGetInstanceState(&sampler, id, &state)) {
+			UT_SUBMIT_FAIL("azaSamplerGetInstanceState didn't find id %u after change %u", id, i);
+		}
+	}
+	utEndSubtest();
+
+	utBeginSubtest("Kept While Reading");
+	// Pretend another thread is in the middle of azaSamplerGetInstanceState
+	azaAtomicFetchAdd32(&sampler.stateTableReaders, 1);
+	for (uint32_t i = 0; i < changes; i++) {
+		source.config.maxInstances = sampler.config.maxInstances == 8 ? 24 : 8;
+		if ((err = azaSamplerCopyConfig(&sampler.dsp, &source.dsp))) {
+			UT_SUBMIT_FAIL("azaSamplerCopyConfig returned an error: %s", azaErrorString(err));
+			break;
+		}
+		uint32_t retired = ut_countRetiredStateTables(&sampler);
+		UT_EXPECT_EQUAL(UT_FAIL, retired, i + 1, "change = %u", i);
+	}
+	azaAtomicFetchAdd32(&sampler.stateTableReaders, -1);
+	// Even without changing maxInstances, the next azaSamplerCopyConfig gets to free them
+	if ((err = azaSamplerCopyConfig(&sampler.dsp, &sampler.dsp))) {
+		UT_SUBMIT_FAIL("azaSamplerCopyConfig returned an error: %s", azaErrorString(err));
+	}
+	uint32_t retired = ut_countRetiredStateTables(&sampler);
+	UT_EXPECT_EQUAL(UT_FAIL, retired, 0, "changes = %u", changes);
+	utEndSubtest();
+
+	azaSamplerDeinit(&source);
+done_sampler:
+	azaSamplerDeinit(&sampler);
+done_sound:
+	azaBufferDeinit(&sound, true);
+	azaBufferDeinit(&output, true);
+}
+
+void ut_run_azaSampler() {
+	const uint32_t changes[] = { 1, 50 };
+	for (uint32_t i = 0; i < sizeof(changes) / sizeof(changes[0]); i++) {
+		utBeginTest(azaTextFormat("azaSampler.c state tables over %u changes of maxInstances", changes[i]));
+		ut_test_azaSamplerStateTables(changes[i]);
+		utEndTest();
+	}
+}